@@ -29,45 +29,80 @@
 #ifndef _LOCAL_LOG_BUFFER_H_
 #define _LOCAL_LOG_BUFFER_H_
 /* External Includes */
-#include <deque>
-#include <sstream>
+#include <atomic>
+#include <stdint.h>
 #include <string>
 #include <sys/types.h>
 #include <vector>
 
 /* Namespace pollution avoidance */
-using ::std::deque;
+using ::std::atomic;
 using ::std::string;
-using ::std::stringstream;
 using ::std::vector;
 
 
+/* Fixed-size ring of binary call records.  Arguments and results are stored
+ * as typed fields and only formatted when the buffer is dumped, so logging a
+ * HAL call costs a few copies instead of string building.  Writers claim a
+ * slot with a single atomic increment and never take a lock.
+ */
 class LocalLogBuffer {
 public:
+    static const int MAX_ARGS = 4;
+    static const int MAX_RESULTS = 8;
+    static const int STR_POOL = 224;
+    /* the rest of the pool is kept for the result message */
+    static const int ARG_POOL = 176;
+
     class FunctionLog {
     public:
-        FunctionLog(string /* funcName */);
-        FunctionLog(const FunctionLog& /* other */);
-        void addArg(string /* kw */, string /* arg */);
-        void addArg(string /* kw */, vector<string> /* args */);
-        void addArg(string /* kw */, uint64_t /* arg */);
-        void setResult(bool /* success */, string /* msg */);
-        void setResult(vector<unsigned int> /* ret */);
+        FunctionLog(const char* /* funcName */);
+        void addArg(const char* /* kw */, const string& /* arg */);
+        void addArg(const char* /* kw */, const vector<string>& /* args */);
+        void addArg(const char* /* kw */, uint64_t /* arg */);
+        void setResult(bool /* success */, const string& /* msg */);
+        void setResult(const vector<unsigned int>& /* ret */);
         void setResult(uint64_t /* rx */, uint64_t /* tx */);
-        string toString();
+        string toString() const;
     private:
-        void maybeAddArgsComma();
-        const string mName;
-        bool mArgsProvided;
-        stringstream mSSArgs;
-        stringstream mSSReturn;
+        friend class LocalLogBuffer;
+        enum ArgType { ARG_STR, ARG_STR_LIST, ARG_U64 };
+        enum ResultType { RES_NONE, RES_BOOL_MSG, RES_U32_LIST, RES_RX_TX };
+        struct Arg {
+            const char* kw;
+            uint8_t type;
+            uint16_t off;       /* ARG_STR/ARG_STR_LIST: string in mPool */
+            uint16_t len;
+            uint64_t val;       /* ARG_U64; number of strings for ARG_STR_LIST */
+        };
+        uint16_t poolAdd(const string& /* str */, int /* limit */);
+        const char* mName;
+        uint8_t mNumArgs;
+        uint8_t mResultType;
+        bool mSuccess;
+        bool mTruncated;
+        uint16_t mPoolUsed;
+        uint16_t mMsgOff;
+        uint16_t mMsgLen;
+        uint8_t mNumResults;
+        Arg mArgs[MAX_ARGS];
+        uint64_t mResults[MAX_RESULTS];
+        char mPool[STR_POOL];
     }; /* FunctionLog */
     LocalLogBuffer(string /* name */, int /* maxLogs */);
-    void addLog(FunctionLog /* log */);
+    ~LocalLogBuffer();
+    void addLog(const FunctionLog& /* log */);
     void toLogcat();
 private:
-    deque<FunctionLog> mLogs;
+    struct Slot {
+        atomic<uint64_t> seq;   /* 2 * index + 2 once written, odd while written */
+        FunctionLog log;
+        Slot() : seq(0), log("") {}
+    };
+    Slot* mSlots;
+    size_t mMask;
+    atomic<uint64_t> mHead;
     const string mName;
     const size_t mMaxLogs;
 }; /* LocalLogBuffer */
-#endif /* _LOCAL_LOG_BUFFER_H_ */
\ No newline at end of file
+#endif /* _LOCAL_LOG_BUFFER_H_ */
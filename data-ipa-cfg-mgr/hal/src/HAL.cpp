@@ -109,6 +109,7 @@ void HAL::doLogcatDump() {
      * ALOGD("fd2->%d", mHandle2->data[0]);
      */
     ALOGD("========");
+    mLogs.toLogcat();
 } /* doLogcatDump */
 
 HAL::BoolResult HAL::makeInputCheckFailure(string customErr) {
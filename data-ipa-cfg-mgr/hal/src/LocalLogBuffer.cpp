@@ -29,8 +29,11 @@
 #define LOG_TAG "IPAHALService/dump"
 
 /* External Includes */
+#include <atomic>
 #include <cutils/log.h>
-#include <deque>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
 #include <string>
 #include <sys/types.h>
 #include <vector>
@@ -39,88 +42,213 @@
 #include "LocalLogBuffer.h"
 
 /* Namespace pollution avoidance */
-using ::std::deque;
+using ::std::atomic;
+using ::std::memory_order_acquire;
+using ::std::memory_order_relaxed;
+using ::std::memory_order_release;
 using ::std::string;
 using ::std::vector;
 
 
-LocalLogBuffer::FunctionLog::FunctionLog(string funcName) : mName(funcName) {
-    mArgsProvided = false;
+LocalLogBuffer::FunctionLog::FunctionLog(const char* funcName) : mName(funcName) {
+    mNumArgs = 0;
+    mResultType = RES_NONE;
+    mSuccess = false;
+    mTruncated = false;
+    mPoolUsed = 0;
+    mMsgOff = 0;
+    mMsgLen = 0;
+    mNumResults = 0;
 } /* FunctionLog */
 
-LocalLogBuffer::FunctionLog::FunctionLog(const FunctionLog& other) :
-        mName(other.mName) {
-    mArgsProvided = other.mArgsProvided;
-    /* Is this right? How do you copy stringstreams without wizardry? */
-    mSSArgs.str(other.mSSArgs.str());
-    mSSReturn.str(other.mSSReturn.str());
-} /* FunctionLog */
-
-void LocalLogBuffer::FunctionLog::addArg(string kw, string arg) {
-    maybeAddArgsComma();
-    mSSArgs << kw << "=" << arg;
-} /* addArg */
+uint16_t LocalLogBuffer::FunctionLog::poolAdd(const string& str, int limit) {
+    size_t len = str.size();
+    uint16_t off = mPoolUsed;
 
-void LocalLogBuffer::FunctionLog::addArg(string kw, vector<string> args) {
-    maybeAddArgsComma();
-    mSSArgs << kw << "=[";
-    for (size_t i = 0; i < args.size(); i++) {
-        mSSArgs << args[i];
-        if (i < (args.size() - 1))
-            mSSArgs << ", ";
+    if (len > (size_t)(limit - mPoolUsed)) {
+        len = (mPoolUsed < limit) ? limit - mPoolUsed : 0;
+        mTruncated = true;
+    }
+    memcpy(mPool + off, str.data(), len);
+    mPoolUsed += len;
+    return off;
+} /* poolAdd */
+
+void LocalLogBuffer::FunctionLog::addArg(const char* kw, const string& arg) {
+    if (mNumArgs >= MAX_ARGS) {
+        mTruncated = true;
+        return;
     }
-    mSSArgs << "]";
+    Arg& a = mArgs[mNumArgs++];
+    a.kw = kw;
+    a.type = ARG_STR;
+    a.off = poolAdd(arg, ARG_POOL);
+    a.len = mPoolUsed - a.off;
+    a.val = 0;
 } /* addArg */
 
-void LocalLogBuffer::FunctionLog::addArg(string kw, uint64_t arg) {
-    maybeAddArgsComma();
-    mSSArgs << kw << "=" << arg;
+void LocalLogBuffer::FunctionLog::addArg(const char* kw, const vector<string>& args) {
+    if (mNumArgs >= MAX_ARGS) {
+        mTruncated = true;
+        return;
+    }
+    Arg& a = mArgs[mNumArgs++];
+    a.kw = kw;
+    a.type = ARG_STR_LIST;
+    a.off = mPoolUsed;
+    a.val = 0;
+    /* NUL separated, the brackets and commas are added when dumped */
+    for (size_t i = 0; i < args.size() && mPoolUsed < ARG_POOL; i++) {
+        poolAdd(args[i], ARG_POOL - 1);
+        mPool[mPoolUsed++] = '\0';
+        a.val++;
+    }
+    if (a.val < args.size())
+        mTruncated = true;
+    a.len = mPoolUsed - a.off;
 } /* addArg */
 
-void LocalLogBuffer::FunctionLog::maybeAddArgsComma() {
-    if (!mArgsProvided) {
-        mArgsProvided = true;
-    } else {
-        mSSArgs << ", ";
+void LocalLogBuffer::FunctionLog::addArg(const char* kw, uint64_t arg) {
+    if (mNumArgs >= MAX_ARGS) {
+        mTruncated = true;
+        return;
     }
-} /* maybeAddArgsComma */
+    Arg& a = mArgs[mNumArgs++];
+    a.kw = kw;
+    a.type = ARG_U64;
+    a.off = 0;
+    a.len = 0;
+    a.val = arg;
+} /* addArg */
 
-void LocalLogBuffer::FunctionLog::setResult(bool success, string msg) {
-    mSSReturn << "[" << ((success) ? "success" : "failure") << ", " << msg
-              << "]";
+void LocalLogBuffer::FunctionLog::setResult(bool success, const string& msg) {
+    mResultType = RES_BOOL_MSG;
+    mSuccess = success;
+    mMsgOff = poolAdd(msg, STR_POOL);
+    mMsgLen = mPoolUsed - mMsgOff;
 } /* setResult */
 
-void LocalLogBuffer::FunctionLog::setResult(vector<unsigned int> ret) {
-    mSSReturn << "[";
-    for (size_t i = 0; i < ret.size(); i++) {
-        mSSReturn << ret[i];
-        if (i < (ret.size() - 1))
-            mSSReturn << ", ";
-    }
-    mSSReturn << "]";
+void LocalLogBuffer::FunctionLog::setResult(const vector<unsigned int>& ret) {
+    mResultType = RES_U32_LIST;
+    mNumResults = 0;
+    for (size_t i = 0; i < ret.size() && i < MAX_RESULTS; i++)
+        mResults[mNumResults++] = ret[i];
+    if (ret.size() > MAX_RESULTS)
+        mTruncated = true;
 } /* setResult */
 
 void LocalLogBuffer::FunctionLog::setResult(uint64_t rx, uint64_t tx) {
-    mSSReturn << "[rx=" << rx << ", tx=" << tx << "]";
+    mResultType = RES_RX_TX;
+    mNumResults = 2;
+    mResults[0] = rx;
+    mResults[1] = tx;
 } /* setResult */
 
-string LocalLogBuffer::FunctionLog::toString() {
-    stringstream ret;
-    ret << mName << "(" << mSSArgs.str() << ") returned " << mSSReturn.str();
-    return ret.str();
+string LocalLogBuffer::FunctionLog::toString() const {
+    char num[24];
+    string ret(mName);
+
+    ret += "(";
+    for (int i = 0; i < mNumArgs; i++) {
+        const Arg& a = mArgs[i];
+        if (i > 0)
+            ret += ", ";
+        ret += a.kw;
+        ret += "=";
+        if (a.type == ARG_U64) {
+            snprintf(num, sizeof(num), "%" PRIu64, a.val);
+            ret += num;
+        } else if (a.type == ARG_STR) {
+            ret.append(mPool + a.off, a.len);
+        } else {
+            const char* p = mPool + a.off;
+            const char* end = p + a.len;
+            ret += "[";
+            for (uint64_t j = 0; j < a.val && p < end; j++) {
+                size_t len = strnlen(p, end - p);
+                if (j > 0)
+                    ret += ", ";
+                ret.append(p, len);
+                p += len + 1;
+            }
+            ret += "]";
+        }
+    }
+    ret += ") returned ";
+
+    switch (mResultType) {
+    case RES_BOOL_MSG:
+        ret += (mSuccess) ? "[success, " : "[failure, ";
+        ret.append(mPool + mMsgOff, mMsgLen);
+        ret += "]";
+        break;
+    case RES_U32_LIST:
+        ret += "[";
+        for (int i = 0; i < mNumResults; i++) {
+            if (i > 0)
+                ret += ", ";
+            snprintf(num, sizeof(num), "%" PRIu64, mResults[i]);
+            ret += num;
+        }
+        ret += "]";
+        break;
+    case RES_RX_TX:
+        snprintf(num, sizeof(num), "%" PRIu64, mResults[0]);
+        ret += "[rx=";
+        ret += num;
+        snprintf(num, sizeof(num), "%" PRIu64, mResults[1]);
+        ret += ", tx=";
+        ret += num;
+        ret += "]";
+        break;
+    default:
+        break;
+    }
+    if (mTruncated)
+        ret += " (truncated)";
+    return ret;
 } /* toString */
 
-LocalLogBuffer::LocalLogBuffer(string name, int maxLogs) : mName(name),
-        mMaxLogs(maxLogs) {
+LocalLogBuffer::LocalLogBuffer(string name, int maxLogs) : mHead(0), mName(name),
+        mMaxLogs((maxLogs > 0) ? maxLogs : 1) {
+    size_t size = 1;
+
+    while (size < mMaxLogs)
+        size <<= 1;
+    mSlots = new Slot[size];
+    mMask = size - 1;
 } /* LocalLogBuffer */
 
-void LocalLogBuffer::addLog(FunctionLog log) {
-    while (mLogs.size() > mMaxLogs)
-        mLogs.pop_front();
-    mLogs.push_back(log);
+LocalLogBuffer::~LocalLogBuffer() {
+    delete[] mSlots;
+} /* ~LocalLogBuffer */
+
+void LocalLogBuffer::addLog(const FunctionLog& log) {
+    uint64_t idx = mHead.fetch_add(1, memory_order_relaxed);
+    Slot& slot = mSlots[idx & mMask];
+
+    /* seqlock: an odd sequence tells the dumper the slot is being written */
+    slot.seq.store(2 * idx + 1, memory_order_relaxed);
+    std::atomic_thread_fence(memory_order_release);
+    slot.log = log;
+    slot.seq.store(2 * idx + 2, memory_order_release);
 } /* addLog */
 
 void LocalLogBuffer::toLogcat() {
-    for (size_t i = 0; i < mLogs.size(); i++)
-        ALOGD("%s: %s", mName.c_str(), mLogs[i].toString().c_str());
+    uint64_t head = mHead.load(memory_order_acquire);
+    uint64_t first = (head > mMaxLogs) ? head - mMaxLogs : 0;
+
+    for (uint64_t idx = first; idx < head; idx++) {
+        Slot& slot = mSlots[idx & mMask];
+        FunctionLog log("");
+
+        if (slot.seq.load(memory_order_acquire) != 2 * idx + 2)
+            continue;
+        log = slot.log;
+        std::atomic_thread_fence(memory_order_acquire);
+        /* overwritten while copied, a newer entry follows anyway */
+        if (slot.seq.load(memory_order_relaxed) != 2 * idx + 2)
+            continue;
+        ALOGD("%s: %s", mName.c_str(), log.toString().c_str());
+    }
 } /* toLogcat */
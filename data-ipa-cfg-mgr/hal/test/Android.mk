@@ -0,0 +1,21 @@
+BOARD_PLATFORM_LIST := test
+ifeq ($(call is-board-platform-in-list,$(BOARD_PLATFORM_LIST)),true)
+ifneq (,$(filter $(QCOM_BOARD_PLATFORMS),$(TARGET_BOARD_PLATFORM)))
+ifneq (, $(filter aarch64 arm arm64, $(TARGET_ARCH)))
+
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := LocalLogBuffer_bench.cpp \
+                ../src/LocalLogBuffer.cpp
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../inc
+LOCAL_MODULE := locallogbuffer_bench
+LOCAL_CPP_FLAGS := -Wall -Werror
+LOCAL_SHARED_LIBRARIES := liblog
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/kernel-tests/ip_accelerator
+include $(BUILD_EXECUTABLE)
+
+endif # $(TARGET_ARCH)
+endif
+endif
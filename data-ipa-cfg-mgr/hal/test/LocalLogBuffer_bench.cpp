@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2017, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above
+ *      copyright notice, this list of conditions and the following
+ *      disclaimer in the documentation and/or other materials provided
+ *      with the distribution.
+ *    * Neither the name of The Linux Foundation nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/* Times the logging done by HAL::setUpstreamParameters against the
+ * stringstream/deque buffer LocalLogBuffer replaced.
+ */
+/* External Includes */
+#include <deque>
+#include <sstream>
+#include <stdio.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+/* Internal Includes */
+#include "LocalLogBuffer.h"
+
+/* Namespace pollution avoidance */
+using ::std::string;
+using ::std::vector;
+
+
+namespace {
+
+class LegacyFunctionLog {
+public:
+    LegacyFunctionLog(string funcName) : mName(funcName), mArgsProvided(false) {}
+    LegacyFunctionLog(const LegacyFunctionLog& other) : mName(other.mName) {
+        mArgsProvided = other.mArgsProvided;
+        mSSArgs.str(other.mSSArgs.str());
+        mSSReturn.str(other.mSSReturn.str());
+    }
+    void addArg(string kw, string arg) {
+        maybeAddArgsComma();
+        mSSArgs << kw << "=" << arg;
+    }
+    void addArg(string kw, vector<string> args) {
+        maybeAddArgsComma();
+        mSSArgs << kw << "=[";
+        for (size_t i = 0; i < args.size(); i++) {
+            mSSArgs << args[i];
+            if (i < (args.size() - 1))
+                mSSArgs << ", ";
+        }
+        mSSArgs << "]";
+    }
+    void setResult(bool success, string msg) {
+        mSSReturn << "[" << ((success) ? "success" : "failure") << ", " << msg << "]";
+    }
+private:
+    void maybeAddArgsComma() {
+        if (!mArgsProvided)
+            mArgsProvided = true;
+        else
+            mSSArgs << ", ";
+    }
+    const string mName;
+    bool mArgsProvided;
+    std::stringstream mSSArgs;
+    std::stringstream mSSReturn;
+}; /* LegacyFunctionLog */
+
+double nowSec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+} /* nowSec */
+
+} /* namespace */
+
+int main() {
+    const int iters = 1000000;
+    string iface("rmnet_data0"), v4Addr("100.64.12.34"), v4Gw("100.64.12.1");
+    vector<string> v6Gws;
+    string errMsg("");
+    std::deque<LegacyFunctionLog> legacy;
+    LocalLogBuffer ring("HAL Function Calls", 50);
+    double t0, legacyNs, ringNs;
+
+    v6Gws.push_back("2001:db8:85a3::8a2e:370:1");
+    v6Gws.push_back("fe80::1");
+
+    t0 = nowSec();
+    for (int i = 0; i < iters; i++) {
+        LegacyFunctionLog fl("setUpstreamParameters");
+        fl.addArg("iface", iface);
+        fl.addArg("v4Addr", v4Addr);
+        fl.addArg("v4Gw", v4Gw);
+        fl.addArg("v6Gws", v6Gws);
+        fl.setResult(true, errMsg);
+        while (legacy.size() > 50)
+            legacy.pop_front();
+        legacy.push_back(fl);
+    }
+    legacyNs = (nowSec() - t0) * 1e9 / iters;
+
+    t0 = nowSec();
+    for (int i = 0; i < iters; i++) {
+        LocalLogBuffer::FunctionLog fl("setUpstreamParameters");
+        fl.addArg("iface", iface);
+        fl.addArg("v4Addr", v4Addr);
+        fl.addArg("v4Gw", v4Gw);
+        fl.addArg("v6Gws", v6Gws);
+        fl.setResult(true, errMsg);
+        ring.addLog(fl);
+    }
+    ringNs = (nowSec() - t0) * 1e9 / iters;
+
+    printf("setUpstreamParameters logging: deque<stringstream> %.0f ns/call, ring %.0f ns/call\n",
+            legacyNs, ringNs);
+    ring.toLogcat();
+    return 0;
+} /* main */
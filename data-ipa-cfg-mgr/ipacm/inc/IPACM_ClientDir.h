@@ -0,0 +1,145 @@
+/*
+Copyright (c) 2018, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_ClientDir.h
+
+	@brief
+	This file implements the IPACM client directory definitions
+
+	@Author
+
+*/
+#ifndef IPACM_CLIENTDIR_H
+#define IPACM_CLIENTDIR_H
+
+#include <stdint.h>
+#include <linux/msm_ipa.h>
+#include <IPACM_Defs.h>
+
+/* client indexes handed out by the directory must stay below IPACM_INVALID_INDEX */
+#define IPACM_CLIENT_DIR_MAX 254
+/* ipv6 addresses tracked per client, same as IPV6_NUM_ADDR */
+#define IPACM_CLIENT_DIR_NUM_V6 3
+
+#define IPACM_CLIENT_HDL_INVALID 0
+
+typedef struct
+{
+	uint8_t mac[IPA_MAC_ADDR_SIZE];
+	bool in_use;
+	uint16_t gen;
+	uint32_t v4_addr;        /* 0 when not set */
+	int num_v6;
+	uint32_t v6_addr[IPACM_CLIENT_DIR_NUM_V6][4];
+	int next_mac;            /* mac chain, free list when not in use */
+	int next_v4;
+	int next_v6[IPACM_CLIENT_DIR_NUM_V6];
+} ipacm_client_dir_entry;
+
+/* Client lookup table for the per-iface client arrays: finds a client by
+   MAC, IPv4 or IPv6 address in O(1) instead of scanning the array. The
+   owner keeps its array and stores the array index here; handles stay
+   valid across array compaction and turn stale once the client leaves. */
+class IPACM_ClientDir
+{
+public:
+
+	IPACM_ClientDir(int max_clients);
+	~IPACM_ClientDir();
+
+	/* add the client or update its index, returns its handle */
+	uint32_t Add(const uint8_t *mac, int idx);
+
+	int Remove(const uint8_t *mac);
+
+	void Clear(void);
+
+	uint32_t Lookup(const uint8_t *mac);
+
+	/* owner's index of the client, IPACM_INVALID_INDEX if not found */
+	int GetIndex(uint32_t hdl);
+
+	int FindMac(const uint8_t *mac);
+
+	int FindV4(uint32_t v4_addr);
+
+	int FindV6(const uint32_t *v6_addr);
+
+	int SetIndex(const uint8_t *mac, int idx);
+
+	/* owner removed array entry idx and moved the following ones down */
+	void ShiftDown(int idx);
+
+	/* an address belongs to one client, setting it moves it from the previous owner */
+	int SetV4(const uint8_t *mac, uint32_t v4_addr);
+
+	int AddV6(const uint8_t *mac, const uint32_t *v6_addr);
+
+	int DelV6(const uint8_t *mac, const uint32_t *v6_addr);
+
+	int ClearAddr(const uint8_t *mac, ipa_ip_type iptype);
+
+	inline int GetCount(void)
+	{
+		return num_clients;
+	}
+
+	inline int GetMax(void)
+	{
+		return max_clients;
+	}
+
+private:
+
+	int max_clients;
+	int num_clients;
+	int hash_bits;
+	int free_head;
+
+	ipacm_client_dir_entry *entries;
+	int *mac_bucket;
+	int *v4_bucket;
+	int *v6_bucket;   /* chains of slot * IPACM_CLIENT_DIR_NUM_V6 + addr */
+	int *slot_idx;    /* owner's client array index per slot, apart so ShiftDown stays a tight loop */
+
+	uint32_t HashMac(const uint8_t *mac);
+	uint32_t HashV4(uint32_t v4_addr);
+	uint32_t HashV6(const uint32_t *v6_addr);
+
+	int FindSlot(const uint8_t *mac);
+	int FindV6Node(const uint32_t *v6_addr);
+
+	void LinkV4(int slot);
+	void UnlinkV4(int slot);
+	void LinkV6(int node);
+	void UnlinkV6(int node);
+};
+
+#endif /* IPACM_CLIENTDIR_H */
@@ -78,20 +78,43 @@ public:
 	Message* getnext()       { return m_next; }
 };
 
+/* Messages handed out by MessageQueue::allocMessage() come from this pool
+	 first and from the heap only once it is used up */
+#define IPACM_MSG_POOL_SIZE 256
+
 class MessageQueue
 {
 
 private:
 	Message *Head;
 	Message *Tail;
-	Message* dequeue(void);
+	pthread_mutex_t q_lock;
+
+	Message* dequeueAll(void);
+	void requeue(Message *item);
+	bool isEmpty(void);
+
+	static MessageQueue *inst_priority;
 	static MessageQueue *inst_internal;
 	static MessageQueue *inst_external;
 
+	/* the worker sleeps on these once every queue is empty */
+	static pthread_mutex_t wait_lock;
+	static pthread_cond_t wait_cond;
+	static bool waiting;
+
+	static Message pool[IPACM_MSG_POOL_SIZE];
+	static Message *pool_free;
+	static bool pool_ready;
+	static pthread_mutex_t pool_lock;
+
+	static int ProcessBatch(MessageQueue *queue, MessageQueue *higher, MessageQueue *highest);
+
 	MessageQueue()
 	{
 		Head = NULL;
 		Tail = NULL;
+		pthread_mutex_init(&q_lock, NULL);
 	}
 
 public:
@@ -99,7 +122,12 @@ public:
 	~MessageQueue() { }
 	void enqueue(Message *item);
 
+	static Message* allocMessage(void);
+	static void freeMessage(Message *item);
+	static int wakeup(void);
+
 	static void* Process(void *);
+	static MessageQueue* getInstancePriority();
 	static MessageQueue* getInstanceInternal();
 	static MessageQueue* getInstanceExternal();
 
@@ -111,6 +111,14 @@ public:
 
 	int ipa_nat_max_entries;
 
+	int ipa_max_wlan_clients;
+
+	int ipa_max_eth_clients;
+
+	int ipa_max_neighbor_clients;
+
+	int ipa_offload_stats_interval_ms;
+
 	bool ipacm_odu_router_mode;
 
 	bool ipacm_odu_enable;
@@ -221,6 +229,26 @@ public:
 		return ipa_nat_max_entries;
 	}
 
+	inline int GetMaxWlanClients(void)
+	{
+		return ipa_max_wlan_clients;
+	}
+
+	inline int GetMaxEthClients(void)
+	{
+		return ipa_max_eth_clients;
+	}
+
+	inline int GetMaxNeighborClients(void)
+	{
+		return ipa_max_neighbor_clients;
+	}
+
+	inline int GetOffloadStatsInterval(void)
+	{
+		return ipa_offload_stats_interval_ms;
+	}
+
 	inline int GetNatIfacesCnt()
 	{
 		return ipa_nat_iface_entries;
@@ -322,6 +350,7 @@ public:
 				for (; cnt < ipa_num_private_subnet - 1; cnt++)
 				{
 					private_subnet_table[cnt].subnet_addr = private_subnet_table[cnt+1].subnet_addr;
+					private_subnet_table[cnt].subnet_mask = private_subnet_table[cnt+1].subnet_mask;
 				}
 				ipa_num_private_subnet = ipa_num_private_subnet - 1;
 
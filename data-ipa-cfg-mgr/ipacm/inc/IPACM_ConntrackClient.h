@@ -36,6 +36,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <errno.h>
+#include <time.h>
 
 #include "IPACM_ConntrackClient.h"
 #include "IPACM_CmdQueue.h"
@@ -59,6 +60,40 @@ using namespace std;
 #define UDP_TIMEOUT_UPDATE 20
 #define BROADCAST_IPV4_ADDR 0xFFFFFFFF
 
+/* longest an event waits in a batch, and the receive buffer that has to
+   absorb a burst meanwhile */
+#define CT_EVT_BATCH_WINDOW_US 5000
+#define CT_RCVBUF_SIZE (512 * 1024)
+
+typedef struct
+{
+	uint32_t src_ip;
+	uint32_t dst_ip;
+	uint16_t src_port;
+	uint16_t dst_port;
+	uint8_t proto;
+} ct_evt_tuple;
+
+typedef struct
+{
+	uint32_t events;     /* received from conntrack */
+	uint32_t coalesced;  /* folded into a later event on the same tuple */
+	uint32_t dropped;    /* lost to socket overruns or allocation failures */
+	uint32_t batches;    /* posted to the listener */
+} ct_evt_stats;
+
+/* events of one receive thread waiting to be posted */
+typedef struct
+{
+	struct nfct_handle *hdl;
+	ipacm_ct_evt_batch *batch;
+	ct_evt_tuple tuples[IPA_CT_EVT_BATCH_MAX];
+	int live;
+	struct timespec first;
+	bool timer_armed;
+	ct_evt_stats stats;
+} ct_evt_batcher;
+
 class IPACM_ConntrackClient
 {
 
@@ -72,6 +107,13 @@ private:
    static int IPA_Conntrack_Filters_Ignore_Local_Addrs(struct nfct_filter *filter);
    static int IPA_Conntrack_Filters_Ignore_Bridge_Addrs(struct nfct_filter *filter);
    static int IPA_Conntrack_Filters_Ignore_Local_Iface(struct nfct_filter *, ipacm_event_iface_up *);
+   ct_evt_batcher tcp_batcher;
+   ct_evt_batcher udp_batcher;
+   static bool SupersedesCTEvent(ipacm_ct_evt_data *, enum nf_conntrack_msg_type, struct nf_conntrack *);
+   static void QueueCTEvent(ct_evt_batcher *, enum nf_conntrack_msg_type, struct nf_conntrack *);
+   static void FlushCTEvents(ct_evt_batcher *);
+   static void SetCTEventTimer(ct_evt_batcher *, bool);
+   static bool HandleCatchError(ct_evt_batcher *);
    IPACM_ConntrackClient();
 
 public:
@@ -90,6 +132,7 @@ public:
    static void Read_TcpUdp_Timeout(char *in, int len);
 
    static IPACM_ConntrackClient* GetInstance();
+   static void GetCTEventStats(ct_evt_stats *);
 
    static void UNRegisterWithConnTrack(void);
    int fd_tcp;
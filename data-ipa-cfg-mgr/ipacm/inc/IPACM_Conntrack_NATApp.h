@@ -32,6 +32,9 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string.h>  /* for stderror */
 #include <stdlib.h>
 #include <cstdio>  /* for perror */
+#include <time.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
 
 #include "IPACM_Config.h"
 #include "IPACM_Xml.h"
@@ -44,6 +47,13 @@ extern "C"
 
 #define MAX_TEMP_ENTRIES 25
 
+/* conntrack timeout updates sent per netlink request, and room per update */
+#define NAT_CT_BATCH_SIZE 64
+#define NAT_CT_MSG_SIZE 256
+
+/* nat table entries moved by the compaction of one timestamp sweep */
+#define NAT_COMPACT_MOVES 32
+
 #define IPACM_TCP_FULL_FILE_NAME  "/proc/sys/net/ipv4/netfilter/ip_conntrack_tcp_timeout_established"
 #define IPACM_UDP_FULL_FILE_NAME   "/proc/sys/net/ipv4/netfilter/ip_conntrack_udp_timeout_stream"
 
@@ -67,6 +77,22 @@ typedef struct _nat_table_entry
 
 }nat_table_entry;
 
+#define NAT_INVALID_SLOT (-1)
+
+/* Index links of a cache slot. While the slot is free,
+   clnt_next links it into the free list instead. */
+typedef struct _nat_cache_link
+{
+	uint32_t tuple_hash;
+
+	int clnt_prev; /* slots with the same private ip */
+	int clnt_next;
+
+	int tgt_prev; /* slots with the same target ip */
+	int tgt_next;
+
+}nat_cache_link;
+
 #define CHK_TBL_HDL()  if(nat_table_hdl == 0){ return -1; }
 
 class NatApp
@@ -83,6 +109,23 @@ private:
 
 	int curCnt, max_entries;
 
+	/* 5-tuple index of cache slots, open addressing with linear probing */
+	int *tuple_idx;
+	uint32_t tuple_idx_mask;
+
+	/* heads of the per private/target ip chains, hashed by ip */
+	int *clnt_bkt;
+	int *tgt_bkt;
+	uint32_t ip_bkt_mask;
+
+	nat_cache_link *links;
+	int free_head;
+
+	/* scratch arrays of the timestamp sweep */
+	int *ts_slots;
+	uint32_t *ts_rule_hdls;
+	uint32_t *ts_vals;
+
 	ipacm_alg *pALGPorts;
 	uint16_t nALGPort;
 
@@ -93,11 +136,17 @@ private:
 
 	struct nf_conntrack *ct;
 	struct nfct_handle *ct_hdl;
+	uint32_t ct_seq;
 
 	NatApp();
 	int Init();
+	int AllocCache();
+
+	int FindEntry(const nat_table_entry *);
+	void IndexEntry(int);
+	void ReleaseEntry(int);
 
-	void UpdateCTUdpTs(nat_table_entry *, uint32_t);
+	int UpdateCTUdpTs(int);
 	bool ChkForDup(const nat_table_entry *);
 	bool isAlgPort(uint8_t, uint16_t);
 	void Reset();
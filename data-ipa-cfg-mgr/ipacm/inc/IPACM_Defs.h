@@ -117,12 +117,20 @@ extern "C"
 #define IPACM_IP_NULL (ipa_ip_type)0xFF
 #define IPACM_INVALID_INDEX (ipa_ip_type)0xFF
 
+/* client caps, <IPACMClients> in IPACM_cfg.xml may change them;
+   wifi clients cannot go above IPA_MAX_NUM_WIFI_CLIENTS */
 #define IPA_MAX_NUM_WIFI_CLIENTS  32
 #define IPA_MAX_NUM_WAN_CLIENTS  10
 #define IPA_MAX_NUM_ETH_CLIENTS  15
+#define IPA_MAX_NUM_NEIGHBOR_CLIENTS  100
 #define IPA_MAX_NUM_AMPDU_RULE  15
 #define IPA_MAC_ADDR_SIZE  6
 
+/* tethering stats sampling period, <IPACMOffload> in IPACM_cfg.xml may change it */
+#define IPACM_OFFLOAD_STATS_INTERVAL_MS      1000
+#define IPACM_OFFLOAD_STATS_INTERVAL_MIN_MS  100
+#define IPACM_OFFLOAD_STATS_INTERVAL_MAX_MS  60000
+
 /*===========================================================================
 										 GLOBAL DEFINITIONS AND DECLARATIONS
 ===========================================================================*/
@@ -156,7 +164,7 @@ typedef enum
 	IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT,       /* ipacm_event_data_all */
 	IPA_SW_ROUTING_ENABLE,                    /* NULL */
 	IPA_SW_ROUTING_DISABLE,                   /* NULL */
-	IPA_PROCESS_CT_MESSAGE,                   /* ipacm_ct_evt_data */
+	IPA_PROCESS_CT_MESSAGE,                   /* ipacm_ct_evt_batch */
 	IPA_PROCESS_CT_MESSAGE_V6,                /* ipacm_ct_evt_data */
 	IPA_LAN_TO_LAN_NEW_CONNECTION,            /* ipacm_event_connection */
 	IPA_LAN_TO_LAN_DEL_CONNECTION,            /* ipacm_event_connection */
@@ -235,6 +243,16 @@ typedef struct
 	enum nf_conntrack_msg_type type;
 }ipacm_ct_evt_data;
 
+#define IPA_CT_EVT_BATCH_MAX 64
+
+/* conntrack events coalesced by a receive thread, a NULL ct marks an
+   event cancelled by a later one on the same tuple */
+typedef struct
+{
+	int num;
+	ipacm_ct_evt_data evts[IPA_CT_EVT_BATCH_MAX];
+}ipacm_ct_evt_batch;
+
 typedef struct
 {
 	char iface_name[IPA_IFACE_NAME_LEN];
@@ -45,16 +45,19 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Defs.h"
 #include "IPACM_Listener.h"
 
-/* queue */
-typedef struct _cmd_evts
+/* listeners of one event, replaced as a whole on every change so a
+	 dispatch in progress keeps walking the copy it started with */
+typedef struct _evt_listeners
 {
-	ipa_cm_event_id event;
-	IPACM_Listener *obj;
-	//int ipa_interface_index;
-	_cmd_evts *next;
-}  cmd_evts;
-
+	int num;
+	IPACM_Listener *obj[1];
+}  evt_listeners;
 
+/* dispatch latency histogram: bucket n counts dispatches taking less than
+	 16us << 2n, the last bucket everything slower */
+#define IPACM_EVT_LAT_HIST_SIZE 8
+#define IPACM_EVT_LAT_BASE_US 16
+#define IPACM_EVT_STATS_DUMP_INTERVAL 1024
 
 class IPACM_EvtDispatcher
 {
@@ -69,8 +72,17 @@ public:
 	static int PostEvt(ipacm_cmd_q_data *);
 	static void ProcessEvt(ipacm_cmd_q_data *);
 
+	/* log per event dispatch counts and latency histograms */
+	static void DumpEvtStats(void);
+
 private:
-	static cmd_evts *head;
+	static evt_listeners *listeners[IPACM_EVENT_MAX];
+	/* list the running dispatch walks, and whether it was replaced meanwhile */
+	static evt_listeners *in_dispatch;
+	static bool in_dispatch_retired;
+
+	static int ReplaceListeners(ipa_cm_event_id event, evt_listeners *nw);
+	static bool IsRegistered(ipa_cm_event_id event, IPACM_Listener *obj);
 };
 
 #endif /* IPACM_EvtDispatcher_H */
@@ -46,6 +46,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Routing.h"
 #include "IPACM_Filtering.h"
 #include "IPACM_Header.h"
+#include "IPACM_RuleTxn.h"
 #include "IPACM_EvtDispatcher.h"
 #include "IPACM_Xml.h"
 #include "IPACM_Log.h"
@@ -49,6 +49,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Filtering.h"
 #include "IPACM_Config.h"
 #include "IPACM_Conntrack_NATApp.h"
+#include "IPACM_ClientDir.h"
 
 #define IPA_WAN_DEFAULT_FILTER_RULE_HANDLES  1
 #define IPA_PRIV_SUBNET_FILTER_RULE_HANDLES  3
@@ -94,6 +95,7 @@ typedef struct _ipa_eth_client
 	int ipv6_set;
 	bool ipv4_header_set;
 	bool ipv6_header_set;
+	uint32_t dir_hdl; /* client_dir handle, follows the entry when the array is compacted */
 	eth_client_rt_hdl eth_rt_hdl[0]; /* depends on number of tx properties */
 }ipa_eth_client;
 
@@ -149,9 +151,11 @@ public:
 	/* add header processing context and return handle to lan2lan controller */
 	int eth_bridge_add_hdr_proc_ctx(ipa_hdr_l2_type peer_l2_hdr_type, uint32_t *hdl);
 
-	/* add routing rule and return handle to lan2lan controller */
+	/* add routing rule and return handle to lan2lan controller,
+	   with txn the rules are queued and the handles written on txn->End() */
 	int eth_bridge_add_rt_rule(uint8_t *mac, char *rt_tbl_name, uint32_t hdr_proc_ctx_hdl,
-		ipa_hdr_l2_type peer_l2_hdr_type, ipa_ip_type iptype, uint32_t *rt_rule_hdl, int *rt_rule_count);
+		ipa_hdr_l2_type peer_l2_hdr_type, ipa_ip_type iptype, uint32_t *rt_rule_hdl, int *rt_rule_count,
+		IPACM_RuleTxn *txn = NULL);
 
 	/* modify routing rule*/
 	int eth_bridge_modify_rt_rule(uint8_t *mac, uint32_t hdr_proc_ctx_hdl,
@@ -272,6 +276,9 @@ protected:
 	bool is_downstream_set[IPA_IP_MAX];
 	_ipacm_offload_prefix prefix[IPA_IP_MAX];
 
+	/* MAC/IP lookup of the eth or wifi clients of this iface */
+	IPACM_ClientDir *client_dir;
+
 private:
 
 	/* get hdr proc ctx type given source and destination l2 hdr type */
@@ -316,32 +323,41 @@ private:
 	inline int get_eth_client_index(uint8_t *mac_addr)
 	{
 		int cnt;
-		int num_eth_client_tmp = num_eth_client;
 
 		IPACMDBG_H("Passed MAC %02x:%02x:%02x:%02x:%02x:%02x\n",
 						 mac_addr[0], mac_addr[1], mac_addr[2],
 						 mac_addr[3], mac_addr[4], mac_addr[5]);
 
-		for(cnt = 0; cnt < num_eth_client_tmp; cnt++)
+		if (client_dir == NULL)
 		{
-			IPACMDBG_H("stored MAC %02x:%02x:%02x:%02x:%02x:%02x\n",
-							 get_client_memptr(eth_client, cnt)->mac[0],
-							 get_client_memptr(eth_client, cnt)->mac[1],
-							 get_client_memptr(eth_client, cnt)->mac[2],
-							 get_client_memptr(eth_client, cnt)->mac[3],
-							 get_client_memptr(eth_client, cnt)->mac[4],
-							 get_client_memptr(eth_client, cnt)->mac[5]);
-
-			if(memcmp(get_client_memptr(eth_client, cnt)->mac,
-								mac_addr,
-								sizeof(get_client_memptr(eth_client, cnt)->mac)) == 0)
-			{
-				IPACMDBG_H("Matched client index: %d\n", cnt);
-				return cnt;
-			}
+			return IPACM_INVALID_INDEX;
 		}
 
-		return IPACM_INVALID_INDEX;
+		cnt = client_dir->FindMac(mac_addr);
+		if (cnt != IPACM_INVALID_INDEX)
+		{
+			IPACMDBG_H("Matched client index: %d\n", cnt);
+		}
+		return cnt;
+	}
+
+	/* client currently holding the address, IPACM_INVALID_INDEX if none */
+	inline int get_eth_client_index_v4(uint32_t v4_addr)
+	{
+		if (client_dir == NULL)
+		{
+			return IPACM_INVALID_INDEX;
+		}
+		return client_dir->FindV4(v4_addr);
+	}
+
+	inline int get_eth_client_index_v6(uint32_t *v6_addr)
+	{
+		if (client_dir == NULL)
+		{
+			return IPACM_INVALID_INDEX;
+		}
+		return client_dir->FindV6(v6_addr);
 	}
 
 	inline int delete_eth_rtrules(int clt_indx, ipa_ip_type iptype)
@@ -413,6 +429,9 @@ private:
 	/* handle eth client ip-address */
 	int handle_eth_client_ipaddr(ipacm_event_data_all *data);
 
+	/* take an address that moved to another client away from the client holding owner_hdl */
+	int release_eth_client_ipaddr(uint32_t owner_hdl, ipacm_event_data_all *data);
+
 	/* handle eth client routing rule*/
 	int handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptype);
 
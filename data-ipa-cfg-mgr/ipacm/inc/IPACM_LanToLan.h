@@ -42,6 +42,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Iface.h"
 #include "IPACM_Defs.h"
 #include "IPACM_Lan.h"
+#include "IPACM_RuleTxn.h"
 
 #ifdef FEATURE_IPA_ANDROID
 #include <libxml/list.h>
@@ -50,6 +51,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif /* ndefined(FEATURE_IPA_ANDROID)*/
 
 #define MAX_NUM_CACHED_CLIENT_ADD_EVENT 10
+/* interface and client slots are tracked in 32 bit adjacency bitmaps */
 #define MAX_NUM_IFACE 10
 #define MAX_NUM_CLIENT 16
 
@@ -97,6 +99,7 @@ struct l2tp_rt_rule_info
 struct client_info
 {
 	uint8_t mac_addr[6];
+	int client_idx;		/* slot in the owner interface client bitmap */
 	rt_rule_info inter_iface_rt_rule_hdl[IPA_HDR_L2_MAX];	/* routing rule handles of inter interface communication based on source l2 header type */
 	rt_rule_info intra_iface_rt_rule_hdl;	/* routing rule handles of inter interface communication */
 	bool is_l2tp_client;
@@ -117,16 +120,17 @@ struct peer_iface_info
 	class IPACM_LanToLan_Iface *peer;
 	char rt_tbl_name_for_rt[IPA_IP_MAX][IPA_RESOURCE_NAME_MAX];
 	char rt_tbl_name_for_flt[IPA_IP_MAX][IPA_RESOURCE_NAME_MAX];
-	list<flt_rule_info> flt_rule;
+	uint32_t flt_rule_bitmap;	/* peer clients with flt rules on this interface */
+	flt_rule_info flt_rule[MAX_NUM_CLIENT];	/* indexed by client_idx of the peer client */
 };
 
 class IPACM_LanToLan_Iface
 {
 public:
-	IPACM_LanToLan_Iface(IPACM_Lan *p_iface);
+	IPACM_LanToLan_Iface(IPACM_Lan *p_iface, int iface_idx);
 	~IPACM_LanToLan_Iface();
 
-	void add_client_rt_rule_for_new_iface();
+	void add_client_rt_rule_for_new_iface(IPACM_LanToLan_Iface *new_iface, IPACM_RuleTxn *txn);
 
 	void add_all_inter_interface_client_flt_rule(ipa_ip_type iptype);
 
@@ -149,6 +153,8 @@ public:
 
 	IPACM_Lan* get_iface_pointer();
 
+	int get_iface_idx();
+
 	bool get_m_is_ip_addr_assigned(ipa_ip_type iptype);
 
 	void set_m_is_ip_addr_assigned(ipa_ip_type iptype, bool value);
@@ -184,8 +190,15 @@ private:
 	uint32_t hdr_proc_ctx_for_intra_interface;
 	uint32_t hdr_proc_ctx_for_l2tp;		/* uc needs to remove 62 bytes IPv6 + L2TP + inner Ethernet header */
 
+	int m_iface_idx;	/* slot in the lan2lan controller interface bitmap */
+
 	list<client_info> m_client_info;	/* client list */
-	list<peer_iface_info> m_peer_iface_info;	/* peer information list */
+	uint32_t m_client_bitmap;	/* client_idx in use */
+
+	/* Peer interfaces indexed by their interface slot. Rules to add or remove
+	   for a client event are the bits set here, no list has to be searched. */
+	uint32_t m_peer_bitmap;
+	peer_iface_info m_peer_iface_info[MAX_NUM_IFACE];
 
 	/* The following members are for intra-interface communication*/
 	peer_iface_info m_intra_interface_info;
@@ -194,19 +207,19 @@ private:
 
 	void add_client_flt_rule(peer_iface_info *peer, client_info *client, ipa_ip_type iptype);
 
-	void del_one_client_flt_rule(IPACM_LanToLan_Iface *peer_iface, client_info *client);
+	void del_one_client_flt_rule(IPACM_LanToLan_Iface *peer_iface, client_info *client, IPACM_RuleTxn *txn);
 
-	void del_client_flt_rule(peer_iface_info *peer, client_info *client);
+	void del_client_flt_rule(peer_iface_info *peer, client_info *client, IPACM_RuleTxn *txn);
 
-	void add_client_rt_rule(peer_iface_info *peer, client_info *client);
+	void add_client_rt_rule(peer_iface_info *peer, client_info *client, IPACM_RuleTxn *txn);
 
-	void del_client_rt_rule(peer_iface_info *peer, client_info *client);
+	void del_client_rt_rule(peer_iface_info *peer, client_info *client, IPACM_RuleTxn *txn);
 
 	void add_l2tp_client_rt_rule(peer_iface_info *peer, client_info *client);
 
-	void clear_all_flt_rule_for_one_peer_iface(peer_iface_info *peer);
+	void clear_all_flt_rule_for_one_peer_iface(peer_iface_info *peer, IPACM_RuleTxn *txn);
 
-	void clear_all_rt_rule_for_one_peer_iface(peer_iface_info *peer);
+	void clear_all_rt_rule_for_one_peer_iface(peer_iface_info *peer, IPACM_RuleTxn *txn);
 
 	void add_hdr_proc_ctx(ipa_hdr_l2_type peer_l2_type);
 
@@ -237,6 +250,8 @@ private:
 
 	list<class IPACM_LanToLan_Iface> m_iface;
 
+	uint32_t m_iface_bitmap;	/* interface slots in use */
+
 	list<ipacm_event_eth_bridge> m_cached_client_add_event;
 
 	list<vlan_iface_info> m_vlan_iface;
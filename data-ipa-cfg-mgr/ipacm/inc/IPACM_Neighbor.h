@@ -47,8 +47,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Filtering.h"
 #include "IPACM_Listener.h"
 #include "IPACM_Iface.h"
-
-#define IPA_MAX_NUM_NEIGHBOR_CLIENTS  100
+#include "IPACM_ClientDir.h"
 
 struct ipa_neighbor_client
 {
@@ -74,9 +73,16 @@ private:
 
 	int num_neighbor_client;
 
+	int max_neighbor_client;
+
 	int circular_index;
 
-	ipa_neighbor_client neighbor_client[IPA_MAX_NUM_NEIGHBOR_CLIENTS];
+	ipa_neighbor_client *neighbor_client;
+
+	/* finds the cached neighbor_client entry by MAC */
+	IPACM_ClientDir *client_dir;
+
+	void del_neighbor_client(int index);
 
 };
 
@@ -142,6 +142,7 @@ typedef struct ipa_nl_proto_info_s {
 typedef struct
 {
 	struct ifinfomsg  metainfo;                   /* from header */
+	char              if_name[IF_NAME_LEN];       /* IFLA_IFNAME, empty if absent */
 } ipa_nl_link_info_t;
 
 
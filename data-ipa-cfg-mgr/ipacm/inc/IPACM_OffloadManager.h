@@ -94,6 +94,9 @@ public:
 
 	bool search_framwork_cache(char * interface_name);
 
+	/* data limit hit, upstream NULL when the kernel reports it */
+	void notifyLimitReached(const char *upstream);
+
 private:
 
 	std::list<std::string> valid_ifaces;
@@ -110,7 +113,7 @@ private:
 
 	int resetTetherStats(const char *upstream_name);
 
-	static const char *DEVICE_NAME;
+	static void limit_reached_cb(const char *upstream);
 
 	/* cache the add_downstream events if netdev is not ready */
 	framework_event_cache event_cache[MAX_EVENT_CACHE];
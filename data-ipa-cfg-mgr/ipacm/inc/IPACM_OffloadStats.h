@@ -0,0 +1,149 @@
+/*
+Copyright (c) 2018, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_OffloadStats.h
+
+	@brief
+	This file implements the tethering offload statistics definitions
+
+	@Author
+
+*/
+#ifndef IPACM_OFFLOADSTATS_H
+#define IPACM_OFFLOADSTATS_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <net/if.h>
+#include <IPACM_Defs.h>
+
+/* upstreams tracked at the same time, LTE/STA switches keep the old one around */
+#define IPACM_OFFLOAD_STATS_MAX_UPSTREAM 4
+
+typedef struct
+{
+	bool valid;
+	bool active;              /* sampled by the thread */
+	bool sample_err;
+	char name[IFNAMSIZ];
+	uint64_t rx_total;        /* monotonic since the upstream is tracked */
+	uint64_t tx_total;
+	uint64_t rx_reported;     /* part of the totals already handed to the framework */
+	uint64_t tx_reported;
+	bool quota_set;
+	bool quota_reached;
+	bool kernel_quota;        /* the wwan quota ioctl was last armed on this upstream */
+	uint32_t quota_seq;       /* bumped when the quota base moves */
+	uint64_t quota_bytes;
+	uint64_t quota_base;      /* rx + tx totals when the quota was set */
+	uint64_t last_sample_ms;
+	uint64_t last_use_ms;
+} ipacm_offload_stats_entry;
+
+typedef void (*ipacm_offload_limit_cb)(const char *upstream);
+
+/* Tethering stats engine: keeps the wwan ioctl device open, samples the
+   tracked upstreams on a fixed period into monotonic totals and answers
+   the framework from those totals. The data quota is also checked against
+   the sampled totals, the kernel quota stays armed as well. */
+class IPACM_OffloadStats
+{
+public:
+
+	static IPACM_OffloadStats* GetInstance();
+
+	/* persistent wwan ioctl fd, reopened on demand, -1 on failure */
+	int GetFd(void);
+
+	void SetLimitCb(ipacm_offload_limit_cb cb);
+
+	/* bytes not reported yet; reset marks them as reported */
+	int Query(const char *upstream, bool reset, uint64_t *rx, uint64_t *tx);
+
+	/* arm the cached quota check after the kernel quota is set */
+	int SetQuota(const char *upstream, uint64_t limit);
+
+	/* fold the unsampled bytes into the totals, then reset the counters */
+	int Reset(const char *upstream);
+
+	/* returns false if the limit was already reported to the framework,
+	   NULL is the kernel quota and marks the upstream it was armed on */
+	bool MarkQuotaReached(const char *upstream);
+
+	/* stop sampling and drop the quotas, the totals stay for the next query */
+	void Suspend(void);
+
+private:
+
+	IPACM_OffloadStats();
+
+	static IPACM_OffloadStats *pInstance;
+
+	static const char *DEVICE_NAME;
+
+	int fd;
+
+	int interval_ms;
+
+	bool thread_started;
+
+	ipacm_offload_limit_cb limit_cb;
+
+	pthread_mutex_t lock;
+
+	pthread_cond_t cond;
+
+	int num_active;
+
+	ipacm_offload_stats_entry upstream_tbl[IPACM_OFFLOAD_STATS_MAX_UPSTREAM];
+
+	static void* SampleThread(void *arg);
+
+	static uint64_t NowMs(void);
+
+	int StartLocked(void);
+
+	int FdLocked(void);
+
+	ipacm_offload_stats_entry* FindLocked(const char *upstream, bool add);
+
+	void ActivateLocked(ipacm_offload_stats_entry *entry, uint64_t now);
+
+	/* reads and resets the kernel counters, no table access so no lock needed */
+	static int ReadCounters(int fd, const char *upstream, uint64_t *rx, uint64_t *tx);
+
+	int FoldLocked(ipacm_offload_stats_entry *entry, int err, uint64_t rx, uint64_t tx, uint64_t now);
+
+	int SampleLocked(ipacm_offload_stats_entry *entry, uint64_t now);
+
+	bool CheckQuotaLocked(ipacm_offload_stats_entry *entry);
+};
+
+#endif /* IPACM_OFFLOADSTATS_H */
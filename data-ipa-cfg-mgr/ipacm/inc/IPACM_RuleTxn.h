@@ -0,0 +1,166 @@
+/*
+Copyright (c) 2018, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_RuleTxn.h
+
+	@brief
+	This file implements the IPACM rule transaction definitions
+
+	@Author
+
+*/
+#ifndef IPACM_RULETXN_H
+#define IPACM_RULETXN_H
+
+#include <stdint.h>
+#include <linux/msm_ipa.h>
+#include <IPACM_Defs.h>
+#include "IPACM_Filtering.h"
+#include "IPACM_Routing.h"
+#include "IPACM_Header.h"
+
+/* operations of one kind held before they are pushed to the driver */
+#define IPACM_TXN_MAX_OPS 64
+
+typedef struct
+{
+	enum ipa_ip_type ip;
+	char rt_tbl_name[IPA_RESOURCE_NAME_MAX];
+	struct ipa_rt_rule_add rule;
+	uint32_t *hdl;
+} ipacm_txn_rt_add;
+
+typedef struct
+{
+	enum ipa_ip_type ip;
+	struct ipa_rt_rule_mdfy rule;
+} ipacm_txn_rt_mdfy;
+
+typedef struct
+{
+	enum ipa_ip_type ip;
+	enum ipa_client_type ep;
+	uint8_t global;
+	struct ipa_flt_rule_add rule;
+	uint32_t *hdl;
+} ipacm_txn_flt_add;
+
+typedef struct
+{
+	struct ipa_hdr_add hdr;
+	uint32_t *hdl;
+} ipacm_txn_hdr_add;
+
+typedef struct
+{
+	enum ipa_ip_type ip;
+	uint32_t hdl;
+} ipacm_txn_del;
+
+typedef struct
+{
+	uint32_t ops;
+	uint32_t ioctls;
+	uint32_t commits;
+} ipacm_txn_stats;
+
+/* Collects filtering, routing and header changes and pushes them with one
+	 ioctl per table and kind, then commits each touched block once per IP
+	 family. Handles of added rules are written to the caller's pointers when
+	 the adds reach the driver, so a rule can not reference a header or rule
+	 added in the same transaction: call End() first. */
+class IPACM_RuleTxn
+{
+public:
+	IPACM_RuleTxn(IPACM_Filtering *filtering, IPACM_Routing *routing, IPACM_Header *header);
+	~IPACM_RuleTxn();
+
+	bool AddRoutingRule(enum ipa_ip_type ip, const char *rt_tbl_name,
+											struct ipa_rt_rule_add const *rule, uint32_t *hdl);
+	bool ModifyRoutingRule(enum ipa_ip_type ip, struct ipa_rt_rule_mdfy const *rule);
+	bool DeleteRoutingHdl(uint32_t hdl, enum ipa_ip_type ip);
+
+	bool AddFilteringRule(enum ipa_ip_type ip, enum ipa_client_type ep, uint8_t global,
+												struct ipa_flt_rule_add const *rule, uint32_t *hdl);
+	bool DeleteFilteringHdl(uint32_t hdl, enum ipa_ip_type ip);
+
+	bool AddHeader(struct ipa_hdr_add const *hdr, uint32_t *hdl);
+	bool DeleteHeaderHdl(uint32_t hdl);
+
+	/* push pending operations, commit and report; the transaction can be reused */
+	bool End();
+
+	static void GetStats(ipacm_txn_stats *stats);
+
+private:
+	IPACM_Filtering *m_filtering;
+	IPACM_Routing *m_routing;
+	IPACM_Header *m_header;
+
+	ipacm_txn_rt_add *rt_add;
+	ipacm_txn_rt_mdfy *rt_mdfy;
+	ipacm_txn_del *rt_del;
+	ipacm_txn_flt_add *flt_add;
+	ipacm_txn_del *flt_del;
+	ipacm_txn_hdr_add *hdr_add;
+	ipacm_txn_del *hdr_del;
+	int num_rt_add, num_rt_mdfy, num_rt_del;
+	int num_flt_add, num_flt_del;
+	int num_hdr_add, num_hdr_del;
+
+	/* what the transaction touched, for End() */
+	bool rt_dirty[IPA_IP_MAX];
+	bool flt_dirty[IPA_IP_MAX];
+	bool hdr_dirty;
+	bool failed;
+	ipacm_txn_stats cur;
+
+	/* set while End() flushes: the last routing add of a family that has
+		 nothing else pending carries the commit instead of a Commit() ioctl */
+	bool ending;
+	bool rt_committed[IPA_IP_MAX];
+
+	/* totals over all transactions: ops and the ioctls/commits they took */
+	static ipacm_txn_stats total;
+
+	bool Flush();
+	bool FlushRtAdd();
+	bool RtAddIsLast(int first, const uint8_t *grouped);
+	bool FlushRtMdfy();
+	bool FlushRtDel();
+	bool FlushFltAdd();
+	bool FlushFltDel();
+	bool FlushHdrAdd();
+	bool FlushHdrDel();
+	void Rollback(int rt_done, int flt_done, int hdr_done);
+	void *Slot(void **ops, int *num, size_t size);
+};
+
+#endif /* IPACM_RULETXN_H */
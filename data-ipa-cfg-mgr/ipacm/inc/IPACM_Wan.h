@@ -520,6 +520,9 @@ private:
 
 	int del_dft_firewall_rules(ipa_ip_type iptype);
 
+	/* compare the reloaded firewall xml with the installed rules */
+	void check_firewall_change(bool *v4_changed, bool *v6_changed);
+
 	int handle_down_evt();
 
 	/*handle wan-iface down event */
@@ -71,6 +71,7 @@ typedef struct _ipa_wlan_client
 	bool ipv4_header_set;
 	bool ipv6_header_set;
 	bool power_save_set;
+	uint32_t dir_hdl; /* client_dir handle, follows the entry when the array is compacted */
 	wlan_client_rt_hdl wifi_rt_hdl[0]; /* depends on number of tx properties */
 }ipa_wlan_client;
 
@@ -118,32 +119,41 @@ private:
 	inline int get_wlan_client_index(uint8_t *mac_addr)
 	{
 		int cnt;
-		int num_wifi_client_tmp = num_wifi_client;
 
 		IPACMDBG_H("Passed MAC %02x:%02x:%02x:%02x:%02x:%02x\n",
 						 mac_addr[0], mac_addr[1], mac_addr[2],
 						 mac_addr[3], mac_addr[4], mac_addr[5]);
 
-		for(cnt = 0; cnt < num_wifi_client_tmp; cnt++)
+		if (client_dir == NULL)
 		{
-			IPACMDBG_H("stored MAC %02x:%02x:%02x:%02x:%02x:%02x\n",
-							 get_client_memptr(wlan_client, cnt)->mac[0],
-							 get_client_memptr(wlan_client, cnt)->mac[1],
-							 get_client_memptr(wlan_client, cnt)->mac[2],
-							 get_client_memptr(wlan_client, cnt)->mac[3],
-							 get_client_memptr(wlan_client, cnt)->mac[4],
-							 get_client_memptr(wlan_client, cnt)->mac[5]);
-
-			if(memcmp(get_client_memptr(wlan_client, cnt)->mac,
-								mac_addr,
-								sizeof(get_client_memptr(wlan_client, cnt)->mac)) == 0)
-			{
-				IPACMDBG_H("Matched client index: %d\n", cnt);
-				return cnt;
-			}
+			return IPACM_INVALID_INDEX;
 		}
 
-		return IPACM_INVALID_INDEX;
+		cnt = client_dir->FindMac(mac_addr);
+		if (cnt != IPACM_INVALID_INDEX)
+		{
+			IPACMDBG_H("Matched client index: %d\n", cnt);
+		}
+		return cnt;
+	}
+
+	/* client currently holding the address, IPACM_INVALID_INDEX if none */
+	inline int get_wlan_client_index_v4(uint32_t v4_addr)
+	{
+		if (client_dir == NULL)
+		{
+			return IPACM_INVALID_INDEX;
+		}
+		return client_dir->FindV4(v4_addr);
+	}
+
+	inline int get_wlan_client_index_v6(uint32_t *v6_addr)
+	{
+		if (client_dir == NULL)
+		{
+			return IPACM_INVALID_INDEX;
+		}
+		return client_dir->FindV6(v6_addr);
 	}
 
 	inline int delete_default_qos_rtrules(int clt_indx, ipa_ip_type iptype)
@@ -217,6 +227,9 @@ private:
 	/*handle wifi client */
 	int handle_wlan_client_ipaddr(ipacm_event_data_all *data);
 
+	/* take an address that moved to another client away from the client holding owner_hdl */
+	int release_wlan_client_ipaddr(uint32_t owner_hdl, ipacm_event_data_all *data);
+
 	/*handle wifi client routing rule*/
 	int handle_wlan_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptype);
 
@@ -64,6 +64,18 @@ if (!(a)) {                                                 \
   
 /* Max allowed size of the XML file (2 MB) */
 #define IPACM_XML_MAX_FILESIZE               (2 << 20)
+
+/* Parsed XML configs are cached as binary snapshots keyed on the source
+   file hash, bump the version whenever a config struct changes layout */
+#ifdef FEATURE_IPA_ANDROID
+#define IPACM_XML_SNAPSHOT_DIR               "/data/vendor/ipa"
+#else
+#define IPACM_XML_SNAPSHOT_DIR               "/etc"
+#endif
+#define IPACM_XML_SNAPSHOT_MAGIC             0x50414E53 /* "SNAP" */
+#define IPACM_XML_SNAPSHOT_VERSION           1
+#define IPACM_XML_SNAPSHOT_CFG               1
+#define IPACM_XML_SNAPSHOT_FIREWALL          2
 #define IPACM_MAX_FIREWALL_ENTRIES            50
 #define IPACM_IPV6_ADDR_LEN                   16
 
@@ -178,6 +190,14 @@ if (!(a)) {                                                 \
 #define IPACMNat_TAG                         "IPACMNAT"
 #define NAT_MaxEntries_TAG                   "MaxNatEntries"
 
+#define IPACMClients_TAG                     "IPACMClients"
+#define MaxWlanClients_TAG                   "MaxWlanClients"
+#define MaxEthClients_TAG                    "MaxEthClients"
+#define MaxNeighborClients_TAG               "MaxNeighborClients"
+
+#define IPACMOffload_TAG                     "IPACMOffload"
+#define StatsIntervalMs_TAG                  "StatsIntervalMs"
+
 #define IP_PassthroughFlag_TAG               "IPPassthroughFlag"
 #define IP_PassthroughMode_TAG               "IPPassthroughMode"
 
@@ -275,6 +295,10 @@ typedef struct  _IPACM_conf_t
 	ipacm_private_subnet_conf_t private_subnet_config;
 	ipacm_alg_conf_t alg_config;
 	int nat_max_entries;
+	int max_wlan_clients;                        /* 0: not configured */
+	int max_eth_clients;
+	int max_neighbor_clients;
+	int offload_stats_interval_ms;               /* 0: not configured */
 	bool odu_enable;
 	bool router_mode_enable;
 	bool odu_embms_enable;
@@ -296,6 +320,14 @@ int IPACM_read_firewall_xml
 	IPACM_firewall_conf_t *config                   /* Mobile AP config data */
 );
 
+/* true if both configs install the same firewall rules for ip_vsn */
+bool IPACM_firewall_rules_equal
+(
+	const IPACM_firewall_conf_t *old_config,
+	const IPACM_firewall_conf_t *new_config,
+	firewall_ip_version_enum ip_vsn
+);
+
 #ifdef __cplusplus
 }
 #endif
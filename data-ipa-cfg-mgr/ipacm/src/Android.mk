@@ -50,6 +50,8 @@ LOCAL_SRC_FILES := IPACM_Main.cpp \
 		IPACM_Filtering.cpp \
 		IPACM_Routing.cpp \
 		IPACM_Header.cpp \
+		IPACM_RuleTxn.cpp \
+		IPACM_ClientDir.cpp \
 		IPACM_Lan.cpp \
 		IPACM_Iface.cpp \
 		IPACM_Wlan.cpp \
@@ -62,7 +64,8 @@ LOCAL_SRC_FILES := IPACM_Main.cpp \
 		IPACM_ConntrackClient.cpp \
 		IPACM_ConntrackListener.cpp \
 		IPACM_Log.cpp \
-		IPACM_OffloadManager.cpp
+		IPACM_OffloadManager.cpp \
+		IPACM_OffloadStats.cpp
 
 LOCAL_MODULE := ipacm
 LOCAL_CLANG := false
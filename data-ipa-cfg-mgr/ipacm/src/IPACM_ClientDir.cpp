@@ -0,0 +1,556 @@
+/*
+Copyright (c) 2018, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_ClientDir.cpp
+
+	@brief
+	This file implements the IPACM client directory functionality.
+
+	@Author
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "IPACM_ClientDir.h"
+#include <IPACM_Log.h>
+
+#define IPACM_CLIENT_DIR_NIL (-1)
+
+/* handle = generation << 16 | (slot + 1), never IPACM_CLIENT_HDL_INVALID */
+#define CLIENT_DIR_HDL(gen, slot) (((uint32_t)(gen) << 16) | (uint32_t)((slot) + 1))
+#define CLIENT_DIR_HDL_SLOT(hdl) ((int)((hdl) & 0xFFFF) - 1)
+#define CLIENT_DIR_HDL_GEN(hdl) ((uint16_t)((hdl) >> 16))
+
+IPACM_ClientDir::IPACM_ClientDir(int max)
+{
+	int num_buckets;
+
+	if (max < 1)
+	{
+		max = 1;
+	}
+	if (max > IPACM_CLIENT_DIR_MAX)
+	{
+		IPACMERR("client directory size %d too large, use %d\n", max, IPACM_CLIENT_DIR_MAX);
+		max = IPACM_CLIENT_DIR_MAX;
+	}
+	max_clients = max;
+	num_clients = 0;
+	free_head = IPACM_CLIENT_DIR_NIL;
+
+	/* keep the chains short: at least two buckets per client */
+	hash_bits = 1;
+	while ((1 << hash_bits) < 2 * max_clients)
+	{
+		hash_bits++;
+	}
+	num_buckets = 1 << hash_bits;
+
+	entries = (ipacm_client_dir_entry *)calloc(max_clients, sizeof(ipacm_client_dir_entry));
+	mac_bucket = (int *)malloc(num_buckets * sizeof(int));
+	v4_bucket = (int *)malloc(num_buckets * sizeof(int));
+	v6_bucket = (int *)malloc(num_buckets * sizeof(int));
+	slot_idx = (int *)malloc(max_clients * sizeof(int));
+	if (entries == NULL || mac_bucket == NULL || v4_bucket == NULL || v6_bucket == NULL || slot_idx == NULL)
+	{
+		IPACMERR("unable to allocate client directory of %d clients\n", max_clients);
+		free(entries);
+		free(mac_bucket);
+		free(v4_bucket);
+		free(v6_bucket);
+		free(slot_idx);
+		entries = NULL;
+		mac_bucket = v4_bucket = v6_bucket = NULL;
+		slot_idx = NULL;
+		max_clients = 0;
+		return;
+	}
+
+	Clear();
+	IPACMDBG_H("client directory: %d clients, %d buckets\n", max_clients, num_buckets);
+	return;
+}
+
+IPACM_ClientDir::~IPACM_ClientDir()
+{
+	free(entries);
+	free(mac_bucket);
+	free(v4_bucket);
+	free(v6_bucket);
+	free(slot_idx);
+}
+
+void IPACM_ClientDir::Clear(void)
+{
+	int i;
+
+	if (entries == NULL)
+	{
+		return;
+	}
+
+	for (i = 0; i < (1 << hash_bits); i++)
+	{
+		mac_bucket[i] = IPACM_CLIENT_DIR_NIL;
+		v4_bucket[i] = IPACM_CLIENT_DIR_NIL;
+		v6_bucket[i] = IPACM_CLIENT_DIR_NIL;
+	}
+
+	/* keep the generations so handles given out before stay stale */
+	free_head = IPACM_CLIENT_DIR_NIL;
+	for (i = max_clients - 1; i >= 0; i--)
+	{
+		if (entries[i].in_use)
+		{
+			entries[i].gen++;
+			entries[i].in_use = false;
+		}
+		slot_idx[i] = IPACM_CLIENT_DIR_NIL;
+		entries[i].next_mac = free_head;
+		free_head = i;
+	}
+	num_clients = 0;
+	return;
+}
+
+uint32_t IPACM_ClientDir::HashMac(const uint8_t *mac)
+{
+	uint32_t key;
+
+	/* the NIC specific octets carry most of the entropy */
+	key = ((uint32_t)mac[2] << 24 | (uint32_t)mac[3] << 16 | (uint32_t)mac[4] << 8 | mac[5]) ^
+		((uint32_t)mac[0] << 8 | mac[1]);
+	return (key * 0x9E3779B1) >> (32 - hash_bits);
+}
+
+uint32_t IPACM_ClientDir::HashV4(uint32_t v4_addr)
+{
+	return (v4_addr * 0x9E3779B1) >> (32 - hash_bits);
+}
+
+uint32_t IPACM_ClientDir::HashV6(const uint32_t *v6_addr)
+{
+	return ((v6_addr[0] ^ v6_addr[1] ^ v6_addr[2] ^ v6_addr[3]) * 0x9E3779B1) >> (32 - hash_bits);
+}
+
+int IPACM_ClientDir::FindSlot(const uint8_t *mac)
+{
+	int slot;
+
+	if (entries == NULL)
+	{
+		return IPACM_CLIENT_DIR_NIL;
+	}
+
+	for (slot = mac_bucket[HashMac(mac)]; slot != IPACM_CLIENT_DIR_NIL; slot = entries[slot].next_mac)
+	{
+		if (memcmp(entries[slot].mac, mac, sizeof(entries[slot].mac)) == 0)
+		{
+			break;
+		}
+	}
+	return slot;
+}
+
+int IPACM_ClientDir::FindV6Node(const uint32_t *v6_addr)
+{
+	int node;
+
+	if (entries == NULL)
+	{
+		return IPACM_CLIENT_DIR_NIL;
+	}
+
+	for (node = v6_bucket[HashV6(v6_addr)]; node != IPACM_CLIENT_DIR_NIL;
+		node = entries[node / IPACM_CLIENT_DIR_NUM_V6].next_v6[node % IPACM_CLIENT_DIR_NUM_V6])
+	{
+		if (memcmp(entries[node / IPACM_CLIENT_DIR_NUM_V6].v6_addr[node % IPACM_CLIENT_DIR_NUM_V6],
+			v6_addr, sizeof(entries[0].v6_addr[0])) == 0)
+		{
+			break;
+		}
+	}
+	return node;
+}
+
+void IPACM_ClientDir::LinkV4(int slot)
+{
+	uint32_t bucket = HashV4(entries[slot].v4_addr);
+
+	entries[slot].next_v4 = v4_bucket[bucket];
+	v4_bucket[bucket] = slot;
+}
+
+void IPACM_ClientDir::UnlinkV4(int slot)
+{
+	int *prev = &v4_bucket[HashV4(entries[slot].v4_addr)];
+
+	while (*prev != IPACM_CLIENT_DIR_NIL)
+	{
+		if (*prev == slot)
+		{
+			*prev = entries[slot].next_v4;
+			break;
+		}
+		prev = &entries[*prev].next_v4;
+	}
+	entries[slot].v4_addr = 0;
+}
+
+void IPACM_ClientDir::LinkV6(int node)
+{
+	ipacm_client_dir_entry *entry = &entries[node / IPACM_CLIENT_DIR_NUM_V6];
+	uint32_t bucket = HashV6(entry->v6_addr[node % IPACM_CLIENT_DIR_NUM_V6]);
+
+	entry->next_v6[node % IPACM_CLIENT_DIR_NUM_V6] = v6_bucket[bucket];
+	v6_bucket[bucket] = node;
+}
+
+void IPACM_ClientDir::UnlinkV6(int node)
+{
+	ipacm_client_dir_entry *entry = &entries[node / IPACM_CLIENT_DIR_NUM_V6];
+	int *prev = &v6_bucket[HashV6(entry->v6_addr[node % IPACM_CLIENT_DIR_NUM_V6])];
+
+	while (*prev != IPACM_CLIENT_DIR_NIL)
+	{
+		if (*prev == node)
+		{
+			*prev = entry->next_v6[node % IPACM_CLIENT_DIR_NUM_V6];
+			break;
+		}
+		prev = &entries[*prev / IPACM_CLIENT_DIR_NUM_V6].next_v6[*prev % IPACM_CLIENT_DIR_NUM_V6];
+	}
+}
+
+uint32_t IPACM_ClientDir::Add(const uint8_t *mac, int idx)
+{
+	int slot;
+	uint32_t bucket;
+
+	slot = FindSlot(mac);
+	if (slot != IPACM_CLIENT_DIR_NIL)
+	{
+		slot_idx[slot] = idx;
+		return CLIENT_DIR_HDL(entries[slot].gen, slot);
+	}
+
+	if (free_head == IPACM_CLIENT_DIR_NIL)
+	{
+		IPACMERR("client directory full (%d clients)\n", max_clients);
+		return IPACM_CLIENT_HDL_INVALID;
+	}
+
+	slot = free_head;
+	free_head = entries[slot].next_mac;
+
+	memcpy(entries[slot].mac, mac, sizeof(entries[slot].mac));
+	entries[slot].in_use = true;
+	slot_idx[slot] = idx;
+	entries[slot].v4_addr = 0;
+	entries[slot].num_v6 = 0;
+
+	bucket = HashMac(mac);
+	entries[slot].next_mac = mac_bucket[bucket];
+	mac_bucket[bucket] = slot;
+	num_clients++;
+
+	return CLIENT_DIR_HDL(entries[slot].gen, slot);
+}
+
+int IPACM_ClientDir::Remove(const uint8_t *mac)
+{
+	int slot, *prev;
+	int num_v6;
+
+	slot = FindSlot(mac);
+	if (slot == IPACM_CLIENT_DIR_NIL)
+	{
+		return IPACM_FAILURE;
+	}
+
+	prev = &mac_bucket[HashMac(mac)];
+	while (*prev != slot)
+	{
+		prev = &entries[*prev].next_mac;
+	}
+	*prev = entries[slot].next_mac;
+
+	if (entries[slot].v4_addr != 0)
+	{
+		UnlinkV4(slot);
+	}
+	for (num_v6 = 0; num_v6 < entries[slot].num_v6; num_v6++)
+	{
+		UnlinkV6(slot * IPACM_CLIENT_DIR_NUM_V6 + num_v6);
+	}
+	entries[slot].num_v6 = 0;
+
+	/* handles of this client are stale from now on */
+	entries[slot].gen++;
+	entries[slot].in_use = false;
+	slot_idx[slot] = IPACM_CLIENT_DIR_NIL;
+	entries[slot].next_mac = free_head;
+	free_head = slot;
+	num_clients--;
+
+	return IPACM_SUCCESS;
+}
+
+uint32_t IPACM_ClientDir::Lookup(const uint8_t *mac)
+{
+	int slot = FindSlot(mac);
+
+	if (slot == IPACM_CLIENT_DIR_NIL)
+	{
+		return IPACM_CLIENT_HDL_INVALID;
+	}
+	return CLIENT_DIR_HDL(entries[slot].gen, slot);
+}
+
+int IPACM_ClientDir::GetIndex(uint32_t hdl)
+{
+	int slot = CLIENT_DIR_HDL_SLOT(hdl);
+
+	if (slot < 0 || slot >= max_clients ||
+		entries[slot].in_use == false || entries[slot].gen != CLIENT_DIR_HDL_GEN(hdl))
+	{
+		return IPACM_INVALID_INDEX;
+	}
+	return slot_idx[slot];
+}
+
+int IPACM_ClientDir::FindMac(const uint8_t *mac)
+{
+	int slot = FindSlot(mac);
+
+	if (slot == IPACM_CLIENT_DIR_NIL)
+	{
+		return IPACM_INVALID_INDEX;
+	}
+	return slot_idx[slot];
+}
+
+int IPACM_ClientDir::FindV4(uint32_t v4_addr)
+{
+	int slot;
+
+	if (entries == NULL || v4_addr == 0)
+	{
+		return IPACM_INVALID_INDEX;
+	}
+
+	for (slot = v4_bucket[HashV4(v4_addr)]; slot != IPACM_CLIENT_DIR_NIL; slot = entries[slot].next_v4)
+	{
+		if (entries[slot].v4_addr == v4_addr)
+		{
+			return slot_idx[slot];
+		}
+	}
+	return IPACM_INVALID_INDEX;
+}
+
+int IPACM_ClientDir::FindV6(const uint32_t *v6_addr)
+{
+	int node = FindV6Node(v6_addr);
+
+	if (node == IPACM_CLIENT_DIR_NIL)
+	{
+		return IPACM_INVALID_INDEX;
+	}
+	return slot_idx[node / IPACM_CLIENT_DIR_NUM_V6];
+}
+
+int IPACM_ClientDir::SetIndex(const uint8_t *mac, int idx)
+{
+	int slot = FindSlot(mac);
+
+	if (slot == IPACM_CLIENT_DIR_NIL)
+	{
+		return IPACM_FAILURE;
+	}
+	slot_idx[slot] = idx;
+	return IPACM_SUCCESS;
+}
+
+void IPACM_ClientDir::ShiftDown(int idx)
+{
+	int slot;
+
+	for (slot = 0; slot < max_clients; slot++)
+	{
+		/* free slots hold IPACM_CLIENT_DIR_NIL */
+		slot_idx[slot] -= (slot_idx[slot] > idx);
+	}
+	return;
+}
+
+int IPACM_ClientDir::SetV4(const uint8_t *mac, uint32_t v4_addr)
+{
+	int slot, owner;
+
+	slot = FindSlot(mac);
+	if (slot == IPACM_CLIENT_DIR_NIL)
+	{
+		return IPACM_FAILURE;
+	}
+	if (entries[slot].v4_addr == v4_addr)
+	{
+		return IPACM_SUCCESS;
+	}
+
+	if (entries[slot].v4_addr != 0)
+	{
+		UnlinkV4(slot);
+	}
+	if (v4_addr == 0)
+	{
+		return IPACM_SUCCESS;
+	}
+
+	for (owner = v4_bucket[HashV4(v4_addr)]; owner != IPACM_CLIENT_DIR_NIL; owner = entries[owner].next_v4)
+	{
+		if (entries[owner].v4_addr == v4_addr)
+		{
+			IPACMDBG_H("ipv4 address 0x%x moved from client:%d to client:%d\n",
+				v4_addr, slot_idx[owner], slot_idx[slot]);
+			UnlinkV4(owner);
+			break;
+		}
+	}
+
+	entries[slot].v4_addr = v4_addr;
+	LinkV4(slot);
+	return IPACM_SUCCESS;
+}
+
+int IPACM_ClientDir::AddV6(const uint8_t *mac, const uint32_t *v6_addr)
+{
+	int slot, node;
+
+	slot = FindSlot(mac);
+	if (slot == IPACM_CLIENT_DIR_NIL)
+	{
+		return IPACM_FAILURE;
+	}
+
+	node = FindV6Node(v6_addr);
+	if (node != IPACM_CLIENT_DIR_NIL)
+	{
+		if (node / IPACM_CLIENT_DIR_NUM_V6 == slot)
+		{
+			return IPACM_SUCCESS;
+		}
+		IPACMDBG_H("ipv6 address 0x%x:%x:%x:%x moved from client:%d to client:%d\n",
+			v6_addr[0], v6_addr[1], v6_addr[2], v6_addr[3],
+			slot_idx[node / IPACM_CLIENT_DIR_NUM_V6], slot_idx[slot]);
+		DelV6(entries[node / IPACM_CLIENT_DIR_NUM_V6].mac, v6_addr);
+	}
+
+	if (entries[slot].num_v6 == IPACM_CLIENT_DIR_NUM_V6)
+	{
+		return IPACM_FAILURE;
+	}
+
+	node = slot * IPACM_CLIENT_DIR_NUM_V6 + entries[slot].num_v6;
+	memcpy(entries[slot].v6_addr[entries[slot].num_v6], v6_addr, sizeof(entries[slot].v6_addr[0]));
+	entries[slot].num_v6++;
+	LinkV6(node);
+	return IPACM_SUCCESS;
+}
+
+int IPACM_ClientDir::DelV6(const uint8_t *mac, const uint32_t *v6_addr)
+{
+	int slot, num_v6, found = IPACM_CLIENT_DIR_NIL;
+
+	slot = FindSlot(mac);
+	if (slot == IPACM_CLIENT_DIR_NIL)
+	{
+		return IPACM_FAILURE;
+	}
+
+	for (num_v6 = 0; num_v6 < entries[slot].num_v6; num_v6++)
+	{
+		if (memcmp(entries[slot].v6_addr[num_v6], v6_addr, sizeof(entries[slot].v6_addr[0])) == 0)
+		{
+			found = num_v6;
+		}
+		UnlinkV6(slot * IPACM_CLIENT_DIR_NUM_V6 + num_v6);
+	}
+	if (found == IPACM_CLIENT_DIR_NIL)
+	{
+		/* put the chains back as they were */
+		for (num_v6 = 0; num_v6 < entries[slot].num_v6; num_v6++)
+		{
+			LinkV6(slot * IPACM_CLIENT_DIR_NUM_V6 + num_v6);
+		}
+		return IPACM_FAILURE;
+	}
+
+	/* keep the addresses packed, same as the owner's v6_addr array */
+	entries[slot].num_v6--;
+	for (num_v6 = found; num_v6 < entries[slot].num_v6; num_v6++)
+	{
+		memcpy(entries[slot].v6_addr[num_v6], entries[slot].v6_addr[num_v6 + 1], sizeof(entries[slot].v6_addr[0]));
+	}
+	for (num_v6 = 0; num_v6 < entries[slot].num_v6; num_v6++)
+	{
+		LinkV6(slot * IPACM_CLIENT_DIR_NUM_V6 + num_v6);
+	}
+	return IPACM_SUCCESS;
+}
+
+int IPACM_ClientDir::ClearAddr(const uint8_t *mac, ipa_ip_type iptype)
+{
+	int slot, num_v6;
+
+	slot = FindSlot(mac);
+	if (slot == IPACM_CLIENT_DIR_NIL)
+	{
+		return IPACM_FAILURE;
+	}
+
+	if (iptype == IPA_IP_v4)
+	{
+		if (entries[slot].v4_addr != 0)
+		{
+			UnlinkV4(slot);
+		}
+	}
+	else
+	{
+		for (num_v6 = 0; num_v6 < entries[slot].num_v6; num_v6++)
+		{
+			UnlinkV6(slot * IPACM_CLIENT_DIR_NUM_V6 + num_v6);
+		}
+		entries[slot].num_v6 = 0;
+	}
+	return IPACM_SUCCESS;
+}
@@ -42,12 +42,34 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Log.h"
 #include "IPACM_Iface.h"
 
-pthread_mutex_t mutex    = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t  cond_var = PTHREAD_COND_INITIALIZER;
+pthread_mutex_t MessageQueue::wait_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t  MessageQueue::wait_cond = PTHREAD_COND_INITIALIZER;
+bool MessageQueue::waiting = false;
 
+Message MessageQueue::pool[IPACM_MSG_POOL_SIZE];
+Message* MessageQueue::pool_free = NULL;
+bool MessageQueue::pool_ready = false;
+pthread_mutex_t MessageQueue::pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+MessageQueue* MessageQueue::inst_priority = NULL;
 MessageQueue* MessageQueue::inst_internal = NULL;
 MessageQueue* MessageQueue::inst_external = NULL;
 
+MessageQueue* MessageQueue::getInstancePriority()
+{
+	if(inst_priority == NULL)
+	{
+		inst_priority = new MessageQueue();
+		if(inst_priority == NULL)
+		{
+			IPACMERR("unable to create priority Message Queue instance\n");
+			return NULL;
+		}
+	}
+
+	return inst_priority;
+}
+
 MessageQueue* MessageQueue::getInstanceInternal()
 {
 	if(inst_internal == NULL)
@@ -78,8 +100,82 @@ MessageQueue* MessageQueue::getInstanceExternal()
 	return inst_external;
 }
 
+Message* MessageQueue::allocMessage(void)
+{
+	Message *item = NULL;
+	int cnt;
+
+	if(pthread_mutex_lock(&pool_lock) != 0)
+	{
+		IPACMERR("unable to lock the mutex\n");
+		return NULL;
+	}
+
+	if(!pool_ready)
+	{
+		for(cnt = 0; cnt < IPACM_MSG_POOL_SIZE - 1; cnt++)
+		{
+			pool[cnt].setnext(&pool[cnt + 1]);
+		}
+		pool[IPACM_MSG_POOL_SIZE - 1].setnext(NULL);
+		pool_free = &pool[0];
+		pool_ready = true;
+	}
+
+	if(pool_free != NULL)
+	{
+		item = pool_free;
+		pool_free = item->getnext();
+	}
+
+	if(pthread_mutex_unlock(&pool_lock) != 0)
+	{
+		IPACMERR("unable to unlock the mutex\n");
+	}
+
+	if(item == NULL)
+	{
+		IPACMDBG("Message pool exhausted\n");
+		return new Message();
+	}
+
+	item->setnext(NULL);
+	item->evt.callback_ptr = NULL;
+	return item;
+}
+
+void MessageQueue::freeMessage(Message *item)
+{
+	if(item < &pool[0] || item >= &pool[IPACM_MSG_POOL_SIZE])
+	{
+		delete item;
+		return;
+	}
+
+	if(pthread_mutex_lock(&pool_lock) != 0)
+	{
+		IPACMERR("unable to lock the mutex\n");
+		return;
+	}
+
+	item->setnext(pool_free);
+	pool_free = item;
+
+	if(pthread_mutex_unlock(&pool_lock) != 0)
+	{
+		IPACMERR("unable to unlock the mutex\n");
+	}
+}
+
 void MessageQueue::enqueue(Message *item)
 {
+	if(pthread_mutex_lock(&q_lock) != 0)
+	{
+		IPACMERR("unable to lock the mutex\n");
+		return;
+	}
+
+	item->setnext(NULL);
 	if(!Head)
 	{
 		Tail = item;
@@ -87,46 +183,157 @@ void MessageQueue::enqueue(Message *item)
 	}
 	else
 	{
-		if(Tail == NULL)
-		{
-			IPACMDBG("Tail is null\n");
-			Head->setnext(item);
-		}
-		else
-		{
-			Tail->setnext(item);
-		}
+		Tail->setnext(item);
 		Tail = item;
 	}
+
+	if(pthread_mutex_unlock(&q_lock) != 0)
+	{
+		IPACMERR("unable to unlock the mutex\n");
+	}
 }
 
+/* Take every queued message at once */
+Message* MessageQueue::dequeueAll(void)
+{
+	Message *item;
+
+	if(pthread_mutex_lock(&q_lock) != 0)
+	{
+		IPACMERR("unable to lock the mutex\n");
+		return NULL;
+	}
 
-Message* MessageQueue::dequeue(void)
+	item = Head;
+	Head = NULL;
+	Tail = NULL;
+
+	if(pthread_mutex_unlock(&q_lock) != 0)
+	{
+		IPACMERR("unable to unlock the mutex\n");
+	}
+	return item;
+}
+
+/* Put the unprocessed rest of a batch back in front of the queue */
+void MessageQueue::requeue(Message *item)
 {
+	Message *last = item;
+
+	while(last->getnext() != NULL)
+	{
+		last = last->getnext();
+	}
+
+	if(pthread_mutex_lock(&q_lock) != 0)
+	{
+		IPACMERR("unable to lock the mutex\n");
+		return;
+	}
+
+	last->setnext(Head);
 	if(Head == NULL)
 	{
-		return NULL;
+		Tail = last;
 	}
-	else
+	Head = item;
+
+	if(pthread_mutex_unlock(&q_lock) != 0)
+	{
+		IPACMERR("unable to unlock the mutex\n");
+	}
+}
+
+bool MessageQueue::isEmpty(void)
+{
+	bool empty;
+
+	pthread_mutex_lock(&q_lock);
+	empty = (Head == NULL);
+	pthread_mutex_unlock(&q_lock);
+
+	return empty;
+}
+
+/* Called after enqueue(); only signals when the worker is asleep */
+int MessageQueue::wakeup(void)
+{
+	int ret = IPACM_SUCCESS;
+
+	if(pthread_mutex_lock(&wait_lock) != 0)
 	{
-		Message *tmp = Head;
-		Head = Head->getnext();
+		IPACMERR("unable to lock the mutex\n");
+		return IPACM_FAILURE;
+	}
 
-		return tmp;
+	if(waiting && pthread_cond_signal(&wait_cond) != 0)
+	{
+		IPACMERR("unable to signal the worker\n");
+		ret = IPACM_FAILURE;
 	}
+
+	if(pthread_mutex_unlock(&wait_lock) != 0)
+	{
+		IPACMERR("unable to unlock the mutex\n");
+		return IPACM_FAILURE;
+	}
+
+	return ret;
 }
 
+/* Run everything queued on one queue. Stops early, putting the rest
+	 back, as soon as a higher priority queue has work. Returns the number
+	 of messages processed. */
+int MessageQueue::ProcessBatch(MessageQueue *queue, MessageQueue *higher, MessageQueue *highest)
+{
+	Message *item, *next;
+	const char *eventName = NULL;
+	int cnt = 0;
+
+	item = queue->dequeueAll();
+	while(item != NULL)
+	{
+		if(cnt > 0 &&
+			 ((highest != NULL && !highest->isEmpty()) || (higher != NULL && !higher->isEmpty())))
+		{
+			IPACMDBG("Preempted after %d messages\n", cnt);
+			queue->requeue(item);
+			break;
+		}
+
+		next = item->getnext();
+
+		eventName = IPACM_Iface::ipacmcfg->getEventName(item->evt.data.event);
+		if (eventName != NULL)
+		{
+			IPACMDBG("Processing item %p event %s\n", item, eventName);
+		}
+		item->evt.callback_ptr(&item->evt.data);
+		freeMessage(item);
+
+		item = next;
+		cnt++;
+	}
+
+	return cnt;
+}
 
 void* MessageQueue::Process(void *param)
 {
+	MessageQueue *MsgQueuePriority = NULL;
 	MessageQueue *MsgQueueInternal = NULL;
 	MessageQueue *MsgQueueExternal = NULL;
-	Message *item = NULL;
 	param = NULL;
-	const char *eventName = NULL;
 
 	IPACMDBG("MessageQueue::Process()\n");
 
+	MsgQueuePriority = MessageQueue::getInstancePriority();
+	if(MsgQueuePriority == NULL)
+	{
+		IPACMERR("unable to start priority cmd queue process\n");
+		return NULL;
+	}
+
 	MsgQueueInternal = MessageQueue::getInstanceInternal();
 	if(MsgQueueInternal == NULL)
 	{
@@ -143,68 +350,52 @@ void* MessageQueue::Process(void *param)
 
 	while(1)
 	{
-		if(pthread_mutex_lock(&mutex) != 0)
+		if(ProcessBatch(MsgQueuePriority, NULL, NULL) > 0)
 		{
-			IPACMERR("unable to lock the mutex\n");
-			return NULL;
+			continue;
 		}
 
-		item = MsgQueueInternal->dequeue();
-		if(item == NULL)
+		if(ProcessBatch(MsgQueueInternal, MsgQueuePriority, NULL) > 0)
 		{
-			item = MsgQueueExternal->dequeue();
-			if(item)
-			{
-				eventName = IPACM_Iface::ipacmcfg->getEventName(item->evt.data.event);
-				if (eventName != NULL)
-				{
-					IPACMDBG("Get event %s from external queue.\n",
-							eventName);
-				}
-			}
+			continue;
+		}
+
+		if(ProcessBatch(MsgQueueExternal, MsgQueueInternal, MsgQueuePriority) > 0)
+		{
+			continue;
 		}
-		else
+
+		if(pthread_mutex_lock(&wait_lock) != 0)
 		{
-			IPACMDBG("Get event %s from internal queue.\n",
-				IPACM_Iface::ipacmcfg->getEventName(item->evt.data.event));
+			IPACMERR("unable to lock the mutex\n");
+			return NULL;
 		}
 
-		if(item == NULL)
+		/* check again under wait_lock, a poster that missed waiting has
+			 already enqueued by now */
+		waiting = true;
+		if(MsgQueuePriority->isEmpty() && MsgQueueInternal->isEmpty() && MsgQueueExternal->isEmpty())
 		{
 			IPACMDBG("Waiting for Message\n");
 
-			if(pthread_cond_wait(&cond_var, &mutex) != 0)
+			if(pthread_cond_wait(&wait_cond, &wait_lock) != 0)
 			{
-				IPACMERR("unable to lock the mutex\n");
+				IPACMERR("unable to wait on the condition\n");
+				waiting = false;
 
-				if(pthread_mutex_unlock(&mutex) != 0)
+				if(pthread_mutex_unlock(&wait_lock) != 0)
 				{
 					IPACMERR("unable to unlock the mutex\n");
-					return NULL;
 				}
-
 				return NULL;
 			}
-
-			if(pthread_mutex_unlock(&mutex) != 0)
-			{
-				IPACMERR("unable to unlock the mutex\n");
-				return NULL;
-			}
-
 		}
-		else
-		{
-			if(pthread_mutex_unlock(&mutex) != 0)
-			{
-				IPACMERR("unable to unlock the mutex\n");
-				return NULL;
-			}
+		waiting = false;
 
-			IPACMDBG("Processing item %p event ID: %d\n",item,item->evt.data.event);
-			item->evt.callback_ptr(&item->evt.data);
-			delete item;
-			item = NULL;
+		if(pthread_mutex_unlock(&wait_lock) != 0)
+		{
+			IPACMERR("unable to unlock the mutex\n");
+			return NULL;
 		}
 
 	} /* Go forever until a termination indication is received */
@@ -40,6 +40,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <IPACM_Config.h>
 #include <IPACM_Log.h>
 #include <IPACM_Iface.h>
+#include <IPACM_ClientDir.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
 
@@ -78,7 +79,7 @@ const char *ipacm_event_name[] = {
 	__stringify(IPA_NEIGH_CLIENT_IP_ADDR_DEL_EVENT),       /* ipacm_event_data_all */
 	__stringify(IPA_SW_ROUTING_ENABLE),                    /* NULL */
 	__stringify(IPA_SW_ROUTING_DISABLE),                   /* NULL */
-	__stringify(IPA_PROCESS_CT_MESSAGE),                   /* ipacm_ct_evt_data */
+	__stringify(IPA_PROCESS_CT_MESSAGE),                   /* ipacm_ct_evt_batch */
 	__stringify(IPA_PROCESS_CT_MESSAGE_V6),                /* ipacm_ct_evt_data */
 	__stringify(IPA_LAN_TO_LAN_NEW_CONNECTION),            /* ipacm_event_connection */
 	__stringify(IPA_LAN_TO_LAN_DEL_CONNECTION),            /* ipacm_event_connection */
@@ -118,6 +119,21 @@ const char *ipacm_event_name[] = {
 	__stringify(IPACM_EVENT_MAX),
 };
 
+/* client cap from the XML file, default when not configured */
+static int ipacm_cfg_client_cap(const char *name, int val, int def, int limit)
+{
+	if (val <= 0)
+	{
+		return def;
+	}
+	if (val > limit)
+	{
+		IPACMERR("max %s clients %d above limit, use %d\n", name, val, limit);
+		return limit;
+	}
+	return val;
+}
+
 IPACM_Config::IPACM_Config()
 {
 	iface_table = NULL;
@@ -134,6 +150,10 @@ IPACM_Config::IPACM_Config()
 	ipa_num_private_subnet = 0;
 	ipa_num_alg_ports = 0;
 	ipa_nat_max_entries = 0;
+	ipa_max_wlan_clients = IPA_MAX_NUM_WIFI_CLIENTS;
+	ipa_max_eth_clients = IPA_MAX_NUM_ETH_CLIENTS;
+	ipa_max_neighbor_clients = IPA_MAX_NUM_NEIGHBOR_CLIENTS;
+	ipa_offload_stats_interval_ms = IPACM_OFFLOAD_STATS_INTERVAL_MS;
 	ipa_nat_iface_entries = 0;
 	ipa_sw_rt_enable = false;
 	ipa_bridge_enable = false;
@@ -285,6 +305,30 @@ int IPACM_Config::Init(void)
 	ipa_nat_max_entries = cfg->nat_max_entries;
 	IPACMDBG_H("Nat Maximum Entries %d\n", ipa_nat_max_entries);
 
+	ipa_max_wlan_clients = ipacm_cfg_client_cap("wlan", cfg->max_wlan_clients,
+		IPA_MAX_NUM_WIFI_CLIENTS, IPA_MAX_NUM_WIFI_CLIENTS);
+	ipa_max_eth_clients = ipacm_cfg_client_cap("eth", cfg->max_eth_clients,
+		IPA_MAX_NUM_ETH_CLIENTS, IPACM_CLIENT_DIR_MAX);
+	ipa_max_neighbor_clients = ipacm_cfg_client_cap("neighbor", cfg->max_neighbor_clients,
+		IPA_MAX_NUM_NEIGHBOR_CLIENTS, IPACM_CLIENT_DIR_MAX);
+	IPACMDBG_H("Max clients wlan %d eth %d neighbor %d\n",
+		ipa_max_wlan_clients, ipa_max_eth_clients, ipa_max_neighbor_clients);
+
+	ipa_offload_stats_interval_ms = IPACM_OFFLOAD_STATS_INTERVAL_MS;
+	if (cfg->offload_stats_interval_ms > 0)
+	{
+		ipa_offload_stats_interval_ms = cfg->offload_stats_interval_ms;
+		if (ipa_offload_stats_interval_ms < IPACM_OFFLOAD_STATS_INTERVAL_MIN_MS)
+		{
+			ipa_offload_stats_interval_ms = IPACM_OFFLOAD_STATS_INTERVAL_MIN_MS;
+		}
+		else if (ipa_offload_stats_interval_ms > IPACM_OFFLOAD_STATS_INTERVAL_MAX_MS)
+		{
+			ipa_offload_stats_interval_ms = IPACM_OFFLOAD_STATS_INTERVAL_MAX_MS;
+		}
+	}
+	IPACMDBG_H("Offload stats interval %d ms\n", ipa_offload_stats_interval_ms);
+
 	/* Find ODU is either router mode or bridge mode*/
 	ipacm_odu_enable = cfg->odu_enable;
 	ipacm_odu_router_mode = cfg->router_mode_enable;
@@ -34,6 +34,8 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
 #include <net/if.h>
 #include "IPACM_Iface.h"
 #include "IPACM_ConntrackListener.h"
@@ -64,6 +66,8 @@ IPACM_ConntrackClient::IPACM_ConntrackClient()
 	fd_udp = -1;
 	subscrips_tcp = NF_NETLINK_CONNTRACK_UPDATE | NF_NETLINK_CONNTRACK_DESTROY;
 	subscrips_udp = NF_NETLINK_CONNTRACK_NEW | NF_NETLINK_CONNTRACK_DESTROY;
+	memset(&tcp_batcher, 0, sizeof(tcp_batcher));
+	memset(&udp_batcher, 0, sizeof(udp_batcher));
 }
 
 IPACM_ConntrackClient* IPACM_ConntrackClient::GetInstance()
@@ -101,25 +105,27 @@ int IPACM_ConntrackClient::IPAConntrackEventCB
 	 void *data
 	 )
 {
+	uint8_t ip_type = 0;
+#ifdef CT_OPT
 	ipacm_cmd_q_data evt_data;
 	ipacm_ct_evt_data *ct_data;
-	uint8_t ip_type = 0;
-	data = NULL;
+#endif
 
 	IPACMDBG("Event callback called with msgtype: %d\n",type);
 
 	/* Retrieve ip type */
 	ip_type = nfct_get_attr_u8(ct, ATTR_REPL_L3PROTO);
 
-#ifndef CT_OPT
-	if(AF_INET6 == ip_type)
+	if(AF_INET6 != ip_type)
 	{
-		IPACMDBG("Ignoring ipv6(%d) connections\n", ip_type);
-		goto IGNORE;
+		QueueCTEvent((ct_evt_batcher *)data, type, ct);
+		return NFCT_CB_STOLEN;
 	}
 
-#endif
-
+#ifndef CT_OPT
+	IPACMDBG("Ignoring ipv6(%d) connections\n", ip_type);
+	goto IGNORE;
+#else
 	ct_data = (ipacm_ct_evt_data *)malloc(sizeof(ipacm_ct_evt_data));
 	if(ct_data == NULL)
 	{
@@ -130,16 +136,9 @@ int IPACM_ConntrackClient::IPAConntrackEventCB
 	ct_data->ct = ct;
 	ct_data->type = type;
 
-	evt_data.event = IPA_PROCESS_CT_MESSAGE;
+	evt_data.event = IPA_PROCESS_CT_MESSAGE_V6;
 	evt_data.evt_data = (void *)ct_data;
 
-#ifdef CT_OPT
-	if(AF_INET6 == ip_type)
-	{
-		evt_data.event = IPA_PROCESS_CT_MESSAGE_V6;
-	}
-#endif
-
 	if(0 != IPACM_EvtDispatcher::PostEvt(&evt_data))
 	{
 		IPACMERR("Error sending Conntrack message to processing thread!\n");
@@ -150,6 +149,7 @@ int IPACM_ConntrackClient::IPAConntrackEventCB
 /* NFCT_CB_STOLEN means that the conntrack object is not released after the
 	 callback That must be manually done later when the object is no longer needed. */
 	return NFCT_CB_STOLEN;
+#endif
 
 IGNORE:
 	nfct_destroy(ct);
@@ -157,6 +157,239 @@ IGNORE:
 
 }
 
+/* A later event can take the place of a pending one on the same tuple
+	 only if the pending one no longer matters: a DESTROY makes whatever
+	 came before it moot, and a repeat of the same event (same TCP state)
+	 adds nothing. A TCP update carrying another state is kept in order,
+	 since the listener acts on the state and not on the event type. */
+bool IPACM_ConntrackClient::SupersedesCTEvent
+(
+	 ipacm_ct_evt_data *old_evt,
+	 enum nf_conntrack_msg_type type,
+	 struct nf_conntrack *ct
+)
+{
+	if(old_evt->ct == NULL || old_evt->type == NFCT_T_DESTROY)
+	{
+		return false;
+	}
+
+	if(type == NFCT_T_DESTROY)
+	{
+		return true;
+	}
+
+	if(old_evt->type != type)
+	{
+		return false;
+	}
+
+	if(nfct_get_attr_u8(ct, ATTR_ORIG_L4PROTO) == IPPROTO_TCP &&
+		 nfct_get_attr_u8(old_evt->ct, ATTR_TCP_STATE) != nfct_get_attr_u8(ct, ATTR_TCP_STATE))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+/* Add an event to the pending batch, folding it into a pending event on
+	 the same tuple where that is safe. NEW followed by DESTROY cancels out,
+	 and a DESTROY stays in front of a NEW that reuses its tuple, so the old
+	 entry is deleted before the new one is added. */
+void IPACM_ConntrackClient::QueueCTEvent
+(
+	 ct_evt_batcher *batcher,
+	 enum nf_conntrack_msg_type type,
+	 struct nf_conntrack *ct
+)
+{
+	ipacm_ct_evt_data *evt;
+	ct_evt_tuple tuple;
+	struct timespec now;
+	int cnt;
+
+	batcher->stats.events++;
+
+	if(batcher->batch == NULL)
+	{
+		batcher->batch = (ipacm_ct_evt_batch *)malloc(sizeof(ipacm_ct_evt_batch));
+		if(batcher->batch == NULL)
+		{
+			IPACMERR("unable to allocate memory \n");
+			batcher->stats.dropped++;
+			nfct_destroy(ct);
+			return;
+		}
+		batcher->batch->num = 0;
+		batcher->live = 0;
+	}
+
+	memset(&tuple, 0, sizeof(tuple));
+	tuple.src_ip = nfct_get_attr_u32(ct, ATTR_ORIG_IPV4_SRC);
+	tuple.dst_ip = nfct_get_attr_u32(ct, ATTR_ORIG_IPV4_DST);
+	tuple.src_port = nfct_get_attr_u16(ct, ATTR_ORIG_PORT_SRC);
+	tuple.dst_port = nfct_get_attr_u16(ct, ATTR_ORIG_PORT_DST);
+	tuple.proto = nfct_get_attr_u8(ct, ATTR_ORIG_L4PROTO);
+
+	for(cnt = batcher->batch->num - 1; cnt >= 0; cnt--)
+	{
+		if(memcmp(&batcher->tuples[cnt], &tuple, sizeof(tuple)) == 0)
+		{
+			break;
+		}
+	}
+
+	if(cnt >= 0 && SupersedesCTEvent(&batcher->batch->evts[cnt], type, ct))
+	{
+		evt = &batcher->batch->evts[cnt];
+		nfct_destroy(evt->ct);
+		if(evt->type == NFCT_T_NEW && type == NFCT_T_DESTROY)
+		{
+			/* never reached the nat table, drop both */
+			nfct_destroy(ct);
+			evt->ct = NULL;
+			batcher->tuples[cnt].proto = 0;
+			batcher->live--;
+			batcher->stats.coalesced += 2;
+			return;
+		}
+		evt->ct = ct;
+		evt->type = type;
+		batcher->stats.coalesced++;
+		return;
+	}
+
+	if(batcher->batch->num == 0)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &batcher->first);
+	}
+
+	evt = &batcher->batch->evts[batcher->batch->num];
+	evt->ct = ct;
+	evt->type = type;
+	batcher->tuples[batcher->batch->num] = tuple;
+	batcher->batch->num++;
+	batcher->live++;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if(batcher->batch->num == IPA_CT_EVT_BATCH_MAX ||
+		 (now.tv_sec - batcher->first.tv_sec) * 1000000 +
+		 (now.tv_nsec - batcher->first.tv_nsec) / 1000 >= CT_EVT_BATCH_WINDOW_US)
+	{
+		FlushCTEvents(batcher);
+	}
+	else if(!batcher->timer_armed)
+	{
+		/* make the receive return once the window is over, in case
+			 nothing else arrives to flush the batch */
+		SetCTEventTimer(batcher, true);
+	}
+	return;
+}
+
+/* Post the pending batch to the listener in one event */
+void IPACM_ConntrackClient::FlushCTEvents(ct_evt_batcher *batcher)
+{
+	ipacm_cmd_q_data evt_data;
+	int cnt;
+
+	if(batcher->timer_armed)
+	{
+		SetCTEventTimer(batcher, false);
+	}
+
+	if(batcher->batch == NULL || batcher->batch->num == 0)
+	{
+		return;
+	}
+
+	if(batcher->live == 0)
+	{
+		/* everything cancelled out, keep the buffer for the next batch */
+		batcher->batch->num = 0;
+		return;
+	}
+
+	evt_data.event = IPA_PROCESS_CT_MESSAGE;
+	evt_data.evt_data = (void *)batcher->batch;
+
+	if(0 != IPACM_EvtDispatcher::PostEvt(&evt_data))
+	{
+		IPACMERR("Error sending Conntrack batch to processing thread!\n");
+		for(cnt = 0; cnt < batcher->batch->num; cnt++)
+		{
+			if(batcher->batch->evts[cnt].ct != NULL)
+			{
+				nfct_destroy(batcher->batch->evts[cnt].ct);
+			}
+		}
+		batcher->stats.dropped += batcher->live;
+		batcher->batch->num = 0;
+		return;
+	}
+
+	IPACMDBG("Posted %d conntrack events, %d live\n", batcher->batch->num, batcher->live);
+	batcher->stats.batches++;
+	/* the dispatcher frees the batch once processed */
+	batcher->batch = NULL;
+	batcher->live = 0;
+	return;
+}
+
+void IPACM_ConntrackClient::SetCTEventTimer(ct_evt_batcher *batcher, bool arm)
+{
+	struct timeval tv;
+
+	tv.tv_sec = 0;
+	tv.tv_usec = (arm) ? CT_EVT_BATCH_WINDOW_US : 0;
+	if(setsockopt(nfct_fd(batcher->hdl), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0)
+	{
+		PERROR("setsockopt SO_RCVTIMEO");
+		return;
+	}
+	batcher->timer_armed = arm;
+}
+
+/* nfct_catch() returned -1: flush on the batch window, count overruns and
+	 go on receiving; anything else ends the receive thread */
+bool IPACM_ConntrackClient::HandleCatchError(ct_evt_batcher *batcher)
+{
+	if(errno == EAGAIN || errno == EWOULDBLOCK)
+	{
+		FlushCTEvents(batcher);
+		return true;
+	}
+
+	if(errno == ENOBUFS)
+	{
+		/* the kernel dropped events we will never see, the count is unknown */
+		IPACMERR("conntrack socket overrun, events lost\n");
+		batcher->stats.dropped++;
+		FlushCTEvents(batcher);
+		return true;
+	}
+
+	FlushCTEvents(batcher);
+	return false;
+}
+
+void IPACM_ConntrackClient::GetCTEventStats(ct_evt_stats *stats)
+{
+	IPACM_ConntrackClient *pClient = GetInstance();
+
+	memset(stats, 0, sizeof(*stats));
+	if(pClient == NULL)
+	{
+		return;
+	}
+
+	stats->events = pClient->tcp_batcher.stats.events + pClient->udp_batcher.stats.events;
+	stats->coalesced = pClient->tcp_batcher.stats.coalesced + pClient->udp_batcher.stats.coalesced;
+	stats->dropped = pClient->tcp_batcher.stats.dropped + pClient->udp_batcher.stats.dropped;
+	stats->batches = pClient->tcp_batcher.stats.batches + pClient->udp_batcher.stats.batches;
+}
+
 int IPACM_ConntrackClient::IPA_Conntrack_Filters_Ignore_Bridge_Addrs
 (
 	 struct nfct_filter *filter
@@ -388,6 +621,7 @@ int IPACM_ConntrackClient::IPA_Conntrack_UDP_Filter_Init(void)
 void* IPACM_ConntrackClient::UDPConnTimeoutUpdate(void *ptr)
 {
 	NatApp *nat_inst = NULL;
+	ct_evt_stats stats;
 	ptr = NULL;
 #ifdef IPACM_DEBUG
 	IPACMDBG("\n");
@@ -403,6 +637,11 @@ void* IPACM_ConntrackClient::UDPConnTimeoutUpdate(void *ptr)
 	while(1)
 	{
 		nat_inst->UpdateUDPTimeStamp();
+
+		GetCTEventStats(&stats);
+		IPACMDBG_H("Conntrack events: %u received, %u coalesced, %u dropped, %u batches\n",
+							 stats.events, stats.coalesced, stats.dropped, stats.batches);
+
 		sleep(UDP_TIMEOUT_UPDATE);
 	} /* end of while(1) loop */
 
@@ -467,14 +706,18 @@ void* IPACM_ConntrackClient::TCPRegisterWithConnTrack(void *)
 		return NULL;
 	}
 
+	/* Room for connection storms while the batch window runs */
+	nfnl_rcvbufsiz(nfct_nfnlh(pClient->tcp_hdl), CT_RCVBUF_SIZE);
+	pClient->tcp_batcher.hdl = pClient->tcp_hdl;
+
 	/* Register callback with netfilter handler */
 	IPACMDBG_H("tcp handle:%pK, fd:%d\n", pClient->tcp_hdl, nfct_fd(pClient->tcp_hdl));
 #ifndef CT_OPT
 	nfct_callback_register(pClient->tcp_hdl,
 			(nf_conntrack_msg_type)	(NFCT_T_UPDATE | NFCT_T_DESTROY | NFCT_T_NEW),
-						IPAConntrackEventCB, NULL);
+						IPAConntrackEventCB, &pClient->tcp_batcher);
 #else
-	nfct_callback_register(pClient->tcp_hdl, (nf_conntrack_msg_type) NFCT_T_ALL, IPAConntrackEventCB, NULL);
+	nfct_callback_register(pClient->tcp_hdl, (nf_conntrack_msg_type) NFCT_T_ALL, IPAConntrackEventCB, &pClient->tcp_batcher);
 #endif
 
 	/* Block to catch events from net filter connection track */
@@ -482,7 +725,11 @@ void* IPACM_ConntrackClient::TCPRegisterWithConnTrack(void *)
 			 blocks waiting for events. */
 	IPACMDBG("Waiting for events\n");
 
-	ret = nfct_catch(pClient->tcp_hdl);
+	do
+	{
+		ret = nfct_catch(pClient->tcp_hdl);
+	} while(ret == -1 && HandleCatchError(&pClient->tcp_batcher));
+
 	if(ret == -1)
 	{
 		IPACMERR("(%d)(%s)\n", ret, strerror(errno));
@@ -558,18 +805,26 @@ void* IPACM_ConntrackClient::UDPRegisterWithConnTrack(void *)
 		return NULL;
 	}
 
+	/* Room for connection storms while the batch window runs */
+	nfnl_rcvbufsiz(nfct_nfnlh(pClient->udp_hdl), CT_RCVBUF_SIZE);
+	pClient->udp_batcher.hdl = pClient->udp_hdl;
+
 	/* Register callback with netfilter handler */
 	IPACMDBG_H("udp handle:%pK, fd:%d\n", pClient->udp_hdl, nfct_fd(pClient->udp_hdl));
 	nfct_callback_register(pClient->udp_hdl,
 			(nf_conntrack_msg_type)(NFCT_T_NEW | NFCT_T_DESTROY),
 			IPAConntrackEventCB,
-			NULL);
+			&pClient->udp_batcher);
 
 	/* Block to catch events from net filter connection track */
 ctcatch:
 	ret = nfct_catch(pClient->udp_hdl);
 	if(ret == -1)
 	{
+		if(HandleCatchError(&pClient->udp_batcher))
+		{
+			goto ctcatch;
+		}
 		IPACMDBG("(%d)(%s)\n", ret, strerror(errno));
 		return NULL;
 	}
@@ -658,34 +658,50 @@ IGNORE:
 
 void IPACM_ConntrackListener::ProcessCTMessage(void *param)
 {
-	 ipacm_ct_evt_data *evt_data = (ipacm_ct_evt_data *)param;
+	 ipacm_ct_evt_batch *batch = (ipacm_ct_evt_batch *)param;
+	 ipacm_ct_evt_data *evt_data;
 	 u_int8_t l4proto = 0;
+	 int cnt;
 
 #ifdef IPACM_DEBUG
 	 char buf[1024];
 	 unsigned int out_flags;
+#endif
 
-	 /* Process message and generate ioctl call to kernel thread */
-	 out_flags = (NFCT_OF_SHOW_LAYER3 | NFCT_OF_TIME | NFCT_OF_ID);
-	 nfct_snprintf(buf, sizeof(buf), evt_data->ct,
-								 evt_data->type, NFCT_O_PLAIN, out_flags);
-	 IPACMDBG_H("%s\n", buf);
+	 IPACMDBG("Processing %d conntrack events\n", batch->num);
 
-	 ParseCTMessage(evt_data->ct);
+	 for(cnt = 0; cnt < batch->num; cnt++)
+	 {
+			evt_data = &batch->evts[cnt];
+			if(evt_data->ct == NULL)
+			{
+				 /* cancelled out in the conntrack client */
+				 continue;
+			}
+
+#ifdef IPACM_DEBUG
+			/* Process message and generate ioctl call to kernel thread */
+			out_flags = (NFCT_OF_SHOW_LAYER3 | NFCT_OF_TIME | NFCT_OF_ID);
+			nfct_snprintf(buf, sizeof(buf), evt_data->ct,
+										evt_data->type, NFCT_O_PLAIN, out_flags);
+			IPACMDBG_H("%s\n", buf);
+
+			ParseCTMessage(evt_data->ct);
 #endif
 
-	 l4proto = nfct_get_attr_u8(evt_data->ct, ATTR_ORIG_L4PROTO);
-	 if(IPPROTO_UDP != l4proto && IPPROTO_TCP != l4proto)
-	 {
-			IPACMDBG("Received unexpected protocl %d conntrack message\n", l4proto);
-	 }
-	 else
-	 {
-			ProcessTCPorUDPMsg(evt_data->ct, evt_data->type, l4proto);
-	 }
+			l4proto = nfct_get_attr_u8(evt_data->ct, ATTR_ORIG_L4PROTO);
+			if(IPPROTO_UDP != l4proto && IPPROTO_TCP != l4proto)
+			{
+				 IPACMDBG("Received unexpected protocl %d conntrack message\n", l4proto);
+			}
+			else
+			{
+				 ProcessTCPorUDPMsg(evt_data->ct, evt_data->type, l4proto);
+			}
 
-	 /* Cleanup item that was allocated during the original CT callback */
-	 nfct_destroy(evt_data->ct);
+			/* Cleanup item that was allocated during the original CT callback */
+			nfct_destroy(evt_data->ct);
+	 }
 	 return;
 }
 
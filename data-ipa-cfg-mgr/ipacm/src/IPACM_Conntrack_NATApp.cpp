@@ -34,6 +34,47 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define INVALID_IP_ADDR 0x0
 
+static inline uint32_t nat_ip_hash(uint32_t ip)
+{
+	ip ^= ip >> 16;
+	ip *= 0x85ebca6b;
+	ip ^= ip >> 13;
+	ip *= 0xc2b2ae35;
+	ip ^= ip >> 16;
+	return ip;
+}
+
+static inline uint32_t nat_tuple_hash(const nat_table_entry *rule)
+{
+	uint32_t hash;
+
+	hash = nat_ip_hash(rule->private_ip);
+	hash = nat_ip_hash(hash ^ rule->target_ip);
+	hash = nat_ip_hash(hash ^ (((uint32_t)rule->private_port << 16) | rule->target_port));
+	return nat_ip_hash(hash ^ rule->protocol);
+}
+
+static inline bool nat_tuple_match(const nat_table_entry *a, const nat_table_entry *b)
+{
+	return (a->private_ip == b->private_ip &&
+			a->target_ip == b->target_ip &&
+			a->private_port == b->private_port &&
+			a->target_port == b->target_port &&
+			a->protocol == b->protocol);
+}
+
+/* smallest power of two >= n */
+static inline uint32_t nat_pow2(uint32_t n)
+{
+	uint32_t size = 1;
+
+	while(size < n)
+	{
+		size <<= 1;
+	}
+	return size;
+}
+
 /* NatApp class Implementation */
 NatApp *NatApp::pInstance = NULL;
 NatApp::NatApp()
@@ -41,6 +82,18 @@ NatApp::NatApp()
 	max_entries = 0;
 	cache = NULL;
 
+	tuple_idx = NULL;
+	tuple_idx_mask = 0;
+	clnt_bkt = NULL;
+	tgt_bkt = NULL;
+	ip_bkt_mask = 0;
+	links = NULL;
+	free_head = NAT_INVALID_SLOT;
+
+	ts_slots = NULL;
+	ts_rule_hdls = NULL;
+	ts_vals = NULL;
+
 	nat_table_hdl = 0;
 	pub_ip_addr = 0;
 
@@ -51,14 +104,15 @@ NatApp::NatApp()
 
 	ct = NULL;
 	ct_hdl = NULL;
+	ct_seq = 0;
 
 	memset(temp, 0, sizeof(temp));
+	memset(PwrSaveIfs, 0, sizeof(PwrSaveIfs));
 }
 
 int NatApp::Init(void)
 {
 	IPACM_Config *pConfig;
-	int size = 0;
 
 	pConfig = IPACM_Config::GetInstance();
 	if(pConfig == NULL)
@@ -69,15 +123,10 @@ int NatApp::Init(void)
 
 	max_entries = pConfig->GetNatMaxEntries();
 
-	size = (sizeof(nat_table_entry) * max_entries);
-	cache = (nat_table_entry *)malloc(size);
-	if(cache == NULL)
+	if(AllocCache())
 	{
-		IPACMERR("Unable to allocate memory for cache\n");
 		goto fail;
 	}
-	IPACMDBG("Allocated %d bytes for config manager nat cache\n", size);
-	memset(cache, 0, size);
 
 	nALGPort = pConfig->GetAlgPortCnt();
 	if(nALGPort > 0)
@@ -107,10 +156,193 @@ int NatApp::Init(void)
 
 fail:
 	free(cache);
+	free(tuple_idx);
+	free(clnt_bkt);
+	free(tgt_bkt);
+	free(links);
+	free(ts_slots);
+	free(ts_rule_hdls);
+	free(ts_vals);
 	free(pALGPorts);
 	return -1;
 }
 
+/* Allocate the cache of max_entries slots and its indexes */
+int NatApp::AllocCache()
+{
+	int size = 0;
+	uint32_t cnt, idx_size, bkt_size;
+
+	size = (sizeof(nat_table_entry) * max_entries);
+	cache = (nat_table_entry *)malloc(size);
+	if(cache == NULL)
+	{
+		IPACMERR("Unable to allocate memory for cache\n");
+		return -1;
+	}
+	IPACMDBG("Allocated %d bytes for config manager nat cache\n", size);
+	memset(cache, 0, size);
+
+	/* keep the tuple index at most half full so probe runs stay short */
+	idx_size = nat_pow2(2 * max_entries);
+	bkt_size = nat_pow2(max_entries);
+	tuple_idx = (int *)malloc(sizeof(int) * idx_size);
+	clnt_bkt = (int *)malloc(sizeof(int) * bkt_size);
+	tgt_bkt = (int *)malloc(sizeof(int) * bkt_size);
+	links = (nat_cache_link *)malloc(sizeof(nat_cache_link) * max_entries);
+	ts_slots = (int *)malloc(sizeof(int) * max_entries);
+	ts_rule_hdls = (uint32_t *)malloc(sizeof(uint32_t) * max_entries);
+	ts_vals = (uint32_t *)malloc(sizeof(uint32_t) * max_entries);
+	if(tuple_idx == NULL || clnt_bkt == NULL || tgt_bkt == NULL || links == NULL ||
+		 ts_slots == NULL || ts_rule_hdls == NULL || ts_vals == NULL)
+	{
+		IPACMERR("Unable to allocate memory for cache index\n");
+		return -1;
+	}
+	tuple_idx_mask = idx_size - 1;
+	ip_bkt_mask = bkt_size - 1;
+
+	for(cnt = 0; cnt < idx_size; cnt++)
+	{
+		tuple_idx[cnt] = NAT_INVALID_SLOT;
+	}
+	for(cnt = 0; cnt < bkt_size; cnt++)
+	{
+		clnt_bkt[cnt] = NAT_INVALID_SLOT;
+		tgt_bkt[cnt] = NAT_INVALID_SLOT;
+	}
+
+	/* all slots start on the free list, lowest first */
+	memset(links, 0, sizeof(nat_cache_link) * max_entries);
+	for(cnt = 0; cnt < (uint32_t)max_entries; cnt++)
+	{
+		links[cnt].clnt_next = (cnt + 1 < (uint32_t)max_entries) ? (int)cnt + 1 : NAT_INVALID_SLOT;
+	}
+	free_head = (max_entries > 0) ? 0 : NAT_INVALID_SLOT;
+	IPACMDBG("Allocated %d index slots, %d ip buckets for nat cache\n", idx_size, bkt_size);
+
+	return 0;
+}
+
+/* Return the cache slot holding the rule's 5-tuple, or NAT_INVALID_SLOT */
+int NatApp::FindEntry(const nat_table_entry *rule)
+{
+	uint32_t pos = nat_tuple_hash(rule) & tuple_idx_mask;
+
+	while(tuple_idx[pos] != NAT_INVALID_SLOT)
+	{
+		if(nat_tuple_match(&cache[tuple_idx[pos]], rule))
+		{
+			return tuple_idx[pos];
+		}
+		pos = (pos + 1) & tuple_idx_mask;
+	}
+
+	return NAT_INVALID_SLOT;
+}
+
+/* Take the filled in slot at the head of the free list into use */
+void NatApp::IndexEntry(int cnt)
+{
+	uint32_t pos, bkt;
+
+	free_head = links[cnt].clnt_next;
+
+	links[cnt].tuple_hash = nat_tuple_hash(&cache[cnt]);
+	pos = links[cnt].tuple_hash & tuple_idx_mask;
+	while(tuple_idx[pos] != NAT_INVALID_SLOT)
+	{
+		pos = (pos + 1) & tuple_idx_mask;
+	}
+	tuple_idx[pos] = cnt;
+
+	bkt = nat_ip_hash(cache[cnt].private_ip) & ip_bkt_mask;
+	links[cnt].clnt_prev = NAT_INVALID_SLOT;
+	links[cnt].clnt_next = clnt_bkt[bkt];
+	if(clnt_bkt[bkt] != NAT_INVALID_SLOT)
+	{
+		links[clnt_bkt[bkt]].clnt_prev = cnt;
+	}
+	clnt_bkt[bkt] = cnt;
+
+	bkt = nat_ip_hash(cache[cnt].target_ip) & ip_bkt_mask;
+	links[cnt].tgt_prev = NAT_INVALID_SLOT;
+	links[cnt].tgt_next = tgt_bkt[bkt];
+	if(tgt_bkt[bkt] != NAT_INVALID_SLOT)
+	{
+		links[tgt_bkt[bkt]].tgt_prev = cnt;
+	}
+	tgt_bkt[bkt] = cnt;
+
+	curCnt++;
+}
+
+/* Remove the slot from all indexes, clear it and put it on the free list */
+void NatApp::ReleaseEntry(int cnt)
+{
+	uint32_t pos, next, home;
+	nat_cache_link *link = &links[cnt];
+
+	pos = link->tuple_hash & tuple_idx_mask;
+	while(tuple_idx[pos] != cnt)
+	{
+		pos = (pos + 1) & tuple_idx_mask;
+	}
+
+	/* backward shift deletion: pull up every later slot of the probe run
+	   that may live at pos, so lookups never need tombstones */
+	tuple_idx[pos] = NAT_INVALID_SLOT;
+	next = pos;
+	while(true)
+	{
+		next = (next + 1) & tuple_idx_mask;
+		if(tuple_idx[next] == NAT_INVALID_SLOT)
+		{
+			break;
+		}
+		home = links[tuple_idx[next]].tuple_hash & tuple_idx_mask;
+		if((pos <= next) ? (pos < home && home <= next) : (pos < home || home <= next))
+		{
+			continue;
+		}
+		tuple_idx[pos] = tuple_idx[next];
+		tuple_idx[next] = NAT_INVALID_SLOT;
+		pos = next;
+	}
+
+	if(link->clnt_prev != NAT_INVALID_SLOT)
+	{
+		links[link->clnt_prev].clnt_next = link->clnt_next;
+	}
+	else
+	{
+		clnt_bkt[nat_ip_hash(cache[cnt].private_ip) & ip_bkt_mask] = link->clnt_next;
+	}
+	if(link->clnt_next != NAT_INVALID_SLOT)
+	{
+		links[link->clnt_next].clnt_prev = link->clnt_prev;
+	}
+
+	if(link->tgt_prev != NAT_INVALID_SLOT)
+	{
+		links[link->tgt_prev].tgt_next = link->tgt_next;
+	}
+	else
+	{
+		tgt_bkt[nat_ip_hash(cache[cnt].target_ip) & ip_bkt_mask] = link->tgt_next;
+	}
+	if(link->tgt_next != NAT_INVALID_SLOT)
+	{
+		links[link->tgt_next].tgt_prev = link->tgt_prev;
+	}
+
+	memset(&cache[cnt], 0, sizeof(cache[cnt]));
+	memset(link, 0, sizeof(*link));
+	link->clnt_next = free_head;
+	free_head = cnt;
+	curCnt--;
+}
+
 NatApp* NatApp::GetInstance()
 {
 	if(pInstance == NULL)
@@ -171,8 +403,7 @@ int NatApp::AddTable(uint32_t pub_ip)
 				if(ipa_nat_add_ipv4_rule(nat_table_hdl, &nat_rule, &cache[cnt].rule_hdl) < 0)
 				{
 					IPACMERR("unable to add the rule delete from cache\n");
-					memset(&cache[cnt], 0, sizeof(cache[cnt]));
-					curCnt--;
+					ReleaseEntry(cnt);
 					continue;
 				}
 				cache[cnt].enabled = true;
@@ -233,21 +464,13 @@ int NatApp::DeleteTable(uint32_t pub_ip)
 /* Check for duplicate entries */
 bool NatApp::ChkForDup(const nat_table_entry *rule)
 {
-	int cnt = 0;
 	IPACMDBG("%s() %d\n", __FUNCTION__, __LINE__);
 
-	for(; cnt < max_entries; cnt++)
+	if(FindEntry(rule) != NAT_INVALID_SLOT)
 	{
-		if(cache[cnt].private_ip == rule->private_ip &&
-			 cache[cnt].target_ip == rule->target_ip &&
-			 cache[cnt].private_port ==  rule->private_port  &&
-			 cache[cnt].target_port == rule->target_port &&
-			 cache[cnt].protocol == rule->protocol)
-		{
-			log_nat(rule->protocol,rule->private_ip,rule->target_ip,rule->private_port,\
-			rule->target_port,"Duplicate Rule\n");
-			return true;
-		}
+		log_nat(rule->protocol,rule->private_ip,rule->target_ip,rule->private_port,\
+		rule->target_port,"Duplicate Rule\n");
+		return true;
 	}
 
 	return false;
@@ -262,34 +485,24 @@ int NatApp::DeleteEntry(const nat_table_entry *rule)
 	log_nat(rule->protocol,rule->private_ip,rule->target_ip,rule->private_port,\
 	rule->target_port,"for deletion\n");
 
-
-	for(; cnt < max_entries; cnt++)
+	cnt = FindEntry(rule);
+	if(cnt != NAT_INVALID_SLOT)
 	{
-		if(cache[cnt].private_ip == rule->private_ip &&
-			 cache[cnt].target_ip == rule->target_ip &&
-			 cache[cnt].private_port ==  rule->private_port  &&
-			 cache[cnt].target_port == rule->target_port &&
-			 cache[cnt].protocol == rule->protocol)
+		if(cache[cnt].enabled == true)
 		{
-
-			if(cache[cnt].enabled == true)
-			{
-				if(ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl) < 0)
-				{
-					IPACMERR("%s() %d deletion failed\n", __FUNCTION__, __LINE__);
-				}
-
-				IPACMDBG_H("Deleted Nat entry(%d) Successfully\n", cnt);
-			}
-			else
+			if(ipa_nat_del_ipv4_rule(nat_table_hdl, cache[cnt].rule_hdl) < 0)
 			{
-				IPACMDBG_H("Deleted Nat entry(%d) only from cache\n", cnt);
+				IPACMERR("%s() %d deletion failed\n", __FUNCTION__, __LINE__);
 			}
 
-			memset(&cache[cnt], 0, sizeof(cache[cnt]));
-			curCnt--;
-			break;
+			IPACMDBG_H("Deleted Nat entry(%d) Successfully\n", cnt);
+		}
+		else
+		{
+			IPACMDBG_H("Deleted Nat entry(%d) only from cache\n", cnt);
 		}
+
+		ReleaseEntry(cnt);
 	}
 
 	return 0;
@@ -325,19 +538,8 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 
 	if(!ChkForDup(rule))
 	{
-		for(; cnt < max_entries; cnt++)
-		{
-			if(cache[cnt].private_ip == 0 &&
-				 cache[cnt].target_ip == 0 &&
-				 cache[cnt].private_port == 0  &&
-				 cache[cnt].target_port == 0 &&
-				 cache[cnt].protocol == 0)
-			{
-				break;
-			}
-		}
-
-		if(max_entries == cnt)
+		cnt = free_head;
+		if(cnt == NAT_INVALID_SLOT)
 		{
 			IPACMERR("Error: Unable to add, reached maximum rules\n");
 			return -1;
@@ -379,7 +581,7 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 			cache[cnt].timestamp = 0;
 			cache[cnt].public_port = rule->public_port;
 			cache[cnt].dst_nat = rule->dst_nat;
-			curCnt++;
+			IndexEntry(cnt);
 		}
 
 	}
@@ -401,25 +603,79 @@ int NatApp::AddEntry(const nat_table_entry *rule)
 	return 0;
 }
 
-void NatApp::UpdateCTUdpTs(nat_table_entry *rule, uint32_t new_ts)
+/* Push the timestamps of the num changed entries in ts_slots/ts_vals
+   to conntrack. Returns the number of syscalls this took. */
+int NatApp::UpdateCTUdpTs(int num)
 {
+	nat_table_entry *rule;
+	int cnt;
 #ifdef FEATURE_IPACM_HAL
 	IOffloadManager::ConntrackTimeoutUpdater::natTimeoutUpdate_t entry;
 	IPACM_OffloadManager* OffloadMng;
-#endif
-	iptodot("Private IP:", rule->private_ip);
-	iptodot("Target IP:",  rule->target_ip);
-	IPACMDBG("Private Port: %d, Target Port: %d\n", rule->private_port, rule->target_port);
+	int calls = 0;
+
+	OffloadMng = IPACM_OffloadManager::GetInstance();
+	if (OffloadMng->touInstance == NULL) {
+		IPACMERR("OffloadMng->touInstance is NULL, can't forward to framework!\n");
+		return 0;
+	}
+
+	/* the HAL callback takes one connection at a time */
+	for(cnt = 0; cnt < num; cnt++)
+	{
+		rule = &cache[ts_slots[cnt]];
+		if(rule->protocol == IPPROTO_UDP)
+		{
+			entry.proto = IOffloadManager::ConntrackTimeoutUpdater::UDP;;
+		}
+		else
+		{
+			entry.proto = IOffloadManager::ConntrackTimeoutUpdater::TCP;
+		}
+
+		if(rule->dst_nat == false)
+		{
+			entry.src.ipAddr = htonl(rule->private_ip);
+			entry.src.port = rule->private_port;
+			entry.dst.ipAddr = htonl(rule->target_ip);
+			entry.dst.port = rule->target_port;
+		}
+		else
+		{
+			entry.src.ipAddr = htonl(rule->target_ip);
+			entry.src.port = rule->target_port;
+			entry.dst.ipAddr = htonl(pub_ip_addr);
+			entry.dst.port = rule->public_port;
+		}
+
+		iptodot("Source IP:", entry.src.ipAddr);
+		iptodot("Destination IP:",  entry.dst.ipAddr);
+		IPACMDBG("Source Port: %d, Destination Port: %d, dst nat %d\n",
+						entry.src.port, entry.dst.port, rule->dst_nat);
+
+		OffloadMng->touInstance->updateTimeout(entry);
+		calls++;
+		rule->timestamp = ts_vals[cnt];
+	}
+
+	return calls;
+#else
+	struct nlmsghdr *nlh;
+	struct nlmsgerr *err;
+	struct sockaddr_nl nladdr;
+	char req[NAT_CT_BATCH_SIZE * NAT_CT_MSG_SIZE];
+	char resp[NAT_CT_BATCH_SIZE * NAT_CT_MSG_SIZE];
+	int built[NAT_CT_BATCH_SIZE];
+	int first, nbuilt, len, ret, fd, i, syscalls = 0;
+	uint32_t idx, seq_base;
 
-#ifndef FEATURE_IPACM_HAL
-	int ret;
 	if(!ct_hdl)
 	{
 		ct_hdl = nfct_open(CONNTRACK, 0);
 		if(!ct_hdl)
 		{
 			PERROR("nfct_open");
-			return;
+			return 0;
 		}
 	}
 
@@ -429,142 +685,197 @@ void NatApp::UpdateCTUdpTs(nat_table_entry *rule, uint32_t new_ts)
 		if(!ct)
 		{
 			PERROR("nfct_new");
-			return;
+			return 0;
 		}
 	}
 
-	nfct_set_attr_u8(ct, ATTR_L3PROTO, AF_INET);
-	if(rule->protocol == IPPROTO_UDP)
-	{
-		nfct_set_attr_u8(ct, ATTR_L4PROTO, rule->protocol);
-		nfct_set_attr_u32(ct, ATTR_TIMEOUT, udp_timeout);
-	}
-	else
-	{
-		nfct_set_attr_u8(ct, ATTR_L4PROTO, rule->protocol);
-		nfct_set_attr_u32(ct, ATTR_TIMEOUT, tcp_timeout);
-	}
+	fd = nfnl_fd(nfct_nfnlh(ct_hdl));
+	memset(&nladdr, 0, sizeof(nladdr));
+	nladdr.nl_family = AF_NETLINK;
+
+	/* entry cnt goes out with sequence number seq_base + cnt; ct_seq keeps
+	   counting across sweeps, so a late error of an earlier request can not
+	   be taken for one of this sweep */
+	seq_base = ct_seq;
+	ct_seq += num;
 
-	if(rule->dst_nat == false)
+	cnt = 0;
+	while(cnt < num)
 	{
-		nfct_set_attr_u32(ct, ATTR_IPV4_SRC, htonl(rule->private_ip));
-		nfct_set_attr_u16(ct, ATTR_PORT_SRC, htons(rule->private_port));
+		/* build up to NAT_CT_BATCH_SIZE updates back to back in one request */
+		len = 0;
+		nbuilt = 0;
+		for(first = cnt; cnt < num && cnt - first < NAT_CT_BATCH_SIZE; cnt++)
+		{
+			rule = &cache[ts_slots[cnt]];
 
-		nfct_set_attr_u32(ct, ATTR_IPV4_DST, htonl(rule->target_ip));
-		nfct_set_attr_u16(ct, ATTR_PORT_DST, htons(rule->target_port));
+			nfct_set_attr_u8(ct, ATTR_L3PROTO, AF_INET);
+			nfct_set_attr_u8(ct, ATTR_L4PROTO, rule->protocol);
+			if(rule->protocol == IPPROTO_UDP)
+			{
+				nfct_set_attr_u32(ct, ATTR_TIMEOUT, udp_timeout);
+			}
+			else
+			{
+				nfct_set_attr_u32(ct, ATTR_TIMEOUT, tcp_timeout);
+			}
 
-		IPACMDBG("dst nat is not set\n");
-	}
-	else
-	{
-		nfct_set_attr_u32(ct, ATTR_IPV4_SRC, htonl(rule->target_ip));
-		nfct_set_attr_u16(ct, ATTR_PORT_SRC, htons(rule->target_port));
+			if(rule->dst_nat == false)
+			{
+				nfct_set_attr_u32(ct, ATTR_IPV4_SRC, htonl(rule->private_ip));
+				nfct_set_attr_u16(ct, ATTR_PORT_SRC, htons(rule->private_port));
 
-		nfct_set_attr_u32(ct, ATTR_IPV4_DST, htonl(pub_ip_addr));
-		nfct_set_attr_u16(ct, ATTR_PORT_DST, htons(rule->public_port));
+				nfct_set_attr_u32(ct, ATTR_IPV4_DST, htonl(rule->target_ip));
+				nfct_set_attr_u16(ct, ATTR_PORT_DST, htons(rule->target_port));
+			}
+			else
+			{
+				nfct_set_attr_u32(ct, ATTR_IPV4_SRC, htonl(rule->target_ip));
+				nfct_set_attr_u16(ct, ATTR_PORT_SRC, htons(rule->target_port));
 
-		IPACMDBG("dst nat is set\n");
-	}
+				nfct_set_attr_u32(ct, ATTR_IPV4_DST, htonl(pub_ip_addr));
+				nfct_set_attr_u16(ct, ATTR_PORT_DST, htons(rule->public_port));
+			}
 
-	iptodot("Source IP:", nfct_get_attr_u32(ct, ATTR_IPV4_SRC));
-	iptodot("Destination IP:",  nfct_get_attr_u32(ct, ATTR_IPV4_DST));
-	IPACMDBG("Source Port: %d, Destination Port: %d\n",
-					 nfct_get_attr_u16(ct, ATTR_PORT_SRC), nfct_get_attr_u16(ct, ATTR_PORT_DST));
+			IPACMDBG("updating %d connection(%d) with time: %d, dst nat %d\n",
+							 rule->protocol, ts_slots[cnt], nfct_get_attr_u32(ct, ATTR_TIMEOUT), rule->dst_nat);
 
-	IPACMDBG("updating %d connection with time: %d\n",
-					 rule->protocol, nfct_get_attr_u32(ct, ATTR_TIMEOUT));
+			ret = nfct_build_query(nfct_subsys_ct(ct_hdl), NFCT_Q_UPDATE, ct,
+								   req + len, sizeof(req) - len);
+			if(ret == -1)
+			{
+				IPACMERR("unable to build update for connection(%d)\n", ts_slots[cnt]);
+				continue;
+			}
+			/* no ack: the kernel only answers an update that failed */
+			nlh = (struct nlmsghdr *)(req + len);
+			nlh->nlmsg_flags &= ~NLM_F_ACK;
+			nlh->nlmsg_seq = seq_base + cnt;
+			len += NLMSG_ALIGN(nlh->nlmsg_len);
+			built[nbuilt++] = cnt;
+		}
 
-	ret = nfct_query(ct_hdl, NFCT_Q_UPDATE, ct);
-	if(ret == -1)
-	{
-		IPACMERR("unable to update time stamp");
-		DeleteEntry(rule);
-	}
-	else
-	{
-		rule->timestamp = new_ts;
-		IPACMDBG("Updated time stamp successfully\n");
-	}
-#else
-	if(rule->protocol == IPPROTO_UDP)
-	{
-		entry.proto = IOffloadManager::ConntrackTimeoutUpdater::UDP;;
-	}
-	else
-	{
-		entry.proto = IOffloadManager::ConntrackTimeoutUpdater::TCP;
-	}
+		if(len == 0)
+		{
+			continue;
+		}
 
-	if(rule->dst_nat == false)
-	{
-		entry.src.ipAddr = htonl(rule->private_ip);
-		entry.src.port = rule->private_port;
-		entry.dst.ipAddr = htonl(rule->target_ip);
-		entry.dst.port = rule->target_port;
-		IPACMDBG("dst nat is not set\n");
-	}
-	else
-	{
-		entry.src.ipAddr = htonl(rule->target_ip);
-		entry.src.port = rule->target_port;
-		entry.dst.ipAddr = htonl(pub_ip_addr);
-		entry.dst.port = rule->public_port;
-		IPACMDBG("dst nat is set\n");
-	}
+		syscalls++;
+		if(sendto(fd, req, len, 0, (struct sockaddr *)&nladdr, sizeof(nladdr)) < 0)
+		{
+			PERROR("sendto");
+			break;
+		}
 
-	iptodot("Source IP:", entry.src.ipAddr);
-	iptodot("Destination IP:",  entry.dst.ipAddr);
-	IPACMDBG("Source Port: %d, Destination Port: %d\n",
-					entry.src.port, entry.dst.port);
+		for(i = 0; i < nbuilt; i++)
+		{
+			cache[ts_slots[built[i]]].timestamp = ts_vals[built[i]];
+		}
 
-	OffloadMng = IPACM_OffloadManager::GetInstance();
-	if (OffloadMng->touInstance == NULL) {
-		IPACMERR("OffloadMng->touInstance is NULL, can't forward to framework!\n");
-	} else {
-		OffloadMng->touInstance->updateTimeout(entry);
-		IPACMDBG("Updated time stamp successfully\n");
-		rule->timestamp = new_ts;
+		/* the kernel runs the whole request inside sendto(), so the errors
+		   of the updates that failed are all queued by now */
+		while(true)
+		{
+			syscalls++;
+			ret = recv(fd, resp, sizeof(resp), MSG_DONTWAIT);
+			if(ret <= 0)
+			{
+				break;
+			}
+
+			for(nlh = (struct nlmsghdr *)resp; NLMSG_OK(nlh, ret); nlh = NLMSG_NEXT(nlh, ret))
+			{
+				if(nlh->nlmsg_type != NLMSG_ERROR)
+				{
+					continue;
+				}
+				err = (struct nlmsgerr *)NLMSG_DATA(nlh);
+				idx = err->msg.nlmsg_seq - seq_base;
+				if(err->error == 0 || idx >= (uint32_t)cnt)
+				{
+					continue;
+				}
+
+				IPACMERR("unable to update time stamp of connection(%d)\n", ts_slots[idx]);
+				DeleteEntry(&cache[ts_slots[idx]]);
+			}
+		}
 	}
+
+	return syscalls;
 #endif
-	return;
 }
 
 void NatApp::UpdateUDPTimeStamp()
 {
-	int cnt;
-	uint32_t ts;
-	bool read_to = false;
+	int cnt, num = 0, changed = 0, syscalls = 0;
+	uint16_t moves = 0;
+	struct timespec start, end;
+#ifdef IPACM_DEBUG
+	ipa_nat_chain_stats rule_stats, index_stats;
+#endif
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
 
 	for(cnt = 0; cnt < max_entries; cnt++)
 	{
-		ts = 0;
 		if(cache[cnt].enabled == true &&
 		   (cache[cnt].private_ip != cache[cnt].public_ip))
 		{
-			IPACMDBG("\n");
-			if(ipa_nat_query_timestamp(nat_table_hdl, cache[cnt].rule_hdl, &ts) < 0)
-			{
-				IPACMERR("unable to retrieve timeout for rule hanle: %d\n", cache[cnt].rule_hdl);
-				continue;
-			}
+			ts_slots[num] = cnt;
+			ts_rule_hdls[num] = cache[cnt].rule_hdl;
+			num++;
+		}
+	}
 
-			if(cache[cnt].timestamp == ts)
-			{
-				IPACMDBG("No Change in Time Stamp: cahce:%d, ipahw:%d\n",
-								                  cache[cnt].timestamp, ts);
-				continue;
-			}
+	if(num == 0)
+	{
+		return;
+	}
 
-			if (read_to == false) {
-				read_to = true;
-				Read_TcpUdp_Timeout();
-			}
+	/* one pass over the mmapped table instead of a query per rule */
+	if(ipa_nat_query_timestamps(nat_table_hdl, num, ts_rule_hdls, ts_vals) < 0)
+	{
+		IPACMERR("unable to retrieve timestamps of %d rules\n", num);
+		return;
+	}
+
+	/* cache[].timestamp shadows the last synced value, keep the ones that moved */
+	for(cnt = 0; cnt < num; cnt++)
+	{
+		if(cache[ts_slots[cnt]].timestamp != ts_vals[cnt])
+		{
+			ts_slots[changed] = ts_slots[cnt];
+			ts_vals[changed] = ts_vals[cnt];
+			changed++;
+		}
+	}
+
+	if(changed > 0)
+	{
+		Read_TcpUdp_Timeout();
+		syscalls = UpdateCTUdpTs(changed);
+	}
 
-			UpdateCTUdpTs(&cache[cnt], ts);
-		} /* end of outer if */
+	/* deleted chain heads linger in the table, fold a few back each sweep */
+	if(ipa_nat_compact_ipv4_tbl(nat_table_hdl, NAT_COMPACT_MOVES, &moves) < 0)
+	{
+		IPACMERR("unable to compact nat table\n");
+	}
 
-	} /* end of for loop */
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	IPACMDBG_H("Timestamp sweep: %d rules, %d changed, %d conntrack syscalls, %d compacted, %ld us\n",
+			   num, changed, syscalls, moves,
+			   (long)((end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000));
 
+#ifdef IPACM_DEBUG
+	/* walks every chain under the nat driver lock, debug builds only */
+	if(ipa_nat_get_chain_stats(nat_table_hdl, &rule_stats, &index_stats) == 0)
+	{
+		IPACMDBG_H("Nat chains: longest %d, %d dead; index chains: longest %d, %d dead\n",
+				   rule_stats.longest, rule_stats.dead, index_stats.longest, index_stats.dead);
+	}
+#endif
 }
 
 bool NatApp::isAlgPort(uint8_t proto, uint16_t port)
@@ -628,7 +939,8 @@ int NatApp::UpdatePwrSaveIf(uint32_t client_lan_ip)
 		}
 	}
 
-	for(cnt = 0; cnt < max_entries; cnt++)
+	for(cnt = clnt_bkt[nat_ip_hash(client_lan_ip) & ip_bkt_mask];
+		cnt != NAT_INVALID_SLOT; cnt = links[cnt].clnt_next)
 	{
 		if(cache[cnt].private_ip == client_lan_ip &&
 			 cache[cnt].enabled == true)
@@ -649,7 +961,7 @@ int NatApp::UpdatePwrSaveIf(uint32_t client_lan_ip)
 
 int NatApp::ResetPwrSaveIf(uint32_t client_lan_ip)
 {
-	int cnt;
+	int cnt, next;
 	ipa_nat_ipv4_rule nat_rule;
 
 	IPACMDBG_H("Received ip address: 0x%x\n", client_lan_ip);
@@ -669,8 +981,10 @@ int NatApp::ResetPwrSaveIf(uint32_t client_lan_ip)
 		}
 	}
 
-	for(cnt = 0; cnt < max_entries; cnt++)
+	for(cnt = clnt_bkt[nat_ip_hash(client_lan_ip) & ip_bkt_mask];
+		cnt != NAT_INVALID_SLOT; cnt = next)
 	{
+		next = links[cnt].clnt_next;
 		IPACMDBG("cache (%d): enable %d, ip 0x%x\n", cnt, cache[cnt].enabled, cache[cnt].private_ip);
 
 		if(cache[cnt].private_ip == client_lan_ip &&
@@ -687,8 +1001,7 @@ int NatApp::ResetPwrSaveIf(uint32_t client_lan_ip)
 			if(ipa_nat_add_ipv4_rule(nat_table_hdl, &nat_rule, &cache[cnt].rule_hdl) < 0)
 			{
 				IPACMERR("unable to add the rule delete from cache\n");
-				memset(&cache[cnt], 0, sizeof(cache[cnt]));
-				curCnt--;
+				ReleaseEntry(cnt);
 				continue;
 			}
 			cache[cnt].enabled = true;
@@ -856,7 +1169,8 @@ int NatApp::DelEntriesOnClntDiscon(uint32_t ip_addr)
 		}
 	}
 
-	for(cnt = 0; cnt < max_entries; cnt++)
+	for(cnt = clnt_bkt[nat_ip_hash(ip_addr) & ip_bkt_mask];
+		cnt != NAT_INVALID_SLOT; cnt = links[cnt].clnt_next)
 	{
 		if(cache[cnt].private_ip == ip_addr)
 		{
@@ -884,7 +1198,7 @@ int NatApp::DelEntriesOnClntDiscon(uint32_t ip_addr)
 
 int NatApp::DelEntriesOnSTAClntDiscon(uint32_t ip_addr)
 {
-	int cnt, tmp = curCnt;
+	int cnt, next, tmp = curCnt;
 	IPACMDBG_H("Received IP address: 0x%x\n", ip_addr);
 
 	if(ip_addr == INVALID_IP_ADDR)
@@ -894,8 +1208,10 @@ int NatApp::DelEntriesOnSTAClntDiscon(uint32_t ip_addr)
 	}
 
 
-	for(cnt = 0; cnt < max_entries; cnt++)
+	for(cnt = tgt_bkt[nat_ip_hash(ip_addr) & ip_bkt_mask];
+		cnt != NAT_INVALID_SLOT; cnt = next)
 	{
+		next = links[cnt].tgt_next;
 		if(cache[cnt].target_ip == ip_addr)
 		{
 			if(cache[cnt].enabled == true)
@@ -907,8 +1223,7 @@ int NatApp::DelEntriesOnSTAClntDiscon(uint32_t ip_addr)
 				}
 			}
 
-			memset(&cache[cnt], 0, sizeof(cache[cnt]));
-			curCnt--;
+			ReleaseEntry(cnt);
 		}
 	}
 
@@ -932,19 +1247,8 @@ void NatApp::CacheEntry(const nat_table_entry *rule)
 
 	if(!ChkForDup(rule))
 	{
-		for(cnt=0; cnt < max_entries; cnt++)
-		{
-			if(cache[cnt].private_ip == 0 &&
-				 cache[cnt].target_ip == 0 &&
-				 cache[cnt].private_port == 0  &&
-				 cache[cnt].target_port == 0 &&
-				 cache[cnt].protocol == 0)
-			{
-				break;
-			}
-		}
-
-		if(max_entries == cnt)
+		cnt = free_head;
+		if(cnt == NAT_INVALID_SLOT)
 		{
 			IPACMERR("Error: Unable to add, reached maximum rules\n");
 			return;
@@ -962,7 +1266,7 @@ void NatApp::CacheEntry(const nat_table_entry *rule)
 			cache[cnt].public_port = rule->public_port;
 			cache[cnt].public_ip = rule->public_ip;
 			cache[cnt].dst_nat = rule->dst_nat;
-			curCnt++;
+			IndexEntry(cnt);
 		}
 
 	}
@@ -38,17 +38,18 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include <string.h>
 #include <pthread.h>
+#include <time.h>
 #include <IPACM_EvtDispatcher.h>
 #include <IPACM_Neighbor.h>
 #include "IPACM_CmdQueue.h"
 #include "IPACM_Defs.h"
 
 
-extern pthread_mutex_t mutex;
-extern pthread_cond_t  cond_var;
-
-cmd_evts *IPACM_EvtDispatcher::head = NULL;
+evt_listeners *IPACM_EvtDispatcher::listeners[IPACM_EVENT_MAX];
+evt_listeners *IPACM_EvtDispatcher::in_dispatch = NULL;
+bool IPACM_EvtDispatcher::in_dispatch_retired = false;
 extern uint32_t ipacm_event_stats[IPACM_EVENT_MAX];
+extern uint32_t ipacm_event_latency[IPACM_EVENT_MAX][IPACM_EVT_LAT_HIST_SIZE];
 
 int IPACM_EvtDispatcher::PostEvt
 (
@@ -58,7 +59,13 @@ int IPACM_EvtDispatcher::PostEvt
 	Message *item = NULL;
 	MessageQueue *MsgQueue = NULL;
 
-	if(data->event < IPA_EXTERNAL_EVENT_MAX)
+	if(data->event >= IPA_HANDLE_WAN_UP && data->event <= IPA_HANDLE_WAN_DOWN_V6_TETHER)
+	{
+		/* upstream changes go ahead of neighbor/route bursts */
+		IPACMDBG("Insert event into priority queue.\n");
+		MsgQueue = MessageQueue::getInstancePriority();
+	}
+	else if(data->event < IPA_EXTERNAL_EVENT_MAX)
 	{
 		IPACMDBG("Insert event into external queue.\n");
 		MsgQueue = MessageQueue::getInstanceExternal();
@@ -74,7 +81,7 @@ int IPACM_EvtDispatcher::PostEvt
 		return IPACM_FAILURE;
 	}
 
-	item = new Message();
+	item = MessageQueue::allocMessage();
 	if(item == NULL)
 	{
 		IPACMERR("unable to create new message item\n");
@@ -84,130 +91,225 @@ int IPACM_EvtDispatcher::PostEvt
 	item->evt.callback_ptr = IPACM_EvtDispatcher::ProcessEvt;
 	memcpy(&item->evt.data, data, sizeof(ipacm_cmd_q_data));
 
-	if(pthread_mutex_lock(&mutex) != 0)
-	{
-		IPACMERR("unable to lock the mutex\n");
-		return IPACM_FAILURE;
-	}
-
 	IPACMDBG("Enqueing item\n");
 	MsgQueue->enqueue(item);
 	IPACMDBG("Enqueued item %p\n", item);
 
-	if(pthread_cond_signal(&cond_var) != 0)
-	{
-		IPACMDBG("unable to lock the mutex\n");
-		/* Release the mutex before you return failure */
-		if(pthread_mutex_unlock(&mutex) != 0)
-		{
-			IPACMERR("unable to unlock the mutex\n");
-			return IPACM_FAILURE;
-		}
-		return IPACM_FAILURE;
-	}
-
-	if(pthread_mutex_unlock(&mutex) != 0)
-	{
-		IPACMERR("unable to unlock the mutex\n");
-		return IPACM_FAILURE;
-	}
-
-	return IPACM_SUCCESS;
+	return MessageQueue::wakeup();
 }
 
 void IPACM_EvtDispatcher::ProcessEvt(ipacm_cmd_q_data *data)
 {
+	static uint32_t dispatched = 0;
+	evt_listeners *snapshot;
+	struct timespec start, end;
+	long lat_us;
+	int cnt, bucket;
 
-	cmd_evts *tmp = head, tmp1;
+	clock_gettime(CLOCK_MONOTONIC, &start);
 
-	if(head == NULL)
+	snapshot = listeners[data->event];
+	if(snapshot == NULL)
 	{
-		IPACMDBG("Queue is empty\n");
+		IPACMDBG("No listener for event %d\n", data->event);
 	}
-
-	while(tmp != NULL)
+	else
 	{
-	        memcpy(&tmp1, tmp, sizeof(tmp1));
-		if(data->event == tmp1.event)
+		in_dispatch = snapshot;
+		in_dispatch_retired = false;
+
+		for(cnt = 0; cnt < snapshot->num; cnt++)
 		{
+			/* an earlier callback changed the listeners, skip the ones it removed */
+			if(listeners[data->event] != snapshot &&
+				 !IsRegistered(data->event, snapshot->obj[cnt]))
+			{
+				continue;
+			}
 			ipacm_event_stats[data->event]++;
-			tmp1.obj->event_callback(data->event, data->evt_data);
+			snapshot->obj[cnt]->event_callback(data->event, data->evt_data);
 			IPACMDBG(" Find matched registered events\n");
 		}
-	        tmp = tmp1.next;
+
+		in_dispatch = NULL;
+		if(in_dispatch_retired)
+		{
+			free(snapshot);
+		}
 	}
 
 	IPACMDBG(" Finished process events\n");
-			
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	lat_us = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+	for(bucket = 0; bucket < IPACM_EVT_LAT_HIST_SIZE - 1; bucket++)
+	{
+		if(lat_us < ((long)IPACM_EVT_LAT_BASE_US << (2 * bucket)))
+		{
+			break;
+		}
+	}
+	ipacm_event_latency[data->event][bucket]++;
+
 	if(data->evt_data != NULL)
 	{
 		IPACMDBG("free the event:%d data: %p\n", data->event, data->evt_data);
 		free(data->evt_data);
 	}
+
+	if(++dispatched % IPACM_EVT_STATS_DUMP_INTERVAL == 0)
+	{
+		DumpEvtStats();
+	}
 	return;
 }
 
-int IPACM_EvtDispatcher::registr(ipa_cm_event_id event, IPACM_Listener *obj)
+void IPACM_EvtDispatcher::DumpEvtStats(void)
 {
-	cmd_evts *tmp = head,*nw;
+	int evt, bucket;
+	uint32_t *hist;
 
-	nw = (cmd_evts *)malloc(sizeof(cmd_evts));
-	if(nw != NULL)
+	for(evt = 0; evt < IPACM_EVENT_MAX; evt++)
 	{
-		nw->event = event;
-		nw->obj = obj;
-		nw->next = NULL;
+		hist = ipacm_event_latency[evt];
+		for(bucket = 0; bucket < IPACM_EVT_LAT_HIST_SIZE; bucket++)
+		{
+			if(hist[bucket] != 0)
+			{
+				break;
+			}
+		}
+		if(bucket == IPACM_EVT_LAT_HIST_SIZE)
+		{
+			continue;
+		}
+		IPACMDBG_H("event %d: callbacks %u latency(us) <16:%u <64:%u <256:%u <1k:%u <4k:%u <16k:%u <64k:%u more:%u\n",
+						 evt, ipacm_event_stats[evt], hist[0], hist[1], hist[2], hist[3],
+						 hist[4], hist[5], hist[6], hist[7]);
 	}
-	else
+	return;
+}
+
+/* Install a new listener list for the event. The old one is freed unless
+	 the running dispatch still walks it, in which case it goes once the
+	 dispatch is over. */
+int IPACM_EvtDispatcher::ReplaceListeners(ipa_cm_event_id event, evt_listeners *nw)
+{
+	evt_listeners *old = listeners[event];
+
+	listeners[event] = nw;
+	if(old != NULL)
 	{
-		return IPACM_FAILURE;
+		if(old == in_dispatch)
+		{
+			in_dispatch_retired = true;
+		}
+		else
+		{
+			free(old);
+		}
 	}
+	return IPACM_SUCCESS;
+}
 
-	if(head == NULL)
+bool IPACM_EvtDispatcher::IsRegistered(ipa_cm_event_id event, IPACM_Listener *obj)
+{
+	evt_listeners *list = listeners[event];
+	int cnt;
+
+	if(list == NULL)
 	{
-		head = nw;
+		return false;
 	}
-	else
+
+	for(cnt = 0; cnt < list->num; cnt++)
 	{
-		while(tmp->next)
+		if(list->obj[cnt] == obj)
 		{
-			tmp = tmp->next;
+			return true;
 		}
-		tmp->next = nw;
 	}
-	return IPACM_SUCCESS;
+	return false;
+}
+
+int IPACM_EvtDispatcher::registr(ipa_cm_event_id event, IPACM_Listener *obj)
+{
+	evt_listeners *old, *nw;
+	int num;
+
+	if(event >= IPACM_EVENT_MAX)
+	{
+		IPACMERR("Invalid event %d\n", event);
+		return IPACM_FAILURE;
+	}
+
+	old = listeners[event];
+	num = (old != NULL) ? old->num : 0;
+
+	nw = (evt_listeners *)malloc(sizeof(evt_listeners) + num * sizeof(IPACM_Listener *));
+	if(nw == NULL)
+	{
+		return IPACM_FAILURE;
+	}
+
+	/* keep registration order, callbacks run in it */
+	if(num > 0)
+	{
+		memcpy(nw->obj, old->obj, num * sizeof(IPACM_Listener *));
+	}
+	nw->obj[num] = obj;
+	nw->num = num + 1;
+
+	return ReplaceListeners(event, nw);
 }
 
 
 int IPACM_EvtDispatcher::deregistr(IPACM_Listener *param)
 {
-	cmd_evts *tmp = head,*tmp1,*prev = head;
+	evt_listeners *old, *nw;
+	int evt, cnt, num;
 
-	while(tmp != NULL)
+	for(evt = 0; evt < IPACM_EVENT_MAX; evt++)
 	{
-		if(tmp->obj == param)
+		old = listeners[evt];
+		if(old == NULL || !IsRegistered((ipa_cm_event_id)evt, param))
 		{
-			tmp1 = tmp;
-			if(tmp == head)
+			continue;
+		}
+
+		/* only the list a dispatch is walking needs a copy */
+		nw = old;
+		if(old == in_dispatch)
+		{
+			nw = (evt_listeners *)malloc(sizeof(evt_listeners) + old->num * sizeof(IPACM_Listener *));
+			if(nw == NULL)
 			{
-				head = head->next;
+				IPACMERR("unable to allocate memory\n");
+				return IPACM_FAILURE;
 			}
-			else if(tmp->next == NULL)
+		}
+
+		num = 0;
+		for(cnt = 0; cnt < old->num; cnt++)
+		{
+			if(old->obj[cnt] != param)
 			{
-				prev->next = NULL;
+				nw->obj[num++] = old->obj[cnt];
 			}
-			else
+		}
+		nw->num = num;
+
+		if(num == 0)
+		{
+			if(nw != old)
 			{
-				prev->next = tmp->next;
+				free(nw);
 			}
-
-			tmp = tmp->next;
-			free(tmp1);
+			nw = NULL;
 		}
-		else
+		if(nw != old)
 		{
-			prev = tmp;
-			tmp = tmp->next;
+			ReplaceListeners((ipa_cm_event_id)evt, nw);
 		}
 	}
 	return IPACM_SUCCESS;
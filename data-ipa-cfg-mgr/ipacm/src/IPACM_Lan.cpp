@@ -67,6 +67,7 @@ IPACM_Lan::IPACM_Lan(int iface_index) : IPACM_Iface(iface_index)
 	odu_route_rule_v4_hdl = NULL;
 	odu_route_rule_v6_hdl = NULL;
 	eth_client = NULL;
+	client_dir = NULL;
 	int m_fd_odu, ret = IPACM_SUCCESS;
 	uint32_t i;
 
@@ -100,7 +101,7 @@ IPACM_Lan::IPACM_Lan(int iface_index) : IPACM_Iface(iface_index)
 		if(ipa_if_cate != WLAN_IF)
 		{
 			eth_client_len = (sizeof(ipa_eth_client)) + (iface_query->num_tx_props * sizeof(eth_client_rt_hdl));
-			eth_client = (ipa_eth_client *)calloc(IPA_MAX_NUM_ETH_CLIENTS, eth_client_len);
+			eth_client = (ipa_eth_client *)calloc(IPACM_Iface::ipacmcfg->GetMaxEthClients(), eth_client_len);
 			if (eth_client == NULL)
 			{
 				IPACMERR("unable to allocate memory\n");
@@ -108,6 +109,9 @@ IPACM_Lan::IPACM_Lan(int iface_index) : IPACM_Iface(iface_index)
 			}
 		}
 
+		client_dir = new IPACM_ClientDir((ipa_if_cate == WLAN_IF) ?
+			IPACM_Iface::ipacmcfg->GetMaxWlanClients() : IPACM_Iface::ipacmcfg->GetMaxEthClients());
+
 		IPACMDBG_H(" IPACM->IPACM_Lan(%d) constructor: Tx:%d Rx:%d \n", ipa_if_num,
 					 iface_query->num_tx_props, iface_query->num_rx_props);
 
@@ -221,6 +225,7 @@ IPACM_Lan::~IPACM_Lan()
 {
 	IPACM_EvtDispatcher::deregistr(this);
 	IPACM_IfaceManager::deregistr(this);
+	delete client_dir;
 	return;
 }
 
@@ -1136,6 +1141,7 @@ int IPACM_Lan::handle_del_ipv6_addr(ipacm_event_data_all *data)
 				}
 				get_client_memptr(eth_client, clnt_indx)->ipv6_set--;
 				get_client_memptr(eth_client, clnt_indx)->route_rule_set_v6--;
+				client_dir->DelV6(data->mac_addr, data->ipv6_addr);
 
 				for(;num_v6< get_client_memptr(eth_client, clnt_indx)->ipv6_set;num_v6++)
 				{
@@ -1794,9 +1800,9 @@ int IPACM_Lan::handle_eth_hdr_init(uint8_t *mac_addr)
 	}
 
 	/* add header to IPA */
-	if (num_eth_client >= IPA_MAX_NUM_ETH_CLIENTS)
+	if (num_eth_client >= (uint32_t)IPACM_Iface::ipacmcfg->GetMaxEthClients())
 	{
-		IPACMERR("Reached maximum number(%d) of eth clients\n", IPA_MAX_NUM_ETH_CLIENTS);
+		IPACMERR("Reached maximum number(%d) of eth clients\n", IPACM_Iface::ipacmcfg->GetMaxEthClients());
 		return IPACM_FAILURE;
 	}
 
@@ -2033,6 +2039,8 @@ int IPACM_Lan::handle_eth_hdr_init(uint8_t *mac_addr)
 		get_client_memptr(eth_client, num_eth_client)->route_rule_set_v6 = 0;
 		get_client_memptr(eth_client, num_eth_client)->ipv4_set = false;
 		get_client_memptr(eth_client, num_eth_client)->ipv6_set = 0;
+		get_client_memptr(eth_client, num_eth_client)->dir_hdl =
+			client_dir->Add(get_client_memptr(eth_client, num_eth_client)->mac, num_eth_client);
 		num_eth_client++;
 		header_name_count++; //keep increasing header_name_count
 		res = IPACM_SUCCESS;
@@ -2050,8 +2058,7 @@ fail:
 /*handle eth client */
 int IPACM_Lan::handle_eth_client_ipaddr(ipacm_event_data_all *data)
 {
-	int clnt_indx;
-	int v6_num;
+	int clnt_indx, owner;
 	uint32_t ipv6_link_local_prefix = 0xFE800000;
 	uint32_t ipv6_link_local_prefix_mask = 0xFFC00000;
 
@@ -2078,10 +2085,19 @@ int IPACM_Lan::handle_eth_client_ipaddr(ipacm_event_data_all *data)
 		IPACMDBG_H("ipv4 address: 0x%x\n", data->ipv4_addr);
 		if (data->ipv4_addr != 0) /* not 0.0.0.0 */
 		{
+			/* the address was handed out again, the previous holder's rules would shadow the new ones */
+			owner = get_eth_client_index_v4(data->ipv4_addr);
+			if (owner != IPACM_INVALID_INDEX && owner != clnt_indx)
+			{
+				IPACMDBG_H("ipv4 addr 0x%x moved from client:%d to client:%d\n", data->ipv4_addr, owner, clnt_indx);
+				release_eth_client_ipaddr(get_client_memptr(eth_client, owner)->dir_hdl, data);
+			}
+
 			if (get_client_memptr(eth_client, clnt_indx)->ipv4_set == false)
 			{
 				get_client_memptr(eth_client, clnt_indx)->v4_addr = data->ipv4_addr;
 				get_client_memptr(eth_client, clnt_indx)->ipv4_set = true;
+				client_dir->SetV4(data->mac_addr, data->ipv4_addr);
 			}
 			else
 			{
@@ -2099,6 +2115,7 @@ int IPACM_Lan::handle_eth_client_ipaddr(ipacm_event_data_all *data)
 					delete_eth_rtrules(clnt_indx,IPA_IP_v4);
 					get_client_memptr(eth_client, clnt_indx)->route_rule_set_v4 = false;
 					get_client_memptr(eth_client, clnt_indx)->v4_addr = data->ipv4_addr;
+					client_dir->SetV4(data->mac_addr, data->ipv4_addr);
 				}
 			}
 		}
@@ -2123,17 +2140,16 @@ int IPACM_Lan::handle_eth_client_ipaddr(ipacm_event_data_all *data)
 
             if(get_client_memptr(eth_client, clnt_indx)->ipv6_set < IPV6_NUM_ADDR)
 			{
-
-		       for(v6_num=0;v6_num < get_client_memptr(eth_client, clnt_indx)->ipv6_set;v6_num++)
+				owner = get_eth_client_index_v6(data->ipv6_addr);
+				if (owner == clnt_indx)
 				{
-					if( data->ipv6_addr[0] == get_client_memptr(eth_client, clnt_indx)->v6_addr[v6_num][0] &&
-			           data->ipv6_addr[1] == get_client_memptr(eth_client, clnt_indx)->v6_addr[v6_num][1] &&
-			  	        data->ipv6_addr[2]== get_client_memptr(eth_client, clnt_indx)->v6_addr[v6_num][2] &&
-			  	         data->ipv6_addr[3] == get_client_memptr(eth_client, clnt_indx)->v6_addr[v6_num][3])
-					{
-						IPACMDBG_H("Already see this ipv6 addr at position: %d for client:%d\n", v6_num, clnt_indx);
-						return IPACM_FAILURE; /* not setup the RT rules*/
-					}
+					IPACMDBG_H("Already see this ipv6 addr for client:%d\n", clnt_indx);
+					return IPACM_FAILURE; /* not setup the RT rules*/
+				}
+				if (owner != IPACM_INVALID_INDEX)
+				{
+					IPACMDBG_H("ipv6 addr moved from client:%d to client:%d\n", owner, clnt_indx);
+					release_eth_client_ipaddr(get_client_memptr(eth_client, owner)->dir_hdl, data);
 				}
 
 		       /* not see this ipv6 before for wifi client*/
@@ -2142,6 +2158,7 @@ int IPACM_Lan::handle_eth_client_ipaddr(ipacm_event_data_all *data)
 			   get_client_memptr(eth_client, clnt_indx)->v6_addr[get_client_memptr(eth_client, clnt_indx)->ipv6_set][2] = data->ipv6_addr[2];
 			   get_client_memptr(eth_client, clnt_indx)->v6_addr[get_client_memptr(eth_client, clnt_indx)->ipv6_set][3] = data->ipv6_addr[3];
 			   get_client_memptr(eth_client, clnt_indx)->ipv6_set++;
+			   client_dir->AddV6(data->mac_addr, data->ipv6_addr);
 		    }
 		    else
 		    {
@@ -2159,6 +2176,52 @@ int IPACM_Lan::handle_eth_client_ipaddr(ipacm_event_data_all *data)
 	return IPACM_SUCCESS;
 }
 
+/* The client holding owner_hdl lost data's address to another client: its routing
+   rules for the address go away, the remaining ipv6 addresses get theirs back */
+int IPACM_Lan::release_eth_client_ipaddr(uint32_t owner_hdl, ipacm_event_data_all *data)
+{
+	ipa_eth_client *client;
+	int clt_indx, num_v6;
+
+	clt_indx = client_dir->GetIndex(owner_hdl);
+	if (clt_indx == IPACM_INVALID_INDEX)
+	{
+		IPACMERR("stale client handle 0x%x\n", owner_hdl);
+		return IPACM_FAILURE;
+	}
+	client = get_client_memptr(eth_client, clt_indx);
+
+	if (data->iptype == IPA_IP_v4)
+	{
+		delete_eth_rtrules(clt_indx, IPA_IP_v4);
+		client->ipv4_set = false;
+		client->v4_addr = 0;
+		client_dir->SetV4(client->mac, 0);
+		return IPACM_SUCCESS;
+	}
+
+	for (num_v6 = 0; num_v6 < client->ipv6_set; num_v6++)
+	{
+		if (memcmp(client->v6_addr[num_v6], data->ipv6_addr, sizeof(client->v6_addr[num_v6])) == 0)
+		{
+			break;
+		}
+	}
+	if (num_v6 == client->ipv6_set)
+	{
+		return IPACM_FAILURE;
+	}
+
+	delete_eth_rtrules(clt_indx, IPA_IP_v6);
+	client_dir->DelV6(client->mac, data->ipv6_addr);
+	client->ipv6_set--;
+	for (; num_v6 < client->ipv6_set; num_v6++)
+	{
+		memcpy(client->v6_addr[num_v6], client->v6_addr[num_v6 + 1], sizeof(client->v6_addr[num_v6]));
+	}
+	return handle_eth_client_route_rule(client->mac, IPA_IP_v6);
+}
+
 /*handle eth client routing rule*/
 int IPACM_Lan::handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptype)
 {
@@ -2167,6 +2230,7 @@ int IPACM_Lan::handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptyp
 	uint32_t tx_index;
 	int eth_index,v6_num;
 	const int NUM = 1;
+	IPACM_RuleTxn txn(&m_filtering, &m_routing, &m_header);
 
 	if(tx_prop == NULL)
 	{
@@ -2220,7 +2284,7 @@ int IPACM_Lan::handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptyp
 			return IPACM_FAILURE;
 		}
 
-		rt_rule->commit = 1;
+		rt_rule->commit = 0;
 		rt_rule->num_rules = (uint8_t)NUM;
 		rt_rule->ip = iptype;
 
@@ -2259,18 +2323,13 @@ int IPACM_Lan::handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptyp
 #ifdef FEATURE_IPA_V3
 				rt_rule_entry->rule.hashable = false;
 #endif
-				if (false == m_routing.AddRoutingRule(rt_rule))
+				if (false == txn.AddRoutingRule(iptype, rt_rule->rt_tbl_name, rt_rule_entry,
+						&get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v4))
 				{
 					IPACMERR("Routing rule addition failed!\n");
 					free(rt_rule);
 					return IPACM_FAILURE;
 				}
-
-			    /* copy ipv4 RT hdl */
-		        get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v4 =
-  	   	        rt_rule->rules[0].rt_rule_hdl;
-		        IPACMDBG_H("tx:%d, rt rule hdl=%x ip-type: %d\n", tx_index,
-		      	get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v4, iptype);
 			} else {
 
 		        for(v6_num = get_client_memptr(eth_client, eth_index)->route_rule_set_v6;v6_num < get_client_memptr(eth_client, eth_index)->ipv6_set;v6_num++)
@@ -2300,17 +2359,14 @@ int IPACM_Lan::handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptyp
 #ifdef FEATURE_IPA_V3
 					rt_rule_entry->rule.hashable = true;
 #endif
-			if (false == m_routing.AddRoutingRule(rt_rule))
+			if (false == txn.AddRoutingRule(iptype, rt_rule->rt_tbl_name, rt_rule_entry,
+					&get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6[v6_num]))
 			{
 				IPACMERR("Routing rule addition failed!\n");
 				free(rt_rule);
 				return IPACM_FAILURE;
 			}
 
-		            get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6[v6_num] = rt_rule->rules[0].rt_rule_hdl;
-		            IPACMDBG_H("tx:%d, rt rule hdl=%x ip-type: %d\n", tx_index,
-		            				 get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6[v6_num], iptype);
-
 			        /*Copy same rule to v6 WAN RT TBL*/
 				strlcpy(rt_rule->rt_tbl_name, IPACM_Iface::ipacmcfg->rt_tbl_wan_v6.name, sizeof(rt_rule->rt_tbl_name));
 				rt_rule->rt_tbl_name[IPA_RESOURCE_NAME_MAX-1] = '\0';
@@ -2332,16 +2388,13 @@ int IPACM_Lan::handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptyp
 #ifdef FEATURE_IPA_V3
 					rt_rule_entry->rule.hashable = true;
 #endif
-		            if (false == m_routing.AddRoutingRule(rt_rule))
+		            if (false == txn.AddRoutingRule(iptype, rt_rule->rt_tbl_name, rt_rule_entry,
+		            		&get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6_wan[v6_num]))
 		            {
 							IPACMERR("Routing rule addition failed!\n");
 							free(rt_rule);
 							return IPACM_FAILURE;
 		            }
-
-		            get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6_wan[v6_num] = rt_rule->rules[0].rt_rule_hdl;
-					IPACMDBG_H("tx:%d, rt rule hdl=%x ip-type: %d\n", tx_index,
-		            				 get_client_memptr(eth_client, eth_index)->eth_rt_hdl[tx_index].eth_rt_rule_hdl_v6_wan[v6_num], iptype);
 			    }
 			}
 
@@ -2349,6 +2402,13 @@ int IPACM_Lan::handle_eth_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptyp
 
 		free(rt_rule);
 
+		/* all rules of the client go out in one ioctl per table and one commit */
+		if (false == txn.End())
+		{
+			IPACMERR("Routing rule addition failed!\n");
+			return IPACM_FAILURE;
+		}
+
 		if (iptype == IPA_IP_v4)
 		{
 			get_client_memptr(eth_client, eth_index)->route_rule_set_v4 = true;
@@ -2755,6 +2815,10 @@ int IPACM_Lan::handle_eth_client_down_evt(uint8_t *mac_addr)
 	get_client_memptr(eth_client, clt_indx)->route_rule_set_v4 = false;
 	get_client_memptr(eth_client, clt_indx)->route_rule_set_v6 = 0;
 
+	/* the clients after this one move down one entry */
+	client_dir->Remove(mac_addr);
+	client_dir->ShiftDown(clt_indx);
+
 	for (; clt_indx < num_eth_client_tmp - 1; clt_indx++)
 	{
 		memcpy(get_client_memptr(eth_client, clt_indx)->mac,
@@ -2764,6 +2828,7 @@ int IPACM_Lan::handle_eth_client_down_evt(uint8_t *mac_addr)
 		get_client_memptr(eth_client, clt_indx)->hdr_hdl_v4 = get_client_memptr(eth_client, (clt_indx + 1))->hdr_hdl_v4;
 		get_client_memptr(eth_client, clt_indx)->hdr_hdl_v6 = get_client_memptr(eth_client, (clt_indx + 1))->hdr_hdl_v6;
 		get_client_memptr(eth_client, clt_indx)->v4_addr = get_client_memptr(eth_client, (clt_indx + 1))->v4_addr;
+		get_client_memptr(eth_client, clt_indx)->dir_hdl = get_client_memptr(eth_client, (clt_indx + 1))->dir_hdl;
 
 		get_client_memptr(eth_client, clt_indx)->ipv4_set = get_client_memptr(eth_client, (clt_indx + 1))->ipv4_set;
 		get_client_memptr(eth_client, clt_indx)->ipv6_set = get_client_memptr(eth_client, (clt_indx + 1))->ipv6_set;
@@ -3679,6 +3744,7 @@ int IPACM_Lan::handle_lan_client_reset_rt(ipa_ip_type iptype)
 		{
 			get_client_memptr(eth_client, i)->ipv6_set = 0;
 		}
+		client_dir->ClearAddr(get_client_memptr(eth_client, i)->mac, iptype);
 	} /* end of for loop */
 	return res;
 }
@@ -4513,7 +4579,8 @@ end:
 
 /* add routing rule and return handle to lan2lan controller */
 int IPACM_Lan::eth_bridge_add_rt_rule(uint8_t *mac, char *rt_tbl_name, uint32_t hdr_proc_ctx_hdl,
-		ipa_hdr_l2_type peer_l2_hdr_type, ipa_ip_type iptype, uint32_t *rt_rule_hdl, int *rt_rule_count)
+		ipa_hdr_l2_type peer_l2_hdr_type, ipa_ip_type iptype, uint32_t *rt_rule_hdl, int *rt_rule_count,
+		IPACM_RuleTxn *txn)
 {
 	int len, res = IPACM_SUCCESS;
 	uint32_t i, position, num_rt_rule;
@@ -4587,7 +4654,20 @@ int IPACM_Lan::eth_bridge_add_rt_rule(uint8_t *mac, char *rt_tbl_name, uint32_t
 			position++;
 		}
 	}
-	if(false == m_routing.AddRoutingRule(rt_rule_table))
+	if(txn != NULL)
+	{
+		for(i=0; i<position; i++)
+		{
+			if(false == txn->AddRoutingRule(iptype, rt_rule_table->rt_tbl_name, &rt_rule_table->rules[i], &rt_rule_hdl[i]))
+			{
+				IPACMERR("Routing rule addition failed!\n");
+				res = IPACM_FAILURE;
+				goto end;
+			}
+		}
+		*rt_rule_count = position;
+	}
+	else if(false == m_routing.AddRoutingRule(rt_rule_table))
 	{
 		IPACMERR("Routing rule addition failed!\n");
 		res = IPACM_FAILURE;
@@ -53,11 +53,16 @@ const char *ipa_l2_hdr_type[] = {
 
 IPACM_LanToLan* IPACM_LanToLan::p_instance;
 
-IPACM_LanToLan_Iface::IPACM_LanToLan_Iface(IPACM_Lan *p_iface)
+IPACM_LanToLan_Iface::IPACM_LanToLan_Iface(IPACM_Lan *p_iface, int iface_idx)
 {
 	int i;
 
 	m_p_iface = p_iface;
+	m_iface_idx = iface_idx;
+	m_client_bitmap = 0;
+	m_peer_bitmap = 0;
+	memset(m_peer_iface_info, 0, sizeof(m_peer_iface_info));
+	memset(&m_intra_interface_info, 0, sizeof(m_intra_interface_info));
 	memset(m_is_ip_addr_assigned, 0, sizeof(m_is_ip_addr_assigned));
 	m_support_inter_iface_offload = true;
 	m_support_intra_iface_offload = false;
@@ -103,6 +108,7 @@ IPACM_LanToLan::IPACM_LanToLan()
 	IPACM_EvtDispatcher::registr(IPA_HANDLE_VLAN_IFACE_INFO, this);
 #endif
 	m_has_l2tp_iface = false;
+	m_iface_bitmap = 0;
 	return;
 }
 
@@ -241,6 +247,7 @@ void IPACM_LanToLan::handle_iface_up(ipacm_event_eth_bridge *data)
 	list<IPACM_LanToLan_Iface>::iterator it;
 	list<l2tp_vlan_mapping_info>::iterator it_mapping;
 	bool has_l2tp_iface = false;
+	int iface_idx;
 
 	IPACMDBG_H("Interface name: %s IP type: %d\n", data->p_iface->dev_name, data->iptype);
 	for(it = m_iface.begin(); it != m_iface.end(); it++)
@@ -286,8 +293,11 @@ void IPACM_LanToLan::handle_iface_up(ipacm_event_eth_bridge *data)
 		}
 
 		IPACMDBG_H("Does not find the interface, insert a new one.\n");
-		IPACM_LanToLan_Iface new_iface(data->p_iface);
+		/* lowest free interface slot, m_iface is below MAX_NUM_IFACE here */
+		iface_idx = __builtin_ctz(~m_iface_bitmap);
+		IPACM_LanToLan_Iface new_iface(data->p_iface, iface_idx);
 		new_iface.set_m_is_ip_addr_assigned(data->iptype, true);
+		m_iface_bitmap |= (1 << iface_idx);
 
 		m_iface.push_front(new_iface);
 		IPACMDBG_H("Now the total number of interfaces is %d.\n", m_iface.size());
@@ -318,6 +328,8 @@ void IPACM_LanToLan::handle_iface_up(ipacm_event_eth_bridge *data)
 		/* install inter-interface rules */
 		if(front_iface.get_m_support_inter_iface_offload())
 		{
+			IPACM_RuleTxn txn(&IPACM_Iface::m_filtering, &IPACM_Iface::m_routing, &IPACM_Iface::m_header);
+
 			for(it = ++m_iface.begin(); it != m_iface.end(); it++)
 			{
 				/* add peer info only when both interfaces support inter-interface communication */
@@ -327,9 +339,15 @@ void IPACM_LanToLan::handle_iface_up(ipacm_event_eth_bridge *data)
 					handle_new_iface_up(&front_iface, &(*it));
 
 					/* add client specific routing rule on existing interface */
-					it->add_client_rt_rule_for_new_iface();
+					it->add_client_rt_rule_for_new_iface(&front_iface, &txn);
 				}
 			}
+			/* the routing rules of all existing clients go out together, before the
+			   filtering rules that point to their tables */
+			if(txn.End() == false)
+			{
+				IPACMERR("Failed to add client routing rules for new interface.\n");
+			}
 
 			/* add client specific filtering rule on new interface */
 			front_iface.add_all_inter_interface_client_flt_rule(data->iptype);
@@ -372,6 +390,7 @@ void IPACM_LanToLan::handle_iface_down(ipacm_event_eth_bridge *data)
 	}
 
 	it_target_iface->handle_down_event();
+	m_iface_bitmap &= ~(1 << it_target_iface->get_iface_idx());
 	m_iface.erase(it_target_iface);
 #ifdef FEATURE_L2TP
 	for(it_target_iface = m_iface.begin(); it_target_iface != m_iface.end(); it_target_iface++)
@@ -866,11 +885,11 @@ void IPACM_LanToLan::print_data_structure_info()
 	return;
 }
 
-void IPACM_LanToLan_Iface::add_client_rt_rule_for_new_iface()
+void IPACM_LanToLan_Iface::add_client_rt_rule_for_new_iface(IPACM_LanToLan_Iface *new_iface, IPACM_RuleTxn *txn)
 {
 	list<client_info>::iterator it;
 	ipa_hdr_l2_type peer_l2_type;
-	peer_iface_info &peer = m_peer_iface_info.front();
+	peer_iface_info &peer = m_peer_iface_info[new_iface->m_iface_idx];
 
 	peer_l2_type = peer.peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type;
 	if(ref_cnt_peer_l2_hdr_type[peer_l2_type] == 1)
@@ -880,12 +899,12 @@ void IPACM_LanToLan_Iface::add_client_rt_rule_for_new_iface()
 #ifdef FEATURE_L2TP
 			if(it->is_l2tp_client == false)
 			{
-				add_client_rt_rule(&peer, &(*it));
+				add_client_rt_rule(&peer, &(*it), txn);
 			}
 			/* add l2tp rt rules */
 			add_l2tp_client_rt_rule(&peer, &(*it));
 #else
-			add_client_rt_rule(&peer, &(*it));
+			add_client_rt_rule(&peer, &(*it), txn);
 #endif
 		}
 	}
@@ -893,11 +912,12 @@ void IPACM_LanToLan_Iface::add_client_rt_rule_for_new_iface()
 	return;
 }
 
-void IPACM_LanToLan_Iface::add_client_rt_rule(peer_iface_info *peer_info, client_info *client)
+/* the rules are queued on txn, their handles are valid after txn->End() */
+void IPACM_LanToLan_Iface::add_client_rt_rule(peer_iface_info *peer_info, client_info *client, IPACM_RuleTxn *txn)
 {
-	int i, num_rt_rule;
-	uint32_t rt_rule_hdl[MAX_NUM_PROP];
 	ipa_hdr_l2_type peer_l2_hdr_type;
+	rt_rule_info *rt_rule;
+	uint32_t hdr_proc_ctx_hdl;
 
 	peer_l2_hdr_type = peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type;
 
@@ -905,54 +925,26 @@ void IPACM_LanToLan_Iface::add_client_rt_rule(peer_iface_info *peer_info, client
 	if(peer_info->peer != this)
 	{
 		IPACMDBG_H("This is for inter interface communication.\n");
-
-		m_p_iface->eth_bridge_add_rt_rule(client->mac_addr, peer_info->rt_tbl_name_for_rt[IPA_IP_v4], hdr_proc_ctx_for_inter_interface[peer_l2_hdr_type],
-			peer_l2_hdr_type, IPA_IP_v4, rt_rule_hdl, &num_rt_rule);
-
-		client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].num_hdl[IPA_IP_v4] = num_rt_rule;
-		IPACMDBG_H("Number of IPv4 routing rule is %d.\n", num_rt_rule);
-		for(i=0; i<num_rt_rule; i++)
-		{
-			IPACMDBG_H("Routing rule %d handle %d\n", i, rt_rule_hdl[i]);
-			client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].rule_hdl[IPA_IP_v4][i] = rt_rule_hdl[i];
-		}
-
-		m_p_iface->eth_bridge_add_rt_rule(client->mac_addr, peer_info->rt_tbl_name_for_rt[IPA_IP_v6], hdr_proc_ctx_for_inter_interface[peer_l2_hdr_type],
-			peer_l2_hdr_type, IPA_IP_v6, rt_rule_hdl, &num_rt_rule);
-
-		client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].num_hdl[IPA_IP_v6] = num_rt_rule;
-		IPACMDBG_H("Number of IPv6 routing rule is %d.\n", num_rt_rule);
-		for(i=0; i<num_rt_rule; i++)
-		{
-			IPACMDBG_H("Routing rule %d handle %d\n", i, rt_rule_hdl[i]);
-			client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].rule_hdl[IPA_IP_v6][i] = rt_rule_hdl[i];
-		}
+		rt_rule = &client->inter_iface_rt_rule_hdl[peer_l2_hdr_type];
+		hdr_proc_ctx_hdl = hdr_proc_ctx_for_inter_interface[peer_l2_hdr_type];
 	}
 	else
 	{
 		IPACMDBG_H("This is for intra interface communication.\n");
-		m_p_iface->eth_bridge_add_rt_rule(client->mac_addr, peer_info->rt_tbl_name_for_rt[IPA_IP_v4], hdr_proc_ctx_for_intra_interface,
-			peer_l2_hdr_type, IPA_IP_v4, rt_rule_hdl, &num_rt_rule);
+		rt_rule = &client->intra_iface_rt_rule_hdl;
+		hdr_proc_ctx_hdl = hdr_proc_ctx_for_intra_interface;
+	}
 
-		client->intra_iface_rt_rule_hdl.num_hdl[IPA_IP_v4] = num_rt_rule;
-		IPACMDBG_H("Number of IPv4 routing rule is %d.\n", num_rt_rule);
-		for(i=0; i<num_rt_rule; i++)
-		{
-			IPACMDBG_H("Routing rule %d handle %d\n", i, rt_rule_hdl[i]);
-			client->intra_iface_rt_rule_hdl.rule_hdl[IPA_IP_v4][i] = rt_rule_hdl[i];
-		}
+	/* a failed transaction leaves no handles behind */
+	memset(rt_rule, 0, sizeof(*rt_rule));
 
-		m_p_iface->eth_bridge_add_rt_rule(client->mac_addr, peer_info->rt_tbl_name_for_rt[IPA_IP_v6], hdr_proc_ctx_for_intra_interface,
-			peer_l2_hdr_type, IPA_IP_v6, rt_rule_hdl, &num_rt_rule);
+	m_p_iface->eth_bridge_add_rt_rule(client->mac_addr, peer_info->rt_tbl_name_for_rt[IPA_IP_v4], hdr_proc_ctx_hdl,
+		peer_l2_hdr_type, IPA_IP_v4, rt_rule->rule_hdl[IPA_IP_v4], &rt_rule->num_hdl[IPA_IP_v4], txn);
+	IPACMDBG_H("Number of IPv4 routing rule is %d.\n", rt_rule->num_hdl[IPA_IP_v4]);
 
-		client->intra_iface_rt_rule_hdl.num_hdl[IPA_IP_v6] = num_rt_rule;
-		IPACMDBG_H("Number of IPv6 routing rule is %d.\n", num_rt_rule);
-		for(i=0; i<num_rt_rule; i++)
-		{
-			IPACMDBG_H("Routing rule %d handle %d\n", i, rt_rule_hdl[i]);
-			client->intra_iface_rt_rule_hdl.rule_hdl[IPA_IP_v6][i] = rt_rule_hdl[i];
-		}
-	}
+	m_p_iface->eth_bridge_add_rt_rule(client->mac_addr, peer_info->rt_tbl_name_for_rt[IPA_IP_v6], hdr_proc_ctx_hdl,
+		peer_l2_hdr_type, IPA_IP_v6, rt_rule->rule_hdl[IPA_IP_v6], &rt_rule->num_hdl[IPA_IP_v6], txn);
+	IPACMDBG_H("Number of IPv6 routing rule is %d.\n", rt_rule->num_hdl[IPA_IP_v6]);
 
 	return;
 }
@@ -995,15 +987,17 @@ void IPACM_LanToLan_Iface::add_l2tp_client_rt_rule(peer_iface_info *peer, client
 
 void IPACM_LanToLan_Iface::add_all_inter_interface_client_flt_rule(ipa_ip_type iptype)
 {
-	list<peer_iface_info>::iterator it_iface;
+	peer_iface_info *peer;
 	list<client_info>::iterator it_client;
+	uint32_t peers;
 
-	for(it_iface = m_peer_iface_info.begin(); it_iface != m_peer_iface_info.end(); it_iface++)
+	for(peers = m_peer_bitmap; peers != 0; peers &= peers - 1)
 	{
-		IPACMDBG_H("Add flt rules for clients of interface %s.\n", it_iface->peer->get_iface_pointer()->dev_name);
-		for(it_client = it_iface->peer->m_client_info.begin(); it_client != it_iface->peer->m_client_info.end(); it_client++)
+		peer = &m_peer_iface_info[__builtin_ctz(peers)];
+		IPACMDBG_H("Add flt rules for clients of interface %s.\n", peer->peer->get_iface_pointer()->dev_name);
+		for(it_client = peer->peer->m_client_info.begin(); it_client != peer->peer->m_client_info.end(); it_client++)
 		{
-			add_client_flt_rule(&(*it_iface), &(*it_client), iptype);
+			add_client_flt_rule(peer, &(*it_client), iptype);
 		}
 	}
 	return;
@@ -1024,34 +1018,32 @@ void IPACM_LanToLan_Iface::add_all_intra_interface_client_flt_rule(ipa_ip_type i
 
 void IPACM_LanToLan_Iface::add_one_client_flt_rule(IPACM_LanToLan_Iface *peer_iface, client_info *client)
 {
-	list<peer_iface_info>::iterator it;
+	peer_iface_info *peer;
 
-	for(it = m_peer_iface_info.begin(); it != m_peer_iface_info.end(); it++)
+	if((m_peer_bitmap & (1 << peer_iface->m_iface_idx)) == 0)
 	{
-		if(it->peer == peer_iface)
-		{
-			IPACMDBG_H("Found the peer iface info.\n");
-			if(m_is_ip_addr_assigned[IPA_IP_v4])
-			{
-				add_client_flt_rule(&(*it), client, IPA_IP_v4);
-			}
-			if(m_is_ip_addr_assigned[IPA_IP_v6])
-			{
-				add_client_flt_rule(&(*it), client, IPA_IP_v6);
-			}
+		IPACMDBG_H("The peer iface info is not found.\n");
+		return;
+	}
 
-			break;
-		}
+	peer = &m_peer_iface_info[peer_iface->m_iface_idx];
+	if(m_is_ip_addr_assigned[IPA_IP_v4])
+	{
+		add_client_flt_rule(peer, client, IPA_IP_v4);
+	}
+	if(m_is_ip_addr_assigned[IPA_IP_v6])
+	{
+		add_client_flt_rule(peer, client, IPA_IP_v6);
 	}
 	return;
 }
 
 void IPACM_LanToLan_Iface::add_client_flt_rule(peer_iface_info *peer, client_info *client, ipa_ip_type iptype)
 {
-	list<flt_rule_info>::iterator it_flt;
-	uint32_t flt_rule_hdl;
+	flt_rule_info *flt_info;
+	uint32_t flt_rule_hdl = 0;
 	uint32_t l2tp_first_pass_flt_rule_hdl = 0, l2tp_second_pass_flt_rule_hdl = 0;
-	flt_rule_info new_flt_info;
+	uint32_t client_bit;
 	ipa_ioc_get_rt_tbl rt_tbl;
 
 	if(m_is_l2tp_iface && iptype == IPA_IP_v4)
@@ -1060,19 +1052,13 @@ void IPACM_LanToLan_Iface::add_client_flt_rule(peer_iface_info *peer, client_inf
 		return;
 	}
 
-	for(it_flt = peer->flt_rule.begin(); it_flt != peer->flt_rule.end(); it_flt++)
+	client_bit = 1 << client->client_idx;
+	flt_info = &peer->flt_rule[client->client_idx];
+	if(peer->flt_rule_bitmap & client_bit)	//the client is already in the flt info list
 	{
-		if(it_flt->p_client == client)	//the client is already in the flt info list
-		{
-			IPACMDBG_H("The client is found in flt info list.\n");
-			break;
-		}
-	}
-
-	if(it_flt != peer->flt_rule.end())
-	{
-		l2tp_first_pass_flt_rule_hdl = it_flt->l2tp_first_pass_flt_rule_hdl[iptype];
-		l2tp_second_pass_flt_rule_hdl = it_flt->l2tp_second_pass_flt_rule_hdl;
+		IPACMDBG_H("The client is found in flt info list.\n");
+		l2tp_first_pass_flt_rule_hdl = flt_info->l2tp_first_pass_flt_rule_hdl[iptype];
+		l2tp_second_pass_flt_rule_hdl = flt_info->l2tp_second_pass_flt_rule_hdl;
 	}
 
 #ifdef FEATURE_L2TP
@@ -1108,112 +1094,100 @@ void IPACM_LanToLan_Iface::add_client_flt_rule(peer_iface_info *peer, client_inf
 		}
 	}
 
-	if(it_flt != peer->flt_rule.end())
-	{
-		it_flt->flt_rule_hdl[iptype] = flt_rule_hdl;
-		it_flt->l2tp_first_pass_flt_rule_hdl[iptype] = l2tp_first_pass_flt_rule_hdl;
-		it_flt->l2tp_second_pass_flt_rule_hdl = l2tp_second_pass_flt_rule_hdl;
-	}
-	else
+	if((peer->flt_rule_bitmap & client_bit) == 0)
 	{
 		IPACMDBG_H("The client is not found in flt info list, insert a new one.\n");
-		memset(&new_flt_info, 0, sizeof(new_flt_info));
-		new_flt_info.p_client = client;
-		new_flt_info.flt_rule_hdl[iptype] = flt_rule_hdl;
-		new_flt_info.l2tp_first_pass_flt_rule_hdl[iptype] = l2tp_first_pass_flt_rule_hdl;
-		new_flt_info.l2tp_second_pass_flt_rule_hdl = l2tp_second_pass_flt_rule_hdl;
-
-		peer->flt_rule.push_front(new_flt_info);
+		memset(flt_info, 0, sizeof(*flt_info));
+		flt_info->p_client = client;
+		peer->flt_rule_bitmap |= client_bit;
 	}
+	flt_info->flt_rule_hdl[iptype] = flt_rule_hdl;
+	flt_info->l2tp_first_pass_flt_rule_hdl[iptype] = l2tp_first_pass_flt_rule_hdl;
+	flt_info->l2tp_second_pass_flt_rule_hdl = l2tp_second_pass_flt_rule_hdl;
 
 	return;
 }
 
-void IPACM_LanToLan_Iface::del_one_client_flt_rule(IPACM_LanToLan_Iface *peer_iface, client_info *client)
+void IPACM_LanToLan_Iface::del_one_client_flt_rule(IPACM_LanToLan_Iface *peer_iface, client_info *client, IPACM_RuleTxn *txn)
 {
-	list<peer_iface_info>::iterator it;
-
-	for(it = m_peer_iface_info.begin(); it != m_peer_iface_info.end(); it++)
+	if(m_peer_bitmap & (1 << peer_iface->m_iface_idx))
 	{
-		if(it->peer == peer_iface)
-		{
-			IPACMDBG_H("Found the peer iface info.\n");
-			del_client_flt_rule(&(*it), client);
-			break;
-		}
+		IPACMDBG_H("Found the peer iface info.\n");
+		del_client_flt_rule(&m_peer_iface_info[peer_iface->m_iface_idx], client, txn);
 	}
 	return;
 }
 
-void IPACM_LanToLan_Iface::del_client_flt_rule(peer_iface_info *peer, client_info *client)
+void IPACM_LanToLan_Iface::del_client_flt_rule(peer_iface_info *peer, client_info *client, IPACM_RuleTxn *txn)
 {
-	list<flt_rule_info>::iterator it_flt;
+	flt_rule_info *flt_info;
+	uint32_t client_bit;
 
-	for(it_flt = peer->flt_rule.begin(); it_flt != peer->flt_rule.end(); it_flt++)
+	client_bit = 1 << client->client_idx;
+	if((peer->flt_rule_bitmap & client_bit) == 0)
 	{
-		if(it_flt->p_client == client)	//found the client in flt info list
+		return;
+	}
+
+	IPACMDBG_H("Found the client in flt info list.\n");
+	flt_info = &peer->flt_rule[client->client_idx];
+	if(m_is_ip_addr_assigned[IPA_IP_v4])
+	{
+		if(m_is_l2tp_iface)
+		{
+			IPACMDBG_H("No IPv4 client flt rule on l2tp iface.\n");
+		}
+		else
 		{
-			IPACMDBG_H("Found the client in flt info list.\n");
-			if(m_is_ip_addr_assigned[IPA_IP_v4])
-			{
-				if(m_is_l2tp_iface)
-				{
-					IPACMDBG_H("No IPv4 client flt rule on l2tp iface.\n");
-				}
-				else
-				{
 #ifdef FEATURE_L2TP
-					if(client->is_l2tp_client)
-					{
-						m_p_iface->del_l2tp_flt_rule(IPA_IP_v4, it_flt->l2tp_first_pass_flt_rule_hdl[IPA_IP_v4],
-							it_flt->l2tp_second_pass_flt_rule_hdl);
-						it_flt->l2tp_second_pass_flt_rule_hdl = 0;
-						IPACMDBG_H("Deleted IPv4 first pass flt rule %d and second pass flt rule %d.\n",
-							it_flt->l2tp_first_pass_flt_rule_hdl[IPA_IP_v4], it_flt->l2tp_second_pass_flt_rule_hdl);
-					}
-					else
-#endif
-					{
-						m_p_iface->eth_bridge_del_flt_rule(it_flt->flt_rule_hdl[IPA_IP_v4], IPA_IP_v4);
-						IPACMDBG_H("Deleted IPv4 flt rule %d.\n", it_flt->flt_rule_hdl[IPA_IP_v4]);
-					}
-				}
+			if(client->is_l2tp_client)
+			{
+				m_p_iface->del_l2tp_flt_rule(IPA_IP_v4, flt_info->l2tp_first_pass_flt_rule_hdl[IPA_IP_v4],
+					flt_info->l2tp_second_pass_flt_rule_hdl);
+				flt_info->l2tp_second_pass_flt_rule_hdl = 0;
+				IPACMDBG_H("Deleted IPv4 first pass flt rule %d and second pass flt rule %d.\n",
+					flt_info->l2tp_first_pass_flt_rule_hdl[IPA_IP_v4], flt_info->l2tp_second_pass_flt_rule_hdl);
 			}
-			if(m_is_ip_addr_assigned[IPA_IP_v6])
+			else
+#endif
 			{
+				txn->DeleteFilteringHdl(flt_info->flt_rule_hdl[IPA_IP_v4], IPA_IP_v4);
+				IPACMDBG_H("Queued deletion of IPv4 flt rule %d.\n", flt_info->flt_rule_hdl[IPA_IP_v4]);
+			}
+		}
+	}
+	if(m_is_ip_addr_assigned[IPA_IP_v6])
+	{
 #ifdef FEATURE_L2TP
-				if(m_is_l2tp_iface)
-				{
-					m_p_iface->del_l2tp_flt_rule(it_flt->l2tp_first_pass_flt_rule_hdl[IPA_IP_v6]);
-					IPACMDBG_H("Deleted IPv6 flt rule %d.\n", it_flt->l2tp_first_pass_flt_rule_hdl[IPA_IP_v6]);
-				}
-				else
+		if(m_is_l2tp_iface)
+		{
+			m_p_iface->del_l2tp_flt_rule(flt_info->l2tp_first_pass_flt_rule_hdl[IPA_IP_v6]);
+			IPACMDBG_H("Deleted IPv6 flt rule %d.\n", flt_info->l2tp_first_pass_flt_rule_hdl[IPA_IP_v6]);
+		}
+		else
 #endif
-				{
+		{
 #ifdef FEATURE_L2TP
-					if(client->is_l2tp_client)
-					{
-						m_p_iface->del_l2tp_flt_rule(IPA_IP_v6, it_flt->l2tp_first_pass_flt_rule_hdl[IPA_IP_v6],
-							it_flt->l2tp_second_pass_flt_rule_hdl);
-						IPACMDBG_H("Deleted IPv6 first pass flt rule %d and second pass flt rule %d.\n",
-							it_flt->l2tp_first_pass_flt_rule_hdl[IPA_IP_v6], it_flt->l2tp_second_pass_flt_rule_hdl);
-					}
-					else
+			if(client->is_l2tp_client)
+			{
+				m_p_iface->del_l2tp_flt_rule(IPA_IP_v6, flt_info->l2tp_first_pass_flt_rule_hdl[IPA_IP_v6],
+					flt_info->l2tp_second_pass_flt_rule_hdl);
+				IPACMDBG_H("Deleted IPv6 first pass flt rule %d and second pass flt rule %d.\n",
+					flt_info->l2tp_first_pass_flt_rule_hdl[IPA_IP_v6], flt_info->l2tp_second_pass_flt_rule_hdl);
+			}
+			else
 #endif
-					{
-						m_p_iface->eth_bridge_del_flt_rule(it_flt->flt_rule_hdl[IPA_IP_v6], IPA_IP_v6);
-						IPACMDBG_H("Deleted IPv6 flt rule %d.\n", it_flt->flt_rule_hdl[IPA_IP_v6]);
-					}
-				}
+			{
+				txn->DeleteFilteringHdl(flt_info->flt_rule_hdl[IPA_IP_v6], IPA_IP_v6);
+				IPACMDBG_H("Queued deletion of IPv6 flt rule %d.\n", flt_info->flt_rule_hdl[IPA_IP_v6]);
 			}
-			peer->flt_rule.erase(it_flt);
-			break;
 		}
 	}
+	peer->flt_rule_bitmap &= ~client_bit;
 	return;
 }
 
-void IPACM_LanToLan_Iface::del_client_rt_rule(peer_iface_info *peer, client_info *client)
+void IPACM_LanToLan_Iface::del_client_rt_rule(peer_iface_info *peer, client_info *client, IPACM_RuleTxn *txn)
 {
 	ipa_hdr_l2_type peer_l2_hdr_type;
 	int i, num_rules;
@@ -1229,16 +1203,16 @@ void IPACM_LanToLan_Iface::del_client_rt_rule(peer_iface_info *peer, client_info
 			num_rules = client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].num_hdl[IPA_IP_v4];
 			for(i = 0; i < num_rules; i++)
 			{
-				m_p_iface->eth_bridge_del_rt_rule(client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].rule_hdl[IPA_IP_v4][i], IPA_IP_v4);
-				IPACMDBG_H("IPv4 rt rule %d is deleted.\n", client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].rule_hdl[IPA_IP_v4][i]);
+				txn->DeleteRoutingHdl(client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].rule_hdl[IPA_IP_v4][i], IPA_IP_v4);
+				IPACMDBG_H("IPv4 rt rule %d is queued for deletion.\n", client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].rule_hdl[IPA_IP_v4][i]);
 			}
 			client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].num_hdl[IPA_IP_v4] = 0;
 
 			num_rules = client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].num_hdl[IPA_IP_v6];
 			for(i = 0; i < num_rules; i++)
 			{
-				m_p_iface->eth_bridge_del_rt_rule(client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].rule_hdl[IPA_IP_v6][i], IPA_IP_v6);
-				IPACMDBG_H("IPv6 rt rule %d is deleted.\n", client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].rule_hdl[IPA_IP_v6][i]);
+				txn->DeleteRoutingHdl(client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].rule_hdl[IPA_IP_v6][i], IPA_IP_v6);
+				IPACMDBG_H("IPv6 rt rule %d is queued for deletion.\n", client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].rule_hdl[IPA_IP_v6][i]);
 			}
 			client->inter_iface_rt_rule_hdl[peer_l2_hdr_type].num_hdl[IPA_IP_v6] = 0;
 #ifdef FEATURE_L2TP
@@ -1269,16 +1243,16 @@ void IPACM_LanToLan_Iface::del_client_rt_rule(peer_iface_info *peer, client_info
 		num_rules = client->intra_iface_rt_rule_hdl.num_hdl[IPA_IP_v4];
 		for(i = 0; i < num_rules; i++)
 		{
-			m_p_iface->eth_bridge_del_rt_rule(client->intra_iface_rt_rule_hdl.rule_hdl[IPA_IP_v4][i], IPA_IP_v4);
-			IPACMDBG_H("IPv4 rt rule %d is deleted.\n", client->intra_iface_rt_rule_hdl.rule_hdl[IPA_IP_v4][i]);
+			txn->DeleteRoutingHdl(client->intra_iface_rt_rule_hdl.rule_hdl[IPA_IP_v4][i], IPA_IP_v4);
+			IPACMDBG_H("IPv4 rt rule %d is queued for deletion.\n", client->intra_iface_rt_rule_hdl.rule_hdl[IPA_IP_v4][i]);
 		}
 		client->intra_iface_rt_rule_hdl.num_hdl[IPA_IP_v4] = 0;
 
 		num_rules = client->intra_iface_rt_rule_hdl.num_hdl[IPA_IP_v6];
 		for(i = 0; i < num_rules; i++)
 		{
-			m_p_iface->eth_bridge_del_rt_rule(client->intra_iface_rt_rule_hdl.rule_hdl[IPA_IP_v6][i], IPA_IP_v6);
-			IPACMDBG_H("IPv6 rt rule %d is deleted.\n", client->intra_iface_rt_rule_hdl.rule_hdl[IPA_IP_v6][i]);
+			txn->DeleteRoutingHdl(client->intra_iface_rt_rule_hdl.rule_hdl[IPA_IP_v6][i], IPA_IP_v6);
+			IPACMDBG_H("IPv6 rt rule %d is queued for deletion.\n", client->intra_iface_rt_rule_hdl.rule_hdl[IPA_IP_v6][i]);
 		}
 		client->intra_iface_rt_rule_hdl.num_hdl[IPA_IP_v6] = 0;
 	}
@@ -1288,74 +1262,105 @@ void IPACM_LanToLan_Iface::del_client_rt_rule(peer_iface_info *peer, client_info
 
 void IPACM_LanToLan_Iface::handle_down_event()
 {
-	list<IPACM_LanToLan_Iface>::iterator it_other_iface;
-	list<peer_iface_info>::iterator it_own_peer_info, it_other_iface_peer_info;
+	peer_iface_info *own_peer_info, *other_iface_peer_info;
 	IPACM_LanToLan_Iface *other_iface;
+	IPACM_RuleTxn txn(&IPACM_Iface::m_filtering, &IPACM_Iface::m_routing, &IPACM_Iface::m_header);
+	bool del_proc_ctx[IPA_HDR_L2_MAX];
+	ipa_hdr_l2_type peer_l2_type;
+	uint32_t peers;
+	int i;
 
-	/* clear inter-interface rules */
+	memset(del_proc_ctx, 0, sizeof(del_proc_ctx));
+
+	/* clear inter-interface rules, the rule deletions are pushed together below */
 	if(m_support_inter_iface_offload)
 	{
-		for(it_own_peer_info = m_peer_iface_info.begin(); it_own_peer_info != m_peer_iface_info.end();
-			it_own_peer_info++)
+		for(peers = m_peer_bitmap; peers != 0; peers &= peers - 1)
 		{
+			own_peer_info = &m_peer_iface_info[__builtin_ctz(peers)];
+			other_iface = own_peer_info->peer;
+			peer_l2_type = other_iface->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type;
+
 			/* decrement reference count of peer l2 header type on both interfaces*/
-			decrement_ref_cnt_peer_l2_hdr_type(it_own_peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type);
-			it_own_peer_info->peer->decrement_ref_cnt_peer_l2_hdr_type(m_p_iface->tx_prop->tx[0].hdr_l2_type);
+			decrement_ref_cnt_peer_l2_hdr_type(peer_l2_type);
+			other_iface->decrement_ref_cnt_peer_l2_hdr_type(m_p_iface->tx_prop->tx[0].hdr_l2_type);
 
 			/* first clear all flt rule on target interface */
 			IPACMDBG_H("Clear all flt rule on target interface.\n");
-			clear_all_flt_rule_for_one_peer_iface(&(*it_own_peer_info));
-
-			other_iface = it_own_peer_info->peer;
-			/* then clear all flt/rt rule and hdr proc ctx for target interface on peer interfaces */
-			IPACMDBG_H("Clear all flt/rt rules and hdr proc ctx for target interface on peer interfaces %s.\n",
-				it_own_peer_info->peer->get_iface_pointer()->dev_name);
-			for(it_other_iface_peer_info = other_iface->m_peer_iface_info.begin();
-				it_other_iface_peer_info != other_iface->m_peer_iface_info.end();
-				it_other_iface_peer_info++)
+			clear_all_flt_rule_for_one_peer_iface(own_peer_info, &txn);
+
+			/* then clear all flt/rt rule for target interface on peer interfaces */
+			IPACMDBG_H("Clear all flt/rt rules for target interface on peer interfaces %s.\n",
+				other_iface->get_iface_pointer()->dev_name);
+			if(other_iface->m_peer_bitmap & (1 << m_iface_idx))
 			{
-				if(it_other_iface_peer_info->peer == this)	//found myself in other iface's peer info list
-				{
-					IPACMDBG_H("Found the right peer info on other iface.\n");
-					other_iface->clear_all_flt_rule_for_one_peer_iface(&(*it_other_iface_peer_info));
-					other_iface->clear_all_rt_rule_for_one_peer_iface(&(*it_other_iface_peer_info));
-					/* remove the peer info from the list */
-					other_iface->m_peer_iface_info.erase(it_other_iface_peer_info);
-					other_iface->del_hdr_proc_ctx(m_p_iface->tx_prop->tx[0].hdr_l2_type);
-					break;
-				}
+				IPACMDBG_H("Found the right peer info on other iface.\n");
+				other_iface_peer_info = &other_iface->m_peer_iface_info[m_iface_idx];
+				other_iface->clear_all_flt_rule_for_one_peer_iface(other_iface_peer_info, &txn);
+				other_iface->clear_all_rt_rule_for_one_peer_iface(other_iface_peer_info, &txn);
 			}
 
-			/* then clear rt rule and hdr proc ctx and release rt table on target interface */
-			IPACMDBG_H("Clear rt rules and hdr proc ctx and release rt table on target interface.\n");
-			clear_all_rt_rule_for_one_peer_iface(&(*it_own_peer_info));
-			del_hdr_proc_ctx(it_own_peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type);
+			/* then clear rt rule on target interface */
+			IPACMDBG_H("Clear rt rules on target interface.\n");
+			clear_all_rt_rule_for_one_peer_iface(own_peer_info, &txn);
+			del_proc_ctx[peer_l2_type] = true;
 		}
-		m_peer_iface_info.clear();
 	}
 
 	/* clear intra interface rules */
 	if(m_support_intra_iface_offload)
 	{
-		IPACMDBG_H("Clear intra interface flt/rt rules and hdr proc ctx, release rt tables.\n");
-		clear_all_flt_rule_for_one_peer_iface(&m_intra_interface_info);
-		clear_all_rt_rule_for_one_peer_iface(&m_intra_interface_info);
+		IPACMDBG_H("Clear intra interface flt/rt rules.\n");
+		clear_all_flt_rule_for_one_peer_iface(&m_intra_interface_info, &txn);
+		clear_all_rt_rule_for_one_peer_iface(&m_intra_interface_info, &txn);
+	}
+
+	txn.End();
+
+	/* the rt rules are gone, release hdr proc ctx on both sides */
+	if(m_support_inter_iface_offload)
+	{
+		for(peers = m_peer_bitmap; peers != 0; peers &= peers - 1)
+		{
+			other_iface = m_peer_iface_info[__builtin_ctz(peers)].peer;
+			if(other_iface->m_peer_bitmap & (1 << m_iface_idx))
+			{
+				/* remove the peer info from the other iface */
+				other_iface->m_peer_bitmap &= ~(1 << m_iface_idx);
+				other_iface->del_hdr_proc_ctx(m_p_iface->tx_prop->tx[0].hdr_l2_type);
+			}
+		}
+		for(i = 0; i < IPA_HDR_L2_MAX; i++)
+		{
+			if(del_proc_ctx[i])
+			{
+				del_hdr_proc_ctx((ipa_hdr_l2_type)i);
+			}
+		}
+		m_peer_bitmap = 0;
+	}
+
+	if(m_support_intra_iface_offload)
+	{
 		m_p_iface->eth_bridge_del_hdr_proc_ctx(hdr_proc_ctx_for_intra_interface);
 		IPACMDBG_H("Hdr proc ctx with hdl %d is deleted.\n", hdr_proc_ctx_for_intra_interface);
 	}
 
 	/* then clear the client info list */
 	m_client_info.clear();
+	m_client_bitmap = 0;
 
 	return;
 }
 
-void IPACM_LanToLan_Iface::clear_all_flt_rule_for_one_peer_iface(peer_iface_info *peer)
+void IPACM_LanToLan_Iface::clear_all_flt_rule_for_one_peer_iface(peer_iface_info *peer, IPACM_RuleTxn *txn)
 {
-	list<flt_rule_info>::iterator it;
+	flt_rule_info *it;
+	uint32_t clients;
 
-	for(it = peer->flt_rule.begin(); it != peer->flt_rule.end(); it++)
+	for(clients = peer->flt_rule_bitmap; clients != 0; clients &= clients - 1)
 	{
+		it = &peer->flt_rule[__builtin_ctz(clients)];
 		if(m_is_ip_addr_assigned[IPA_IP_v4])
 		{
 			if(m_is_l2tp_iface)
@@ -1376,8 +1381,8 @@ void IPACM_LanToLan_Iface::clear_all_flt_rule_for_one_peer_iface(peer_iface_info
 				else
 #endif
 				{
-					m_p_iface->eth_bridge_del_flt_rule(it->flt_rule_hdl[IPA_IP_v4], IPA_IP_v4);
-					IPACMDBG_H("Deleted IPv4 flt rule %d.\n", it->flt_rule_hdl[IPA_IP_v4]);
+					txn->DeleteFilteringHdl(it->flt_rule_hdl[IPA_IP_v4], IPA_IP_v4);
+					IPACMDBG_H("Queued deletion of IPv4 flt rule %d.\n", it->flt_rule_hdl[IPA_IP_v4]);
 				}
 			}
 		}
@@ -1403,17 +1408,17 @@ void IPACM_LanToLan_Iface::clear_all_flt_rule_for_one_peer_iface(peer_iface_info
 				else
 #endif
 				{
-					m_p_iface->eth_bridge_del_flt_rule(it->flt_rule_hdl[IPA_IP_v6], IPA_IP_v6);
-					IPACMDBG_H("Deleted IPv6 flt rule %d.\n", it->flt_rule_hdl[IPA_IP_v6]);
+					txn->DeleteFilteringHdl(it->flt_rule_hdl[IPA_IP_v6], IPA_IP_v6);
+					IPACMDBG_H("Queued deletion of IPv6 flt rule %d.\n", it->flt_rule_hdl[IPA_IP_v6]);
 				}
 			}
 		}
 	}
-	peer->flt_rule.clear();
+	peer->flt_rule_bitmap = 0;
 	return;
 }
 
-void IPACM_LanToLan_Iface::clear_all_rt_rule_for_one_peer_iface(peer_iface_info *peer)
+void IPACM_LanToLan_Iface::clear_all_rt_rule_for_one_peer_iface(peer_iface_info *peer, IPACM_RuleTxn *txn)
 {
 	list<client_info>::iterator it;
 	ipa_hdr_l2_type peer_l2_type;
@@ -1423,11 +1428,13 @@ void IPACM_LanToLan_Iface::clear_all_rt_rule_for_one_peer_iface(peer_iface_info
 	{
 		for(it = m_client_info.begin(); it != m_client_info.end(); it++)
 		{
-			del_client_rt_rule(peer, &(*it));
+			del_client_rt_rule(peer, &(*it), txn);
 		}
 #ifdef FEATURE_L2TP
 		if(IPACM_LanToLan::get_instance()->has_l2tp_iface() == true)
 		{
+			/* the queued rt rules still point to the proc ctx */
+			txn->End();
 			m_p_iface->eth_bridge_del_hdr_proc_ctx(hdr_proc_ctx_for_l2tp);
 			hdr_proc_ctx_for_l2tp = 0;
 		}
@@ -1439,10 +1446,10 @@ void IPACM_LanToLan_Iface::clear_all_rt_rule_for_one_peer_iface(peer_iface_info
 
 void IPACM_LanToLan_Iface::handle_wlan_scc_mcc_switch()
 {
-	list<peer_iface_info>::iterator it_peer_info;
 	list<client_info>::iterator it_client;
 	ipa_hdr_l2_type peer_l2_hdr_type;
 	bool flag[IPA_HDR_L2_MAX];
+	uint32_t peers;
 	int i;
 
 	/* modify inter-interface routing rules */
@@ -1450,9 +1457,9 @@ void IPACM_LanToLan_Iface::handle_wlan_scc_mcc_switch()
 	{
 		IPACMDBG_H("Modify rt rules for peer interfaces.\n");
 		memset(flag, 0, sizeof(flag));
-		for(it_peer_info = m_peer_iface_info.begin(); it_peer_info != m_peer_iface_info.end(); it_peer_info++)
+		for(peers = m_peer_bitmap; peers != 0; peers &= peers - 1)
 		{
-			peer_l2_hdr_type = it_peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type;
+			peer_l2_hdr_type = m_peer_iface_info[__builtin_ctz(peers)].peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type;
 			if(flag[peer_l2_hdr_type] == false)
 			{
 				flag[peer_l2_hdr_type] = true;
@@ -1546,21 +1553,23 @@ void IPACM_LanToLan_Iface::handle_intra_interface_info()
 void IPACM_LanToLan_Iface::handle_new_iface_up(char rt_tbl_name_for_flt[][IPA_RESOURCE_NAME_MAX], char rt_tbl_name_for_rt[][IPA_RESOURCE_NAME_MAX],
 		IPACM_LanToLan_Iface *peer_iface)
 {
-	peer_iface_info new_peer;
+	peer_iface_info *new_peer;
 	ipa_hdr_l2_type peer_l2_hdr_type;
 
-	new_peer.peer = peer_iface;
-	memcpy(new_peer.rt_tbl_name_for_rt[IPA_IP_v4], rt_tbl_name_for_rt[IPA_IP_v4], IPA_RESOURCE_NAME_MAX);
-	memcpy(new_peer.rt_tbl_name_for_rt[IPA_IP_v6], rt_tbl_name_for_rt[IPA_IP_v6], IPA_RESOURCE_NAME_MAX);
-	memcpy(new_peer.rt_tbl_name_for_flt[IPA_IP_v4], rt_tbl_name_for_flt[IPA_IP_v4], IPA_RESOURCE_NAME_MAX);
-	memcpy(new_peer.rt_tbl_name_for_flt[IPA_IP_v6], rt_tbl_name_for_flt[IPA_IP_v6], IPA_RESOURCE_NAME_MAX);
+	new_peer = &m_peer_iface_info[peer_iface->m_iface_idx];
+	memset(new_peer, 0, sizeof(*new_peer));
+	new_peer->peer = peer_iface;
+	memcpy(new_peer->rt_tbl_name_for_rt[IPA_IP_v4], rt_tbl_name_for_rt[IPA_IP_v4], IPA_RESOURCE_NAME_MAX);
+	memcpy(new_peer->rt_tbl_name_for_rt[IPA_IP_v6], rt_tbl_name_for_rt[IPA_IP_v6], IPA_RESOURCE_NAME_MAX);
+	memcpy(new_peer->rt_tbl_name_for_flt[IPA_IP_v4], rt_tbl_name_for_flt[IPA_IP_v4], IPA_RESOURCE_NAME_MAX);
+	memcpy(new_peer->rt_tbl_name_for_flt[IPA_IP_v6], rt_tbl_name_for_flt[IPA_IP_v6], IPA_RESOURCE_NAME_MAX);
 
 	peer_l2_hdr_type = peer_iface->m_p_iface->tx_prop->tx[0].hdr_l2_type;
 	increment_ref_cnt_peer_l2_hdr_type(peer_l2_hdr_type);
 	add_hdr_proc_ctx(peer_l2_hdr_type);
 
-	/* push the new peer_iface_info into the list */
-	m_peer_iface_info.push_front(new_peer);
+	/* the peer slot is indexed by the peer's interface slot */
+	m_peer_bitmap |= (1 << peer_iface->m_iface_idx);
 
 	return;
 }
@@ -1568,9 +1577,11 @@ void IPACM_LanToLan_Iface::handle_new_iface_up(char rt_tbl_name_for_flt[][IPA_RE
 void IPACM_LanToLan_Iface::handle_client_add(uint8_t *mac, bool is_l2tp_client, l2tp_vlan_mapping_info *mapping_info)
 {
 	list<client_info>::iterator it_client;
-	list<peer_iface_info>::iterator it_peer_info;
+	peer_iface_info *peer_info;
 	client_info new_client;
 	bool flag[IPA_HDR_L2_MAX];
+	uint32_t peers;
+	IPACM_RuleTxn txn(&IPACM_Iface::m_filtering, &IPACM_Iface::m_routing, &IPACM_Iface::m_header);
 
 	for(it_client = m_client_info.begin(); it_client != m_client_info.end(); it_client++)
 	{
@@ -1592,42 +1603,60 @@ void IPACM_LanToLan_Iface::handle_client_add(uint8_t *mac, bool is_l2tp_client,
 	memcpy(new_client.mac_addr, mac, sizeof(new_client.mac_addr));
 	new_client.is_l2tp_client = is_l2tp_client;
 	new_client.mapping_info = mapping_info;
+	/* lowest free client slot, indexes the flt info on peer interfaces */
+	new_client.client_idx = __builtin_ctz(~m_client_bitmap);
+	m_client_bitmap |= (1 << new_client.client_idx);
 	m_client_info.push_front(new_client);
 
 	client_info &front_client = m_client_info.front();
 
-	/* install inter-interface rules */
+	/* routing rules of all peers go out in one transaction, filtering rules
+	   are placed per peer endpoint after it */
 	if(m_support_inter_iface_offload)
 	{
 		memset(flag, 0, sizeof(flag));
-		for(it_peer_info = m_peer_iface_info.begin(); it_peer_info != m_peer_iface_info.end(); it_peer_info++)
+		for(peers = m_peer_bitmap; peers != 0; peers &= peers - 1)
 		{
+			peer_info = &m_peer_iface_info[__builtin_ctz(peers)];
 			/* make sure add routing rule only once for each peer l2 header type */
-			if(flag[it_peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type] == false)
+			if(flag[peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type] == false)
 			{
 				/* add client routing rule for each peer interface */
 				if(front_client.is_l2tp_client == false)
 				{
-					add_client_rt_rule(&(*it_peer_info), &front_client);
+					add_client_rt_rule(peer_info, &front_client, &txn);
 				}
 #ifdef FEATURE_L2TP
 				/* add l2tp rt rules */
-				add_l2tp_client_rt_rule(&(*it_peer_info), &front_client);
+				add_l2tp_client_rt_rule(peer_info, &front_client);
 #endif
-				flag[it_peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type] = true;
+				flag[peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type] = true;
 			}
+		}
+	}
+	if(m_support_intra_iface_offload)
+	{
+		add_client_rt_rule(&m_intra_interface_info, &front_client, &txn);
+	}
+	if(txn.End() == false)
+	{
+		IPACMERR("Failed to add routing rules for new client.\n");
+	}
 
+	/* install inter-interface rules */
+	if(m_support_inter_iface_offload)
+	{
+		for(peers = m_peer_bitmap; peers != 0; peers &= peers - 1)
+		{
+			peer_info = &m_peer_iface_info[__builtin_ctz(peers)];
 			/* add client filtering rule on peer interfaces */
-			it_peer_info->peer->add_one_client_flt_rule(this, &front_client);
+			peer_info->peer->add_one_client_flt_rule(this, &front_client);
 		}
 	}
 
 	/* install intra-interface rules */
 	if(m_support_intra_iface_offload)
 	{
-		/* add routing rule first */
-		add_client_rt_rule(&m_intra_interface_info, &front_client);
-
 		/* add filtering rule */
 		if(m_is_ip_addr_assigned[IPA_IP_v4])
 		{
@@ -1645,8 +1674,10 @@ void IPACM_LanToLan_Iface::handle_client_add(uint8_t *mac, bool is_l2tp_client,
 void IPACM_LanToLan_Iface::handle_client_del(uint8_t *mac)
 {
 	list<client_info>::iterator it_client;
-	list<peer_iface_info>::iterator it_peer_info;
+	peer_iface_info *peer_info;
+	IPACM_RuleTxn txn(&IPACM_Iface::m_filtering, &IPACM_Iface::m_routing, &IPACM_Iface::m_header);
 	bool flag[IPA_HDR_L2_MAX];
+	uint32_t peers;
 
 	for(it_client = m_client_info.begin(); it_client != m_client_info.end(); it_client++)
 	{
@@ -1663,26 +1694,18 @@ void IPACM_LanToLan_Iface::handle_client_del(uint8_t *mac)
 		if(m_support_inter_iface_offload)
 		{
 			memset(flag, 0, sizeof(flag));
-			for(it_peer_info = m_peer_iface_info.begin(); it_peer_info != m_peer_iface_info.end();
-				it_peer_info++)
+			for(peers = m_peer_bitmap; peers != 0; peers &= peers - 1)
 			{
+				peer_info = &m_peer_iface_info[__builtin_ctz(peers)];
 				IPACMDBG_H("Delete client filtering rule on peer interface.\n");
-				it_peer_info->peer->del_one_client_flt_rule(this, &(*it_client));
+				peer_info->peer->del_one_client_flt_rule(this, &(*it_client), &txn);
 
 				/* make sure to delete routing rule only once for each peer l2 header type */
-				if(flag[it_peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type] == false)
+				if(flag[peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type] == false)
 				{
 					IPACMDBG_H("Delete client routing rule for peer interface.\n");
-					del_client_rt_rule(&(*it_peer_info), &(*it_client));
-#ifdef FEATURE_L2TP
-					if(it_client->is_l2tp_client == false && IPACM_LanToLan::get_instance()->has_l2tp_iface() == true
-						&& m_client_info.size() == 1)
-					{
-						m_p_iface->eth_bridge_del_hdr_proc_ctx(hdr_proc_ctx_for_l2tp);
-						hdr_proc_ctx_for_l2tp = 0;
-					}
-#endif
-					flag[it_peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type] = true;
+					del_client_rt_rule(peer_info, &(*it_client), &txn);
+					flag[peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type] = true;
 				}
 			}
 		}
@@ -1692,14 +1715,27 @@ void IPACM_LanToLan_Iface::handle_client_del(uint8_t *mac)
 		{
 			/* delete filtering rule first */
 			IPACMDBG_H("Delete client filtering rule for intra-interface communication.\n");
-			del_client_flt_rule(&m_intra_interface_info, &(*it_client));
+			del_client_flt_rule(&m_intra_interface_info, &(*it_client), &txn);
 
 			/* delete routing rule */
 			IPACMDBG_H("Delete client routing rule for intra-interface communication.\n");
-			del_client_rt_rule(&m_intra_interface_info, &(*it_client));
+			del_client_rt_rule(&m_intra_interface_info, &(*it_client), &txn);
+		}
+
+		/* push all flt/rt rule deletions of the client at once */
+		txn.End();
+
+#ifdef FEATURE_L2TP
+		if(m_support_inter_iface_offload && m_peer_bitmap != 0 && it_client->is_l2tp_client == false
+			&& IPACM_LanToLan::get_instance()->has_l2tp_iface() == true && m_client_info.size() == 1)
+		{
+			m_p_iface->eth_bridge_del_hdr_proc_ctx(hdr_proc_ctx_for_l2tp);
+			hdr_proc_ctx_for_l2tp = 0;
 		}
+#endif
 
 		/* erase the client from client info list */
+		m_client_bitmap &= ~(1 << it_client->client_idx);
 		m_client_info.erase(it_client);
 	}
 	else
@@ -1735,8 +1771,8 @@ void IPACM_LanToLan_Iface::del_hdr_proc_ctx(ipa_hdr_l2_type peer_l2_type)
 
 void IPACM_LanToLan_Iface::print_data_structure_info()
 {
-	list<peer_iface_info>::iterator it_peer;
 	list<client_info>::iterator it_client;
+	uint32_t peers;
 	int i, j, k;
 
 	IPACMDBG_H("\n");
@@ -1869,10 +1905,10 @@ void IPACM_LanToLan_Iface::print_data_structure_info()
 		i++;
 	}
 
-	IPACMDBG_H("There are %d peer interfaces in total.\n", m_peer_iface_info.size());
-	for(it_peer = m_peer_iface_info.begin(); it_peer != m_peer_iface_info.end(); it_peer++)
+	IPACMDBG_H("There are %d peer interfaces in total.\n", __builtin_popcount(m_peer_bitmap));
+	for(peers = m_peer_bitmap; peers != 0; peers &= peers - 1)
 	{
-		print_peer_info(&(*it_peer));
+		print_peer_info(&m_peer_iface_info[__builtin_ctz(peers)]);
 	}
 
 	if(m_support_intra_iface_offload)
@@ -1886,14 +1922,15 @@ void IPACM_LanToLan_Iface::print_data_structure_info()
 
 void IPACM_LanToLan_Iface::print_peer_info(peer_iface_info *peer_info)
 {
-	list<flt_rule_info>::iterator it_flt;
-	list<rt_rule_info>::iterator it_rt;
+	flt_rule_info *it_flt;
+	uint32_t clients;
 
 	IPACMDBG_H("Printing peer info for iface %s:\n", peer_info->peer->m_p_iface->dev_name);
 
-	IPACMDBG_H("There are %d flt info in total.\n", peer_info->flt_rule.size());
-	for(it_flt = peer_info->flt_rule.begin(); it_flt != peer_info->flt_rule.end(); it_flt++)
+	IPACMDBG_H("There are %d flt info in total.\n", __builtin_popcount(peer_info->flt_rule_bitmap));
+	for(clients = peer_info->flt_rule_bitmap; clients != 0; clients &= clients - 1)
 	{
+		it_flt = &peer_info->flt_rule[__builtin_ctz(clients)];
 		IPACMDBG_H("Flt rule handle for client 0x%08x:\n", it_flt->p_client);
 		if(m_is_ip_addr_assigned[IPA_IP_v4])
 		{
@@ -1916,6 +1953,11 @@ IPACM_Lan* IPACM_LanToLan_Iface::get_iface_pointer()
 	return m_p_iface;
 }
 
+int IPACM_LanToLan_Iface::get_iface_idx()
+{
+	return m_iface_idx;
+}
+
 bool IPACM_LanToLan_Iface::get_m_is_ip_addr_assigned(ipa_ip_type iptype)
 {
 	IPACMDBG_H("Has IP address been assigned to interface %s for IP type %d? %d\n",
@@ -1987,13 +2029,16 @@ bool IPACM_LanToLan_Iface::is_l2tp_iface()
 
 void IPACM_LanToLan_Iface::switch_to_l2tp_iface()
 {
-	list<peer_iface_info>::iterator it_peer;
-	list<flt_rule_info>::iterator it_flt;
+	peer_iface_info *peer;
+	flt_rule_info *it_flt;
+	uint32_t peers, clients;
 
-	for(it_peer = m_peer_iface_info.begin(); it_peer != m_peer_iface_info.end(); it_peer++)
+	for(peers = m_peer_bitmap; peers != 0; peers &= peers - 1)
 	{
-		for(it_flt = it_peer->flt_rule.begin(); it_flt != it_peer->flt_rule.end(); it_flt++)
+		peer = &m_peer_iface_info[__builtin_ctz(peers)];
+		for(clients = peer->flt_rule_bitmap; clients != 0; clients &= clients - 1)
 		{
+			it_flt = &peer->flt_rule[__builtin_ctz(clients)];
 			if(m_is_ip_addr_assigned[IPA_IP_v4])
 			{
 				m_p_iface->eth_bridge_del_flt_rule(it_flt->flt_rule_hdl[IPA_IP_v4], IPA_IP_v4);
@@ -2013,18 +2058,20 @@ void IPACM_LanToLan_Iface::handle_l2tp_enable()
 {
 	int i;
 	ipa_hdr_l2_type peer_l2_hdr_type;
-	list<peer_iface_info>::iterator it_peer_info;
 	list<client_info>::iterator it_client;
 	bool flag[IPA_HDR_L2_MAX];
+	IPACM_LanToLan_Iface *peer;
+	uint32_t peers;
 
 	if(m_support_inter_iface_offload)
 	{
 		memset(flag, 0, sizeof(flag));
-		for(it_peer_info = m_peer_iface_info.begin(); it_peer_info != m_peer_iface_info.end(); it_peer_info++)
+		for(peers = m_peer_bitmap; peers != 0; peers &= peers - 1)
 		{
-			if(it_peer_info->peer->is_l2tp_iface())
+			peer = m_peer_iface_info[__builtin_ctz(peers)].peer;
+			if(peer->is_l2tp_iface())
 			{
-				peer_l2_hdr_type = it_peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type;
+				peer_l2_hdr_type = peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type;
 				flag[peer_l2_hdr_type] = true;
 			}
 		}
@@ -2050,16 +2097,16 @@ void IPACM_LanToLan_Iface::handle_l2tp_disable()
 {
 	int i;
 	ipa_hdr_l2_type peer_l2_hdr_type;
-	list<peer_iface_info>::iterator it_peer_info;
 	list<client_info>::iterator it_client;
 	bool flag[IPA_HDR_L2_MAX];
+	uint32_t peers;
 
 	if(m_support_inter_iface_offload)
 	{
 		memset(flag, 0, sizeof(flag));
-		for(it_peer_info = m_peer_iface_info.begin(); it_peer_info != m_peer_iface_info.end(); it_peer_info++)
+		for(peers = m_peer_bitmap; peers != 0; peers &= peers - 1)
 		{
-			peer_l2_hdr_type = it_peer_info->peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type;
+			peer_l2_hdr_type = m_peer_iface_info[__builtin_ctz(peers)].peer->get_iface_pointer()->tx_prop->tx[0].hdr_l2_type;
 			flag[peer_l2_hdr_type] = true;
 		}
 
@@ -101,6 +101,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define IPA_DRIVER_WLAN_BUF_LEN     (IPA_DRIVER_PIPE_STATS_EVENT_SIZE + IPA_DRIVER_WLAN_META_MSG)
 
 uint32_t ipacm_event_stats[IPACM_EVENT_MAX];
+uint32_t ipacm_event_latency[IPACM_EVENT_MAX][IPACM_EVT_LAT_HIST_SIZE];
 bool ipacm_logging = true;
 
 void ipa_is_ipacm_running(void);
@@ -697,12 +698,7 @@ void* ipa_driver_msg_notifier(void *param)
 		case IPA_QUOTA_REACH:
 			IPACMDBG_H("Received IPA_QUOTA_REACH\n");
 			OffloadMng = IPACM_OffloadManager::GetInstance();
-			if (OffloadMng->elrInstance == NULL) {
-				IPACMERR("OffloadMng->elrInstance is NULL, can't forward to framework!\n");
-			} else {
-				IPACMERR("calling OffloadMng->elrInstance->onLimitReached \n");
-				OffloadMng->elrInstance->onLimitReached();
-			}
+			OffloadMng->notifyLimitReached(NULL);
 			continue;
 		case IPA_SSR_BEFORE_SHUTDOWN:
 			IPACMDBG_H("Received IPA_SSR_BEFORE_SHUTDOWN\n");
@@ -41,6 +41,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <unistd.h>
 #include <sys/ioctl.h>
 #include <netinet/in.h>
+#include <time.h>
 #include "IPACM_CmdQueue.h"
 #include "IPACM_Defs.h"
 #include "IPACM_Netlink.h"
@@ -48,8 +49,90 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "IPACM_Log.h"
 
 int ipa_get_if_name(char *if_name, int if_index);
+int ipa_get_if_index_cached(const char *if_name, int *if_index);
 int find_mask(int ip_v4_last, int *mask_value);
 
+/* ifindex -> name cache, direct mapped on the index. RTM_NEWLINK refreshes
+	 an entry and RTM_DELLINK drops it; SIOCGIFNAME is only issued on a miss. */
+#define IPA_IF_NAME_CACHE_SIZE 32
+#define IPA_IF_NAME_STATS_PERIOD 10 /* seconds */
+/* socket + ioctl + close per uncached lookup */
+#define IPA_IF_NAME_SYSCALLS_PER_LOOKUP 3
+
+typedef struct
+{
+	int if_index;
+	char if_name[IF_NAME_LEN];
+} ipa_if_name_cache_entry;
+
+static ipa_if_name_cache_entry if_name_cache[IPA_IF_NAME_CACHE_SIZE];
+static pthread_mutex_t if_name_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t if_name_cache_hits, if_name_cache_misses;
+static time_t if_name_stats_start;
+
+/* Set (if_name != NULL and not empty) or drop the cached name of if_index */
+static void ipa_if_name_cache_update(int if_index, const char *if_name)
+{
+	ipa_if_name_cache_entry *entry;
+
+	if(if_index <= 0)
+	{
+		return;
+	}
+	entry = &if_name_cache[if_index % IPA_IF_NAME_CACHE_SIZE];
+
+	pthread_mutex_lock(&if_name_cache_lock);
+	if(if_name != NULL && if_name[0] != '\0')
+	{
+		entry->if_index = if_index;
+		(void)strlcpy(entry->if_name, if_name, sizeof(entry->if_name));
+	}
+	else if(entry->if_index == if_index)
+	{
+		entry->if_index = 0;
+	}
+	pthread_mutex_unlock(&if_name_cache_lock);
+}
+
+/* Count a lookup and report the syscalls saved every stats period */
+static void ipa_if_name_cache_count(bool hit)
+{
+	time_t now = time(NULL);
+	uint32_t hits, misses;
+	time_t elapsed;
+
+	pthread_mutex_lock(&if_name_cache_lock);
+	if(hit)
+	{
+		if_name_cache_hits++;
+	}
+	else
+	{
+		if_name_cache_misses++;
+	}
+
+	if(if_name_stats_start == 0)
+	{
+		if_name_stats_start = now;
+	}
+	elapsed = now - if_name_stats_start;
+	if(elapsed < IPA_IF_NAME_STATS_PERIOD)
+	{
+		pthread_mutex_unlock(&if_name_cache_lock);
+		return;
+	}
+
+	hits = if_name_cache_hits;
+	misses = if_name_cache_misses;
+	if_name_cache_hits = 0;
+	if_name_cache_misses = 0;
+	if_name_stats_start = now;
+	pthread_mutex_unlock(&if_name_cache_lock);
+
+	IPACMDBG_H("ifname cache: %u hits %u misses, %ld syscalls/s saved\n", hits, misses,
+		(long)(hits * IPA_IF_NAME_SYSCALLS_PER_LOOKUP) / (long)elapsed);
+}
+
 #ifdef FEATURE_IPA_ANDROID
 
 #define IPACM_NL_COPY_ADDR( event_info, element )                                        \
@@ -428,10 +511,27 @@ static int ipa_nl_decode_rtm_link
 	/* NL message header */
 	struct nlmsghdr *nlh = (struct nlmsghdr *)buffer;
 
+	struct rtattr *rtah = NULL;
+	int rtalen;
+
 	/* Extract the header data */
 	link_info->metainfo = *(struct ifinfomsg *)NLMSG_DATA(nlh);
 	buflen -= sizeof(struct nlmsghdr);
 
+	/* only the name is of interest, it keeps the ifindex cache in sync */
+	memset(link_info->if_name, 0, sizeof(link_info->if_name));
+	rtah = IFLA_RTA(NLMSG_DATA(nlh));
+	rtalen = IFLA_PAYLOAD(nlh);
+	while(RTA_OK(rtah, rtalen))
+	{
+		if(rtah->rta_type == IFLA_IFNAME)
+		{
+			(void)strlcpy(link_info->if_name, (char *)RTA_DATA(rtah), sizeof(link_info->if_name));
+			break;
+		}
+		rtah = RTA_NEXT(rtah, rtalen);
+	}
+
 	return IPACM_SUCCESS;
 }
 
@@ -639,6 +739,8 @@ static int ipa_nl_decode_nlmsg
 				IPACMDBG("RTM_NEWLINK, ifi_flags:%d\n", msg_ptr->nl_link_info.metainfo.ifi_flags);
 				IPACMDBG("RTM_NEWLINK, ifi_index:%d\n", msg_ptr->nl_link_info.metainfo.ifi_index);
 				IPACMDBG("RTM_NEWLINK, family:%d\n", msg_ptr->nl_link_info.metainfo.ifi_family);
+				ipa_if_name_cache_update(msg_ptr->nl_link_info.metainfo.ifi_index,
+					msg_ptr->nl_link_info.if_name);
 				/* RTM_NEWLINK event with AF_BRIDGE family should be ignored in Android
 				   but this should be processed in case of MDM for Ehernet interface.
 				*/
@@ -779,6 +881,9 @@ static int ipa_nl_decode_nlmsg
 					return IPACM_SUCCESS;
 				}
 #endif
+				/* drop the cached name first so the lookup still goes to the kernel:
+				   a device that is already gone fails SIOCGIFNAME and posts nothing */
+				ipa_if_name_cache_update(msg_ptr->nl_link_info.metainfo.ifi_index, NULL);
 				ret_val = ipa_get_if_name(dev_name, msg_ptr->nl_link_info.metainfo.ifi_index);
 				if(ret_val != IPACM_SUCCESS)
 				{
@@ -786,6 +891,7 @@ static int ipa_nl_decode_nlmsg
 					return IPACM_FAILURE;
 				}
 				IPACMDBG("Interface %s bring down \n", dev_name);
+				ipa_if_name_cache_update(msg_ptr->nl_link_info.metainfo.ifi_index, NULL);
 
 				/* post link down to command queue */
 				evt_data.event = IPA_LINK_DOWN_EVENT;
@@ -1602,9 +1708,26 @@ int ipa_get_if_name
 	 int if_index
 	 )
 {
+	ipa_if_name_cache_entry *entry;
 	int fd;
 	struct ifreq ifr;
 
+	if(if_index > 0)
+	{
+		entry = &if_name_cache[if_index % IPA_IF_NAME_CACHE_SIZE];
+		pthread_mutex_lock(&if_name_cache_lock);
+		if(entry->if_index == if_index)
+		{
+			(void)strlcpy(if_name, entry->if_name, IF_NAME_LEN);
+			pthread_mutex_unlock(&if_name_cache_lock);
+			ipa_if_name_cache_count(true);
+			IPACMDBG("interface name %s (cached)\n", if_name);
+			return IPACM_SUCCESS;
+		}
+		pthread_mutex_unlock(&if_name_cache_lock);
+	}
+	ipa_if_name_cache_count(false);
+
 	if((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
 	{
 		IPACMERR("get interface name socket create failed \n");
@@ -1626,6 +1749,57 @@ int ipa_get_if_name
 	IPACMDBG("interface name %s\n", ifr.ifr_name);
 	close(fd);
 
+	ipa_if_name_cache_update(if_index, if_name);
+	return IPACM_SUCCESS;
+}
+
+/*  get interface index from the name, reverse of ipa_get_if_name */
+int ipa_get_if_index_cached
+(
+	 const char *if_name,
+	 int *if_index
+	 )
+{
+	int fd, cnt;
+	struct ifreq ifr;
+
+	pthread_mutex_lock(&if_name_cache_lock);
+	for(cnt = 0; cnt < IPA_IF_NAME_CACHE_SIZE; cnt++)
+	{
+		if(if_name_cache[cnt].if_index > 0 &&
+			 strncmp(if_name_cache[cnt].if_name, if_name, IF_NAME_LEN) == 0)
+		{
+			*if_index = if_name_cache[cnt].if_index;
+			pthread_mutex_unlock(&if_name_cache_lock);
+			ipa_if_name_cache_count(true);
+			IPACMDBG("Interface netdev index %d (cached)\n", *if_index);
+			return IPACM_SUCCESS;
+		}
+	}
+	pthread_mutex_unlock(&if_name_cache_lock);
+	ipa_if_name_cache_count(false);
+
+	if((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
+	{
+		IPACMERR("get interface index socket create failed \n");
+		return IPACM_FAILURE;
+	}
+
+	memset(&ifr, 0, sizeof(struct ifreq));
+	(void)strlcpy(ifr.ifr_name, if_name, sizeof(ifr.ifr_name));
+
+	if(ioctl(fd, SIOCGIFINDEX, &ifr) < 0)
+	{
+		IPACMERR("call_ioctl_on_dev: ioctl failed, interface name (%s):\n", ifr.ifr_name);
+		close(fd);
+		return IPACM_FAILURE;
+	}
+
+	*if_index = ifr.ifr_ifindex;
+	IPACMDBG("Interface netdev index %d\n", *if_index);
+	close(fd);
+
+	ipa_if_name_cache_update(*if_index, ifr.ifr_name);
 	return IPACM_SUCCESS;
 }
 
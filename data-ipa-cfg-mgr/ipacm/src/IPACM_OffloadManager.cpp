@@ -45,9 +45,10 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.Z
 #include "IPACM_ConntrackListener.h"
 #include "IPACM_Iface.h"
 #include "IPACM_Config.h"
+#include "IPACM_OffloadStats.h"
 #include <unistd.h>
 
-const char *IPACM_OffloadManager::DEVICE_NAME = "/dev/wwan_ioctl";
+int ipa_get_if_index_cached(const char *if_name, int *if_index);
 
 /* NatApp class Implementation */
 IPACM_OffloadManager *IPACM_OffloadManager::pInstance = NULL;
@@ -61,9 +62,31 @@ IPACM_OffloadManager::IPACM_OffloadManager()
 	latest_cache_index = 0;
 	elrInstance = NULL;
 	touInstance = NULL;
+	IPACM_OffloadStats::GetInstance()->SetLimitCb(limit_reached_cb);
 	return ;
 }
 
+void IPACM_OffloadManager::limit_reached_cb(const char *upstream)
+{
+	IPACM_OffloadManager::GetInstance()->notifyLimitReached(upstream);
+}
+
+void IPACM_OffloadManager::notifyLimitReached(const char *upstream)
+{
+	/* the kernel quota and the cached quota check both end up here */
+	if (!IPACM_OffloadStats::GetInstance()->MarkQuotaReached(upstream))
+	{
+		IPACMDBG_H("limit already reported\n");
+		return;
+	}
+	if (elrInstance == NULL) {
+		IPACMERR("elrInstance is NULL, can't forward to framework!\n");
+	} else {
+		IPACMERR("calling elrInstance->onLimitReached \n");
+		elrInstance->onLimitReached();
+	}
+}
+
 RET IPACM_OffloadManager::registerEventListener(IpaEventListener* eventlistener)
 {
 	RET result = SUCCESS;
@@ -552,6 +575,7 @@ RET IPACM_OffloadManager::stopAllOffload()
 	memset(event_cache, 0, MAX_EVENT_CACHE*sizeof(framework_event_cache));
 	latest_cache_index = 0;
 	valid_ifaces.clear();
+	IPACM_OffloadStats::GetInstance()->Suspend();
 	return result;
 }
 
@@ -560,9 +584,8 @@ RET IPACM_OffloadManager::setQuota(const char * upstream_name /* upstream */, ui
 	wan_ioctl_set_data_quota quota;
 	int fd = -1,rc = 0;
 
-	if ((fd = open(DEVICE_NAME, O_RDWR)) < 0)
+	if ((fd = IPACM_OffloadStats::GetInstance()->GetFd()) < 0)
 	{
-		IPACMERR("Failed opening %s.\n", DEVICE_NAME);
 		return FAIL_HARDWARE;
 	}
 
@@ -572,7 +595,6 @@ RET IPACM_OffloadManager::setQuota(const char * upstream_name /* upstream */, ui
     memset(quota.interface_name, 0, IFNAMSIZ);
     if (strlcpy(quota.interface_name, upstream_name, IFNAMSIZ) >= IFNAMSIZ) {
 		IPACMERR("String truncation occurred on upstream");
-		close(fd);
 		return FAIL_INPUT_CHECK;
 	}
 
@@ -582,7 +604,6 @@ RET IPACM_OffloadManager::setQuota(const char * upstream_name /* upstream */, ui
 
 	if(rc != 0)
 	{
-		close(fd);
         	IPACMERR("IOCTL WAN_IOCTL_SET_DATA_QUOTA call failed: %s rc: %d\n", strerror(errno),rc);
 		if (errno == ENODEV) {
 			IPACMDBG_H("Invalid argument.\n");
@@ -592,41 +613,30 @@ RET IPACM_OffloadManager::setQuota(const char * upstream_name /* upstream */, ui
 			return FAIL_TRY_AGAIN;
 		}
 	}
-	close(fd);
+	/* the framework limit is in bytes, checked against the sampled totals too */
+	IPACM_OffloadStats::GetInstance()->SetQuota(upstream_name, mb);
 	return SUCCESS;
 }
 
 RET IPACM_OffloadManager::getStats(const char * upstream_name /* upstream */,
 		bool reset /* reset */, OffloadStatistics& offload_stats/* ret */)
 {
-	int fd = -1;
-	wan_ioctl_query_tether_stats_all stats;
-
-	if ((fd = open(DEVICE_NAME, O_RDWR)) < 0) {
-        IPACMERR("Failed opening %s.\n", DEVICE_NAME);
-        return FAIL_HARDWARE;
-    }
+	uint64_t rx = 0, tx = 0;
 
-    memset(&stats, 0, sizeof(stats));
-    if (strlcpy(stats.upstreamIface, upstream_name, IFNAMSIZ) >= IFNAMSIZ) {
+	if (strnlen(upstream_name, IFNAMSIZ) >= IFNAMSIZ) {
 		IPACMERR("String truncation occurred on upstream\n");
-		close(fd);
 		return FAIL_INPUT_CHECK;
 	}
-	stats.reset_stats = reset;
-	stats.ipa_client = IPACM_CLIENT_MAX;
 
-	if (ioctl(fd, WAN_IOC_QUERY_TETHER_STATS_ALL, &stats) < 0) {
-        IPACMERR("IOCTL WAN_IOC_QUERY_TETHER_STATS_ALL call failed: %s \n", strerror(errno));
-		close(fd);
+	/* answered from the stats engine, it only reads the counters when its sample is stale */
+	if (IPACM_OffloadStats::GetInstance()->Query(upstream_name, reset, &rx, &tx) != IPACM_SUCCESS) {
 		return FAIL_TRY_AGAIN;
 	}
 	/* feedback to IPAHAL*/
-	offload_stats.tx = stats.tx_bytes;
-	offload_stats.rx = stats.rx_bytes;
+	offload_stats.tx = tx;
+	offload_stats.rx = rx;
 
 	IPACMDBG_H("send getStats tx:%llu rx:%llu \n", (long long)offload_stats.tx, (long long)offload_stats.rx);
-	close(fd);
 	return SUCCESS;
 }
 
@@ -681,63 +691,32 @@ int IPACM_OffloadManager::post_route_evt(enum ipa_ip_type iptype, int index, ipa
 
 int IPACM_OffloadManager::ipa_get_if_index(const char * if_name, int * if_index)
 {
-	int fd;
-	struct ifreq ifr;
-
-	if((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
-	{
-		IPACMERR("get interface index socket create failed \n");
-		return IPACM_FAILURE;
-	}
-
-	if(strnlen(if_name, sizeof(if_name)) >= sizeof(ifr.ifr_name)) {
-		IPACMERR("interface name overflows: len %zu\n", strnlen(if_name, sizeof(if_name)));
-		close(fd);
+	if(strnlen(if_name, IF_NAME_LEN) >= IF_NAME_LEN) {
+		IPACMERR("interface name overflows: len %zu\n", strnlen(if_name, IF_NAME_LEN));
 		return IPACM_FAILURE;
 	}
 
-	memset(&ifr, 0, sizeof(struct ifreq));
-	(void)strlcpy(ifr.ifr_name, if_name, sizeof(ifr.ifr_name));
 	IPACMDBG_H("interface name (%s)\n", if_name);
-
-	if(ioctl(fd,SIOCGIFINDEX , &ifr) < 0)
+	if(ipa_get_if_index_cached(if_name, if_index) != IPACM_SUCCESS)
 	{
-		IPACMERR("call_ioctl_on_dev: ioctl failed, interface name (%s):\n", ifr.ifr_name);
-		close(fd);
 		return IPACM_FAILURE;
 	}
 
-	*if_index = ifr.ifr_ifindex;
 	IPACMDBG_H("Interface netdev index %d\n", *if_index);
-	close(fd);
 	return IPACM_SUCCESS;
 }
 
 int IPACM_OffloadManager::resetTetherStats(const char * upstream_name /* upstream */)
 {
-	int fd = -1;
-	wan_ioctl_reset_tether_stats stats;
-
-	if ((fd = open(DEVICE_NAME, O_RDWR)) < 0) {
-		IPACMERR("Failed opening %s.\n", DEVICE_NAME);
-		return FAIL_HARDWARE;
-	}
-	memset(stats.upstreamIface, 0, IFNAMSIZ);
-	if (strlcpy(stats.upstreamIface, upstream_name, IFNAMSIZ) >= IFNAMSIZ) {
+	if (strnlen(upstream_name, IFNAMSIZ) >= IFNAMSIZ) {
 		IPACMERR("String truncation occurred on upstream\n");
-		close(fd);
 		return FAIL_INPUT_CHECK;
 	}
-	stats.reset_stats = true;
-	if (ioctl(fd, WAN_IOC_RESET_TETHER_STATS, &stats) < 0) {
-		IPACMERR("IOCTL WAN_IOC_RESET_TETHER_STATS call failed: %s", strerror(errno));
-		close(fd);
+	if (IPACM_OffloadStats::GetInstance()->Reset(upstream_name) != IPACM_SUCCESS) {
 		return FAIL_HARDWARE;
 	}
-	IPACMDBG_H("Reset Interface %s stats\n", upstream_name);
-	close(fd);
 	return IPACM_SUCCESS;
-	}
+}
 
 IPACM_OffloadManager* IPACM_OffloadManager::GetInstance()
 {
@@ -0,0 +1,476 @@
+/*
+Copyright (c) 2018, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_OffloadStats.cpp
+
+	@brief
+	This file implements the tethering offload statistics engine
+
+	@Author
+
+*/
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <linux/rmnet_ipa_fd_ioctl.h>
+#include <IPACM_OffloadStats.h>
+#include <IPACM_Config.h>
+#include <IPACM_Log.h>
+
+const char *IPACM_OffloadStats::DEVICE_NAME = "/dev/wwan_ioctl";
+
+IPACM_OffloadStats *IPACM_OffloadStats::pInstance = NULL;
+
+IPACM_OffloadStats::IPACM_OffloadStats()
+{
+	pthread_condattr_t attr;
+
+	fd = -1;
+	interval_ms = IPACM_Config::GetInstance()->GetOffloadStatsInterval();
+	thread_started = false;
+	limit_cb = NULL;
+	num_active = 0;
+	memset(upstream_tbl, 0, sizeof(upstream_tbl));
+
+	pthread_mutex_init(&lock, NULL);
+	/* the period must not jump with the wall clock */
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&cond, &attr);
+	pthread_condattr_destroy(&attr);
+	IPACMDBG_H("offload stats sampled every %d ms\n", interval_ms);
+}
+
+IPACM_OffloadStats* IPACM_OffloadStats::GetInstance()
+{
+	if (pInstance == NULL)
+		pInstance = new IPACM_OffloadStats();
+
+	return pInstance;
+}
+
+uint64_t IPACM_OffloadStats::NowMs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int IPACM_OffloadStats::FdLocked(void)
+{
+	if (fd < 0)
+	{
+		fd = open(DEVICE_NAME, O_RDWR);
+		if (fd < 0)
+		{
+			IPACMERR("Failed opening %s.\n", DEVICE_NAME);
+		}
+	}
+	return fd;
+}
+
+int IPACM_OffloadStats::GetFd(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&lock);
+	ret = FdLocked();
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+void IPACM_OffloadStats::SetLimitCb(ipacm_offload_limit_cb cb)
+{
+	pthread_mutex_lock(&lock);
+	limit_cb = cb;
+	pthread_mutex_unlock(&lock);
+}
+
+int IPACM_OffloadStats::StartLocked(void)
+{
+	pthread_t thread;
+
+	if (thread_started)
+	{
+		return IPACM_SUCCESS;
+	}
+	if (pthread_create(&thread, NULL, SampleThread, this) != 0)
+	{
+		IPACMERR("unable to create offload stats thread\n");
+		return IPACM_FAILURE;
+	}
+	pthread_detach(thread);
+	if (pthread_setname_np(thread, "offload stats") != 0)
+	{
+		IPACMERR("unable to set thread name\n");
+	}
+	thread_started = true;
+	IPACMDBG_H("created offload stats thread\n");
+	return IPACM_SUCCESS;
+}
+
+ipacm_offload_stats_entry* IPACM_OffloadStats::FindLocked(const char *upstream, bool add)
+{
+	ipacm_offload_stats_entry *free_entry = NULL, *old_entry = NULL;
+	int i;
+
+	for (i = 0; i < IPACM_OFFLOAD_STATS_MAX_UPSTREAM; i++)
+	{
+		if (!upstream_tbl[i].valid)
+		{
+			if (free_entry == NULL)
+				free_entry = &upstream_tbl[i];
+			continue;
+		}
+		if (strncmp(upstream_tbl[i].name, upstream, IFNAMSIZ) == 0)
+		{
+			return &upstream_tbl[i];
+		}
+		if (old_entry == NULL || upstream_tbl[i].last_use_ms < old_entry->last_use_ms)
+		{
+			old_entry = &upstream_tbl[i];
+		}
+	}
+	if (!add)
+	{
+		return NULL;
+	}
+
+	if (free_entry == NULL)
+	{
+		/* recycle the upstream the framework asked about least recently */
+		IPACMDBG_H("stats table full, drop upstream %s\n", old_entry->name);
+		if (old_entry->active)
+			num_active--;
+		free_entry = old_entry;
+	}
+	memset(free_entry, 0, sizeof(*free_entry));
+	free_entry->valid = true;
+	strlcpy(free_entry->name, upstream, IFNAMSIZ);
+	IPACMDBG_H("track stats of upstream %s\n", free_entry->name);
+	return free_entry;
+}
+
+void IPACM_OffloadStats::ActivateLocked(ipacm_offload_stats_entry *entry, uint64_t now)
+{
+	entry->last_use_ms = now;
+	if (!entry->active)
+	{
+		entry->active = true;
+		num_active++;
+		StartLocked();
+		pthread_cond_signal(&cond);
+	}
+}
+
+/* the kernel counters restart on every query, the totals keep the sum */
+int IPACM_OffloadStats::ReadCounters(int fd, const char *upstream, uint64_t *rx, uint64_t *tx)
+{
+	wan_ioctl_query_tether_stats_all stats;
+
+	memset(&stats, 0, sizeof(stats));
+	strlcpy(stats.upstreamIface, upstream, IFNAMSIZ);
+	stats.reset_stats = true;
+	stats.ipa_client = IPACM_CLIENT_MAX;
+
+	if (ioctl(fd, WAN_IOC_QUERY_TETHER_STATS_ALL, &stats) < 0)
+	{
+		return errno;
+	}
+	*rx = stats.rx_bytes;
+	*tx = stats.tx_bytes;
+	return 0;
+}
+
+int IPACM_OffloadStats::FoldLocked(ipacm_offload_stats_entry *entry, int err, uint64_t rx, uint64_t tx, uint64_t now)
+{
+	if (err != 0)
+	{
+		/* an upstream without offload keeps failing, log it once */
+		if (!entry->sample_err)
+		{
+			IPACMERR("IOCTL WAN_IOC_QUERY_TETHER_STATS_ALL on %s failed: %s\n",
+				entry->name, strerror(err));
+			entry->sample_err = true;
+		}
+		return IPACM_FAILURE;
+	}
+	entry->sample_err = false;
+	entry->rx_total += rx;
+	entry->tx_total += tx;
+	entry->last_sample_ms = now;
+	return IPACM_SUCCESS;
+}
+
+int IPACM_OffloadStats::SampleLocked(ipacm_offload_stats_entry *entry, uint64_t now)
+{
+	uint64_t rx = 0, tx = 0;
+	int err;
+
+	if (FdLocked() < 0)
+	{
+		return IPACM_FAILURE;
+	}
+	err = ReadCounters(fd, entry->name, &rx, &tx);
+	return FoldLocked(entry, err, rx, tx, now);
+}
+
+bool IPACM_OffloadStats::CheckQuotaLocked(ipacm_offload_stats_entry *entry)
+{
+	if (!entry->quota_set || entry->quota_reached)
+	{
+		return false;
+	}
+	if (entry->rx_total + entry->tx_total - entry->quota_base < entry->quota_bytes)
+	{
+		return false;
+	}
+	/* quota_reached is set by MarkQuotaReached from the limit callback */
+	IPACMDBG_H("upstream %s used up quota %llu\n", entry->name, (long long)entry->quota_bytes);
+	return true;
+}
+
+void* IPACM_OffloadStats::SampleThread(void *arg)
+{
+	IPACM_OffloadStats *st = (IPACM_OffloadStats *)arg;
+	struct
+	{
+		char name[IFNAMSIZ];
+		uint32_t quota_seq;
+		int err;
+		uint64_t rx;
+		uint64_t tx;
+	} sample[IPACM_OFFLOAD_STATS_MAX_UPSTREAM];
+	char reached[IPACM_OFFLOAD_STATS_MAX_UPSTREAM][IFNAMSIZ];
+	ipacm_offload_stats_entry *entry;
+	ipacm_offload_limit_cb cb;
+	struct timespec ts;
+	uint64_t now, deadline;
+	int i, fd, num_sample, num_reached;
+
+	pthread_mutex_lock(&st->lock);
+	while (1)
+	{
+		if (st->num_active == 0)
+		{
+			pthread_cond_wait(&st->cond, &st->lock);
+			continue;
+		}
+
+		now = NowMs();
+		num_sample = 0;
+		for (i = 0; i < IPACM_OFFLOAD_STATS_MAX_UPSTREAM; i++)
+		{
+			if (!st->upstream_tbl[i].active)
+				continue;
+			memcpy(sample[num_sample].name, st->upstream_tbl[i].name, IFNAMSIZ);
+			sample[num_sample].quota_seq = st->upstream_tbl[i].quota_seq;
+			num_sample++;
+		}
+		fd = st->FdLocked();
+
+		/* the framework calls must not wait behind the ioctls */
+		pthread_mutex_unlock(&st->lock);
+		for (i = 0; i < num_sample; i++)
+		{
+			sample[i].rx = sample[i].tx = 0;
+			sample[i].err = (fd < 0) ? ENODEV : ReadCounters(fd, sample[i].name, &sample[i].rx, &sample[i].tx);
+		}
+		pthread_mutex_lock(&st->lock);
+
+		num_reached = 0;
+		for (i = 0; i < num_sample; i++)
+		{
+			/* the upstream may have been recycled meanwhile, its bytes go with it */
+			entry = st->FindLocked(sample[i].name, false);
+			if (entry == NULL)
+				continue;
+			if (st->FoldLocked(entry, sample[i].err, sample[i].rx, sample[i].tx, now) != IPACM_SUCCESS)
+				continue;
+			/* the quota was set after these bytes were counted, keep them out of it */
+			if (entry->quota_seq != sample[i].quota_seq)
+				entry->quota_base += sample[i].rx + sample[i].tx;
+			if (st->CheckQuotaLocked(entry))
+				memcpy(reached[num_reached++], entry->name, IFNAMSIZ);
+		}
+
+		cb = st->limit_cb;
+		if (num_reached > 0 && cb != NULL)
+		{
+			pthread_mutex_unlock(&st->lock);
+			for (i = 0; i < num_reached; i++)
+			{
+				cb(reached[i]);
+			}
+			pthread_mutex_lock(&st->lock);
+		}
+
+		deadline = now + st->interval_ms;
+		ts.tv_sec = deadline / 1000;
+		ts.tv_nsec = (deadline % 1000) * 1000000;
+		while (st->num_active > 0 && NowMs() < deadline)
+		{
+			if (pthread_cond_timedwait(&st->cond, &st->lock, &ts) == ETIMEDOUT)
+				break;
+		}
+	}
+	pthread_mutex_unlock(&st->lock);
+	return NULL;
+}
+
+int IPACM_OffloadStats::Query(const char *upstream, bool reset, uint64_t *rx, uint64_t *tx)
+{
+	ipacm_offload_stats_entry *entry;
+	uint64_t now = NowMs();
+
+	pthread_mutex_lock(&lock);
+	entry = FindLocked(upstream, true);
+
+	/* first query, or the thread is behind: read the counters now */
+	if (entry->last_sample_ms == 0 || now - entry->last_sample_ms >= (uint64_t)interval_ms)
+	{
+		if (SampleLocked(entry, now) != IPACM_SUCCESS && entry->last_sample_ms == 0)
+		{
+			pthread_mutex_unlock(&lock);
+			return IPACM_FAILURE;
+		}
+	}
+	ActivateLocked(entry, now);
+
+	*rx = entry->rx_total - entry->rx_reported;
+	*tx = entry->tx_total - entry->tx_reported;
+	if (reset)
+	{
+		entry->rx_reported = entry->rx_total;
+		entry->tx_reported = entry->tx_total;
+	}
+	pthread_mutex_unlock(&lock);
+	return IPACM_SUCCESS;
+}
+
+int IPACM_OffloadStats::SetQuota(const char *upstream, uint64_t limit)
+{
+	ipacm_offload_stats_entry *entry;
+	uint64_t now = NowMs();
+	int i;
+
+	pthread_mutex_lock(&lock);
+	entry = FindLocked(upstream, true);
+	/* the kernel counts the quota from now on, so does the base */
+	SampleLocked(entry, now);
+	/* the wwan quota ioctl replaces the previously armed one */
+	for (i = 0; i < IPACM_OFFLOAD_STATS_MAX_UPSTREAM; i++)
+	{
+		upstream_tbl[i].kernel_quota = false;
+	}
+	entry->kernel_quota = true;
+	entry->quota_set = true;
+	entry->quota_reached = false;
+	entry->quota_seq++;
+	entry->quota_bytes = limit;
+	entry->quota_base = entry->rx_total + entry->tx_total;
+	ActivateLocked(entry, now);
+	pthread_mutex_unlock(&lock);
+	return IPACM_SUCCESS;
+}
+
+int IPACM_OffloadStats::Reset(const char *upstream)
+{
+	ipacm_offload_stats_entry *entry;
+	wan_ioctl_reset_tether_stats stats;
+
+	pthread_mutex_lock(&lock);
+	entry = FindLocked(upstream, false);
+	if (entry != NULL)
+	{
+		SampleLocked(entry, NowMs());
+	}
+	if (FdLocked() < 0)
+	{
+		pthread_mutex_unlock(&lock);
+		return IPACM_FAILURE;
+	}
+	memset(&stats, 0, sizeof(stats));
+	strlcpy(stats.upstreamIface, upstream, IFNAMSIZ);
+	stats.reset_stats = true;
+	if (ioctl(fd, WAN_IOC_RESET_TETHER_STATS, &stats) < 0)
+	{
+		IPACMERR("IOCTL WAN_IOC_RESET_TETHER_STATS call failed: %s", strerror(errno));
+		pthread_mutex_unlock(&lock);
+		return IPACM_FAILURE;
+	}
+	pthread_mutex_unlock(&lock);
+	IPACMDBG_H("Reset Interface %s stats\n", upstream);
+	return IPACM_SUCCESS;
+}
+
+bool IPACM_OffloadStats::MarkQuotaReached(const char *upstream)
+{
+	bool armed = false, ret = false;
+	int i;
+
+	pthread_mutex_lock(&lock);
+	for (i = 0; i < IPACM_OFFLOAD_STATS_MAX_UPSTREAM; i++)
+	{
+		if (!upstream_tbl[i].valid || !upstream_tbl[i].quota_set)
+			continue;
+		if (upstream == NULL ? !upstream_tbl[i].kernel_quota :
+			strncmp(upstream_tbl[i].name, upstream, IFNAMSIZ) != 0)
+			continue;
+		armed = true;
+		if (!upstream_tbl[i].quota_reached)
+		{
+			upstream_tbl[i].quota_reached = true;
+			ret = true;
+		}
+	}
+	pthread_mutex_unlock(&lock);
+
+	/* nothing armed here, the kernel knows better */
+	return armed ? ret : true;
+}
+
+void IPACM_OffloadStats::Suspend(void)
+{
+	int i;
+
+	pthread_mutex_lock(&lock);
+	for (i = 0; i < IPACM_OFFLOAD_STATS_MAX_UPSTREAM; i++)
+	{
+		upstream_tbl[i].active = false;
+		upstream_tbl[i].quota_set = false;
+		upstream_tbl[i].quota_reached = false;
+		upstream_tbl[i].kernel_quota = false;
+	}
+	num_active = 0;
+	pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,878 @@
+/*
+Copyright (c) 2018, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_RuleTxn.cpp
+
+	@brief
+	This file implements the IPACM rule transaction functionality.
+
+	@Author
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "IPACM_RuleTxn.h"
+#include <IPACM_Log.h>
+
+ipacm_txn_stats IPACM_RuleTxn::total;
+
+IPACM_RuleTxn::IPACM_RuleTxn(IPACM_Filtering *filtering, IPACM_Routing *routing, IPACM_Header *header)
+{
+	m_filtering = filtering;
+	m_routing = routing;
+	m_header = header;
+
+	rt_add = NULL;
+	rt_mdfy = NULL;
+	rt_del = NULL;
+	flt_add = NULL;
+	flt_del = NULL;
+	hdr_add = NULL;
+	hdr_del = NULL;
+	num_rt_add = num_rt_mdfy = num_rt_del = 0;
+	num_flt_add = num_flt_del = 0;
+	num_hdr_add = num_hdr_del = 0;
+
+	memset(rt_dirty, 0, sizeof(rt_dirty));
+	memset(flt_dirty, 0, sizeof(flt_dirty));
+	hdr_dirty = false;
+	failed = false;
+	memset(&cur, 0, sizeof(cur));
+	ending = false;
+	memset(rt_committed, 0, sizeof(rt_committed));
+}
+
+IPACM_RuleTxn::~IPACM_RuleTxn()
+{
+	if(num_rt_add || num_rt_mdfy || num_rt_del || num_flt_add ||
+		 num_flt_del || num_hdr_add || num_hdr_del)
+	{
+		IPACMERR("rule transaction dropped with pending operations\n");
+	}
+
+	free(rt_add);
+	free(rt_mdfy);
+	free(rt_del);
+	free(flt_add);
+	free(flt_del);
+	free(hdr_add);
+	free(hdr_del);
+}
+
+/* Next free entry of an op array, allocated on first use. A full array
+	 pushes everything queued so far to the driver, commits still wait. */
+void *IPACM_RuleTxn::Slot(void **ops, int *num, size_t size)
+{
+	if(*ops == NULL)
+	{
+		*ops = calloc(IPACM_TXN_MAX_OPS, size);
+		if(*ops == NULL)
+		{
+			IPACMERR("unable to allocate memory for rule transaction\n");
+			return NULL;
+		}
+	}
+
+	if(*num == IPACM_TXN_MAX_OPS)
+	{
+		if(!Flush())
+		{
+			return NULL;
+		}
+	}
+
+	cur.ops++;
+	return (char *)*ops + (*num)++ * size;
+}
+
+bool IPACM_RuleTxn::AddRoutingRule(enum ipa_ip_type ip, const char *rt_tbl_name,
+																	 struct ipa_rt_rule_add const *rule, uint32_t *hdl)
+{
+	ipacm_txn_rt_add *op;
+
+	if(failed || ip >= IPA_IP_MAX)
+	{
+		return false;
+	}
+
+	if(rule->rule.dst > IPA_CLIENT_MAX)
+	{
+		IPACMERR("Invalid dst pipe %d\n", rule->rule.dst);
+		return false;
+	}
+
+	op = (ipacm_txn_rt_add *)Slot((void **)&rt_add, &num_rt_add, sizeof(*op));
+	if(op == NULL)
+	{
+		return false;
+	}
+
+	op->ip = ip;
+	strlcpy(op->rt_tbl_name, rt_tbl_name, sizeof(op->rt_tbl_name));
+	memcpy(&op->rule, rule, sizeof(op->rule));
+	op->rule.rt_rule_hdl = 0;
+	op->rule.status = -1;
+	op->hdl = hdl;
+	rt_dirty[ip] = true;
+	return true;
+}
+
+bool IPACM_RuleTxn::ModifyRoutingRule(enum ipa_ip_type ip, struct ipa_rt_rule_mdfy const *rule)
+{
+	ipacm_txn_rt_mdfy *op;
+
+	if(failed || ip >= IPA_IP_MAX)
+	{
+		return false;
+	}
+
+	op = (ipacm_txn_rt_mdfy *)Slot((void **)&rt_mdfy, &num_rt_mdfy, sizeof(*op));
+	if(op == NULL)
+	{
+		return false;
+	}
+
+	op->ip = ip;
+	memcpy(&op->rule, rule, sizeof(op->rule));
+	rt_dirty[ip] = true;
+	return true;
+}
+
+bool IPACM_RuleTxn::DeleteRoutingHdl(uint32_t hdl, enum ipa_ip_type ip)
+{
+	ipacm_txn_del *op;
+
+	if(hdl == 0)
+	{
+		IPACMERR(" No route handle passed. Ignoring it\n");
+		return true;
+	}
+
+	if(failed || ip >= IPA_IP_MAX)
+	{
+		return false;
+	}
+
+	op = (ipacm_txn_del *)Slot((void **)&rt_del, &num_rt_del, sizeof(*op));
+	if(op == NULL)
+	{
+		return false;
+	}
+
+	op->ip = ip;
+	op->hdl = hdl;
+	rt_dirty[ip] = true;
+	return true;
+}
+
+bool IPACM_RuleTxn::AddFilteringRule(enum ipa_ip_type ip, enum ipa_client_type ep, uint8_t global,
+																		 struct ipa_flt_rule_add const *rule, uint32_t *hdl)
+{
+	ipacm_txn_flt_add *op;
+
+	if(failed || ip >= IPA_IP_MAX)
+	{
+		return false;
+	}
+
+	op = (ipacm_txn_flt_add *)Slot((void **)&flt_add, &num_flt_add, sizeof(*op));
+	if(op == NULL)
+	{
+		return false;
+	}
+
+	op->ip = ip;
+	op->ep = ep;
+	op->global = global;
+	memcpy(&op->rule, rule, sizeof(op->rule));
+	op->rule.flt_rule_hdl = 0;
+	op->rule.status = -1;
+	op->hdl = hdl;
+	flt_dirty[ip] = true;
+	return true;
+}
+
+bool IPACM_RuleTxn::DeleteFilteringHdl(uint32_t hdl, enum ipa_ip_type ip)
+{
+	ipacm_txn_del *op;
+
+	if(hdl == 0)
+	{
+		IPACMERR(" No filter handle passed. Ignoring it\n");
+		return true;
+	}
+
+	if(failed || ip >= IPA_IP_MAX)
+	{
+		return false;
+	}
+
+	op = (ipacm_txn_del *)Slot((void **)&flt_del, &num_flt_del, sizeof(*op));
+	if(op == NULL)
+	{
+		return false;
+	}
+
+	op->ip = ip;
+	op->hdl = hdl;
+	flt_dirty[ip] = true;
+	return true;
+}
+
+bool IPACM_RuleTxn::AddHeader(struct ipa_hdr_add const *hdr, uint32_t *hdl)
+{
+	ipacm_txn_hdr_add *op;
+
+	if(failed)
+	{
+		return false;
+	}
+
+	op = (ipacm_txn_hdr_add *)Slot((void **)&hdr_add, &num_hdr_add, sizeof(*op));
+	if(op == NULL)
+	{
+		return false;
+	}
+
+	memcpy(&op->hdr, hdr, sizeof(op->hdr));
+	op->hdr.hdr_hdl = 0;
+	op->hdr.status = -1;
+	op->hdl = hdl;
+	hdr_dirty = true;
+	return true;
+}
+
+bool IPACM_RuleTxn::DeleteHeaderHdl(uint32_t hdl)
+{
+	ipacm_txn_del *op;
+
+	if(hdl == 0)
+	{
+		IPACMERR("Invalid header handle passed. Ignoring it\n");
+		return true;
+	}
+
+	if(failed)
+	{
+		return false;
+	}
+
+	op = (ipacm_txn_del *)Slot((void **)&hdr_del, &num_hdr_del, sizeof(*op));
+	if(op == NULL)
+	{
+		return false;
+	}
+
+	op->ip = IPA_IP_MAX;
+	op->hdl = hdl;
+	hdr_dirty = true;
+	return true;
+}
+
+/* Whether the group just built from rt_add[first] is the last routing
+	 change of its family, so that its ioctl can commit. Headers have to be
+	 committed before routing, so only a transaction without header changes
+	 qualifies. */
+bool IPACM_RuleTxn::RtAddIsLast(int first, const uint8_t *grouped)
+{
+	int i;
+
+	if(hdr_dirty || num_rt_mdfy != 0)
+	{
+		return false;
+	}
+	for(i = first + 1; i < num_rt_add; i++)
+	{
+		if(!grouped[i] && rt_add[i].ip == rt_add[first].ip)
+		{
+			return false;
+		}
+	}
+	for(i = 0; i < num_rt_del; i++)
+	{
+		if(rt_del[i].ip == rt_add[first].ip)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/* One IPA_IOC_ADD_RT_RULE per (ip, table), in queue order within a table */
+bool IPACM_RuleTxn::FlushRtAdd()
+{
+	struct ipa_ioc_add_rt_rule *tbl;
+	uint8_t grouped[IPACM_TXN_MAX_OPS];
+	int member[IPACM_TXN_MAX_OPS];
+	int i, j, num;
+	bool res = true;
+
+	if(num_rt_add == 0)
+	{
+		return true;
+	}
+
+	tbl = (struct ipa_ioc_add_rt_rule *)calloc(1, sizeof(struct ipa_ioc_add_rt_rule) +
+																						 num_rt_add * sizeof(struct ipa_rt_rule_add));
+	if(tbl == NULL)
+	{
+		IPACMERR("unable to allocate memory for add route rule\n");
+		return false;
+	}
+
+	memset(grouped, 0, sizeof(grouped));
+	for(i = 0; i < num_rt_add && res; i++)
+	{
+		if(grouped[i])
+		{
+			continue;
+		}
+
+		tbl->commit = 0;
+		tbl->ip = rt_add[i].ip;
+		strlcpy(tbl->rt_tbl_name, rt_add[i].rt_tbl_name, sizeof(tbl->rt_tbl_name));
+		num = 0;
+		for(j = i; j < num_rt_add; j++)
+		{
+			if(!grouped[j] && rt_add[j].ip == rt_add[i].ip &&
+				 strncmp(rt_add[j].rt_tbl_name, rt_add[i].rt_tbl_name, IPA_RESOURCE_NAME_MAX) == 0)
+			{
+				memcpy(&tbl->rules[num], &rt_add[j].rule, sizeof(tbl->rules[num]));
+				member[num++] = j;
+				grouped[j] = 1;
+			}
+		}
+		tbl->num_rules = (uint8_t)num;
+
+		if(ending && RtAddIsLast(i, grouped))
+		{
+			tbl->commit = 1;
+			rt_committed[tbl->ip] = true;
+			cur.commits++;
+		}
+
+		cur.ioctls++;
+		if(false == m_routing->AddRoutingRule(tbl))
+		{
+			res = false;
+		}
+
+		for(j = 0; j < num; j++)
+		{
+			rt_add[member[j]].rule.rt_rule_hdl = tbl->rules[j].rt_rule_hdl;
+			rt_add[member[j]].rule.status = tbl->rules[j].status;
+			if(tbl->rules[j].status != 0)
+			{
+				IPACMERR("Routing rule addition to %s failed, status %d\n",
+								 tbl->rt_tbl_name, tbl->rules[j].status);
+				res = false;
+			}
+		}
+	}
+
+	free(tbl);
+	return res;
+}
+
+bool IPACM_RuleTxn::FlushRtMdfy()
+{
+	struct ipa_ioc_mdfy_rt_rule *tbl;
+	int ip, i, num;
+	bool res = true;
+
+	if(num_rt_mdfy == 0)
+	{
+		return true;
+	}
+
+	tbl = (struct ipa_ioc_mdfy_rt_rule *)calloc(1, sizeof(struct ipa_ioc_mdfy_rt_rule) +
+																							num_rt_mdfy * sizeof(struct ipa_rt_rule_mdfy));
+	if(tbl == NULL)
+	{
+		IPACMERR("unable to allocate memory for modify route rule\n");
+		return false;
+	}
+
+	for(ip = 0; ip < IPA_IP_MAX && res; ip++)
+	{
+		num = 0;
+		for(i = 0; i < num_rt_mdfy; i++)
+		{
+			if(rt_mdfy[i].ip == ip)
+			{
+				memcpy(&tbl->rules[num++], &rt_mdfy[i].rule, sizeof(tbl->rules[0]));
+			}
+		}
+		if(num == 0)
+		{
+			continue;
+		}
+
+		tbl->commit = 0;
+		tbl->ip = (enum ipa_ip_type)ip;
+		tbl->num_rules = (uint8_t)num;
+
+		cur.ioctls++;
+		if(false == m_routing->ModifyRoutingRule(tbl))
+		{
+			res = false;
+		}
+	}
+
+	free(tbl);
+	return res;
+}
+
+bool IPACM_RuleTxn::FlushRtDel()
+{
+	struct ipa_ioc_del_rt_rule *tbl;
+	int ip, i, num;
+	bool res = true;
+
+	if(num_rt_del == 0)
+	{
+		return true;
+	}
+
+	tbl = (struct ipa_ioc_del_rt_rule *)calloc(1, sizeof(struct ipa_ioc_del_rt_rule) +
+																						 num_rt_del * sizeof(struct ipa_rt_rule_del));
+	if(tbl == NULL)
+	{
+		IPACMERR("unable to allocate memory for del route rule\n");
+		return false;
+	}
+
+	for(ip = 0; ip < IPA_IP_MAX; ip++)
+	{
+		num = 0;
+		for(i = 0; i < num_rt_del; i++)
+		{
+			if(rt_del[i].ip == ip)
+			{
+				tbl->hdl[num].hdl = rt_del[i].hdl;
+				tbl->hdl[num++].status = -1;
+			}
+		}
+		if(num == 0)
+		{
+			continue;
+		}
+
+		tbl->commit = 0;
+		tbl->ip = (enum ipa_ip_type)ip;
+		tbl->num_hdls = (uint8_t)num;
+
+		cur.ioctls++;
+		if(false == m_routing->DeleteRoutingRule(tbl))
+		{
+			res = false;
+		}
+		for(i = 0; i < num; i++)
+		{
+			if(tbl->hdl[i].status != 0)
+			{
+				IPACMERR("Routing rule deletion of hdl 0x%x failed\n", tbl->hdl[i].hdl);
+				res = false;
+			}
+		}
+	}
+
+	free(tbl);
+	return res;
+}
+
+/* One IPA_IOC_ADD_FLT_RULE per (ip, ep, global) table, queue order kept */
+bool IPACM_RuleTxn::FlushFltAdd()
+{
+	struct ipa_ioc_add_flt_rule *tbl;
+	uint8_t grouped[IPACM_TXN_MAX_OPS];
+	int member[IPACM_TXN_MAX_OPS];
+	int i, j, num;
+	bool res = true;
+
+	if(num_flt_add == 0)
+	{
+		return true;
+	}
+
+	tbl = (struct ipa_ioc_add_flt_rule *)calloc(1, sizeof(struct ipa_ioc_add_flt_rule) +
+																							num_flt_add * sizeof(struct ipa_flt_rule_add));
+	if(tbl == NULL)
+	{
+		IPACMERR("unable to allocate memory for add filtering rule\n");
+		return false;
+	}
+
+	memset(grouped, 0, sizeof(grouped));
+	for(i = 0; i < num_flt_add && res; i++)
+	{
+		if(grouped[i])
+		{
+			continue;
+		}
+
+		tbl->commit = 0;
+		tbl->ip = flt_add[i].ip;
+		tbl->ep = flt_add[i].ep;
+		tbl->global = flt_add[i].global;
+		num = 0;
+		for(j = i; j < num_flt_add; j++)
+		{
+			if(!grouped[j] && flt_add[j].ip == tbl->ip && flt_add[j].ep == tbl->ep &&
+				 flt_add[j].global == tbl->global)
+			{
+				memcpy(&tbl->rules[num], &flt_add[j].rule, sizeof(tbl->rules[num]));
+				member[num++] = j;
+				grouped[j] = 1;
+			}
+		}
+		tbl->num_rules = (uint8_t)num;
+
+		cur.ioctls++;
+		if(false == m_filtering->AddFilteringRule(tbl))
+		{
+			res = false;
+		}
+
+		for(j = 0; j < num; j++)
+		{
+			flt_add[member[j]].rule.flt_rule_hdl = tbl->rules[j].flt_rule_hdl;
+			flt_add[member[j]].rule.status = tbl->rules[j].status;
+			if(tbl->rules[j].status != 0)
+			{
+				res = false;
+			}
+		}
+	}
+
+	free(tbl);
+	return res;
+}
+
+bool IPACM_RuleTxn::FlushFltDel()
+{
+	struct ipa_ioc_del_flt_rule *tbl;
+	int ip, i, num;
+	bool res = true;
+
+	if(num_flt_del == 0)
+	{
+		return true;
+	}
+
+	tbl = (struct ipa_ioc_del_flt_rule *)calloc(1, sizeof(struct ipa_ioc_del_flt_rule) +
+																							num_flt_del * sizeof(struct ipa_flt_rule_del));
+	if(tbl == NULL)
+	{
+		IPACMERR("unable to allocate memory for del filtering rule\n");
+		return false;
+	}
+
+	for(ip = 0; ip < IPA_IP_MAX; ip++)
+	{
+		num = 0;
+		for(i = 0; i < num_flt_del; i++)
+		{
+			if(flt_del[i].ip == ip)
+			{
+				tbl->hdl[num].hdl = flt_del[i].hdl;
+				tbl->hdl[num++].status = -1;
+			}
+		}
+		if(num == 0)
+		{
+			continue;
+		}
+
+		tbl->commit = 0;
+		tbl->ip = (enum ipa_ip_type)ip;
+		tbl->num_hdls = (uint8_t)num;
+
+		cur.ioctls++;
+		if(false == m_filtering->DeleteFilteringRule(tbl))
+		{
+			res = false;
+		}
+		for(i = 0; i < num; i++)
+		{
+			if(tbl->hdl[i].status != 0)
+			{
+				IPACMERR("Filtering rule deletion of hdl 0x%x failed\n", tbl->hdl[i].hdl);
+				res = false;
+			}
+		}
+	}
+
+	free(tbl);
+	return res;
+}
+
+bool IPACM_RuleTxn::FlushHdrAdd()
+{
+	struct ipa_ioc_add_hdr *tbl;
+	int i;
+	bool res = true;
+
+	if(num_hdr_add == 0)
+	{
+		return true;
+	}
+
+	tbl = (struct ipa_ioc_add_hdr *)calloc(1, sizeof(struct ipa_ioc_add_hdr) +
+																				 num_hdr_add * sizeof(struct ipa_hdr_add));
+	if(tbl == NULL)
+	{
+		IPACMERR("unable to allocate memory for add header\n");
+		return false;
+	}
+
+	for(i = 0; i < num_hdr_add; i++)
+	{
+		memcpy(&tbl->hdr[i], &hdr_add[i].hdr, sizeof(tbl->hdr[i]));
+	}
+	tbl->commit = 0;
+	tbl->num_hdrs = (uint8_t)num_hdr_add;
+
+	cur.ioctls++;
+	if(false == m_header->AddHeader(tbl))
+	{
+		res = false;
+	}
+
+	for(i = 0; i < num_hdr_add; i++)
+	{
+		hdr_add[i].hdr.hdr_hdl = tbl->hdr[i].hdr_hdl;
+		hdr_add[i].hdr.status = tbl->hdr[i].status;
+		if(tbl->hdr[i].status != 0)
+		{
+			IPACMERR("Header %s addition failed\n", tbl->hdr[i].name);
+			res = false;
+		}
+	}
+
+	free(tbl);
+	return res;
+}
+
+bool IPACM_RuleTxn::FlushHdrDel()
+{
+	struct ipa_ioc_del_hdr *tbl;
+	int i;
+	bool res = true;
+
+	if(num_hdr_del == 0)
+	{
+		return true;
+	}
+
+	tbl = (struct ipa_ioc_del_hdr *)calloc(1, sizeof(struct ipa_ioc_del_hdr) +
+																				 num_hdr_del * sizeof(struct ipa_hdr_del));
+	if(tbl == NULL)
+	{
+		IPACMERR("unable to allocate memory for del header\n");
+		return false;
+	}
+
+	for(i = 0; i < num_hdr_del; i++)
+	{
+		tbl->hdl[i].hdl = hdr_del[i].hdl;
+		tbl->hdl[i].status = -1;
+	}
+	tbl->commit = 0;
+	tbl->num_hdls = (uint8_t)num_hdr_del;
+
+	cur.ioctls++;
+	if(false == m_header->DeleteHeader(tbl))
+	{
+		res = false;
+	}
+	for(i = 0; i < num_hdr_del; i++)
+	{
+		if(tbl->hdl[i].status != 0)
+		{
+			IPACMERR("Header deletion of hdl 0x%x failed\n", tbl->hdl[i].hdl);
+			res = false;
+		}
+	}
+
+	free(tbl);
+	return res;
+}
+
+/* Undo the adds of a failed flush; the deletes commit on their own */
+void IPACM_RuleTxn::Rollback(int rt_done, int flt_done, int hdr_done)
+{
+	int i;
+
+	for(i = 0; i < flt_done; i++)
+	{
+		if(flt_add[i].rule.status == 0 && flt_add[i].rule.flt_rule_hdl != 0)
+		{
+			m_filtering->DeleteFilteringHdls(&flt_add[i].rule.flt_rule_hdl, flt_add[i].ip, 1);
+		}
+	}
+
+	for(i = 0; i < rt_done; i++)
+	{
+		if(rt_add[i].rule.status == 0 && rt_add[i].rule.rt_rule_hdl != 0)
+		{
+			m_routing->DeleteRoutingHdl(rt_add[i].rule.rt_rule_hdl, rt_add[i].ip);
+		}
+	}
+
+	for(i = 0; i < hdr_done; i++)
+	{
+		if(hdr_add[i].hdr.status == 0 && hdr_add[i].hdr.hdr_hdl != 0)
+		{
+			m_header->DeleteHeaderHdl(hdr_add[i].hdr.hdr_hdl);
+		}
+	}
+}
+
+/* Push everything queued: adds first so that replaced rules never leave a
+	 gap, then modifies, then deletes from filtering down to headers */
+bool IPACM_RuleTxn::Flush()
+{
+	int i;
+	bool res;
+
+	res = FlushHdrAdd();
+	res = res && FlushRtAdd();
+	res = res && FlushFltAdd();
+	if(!res)
+	{
+		IPACMERR("rule transaction failed, rolling back its adds\n");
+		Rollback(num_rt_add, num_flt_add, num_hdr_add);
+		failed = true;
+	}
+	else
+	{
+		for(i = 0; i < num_hdr_add; i++)
+		{
+			if(hdr_add[i].hdl != NULL)
+			{
+				*hdr_add[i].hdl = hdr_add[i].hdr.hdr_hdl;
+			}
+		}
+		for(i = 0; i < num_rt_add; i++)
+		{
+			if(rt_add[i].hdl != NULL)
+			{
+				*rt_add[i].hdl = rt_add[i].rule.rt_rule_hdl;
+			}
+		}
+		for(i = 0; i < num_flt_add; i++)
+		{
+			if(flt_add[i].hdl != NULL)
+			{
+				*flt_add[i].hdl = flt_add[i].rule.flt_rule_hdl;
+			}
+		}
+
+		res = FlushRtMdfy();
+		res = FlushFltDel() && res;
+		res = FlushRtDel() && res;
+		res = FlushHdrDel() && res;
+		if(!res)
+		{
+			failed = true;
+		}
+	}
+
+	num_rt_add = num_rt_mdfy = num_rt_del = 0;
+	num_flt_add = num_flt_del = 0;
+	num_hdr_add = num_hdr_del = 0;
+	return res;
+}
+
+bool IPACM_RuleTxn::End()
+{
+	int ip;
+	bool res;
+
+	ending = true;
+	res = Flush();
+	ending = false;
+
+	/* commit even after a failure, the rollback has to reach the HW */
+	if(hdr_dirty)
+	{
+		cur.ioctls++;
+		cur.commits++;
+		m_header->Commit();
+	}
+	for(ip = 0; ip < IPA_IP_MAX; ip++)
+	{
+		if(rt_dirty[ip] && !(res && rt_committed[ip]))
+		{
+			cur.ioctls++;
+			cur.commits++;
+			if(false == m_routing->Commit((enum ipa_ip_type)ip))
+			{
+				res = false;
+			}
+		}
+	}
+	for(ip = 0; ip < IPA_IP_MAX; ip++)
+	{
+		if(flt_dirty[ip])
+		{
+			cur.ioctls++;
+			cur.commits++;
+			if(false == m_filtering->Commit((enum ipa_ip_type)ip))
+			{
+				res = false;
+			}
+		}
+	}
+
+	/* one ioctl with commit set per operation is what this replaces */
+	IPACMDBG_H("rule transaction: %u ops, %u ioctls, %u commits, saved %d ioctls %d commits\n",
+						 cur.ops, cur.ioctls, cur.commits,
+						 (int)cur.ops - (int)cur.ioctls, (int)cur.ops - (int)cur.commits);
+
+	total.ops += cur.ops;
+	total.ioctls += cur.ioctls;
+	total.commits += cur.commits;
+
+	memset(rt_dirty, 0, sizeof(rt_dirty));
+	memset(flt_dirty, 0, sizeof(flt_dirty));
+	memset(rt_committed, 0, sizeof(rt_committed));
+	hdr_dirty = false;
+	failed = false;
+	memset(&cur, 0, sizeof(cur));
+	return res;
+}
+
+void IPACM_RuleTxn::GetStats(ipacm_txn_stats *stats)
+{
+	memcpy(stats, &total, sizeof(*stats));
+}
@@ -529,6 +529,7 @@ fail:
 void IPACM_Wan::event_callback(ipa_cm_event_id event, void *param)
 {
 	int ipa_interface_index;
+	bool fw_v4_changed, fw_v6_changed;
 
 	switch (event)
 	{
@@ -1181,26 +1182,41 @@ void IPACM_Wan::event_callback(ipa_cm_event_id event, void *param)
 				return;
 			}
 
+			check_firewall_change(&fw_v4_changed, &fw_v6_changed);
 			if(ip_type == IPA_IP_v4)
 			{
-				del_wan_firewall_rule(IPA_IP_v4);
-				config_wan_firewall_rule(IPA_IP_v4);
-				install_wan_filtering_rule(false);
+				if(fw_v4_changed)
+				{
+					del_wan_firewall_rule(IPA_IP_v4);
+					config_wan_firewall_rule(IPA_IP_v4);
+					install_wan_filtering_rule(false);
+				}
 			}
 			else if(ip_type == IPA_IP_v6)
 			{
-				del_wan_firewall_rule(IPA_IP_v6);
-				config_wan_firewall_rule(IPA_IP_v6);
-				install_wan_filtering_rule(false);
+				if(fw_v6_changed)
+				{
+					del_wan_firewall_rule(IPA_IP_v6);
+					config_wan_firewall_rule(IPA_IP_v6);
+					install_wan_filtering_rule(false);
+				}
 			}
 			else if(ip_type == IPA_IP_MAX)
 			{
-				del_wan_firewall_rule(IPA_IP_v4);
-				config_wan_firewall_rule(IPA_IP_v4);
-
-				del_wan_firewall_rule(IPA_IP_v6);
-				config_wan_firewall_rule(IPA_IP_v6);
-				install_wan_filtering_rule(false);
+				if(fw_v4_changed)
+				{
+					del_wan_firewall_rule(IPA_IP_v4);
+					config_wan_firewall_rule(IPA_IP_v4);
+				}
+				if(fw_v6_changed)
+				{
+					del_wan_firewall_rule(IPA_IP_v6);
+					config_wan_firewall_rule(IPA_IP_v6);
+				}
+				if(fw_v4_changed || fw_v6_changed)
+				{
+					install_wan_filtering_rule(false);
+				}
 			}
 			else
 			{
@@ -1209,12 +1225,13 @@ void IPACM_Wan::event_callback(ipa_cm_event_id event, void *param)
 		}
 		else
 		{
-			if (active_v4)
+			check_firewall_change(&fw_v4_changed, &fw_v6_changed);
+			if (active_v4 && fw_v4_changed)
 			{
 				del_dft_firewall_rules(IPA_IP_v4);
 				config_dft_firewall_rules(IPA_IP_v4);
 			}
-			if (active_v6)
+			if (active_v6 && fw_v6_changed)
 			{
 
 				del_dft_firewall_rules(IPA_IP_v6);
@@ -1936,6 +1953,34 @@ bool IPACM_Wan::check_dft_firewall_rules_attr_mask(IPACM_firewall_conf_t *firewa
 	return false;
 }
 
+/* firewall xml rewrites usually leave the rules as they are, only the
+   ip families whose rules changed need to be reinstalled */
+void IPACM_Wan::check_firewall_change(bool *v4_changed, bool *v6_changed)
+{
+	IPACM_firewall_conf_t *new_config;
+
+	*v4_changed = true;
+	*v6_changed = true;
+
+	new_config = (IPACM_firewall_conf_t *)calloc(1, sizeof(IPACM_firewall_conf_t));
+	if (new_config == NULL)
+	{
+		IPACMERR("Unable to allocate firewall config, reinstall all rules\n");
+		return;
+	}
+	strlcpy(new_config->firewall_config_file, "/etc/mobileap_firewall.xml", sizeof(new_config->firewall_config_file));
+	if (IPACM_SUCCESS != IPACM_read_firewall_xml(new_config->firewall_config_file, new_config))
+	{
+		/* same fallback as config_dft_firewall_rules */
+		memset(new_config, 0, sizeof(IPACM_firewall_conf_t));
+	}
+
+	*v4_changed = !IPACM_firewall_rules_equal(&firewall_config, new_config, IP_V4);
+	*v6_changed = !IPACM_firewall_rules_equal(&firewall_config, new_config, IP_V6);
+	IPACMDBG_H("firewall rules changed v4(%d) v6(%d)\n", *v4_changed, *v6_changed);
+	free(new_config);
+}
+
 /* for STA mode: add firewall rules */
 int IPACM_Wan::config_dft_firewall_rules(ipa_ip_type iptype)
 {
@@ -88,7 +88,7 @@ IPACM_Wlan::IPACM_Wlan(int iface_index) : IPACM_Lan(iface_index)
 	if(iface_query != NULL)
 	{
 		wlan_client_len = (sizeof(ipa_wlan_client)) + (iface_query->num_tx_props * sizeof(wlan_client_rt_hdl));
-		wlan_client = (ipa_wlan_client *)calloc(IPA_MAX_NUM_WIFI_CLIENTS, wlan_client_len);
+		wlan_client = (ipa_wlan_client *)calloc(IPACM_Iface::ipacmcfg->GetMaxWlanClients(), wlan_client_len);
 		if (wlan_client == NULL)
 		{
 			IPACMERR("unable to allocate memory\n");
@@ -939,8 +939,8 @@ int IPACM_Wlan::handle_wlan_client_init_ex(ipacm_event_data_wlan_ex *data)
 	IPACMDBG_H("Wifi client number for this iface: %d & total number of wlan clients: %d\n",
                  num_wifi_client,IPACM_Wlan::total_num_wifi_clients);
 
-	if ((num_wifi_client >= IPA_MAX_NUM_WIFI_CLIENTS) ||
-			(IPACM_Wlan::total_num_wifi_clients >= IPA_MAX_NUM_WIFI_CLIENTS))
+	if ((num_wifi_client >= IPACM_Iface::ipacmcfg->GetMaxWlanClients()) ||
+			(IPACM_Wlan::total_num_wifi_clients >= IPACM_Iface::ipacmcfg->GetMaxWlanClients()))
 	{
 		IPACMERR("Reached maximum number of wlan clients\n");
 		return IPACM_FAILURE;
@@ -1199,6 +1199,8 @@ int IPACM_Wlan::handle_wlan_client_init_ex(ipacm_event_data_wlan_ex *data)
 		get_client_memptr(wlan_client, num_wifi_client)->ipv4_set = false;
 		get_client_memptr(wlan_client, num_wifi_client)->ipv6_set = 0;
 		get_client_memptr(wlan_client, num_wifi_client)->power_save_set=false;
+		get_client_memptr(wlan_client, num_wifi_client)->dir_hdl =
+			client_dir->Add(get_client_memptr(wlan_client, num_wifi_client)->mac, num_wifi_client);
 		num_wifi_client++;
 		header_name_count++; //keep increasing header_name_count
 		IPACM_Wlan::total_num_wifi_clients++;
@@ -1218,8 +1220,7 @@ fail:
 /*handle wifi client */
 int IPACM_Wlan::handle_wlan_client_ipaddr(ipacm_event_data_all *data)
 {
-	int clnt_indx;
-	int v6_num;
+	int clnt_indx, owner;
 	uint32_t ipv6_link_local_prefix = 0xFE800000;
 	uint32_t ipv6_link_local_prefix_mask = 0xFFC00000;
 
@@ -1246,10 +1247,19 @@ int IPACM_Wlan::handle_wlan_client_ipaddr(ipacm_event_data_all *data)
 		IPACMDBG_H("ipv4 address: 0x%x\n", data->ipv4_addr);
 		if (data->ipv4_addr != 0) /* not 0.0.0.0 */
 		{
+			/* the address was handed out again, the previous holder's rules would shadow the new ones */
+			owner = get_wlan_client_index_v4(data->ipv4_addr);
+			if (owner != IPACM_INVALID_INDEX && owner != clnt_indx)
+			{
+				IPACMDBG_H("ipv4 addr 0x%x moved from client:%d to client:%d\n", data->ipv4_addr, owner, clnt_indx);
+				release_wlan_client_ipaddr(get_client_memptr(wlan_client, owner)->dir_hdl, data);
+			}
+
 			if (get_client_memptr(wlan_client, clnt_indx)->ipv4_set == false)
 			{
 				get_client_memptr(wlan_client, clnt_indx)->v4_addr = data->ipv4_addr;
 				get_client_memptr(wlan_client, clnt_indx)->ipv4_set = true;
+				client_dir->SetV4(data->mac_addr, data->ipv4_addr);
 			}
 			else
 			{
@@ -1267,6 +1277,7 @@ int IPACM_Wlan::handle_wlan_client_ipaddr(ipacm_event_data_all *data)
 			     delete_default_qos_rtrules(clnt_indx,IPA_IP_v4);
 		         get_client_memptr(wlan_client, clnt_indx)->route_rule_set_v4 = false;
 			     get_client_memptr(wlan_client, clnt_indx)->v4_addr = data->ipv4_addr;
+			     client_dir->SetV4(data->mac_addr, data->ipv4_addr);
 			}
 		}
 	}
@@ -1292,18 +1303,16 @@ int IPACM_Wlan::handle_wlan_client_ipaddr(ipacm_event_data_all *data)
 
 			if(get_client_memptr(wlan_client, clnt_indx)->ipv6_set < IPV6_NUM_ADDR)
 			{
-
-		       for(v6_num=0;v6_num < get_client_memptr(wlan_client, clnt_indx)->ipv6_set;v6_num++)
+				owner = get_wlan_client_index_v6(data->ipv6_addr);
+				if (owner == clnt_indx)
 				{
-					if( data->ipv6_addr[0] == get_client_memptr(wlan_client, clnt_indx)->v6_addr[v6_num][0] &&
-			           data->ipv6_addr[1] == get_client_memptr(wlan_client, clnt_indx)->v6_addr[v6_num][1] &&
-			  	        data->ipv6_addr[2]== get_client_memptr(wlan_client, clnt_indx)->v6_addr[v6_num][2] &&
-			  	         data->ipv6_addr[3] == get_client_memptr(wlan_client, clnt_indx)->v6_addr[v6_num][3])
-					{
-			  	    IPACMDBG_H("Already see this ipv6 addr for client:%d\n", clnt_indx);
-			  	    return IPACM_FAILURE; /* not setup the RT rules*/
-			  		break;
-					}
+					IPACMDBG_H("Already see this ipv6 addr for client:%d\n", clnt_indx);
+					return IPACM_FAILURE; /* not setup the RT rules*/
+				}
+				if (owner != IPACM_INVALID_INDEX)
+				{
+					IPACMDBG_H("ipv6 addr moved from client:%d to client:%d\n", owner, clnt_indx);
+					release_wlan_client_ipaddr(get_client_memptr(wlan_client, owner)->dir_hdl, data);
 				}
 
 		       /* not see this ipv6 before for wifi client*/
@@ -1312,6 +1321,7 @@ int IPACM_Wlan::handle_wlan_client_ipaddr(ipacm_event_data_all *data)
 			   get_client_memptr(wlan_client, clnt_indx)->v6_addr[get_client_memptr(wlan_client, clnt_indx)->ipv6_set][2] = data->ipv6_addr[2];
 			   get_client_memptr(wlan_client, clnt_indx)->v6_addr[get_client_memptr(wlan_client, clnt_indx)->ipv6_set][3] = data->ipv6_addr[3];
 			   get_client_memptr(wlan_client, clnt_indx)->ipv6_set++;
+			   client_dir->AddV6(data->mac_addr, data->ipv6_addr);
 		    }
 		    else
 		    {
@@ -1329,6 +1339,52 @@ int IPACM_Wlan::handle_wlan_client_ipaddr(ipacm_event_data_all *data)
 	return IPACM_SUCCESS;
 }
 
+/* The client holding owner_hdl lost data's address to another client: its routing
+   rules for the address go away, the remaining ipv6 addresses get theirs back */
+int IPACM_Wlan::release_wlan_client_ipaddr(uint32_t owner_hdl, ipacm_event_data_all *data)
+{
+	ipa_wlan_client *client;
+	int clt_indx, num_v6;
+
+	clt_indx = client_dir->GetIndex(owner_hdl);
+	if (clt_indx == IPACM_INVALID_INDEX)
+	{
+		IPACMERR("stale client handle 0x%x\n", owner_hdl);
+		return IPACM_FAILURE;
+	}
+	client = get_client_memptr(wlan_client, clt_indx);
+
+	if (data->iptype == IPA_IP_v4)
+	{
+		delete_default_qos_rtrules(clt_indx, IPA_IP_v4);
+		client->ipv4_set = false;
+		client->v4_addr = 0;
+		client_dir->SetV4(client->mac, 0);
+		return IPACM_SUCCESS;
+	}
+
+	for (num_v6 = 0; num_v6 < client->ipv6_set; num_v6++)
+	{
+		if (memcmp(client->v6_addr[num_v6], data->ipv6_addr, sizeof(client->v6_addr[num_v6])) == 0)
+		{
+			break;
+		}
+	}
+	if (num_v6 == client->ipv6_set)
+	{
+		return IPACM_FAILURE;
+	}
+
+	delete_default_qos_rtrules(clt_indx, IPA_IP_v6);
+	client_dir->DelV6(client->mac, data->ipv6_addr);
+	client->ipv6_set--;
+	for (; num_v6 < client->ipv6_set; num_v6++)
+	{
+		memcpy(client->v6_addr[num_v6], client->v6_addr[num_v6 + 1], sizeof(client->v6_addr[num_v6]));
+	}
+	return handle_wlan_client_route_rule(client->mac, IPA_IP_v6);
+}
+
 /*handle wifi client routing rule*/
 int IPACM_Wlan::handle_wlan_client_route_rule(uint8_t *mac_addr, ipa_ip_type iptype)
 {
@@ -1337,6 +1393,7 @@ int IPACM_Wlan::handle_wlan_client_route_rule(uint8_t *mac_addr, ipa_ip_type ipt
 	uint32_t tx_index;
 	int wlan_index,v6_num;
 	const int NUM = 1;
+	IPACM_RuleTxn txn(&m_filtering, &m_routing, &m_header);
 
 	if(tx_prop == NULL)
 	{
@@ -1394,7 +1451,7 @@ int IPACM_Wlan::handle_wlan_client_route_rule(uint8_t *mac_addr, ipa_ip_type ipt
 			return IPACM_FAILURE;
 		}
 
-		rt_rule->commit = 1;
+		rt_rule->commit = 0;
 		rt_rule->num_rules = (uint8_t)NUM;
 		rt_rule->ip = iptype;
 
@@ -1446,18 +1503,13 @@ int IPACM_Wlan::handle_wlan_client_route_rule(uint8_t *mac_addr, ipa_ip_type ipt
 #ifdef FEATURE_IPA_V3
 				rt_rule_entry->rule.hashable = false;
 #endif
-				if (false == m_routing.AddRoutingRule(rt_rule))
+				if (false == txn.AddRoutingRule(iptype, rt_rule->rt_tbl_name, rt_rule_entry,
+						&get_client_memptr(wlan_client, wlan_index)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v4))
 				{
 					IPACMERR("Routing rule addition failed!\n");
 					free(rt_rule);
 					return IPACM_FAILURE;
 				}
-
-				/* copy ipv4 RT hdl */
-				get_client_memptr(wlan_client, wlan_index)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v4 =
-					rt_rule->rules[0].rt_rule_hdl;
-				IPACMDBG_H("tx:%d, rt rule hdl=%x ip-type: %d\n", tx_index,
-						get_client_memptr(wlan_client, wlan_index)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v4, iptype);
 			}
 			else
 			{
@@ -1488,17 +1540,14 @@ int IPACM_Wlan::handle_wlan_client_route_rule(uint8_t *mac_addr, ipa_ip_type ipt
 #ifdef FEATURE_IPA_V3
 					rt_rule_entry->rule.hashable = true;
 #endif
-					if (false == m_routing.AddRoutingRule(rt_rule))
+					if (false == txn.AddRoutingRule(iptype, rt_rule->rt_tbl_name, rt_rule_entry,
+							&get_client_memptr(wlan_client, wlan_index)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6[v6_num]))
 					{
 						IPACMERR("Routing rule addition failed!\n");
 						free(rt_rule);
 						return IPACM_FAILURE;
 					}
 
-					get_client_memptr(wlan_client, wlan_index)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6[v6_num] = rt_rule->rules[0].rt_rule_hdl;
-					IPACMDBG_H("tx:%d, rt rule hdl=%x ip-type: %d\n", tx_index,
-							get_client_memptr(wlan_client, wlan_index)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6[v6_num], iptype);
-
 					/*Copy same rule to v6 WAN RT TBL*/
 					strlcpy(rt_rule->rt_tbl_name,
 							IPACM_Iface::ipacmcfg->rt_tbl_wan_v6.name,
@@ -1531,17 +1580,13 @@ int IPACM_Wlan::handle_wlan_client_route_rule(uint8_t *mac_addr, ipa_ip_type ipt
 #ifdef FEATURE_IPA_V3
 					rt_rule_entry->rule.hashable = true;
 #endif
-					if (false == m_routing.AddRoutingRule(rt_rule))
+					if (false == txn.AddRoutingRule(iptype, rt_rule->rt_tbl_name, rt_rule_entry,
+							&get_client_memptr(wlan_client, wlan_index)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6_wan[v6_num]))
 					{
 						IPACMERR("Routing rule addition failed!\n");
 						free(rt_rule);
 						return IPACM_FAILURE;
 					}
-
-					get_client_memptr(wlan_client, wlan_index)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6_wan[v6_num] = rt_rule->rules[0].rt_rule_hdl;
-
-					IPACMDBG_H("tx:%d, rt rule hdl=%x ip-type: %d\n", tx_index,
-							get_client_memptr(wlan_client, wlan_index)->wifi_rt_hdl[tx_index].wifi_rt_rule_hdl_v6_wan[v6_num], iptype);
 				}
 			}
 
@@ -1549,6 +1594,13 @@ int IPACM_Wlan::handle_wlan_client_route_rule(uint8_t *mac_addr, ipa_ip_type ipt
 
 		free(rt_rule);
 
+		/* all rules of the client go out in one ioctl per table and one commit */
+		if (false == txn.End())
+		{
+			IPACMERR("Routing rule addition failed!\n");
+			return IPACM_FAILURE;
+		}
+
 		if (iptype == IPA_IP_v4)
 		{
 			get_client_memptr(wlan_client, wlan_index)->route_rule_set_v4 = true;
@@ -1662,6 +1714,10 @@ int IPACM_Wlan::handle_wlan_client_down_evt(uint8_t *mac_addr)
 	get_client_memptr(wlan_client, clt_indx)->route_rule_set_v6 = 0;
 	free(get_client_memptr(wlan_client, clt_indx)->p_hdr_info);
 
+	/* the clients after this one move down one entry */
+	client_dir->Remove(mac_addr);
+	client_dir->ShiftDown(clt_indx);
+
 	for (; clt_indx < num_wifi_client_tmp - 1; clt_indx++)
 	{
 		get_client_memptr(wlan_client, clt_indx)->p_hdr_info = get_client_memptr(wlan_client, (clt_indx + 1))->p_hdr_info;
@@ -1673,6 +1729,7 @@ int IPACM_Wlan::handle_wlan_client_down_evt(uint8_t *mac_addr)
 		get_client_memptr(wlan_client, clt_indx)->hdr_hdl_v4 = get_client_memptr(wlan_client, (clt_indx + 1))->hdr_hdl_v4;
 		get_client_memptr(wlan_client, clt_indx)->hdr_hdl_v6 = get_client_memptr(wlan_client, (clt_indx + 1))->hdr_hdl_v6;
 		get_client_memptr(wlan_client, clt_indx)->v4_addr = get_client_memptr(wlan_client, (clt_indx + 1))->v4_addr;
+		get_client_memptr(wlan_client, clt_indx)->dir_hdl = get_client_memptr(wlan_client, (clt_indx + 1))->dir_hdl;
 
 		get_client_memptr(wlan_client, clt_indx)->ipv4_set = get_client_memptr(wlan_client, (clt_indx + 1))->ipv4_set;
 		get_client_memptr(wlan_client, clt_indx)->ipv6_set = get_client_memptr(wlan_client, (clt_indx + 1))->ipv6_set;
@@ -1994,6 +2051,7 @@ int IPACM_Wlan::handle_wlan_client_reset_rt(ipa_ip_type iptype)
 		{
 			get_client_memptr(wlan_client, i)->ipv6_set = 0;
 		}
+		client_dir->ClearAddr(get_client_memptr(wlan_client, i)->mac, iptype);
 	} /* end of for loop */
 	return res;
 }
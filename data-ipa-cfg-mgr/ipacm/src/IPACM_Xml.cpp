@@ -38,8 +38,12 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "IPACM_Xml.h"
 #include "IPACM_Log.h"
@@ -68,6 +72,36 @@ static int IPACM_firewall_xml_parse_tree
 	 IPACM_firewall_conf_t *config
 );
 
+static int IPACM_xml_snapshot_load
+(
+	 const char *xml_file,
+	 uint16_t type,
+	 void *data,
+	 uint32_t data_len,
+	 uint64_t *src_hash
+);
+
+static void IPACM_xml_snapshot_store
+(
+	 const char *xml_file,
+	 uint16_t type,
+	 const void *data,
+	 uint32_t data_len,
+	 uint64_t src_hash
+);
+
+/* snapshot file layout: header followed by the raw config struct */
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t type;
+	uint32_t data_len;          /* sizeof the config struct that wrote it */
+	uint32_t reserved;
+	uint64_t src_size;
+	uint64_t src_hash;          /* FNV-1a of the source xml */
+} ipacm_xml_snapshot_hdr;
+
 /*Reads content (stored as child) of the element */
 static char* IPACM_read_content_element
 (
@@ -111,12 +145,173 @@ static int32_t IPACM_util_icmp_string
 	return ret;
 }
 
+/* FNV-1a hash of the xml file, 0 if it can't be read */
+static uint64_t IPACM_xml_hash(const char *xml_file, uint64_t *size)
+{
+	struct stat st;
+	const uint8_t *buf;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	size_t i;
+	int fd;
+
+	fd = open(xml_file, O_RDONLY);
+	if (fd < 0)
+	{
+		return 0;
+	}
+	if (fstat(fd, &st) < 0 || st.st_size <= 0 || st.st_size > IPACM_XML_MAX_FILESIZE)
+	{
+		close(fd);
+		return 0;
+	}
+	buf = (const uint8_t *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (buf == MAP_FAILED)
+	{
+		return 0;
+	}
+	for (i = 0; i < (size_t)st.st_size; i++)
+	{
+		hash ^= buf[i];
+		hash *= 0x100000001b3ULL;
+	}
+	munmap((void *)buf, st.st_size);
+	*size = st.st_size;
+	return hash;
+}
+
+static void IPACM_xml_snapshot_path(const char *xml_file, char *path, size_t len)
+{
+	const char *name = strrchr(xml_file, '/');
+
+	name = (name == NULL) ? xml_file : name + 1;
+	snprintf(path, len, "%s/ipacm_%s.snap", IPACM_XML_SNAPSHOT_DIR, name);
+}
+
+/* copy the cached config if the snapshot was taken from the same xml */
+static int IPACM_xml_snapshot_load
+(
+	 const char *xml_file,
+	 uint16_t type,
+	 void *data,
+	 uint32_t data_len,
+	 uint64_t *src_hash
+)
+{
+	char path[IPA_MAX_FILE_LEN];
+	struct stat st;
+	const ipacm_xml_snapshot_hdr *hdr;
+	uint64_t src_size = 0;
+	void *map;
+	int fd, ret = IPACM_FAILURE;
+
+	*src_hash = IPACM_xml_hash(xml_file, &src_size);
+	if (*src_hash == 0)
+	{
+		return IPACM_FAILURE;
+	}
+
+	IPACM_xml_snapshot_path(xml_file, path, sizeof(path));
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return IPACM_FAILURE;
+	}
+	if (fstat(fd, &st) < 0 || st.st_size != (off_t)(sizeof(*hdr) + data_len))
+	{
+		close(fd);
+		return IPACM_FAILURE;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+	{
+		return IPACM_FAILURE;
+	}
+
+	hdr = (const ipacm_xml_snapshot_hdr *)map;
+	if (hdr->magic == IPACM_XML_SNAPSHOT_MAGIC &&
+		hdr->version == IPACM_XML_SNAPSHOT_VERSION &&
+		hdr->type == type &&
+		hdr->data_len == data_len &&
+		hdr->src_size == src_size &&
+		hdr->src_hash == *src_hash)
+	{
+		memcpy(data, (const uint8_t *)map + sizeof(*hdr), data_len);
+		ret = IPACM_SUCCESS;
+	}
+	munmap(map, st.st_size);
+
+	if (ret == IPACM_SUCCESS)
+	{
+		IPACMDBG_H("%s loaded from snapshot %s\n", xml_file, path);
+	}
+	return ret;
+}
+
+/* written to a temp file and renamed, a reader never sees a partial snapshot */
+static void IPACM_xml_snapshot_store
+(
+	 const char *xml_file,
+	 uint16_t type,
+	 const void *data,
+	 uint32_t data_len,
+	 uint64_t src_hash
+)
+{
+	char path[IPA_MAX_FILE_LEN], tmp_path[IPA_MAX_FILE_LEN + 4];
+	ipacm_xml_snapshot_hdr hdr;
+	uint64_t src_size = 0;
+	int fd;
+	bool ok;
+
+	/* the xml may have changed while it was parsed */
+	if (src_hash == 0 || IPACM_xml_hash(xml_file, &src_size) != src_hash)
+	{
+		return;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = IPACM_XML_SNAPSHOT_MAGIC;
+	hdr.version = IPACM_XML_SNAPSHOT_VERSION;
+	hdr.type = type;
+	hdr.data_len = data_len;
+	hdr.src_size = src_size;
+	hdr.src_hash = src_hash;
+
+	IPACM_xml_snapshot_path(xml_file, path, sizeof(path));
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		IPACMDBG_H("unable to create snapshot %s\n", tmp_path);
+		return;
+	}
+	ok = (write(fd, &hdr, sizeof(hdr)) == (ssize_t)sizeof(hdr) &&
+		write(fd, data, data_len) == (ssize_t)data_len);
+	close(fd);
+	if (!ok || rename(tmp_path, path) < 0)
+	{
+		IPACMERR("failed to write snapshot %s\n", path);
+		unlink(tmp_path);
+		return;
+	}
+	IPACMDBG_H("%s cached in snapshot %s\n", xml_file, path);
+}
+
 /* This function read IPACM XML and populate the IPA CM Cfg */
 int ipacm_read_cfg_xml(char *xml_file, IPACM_conf_t *config)
 {
 	xmlDocPtr doc = NULL;
 	xmlNode* root = NULL;
 	int ret_val = IPACM_SUCCESS;
+	uint64_t src_hash;
+
+	if (IPACM_xml_snapshot_load(xml_file, IPACM_XML_SNAPSHOT_CFG,
+			config, sizeof(IPACM_conf_t), &src_hash) == IPACM_SUCCESS)
+	{
+		return IPACM_SUCCESS;
+	}
 
 	/* Invoke the XML parser and obtain the parse tree */
 	doc = xmlReadFile(xml_file, "UTF-8", XML_PARSE_NOBLANKS);
@@ -137,6 +332,11 @@ int ipacm_read_cfg_xml(char *xml_file, IPACM_conf_t *config)
 	{
 		IPACMDBG_H("IPACM_xml_parse: ipacm_cfg_xml_parse_tree returned parse error!\n");
 	}
+	else
+	{
+		IPACM_xml_snapshot_store(xml_file, IPACM_XML_SNAPSHOT_CFG,
+			config, sizeof(IPACM_conf_t), src_hash);
+	}
 
 	/* Free up the libxml's parse tree */
 	xmlFreeDoc(doc);
@@ -175,6 +375,8 @@ static int ipacm_cfg_xml_parse_tree
 						IPACM_util_icmp_string((char*)xml_node->name, IPACMALG_TAG) == 0 ||
 						IPACM_util_icmp_string((char*)xml_node->name, ALG_TAG) == 0 ||
 						IPACM_util_icmp_string((char*)xml_node->name, IPACMNat_TAG) == 0 ||
+						IPACM_util_icmp_string((char*)xml_node->name, IPACMClients_TAG) == 0 ||
+						IPACM_util_icmp_string((char*)xml_node->name, IPACMOffload_TAG) == 0 ||
 						IPACM_util_icmp_string((char*)xml_node->name, IP_PassthroughFlag_TAG) == 0)
 				{
 					if (0 == IPACM_util_icmp_string((char*)xml_node->name, IFACE_TAG))
@@ -439,6 +641,54 @@ static int ipacm_cfg_xml_parse_tree
 						IPACMDBG_H("Nat Table Max Entries %d\n", config->nat_max_entries);
 					}
 				}
+				else if (IPACM_util_icmp_string((char*)xml_node->name, MaxWlanClients_TAG) == 0)
+				{
+					content = IPACM_read_content_element(xml_node);
+					if (content)
+					{
+						str_size = strlen(content);
+						memset(content_buf, 0, sizeof(content_buf));
+						memcpy(content_buf, (void *)content, str_size);
+						config->max_wlan_clients = atoi(content_buf);
+						IPACMDBG_H("Max wlan clients %d\n", config->max_wlan_clients);
+					}
+				}
+				else if (IPACM_util_icmp_string((char*)xml_node->name, MaxEthClients_TAG) == 0)
+				{
+					content = IPACM_read_content_element(xml_node);
+					if (content)
+					{
+						str_size = strlen(content);
+						memset(content_buf, 0, sizeof(content_buf));
+						memcpy(content_buf, (void *)content, str_size);
+						config->max_eth_clients = atoi(content_buf);
+						IPACMDBG_H("Max eth clients %d\n", config->max_eth_clients);
+					}
+				}
+				else if (IPACM_util_icmp_string((char*)xml_node->name, MaxNeighborClients_TAG) == 0)
+				{
+					content = IPACM_read_content_element(xml_node);
+					if (content)
+					{
+						str_size = strlen(content);
+						memset(content_buf, 0, sizeof(content_buf));
+						memcpy(content_buf, (void *)content, str_size);
+						config->max_neighbor_clients = atoi(content_buf);
+						IPACMDBG_H("Max neighbor clients %d\n", config->max_neighbor_clients);
+					}
+				}
+				else if (IPACM_util_icmp_string((char*)xml_node->name, StatsIntervalMs_TAG) == 0)
+				{
+					content = IPACM_read_content_element(xml_node);
+					if (content)
+					{
+						str_size = strlen(content);
+						memset(content_buf, 0, sizeof(content_buf));
+						memcpy(content_buf, (void *)content, str_size);
+						config->offload_stats_interval_ms = atoi(content_buf);
+						IPACMDBG_H("Offload stats interval %d ms\n", config->offload_stats_interval_ms);
+					}
+				}
 			}
 			break;
 		default:
@@ -456,10 +706,21 @@ int IPACM_read_firewall_xml(char *xml_file, IPACM_firewall_conf_t *config)
 	xmlDocPtr doc = NULL;
 	xmlNode* root = NULL;
 	int ret_val;
+	uint64_t src_hash;
+	char config_file[IPA_MAX_FILE_LEN];
 
 	IPACM_ASSERT(xml_file != NULL);
 	IPACM_ASSERT(config != NULL);
 
+	/* the snapshot holds the whole struct, keep the caller's file name */
+	strlcpy(config_file, config->firewall_config_file, sizeof(config_file));
+	if (IPACM_xml_snapshot_load(xml_file, IPACM_XML_SNAPSHOT_FIREWALL,
+			config, sizeof(IPACM_firewall_conf_t), &src_hash) == IPACM_SUCCESS)
+	{
+		strlcpy(config->firewall_config_file, config_file, sizeof(config->firewall_config_file));
+		return IPACM_SUCCESS;
+	}
+
 	/* invoke the XML parser and obtain the parse tree */
 	doc = xmlReadFile(xml_file, "UTF-8", XML_PARSE_NOBLANKS);
 	if (doc == NULL) {
@@ -476,6 +737,11 @@ int IPACM_read_firewall_xml(char *xml_file, IPACM_firewall_conf_t *config)
 	{
 		IPACMDBG_H("IPACM_xml_parse: ipacm_firewall_xml_parse_tree returned parse error!\n");
 	}
+	else
+	{
+		IPACM_xml_snapshot_store(xml_file, IPACM_XML_SNAPSHOT_FIREWALL,
+			config, sizeof(IPACM_firewall_conf_t), src_hash);
+	}
 
 	/* free the tree */
 	xmlFreeDoc(doc);
@@ -1171,3 +1437,50 @@ static int IPACM_firewall_xml_parse_tree
 	} /* end while */
 	return ret_val;
 }
+
+/* true if both configs install the same firewall rules for ip_vsn */
+bool IPACM_firewall_rules_equal
+(
+	const IPACM_firewall_conf_t *old_config,
+	const IPACM_firewall_conf_t *new_config,
+	firewall_ip_version_enum ip_vsn
+)
+{
+	int i = 0, j = 0;
+
+	if (old_config->firewall_enable != new_config->firewall_enable ||
+		old_config->rule_action_accept != new_config->rule_action_accept)
+	{
+		return false;
+	}
+
+	/* rules are installed in file order, compare the ip_vsn rules in sequence */
+	while (1)
+	{
+		while (i < old_config->num_extd_firewall_entries &&
+			old_config->extd_firewall_entries[i].ip_vsn != ip_vsn)
+		{
+			i++;
+		}
+		while (j < new_config->num_extd_firewall_entries &&
+			new_config->extd_firewall_entries[j].ip_vsn != ip_vsn)
+		{
+			j++;
+		}
+		if (i == old_config->num_extd_firewall_entries ||
+			j == new_config->num_extd_firewall_entries)
+		{
+			break;
+		}
+		if (memcmp(&old_config->extd_firewall_entries[i].attrib,
+			&new_config->extd_firewall_entries[j].attrib,
+			sizeof(struct ipa_rule_attrib)) != 0)
+		{
+			return false;
+		}
+		i++;
+		j++;
+	}
+	return (i == old_config->num_extd_firewall_entries &&
+		j == new_config->num_extd_firewall_entries);
+}
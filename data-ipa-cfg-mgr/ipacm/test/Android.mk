@@ -0,0 +1,82 @@
+BOARD_PLATFORM_LIST := test
+ifeq ($(call is-board-platform-in-list,$(BOARD_PLATFORM_LIST)),true)
+ifneq (,$(filter $(QCOM_BOARD_PLATFORMS),$(TARGET_BOARD_PLATFORM)))
+ifneq (, $(filter aarch64 arm arm64, $(TARGET_ARCH)))
+
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../inc
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../../ipanat/inc
+LOCAL_C_INCLUDES += external/libxml2/include
+LOCAL_C_INCLUDES += external/libnetfilter_conntrack/include
+LOCAL_C_INCLUDES += external/libnfnetlink/include
+
+LOCAL_HEADER_LIBRARIES := generated_kernel_headers
+
+LOCAL_CFLAGS := -DFEATURE_IPA_ANDROID -DFEATURE_IPA_V3
+
+LOCAL_MODULE := natapp_bench
+LOCAL_SRC_FILES := IPACM_NATApp_bench.cpp \
+		IPACM_NATApp_stubs.cpp \
+		../src/IPACM_Conntrack_NATApp.cpp \
+		../src/IPACM_Log.cpp
+
+LOCAL_SHARED_LIBRARIES := libnfnetlink
+LOCAL_SHARED_LIBRARIES += libnetfilter_conntrack
+
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/kernel-tests/ip_accelerator
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../inc
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../../ipanat/inc
+
+LOCAL_HEADER_LIBRARIES := generated_kernel_headers
+
+LOCAL_CFLAGS := -DFEATURE_IPA_ANDROID -DFEATURE_IPA_V3
+
+LOCAL_MODULE := clientdir_bench
+LOCAL_SRC_FILES := IPACM_ClientDir_bench.cpp \
+		../src/IPACM_ClientDir.cpp \
+		../src/IPACM_Log.cpp
+
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/kernel-tests/ip_accelerator
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../inc
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../../ipanat/inc
+LOCAL_C_INCLUDES += external/libxml2/include
+LOCAL_C_INCLUDES += external/libnetfilter_conntrack/include
+LOCAL_C_INCLUDES += external/libnfnetlink/include
+
+LOCAL_HEADER_LIBRARIES := generated_kernel_headers
+
+LOCAL_CFLAGS := -DFEATURE_IPA_ANDROID -DFEATURE_IPA_V3
+
+LOCAL_MODULE := lantolan_bench
+LOCAL_SRC_FILES := IPACM_LanToLan_bench.cpp \
+		IPACM_LanToLan_stubs.cpp \
+		../src/IPACM_LanToLan.cpp \
+		../src/IPACM_RuleTxn.cpp \
+		../src/IPACM_Log.cpp
+
+LOCAL_MODULE_TAGS := debug
+LOCAL_MODULE_PATH := $(TARGET_OUT_DATA)/kernel-tests/ip_accelerator
+
+include $(BUILD_EXECUTABLE)
+
+endif # $(TARGET_ARCH)
+endif
+endif
@@ -0,0 +1,182 @@
+/*
+Copyright (c) 2018, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_ClientDir_bench.cpp
+
+	@brief
+	Client join/leave storm: fill the client table, then replace a random
+	client with a new one per event. Each join/leave does the lookups the
+	Lan/Wlan event path does (client init, ipaddr, route rule, down) plus
+	the array compaction on leave. Compares the directory with the plain
+	memcmp scan it replaces
+
+	usage: clientdir_bench [events]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "IPACM_ClientDir.h"
+
+#define BENCH_LOOKUPS_PER_EVENT 4
+
+static uint32_t bench_seed = 1;
+
+static uint32_t bench_rand(void)
+{
+	bench_seed = bench_seed * 1103515245 + 12345;
+	return bench_seed >> 8;
+}
+
+static void bench_make_mac(uint8_t *mac)
+{
+	uint32_t rnd = bench_rand();
+
+	mac[0] = 0x02;
+	mac[1] = 0x1A;
+	mac[2] = (uint8_t)(rnd >> 16);
+	mac[3] = (uint8_t)(rnd >> 8);
+	mac[4] = (uint8_t)rnd;
+	mac[5] = (uint8_t)bench_rand();
+}
+
+static int bench_linear_find(uint8_t (*macs)[IPA_MAC_ADDR_SIZE], int num, const uint8_t *mac)
+{
+	int cnt;
+
+	for (cnt = 0; cnt < num; cnt++)
+	{
+		if (memcmp(macs[cnt], mac, IPA_MAC_ADDR_SIZE) == 0)
+		{
+			return cnt;
+		}
+	}
+	return IPACM_INVALID_INDEX;
+}
+
+static int bench_find(IPACM_ClientDir *dir, uint8_t (*macs)[IPA_MAC_ADDR_SIZE], int num, const uint8_t *mac)
+{
+	return (dir != NULL) ? dir->FindMac(mac) : bench_linear_find(macs, num, mac);
+}
+
+static void bench_leave(uint8_t (*macs)[IPA_MAC_ADDR_SIZE], int *num, int idx, IPACM_ClientDir *dir)
+{
+	if (dir != NULL)
+	{
+		dir->Remove(macs[idx]);
+		dir->ShiftDown(idx);
+	}
+	for (; idx < *num - 1; idx++)
+	{
+		memcpy(macs[idx], macs[idx + 1], IPA_MAC_ADDR_SIZE);
+	}
+	(*num)--;
+}
+
+static double bench_run(int clients, int events, bool use_dir)
+{
+	IPACM_ClientDir *dir = use_dir ? new IPACM_ClientDir(clients) : NULL;
+	uint8_t (*macs)[IPA_MAC_ADDR_SIZE];
+	uint8_t mac[IPA_MAC_ADDR_SIZE];
+	struct timespec start, end;
+	int cnt, lookup, idx, num = 0;
+	long misses = 0;
+
+	macs = (uint8_t (*)[IPA_MAC_ADDR_SIZE])malloc(clients * IPA_MAC_ADDR_SIZE);
+	bench_seed = 1;
+	while (num < clients)
+	{
+		bench_make_mac(macs[num]);
+		if (dir != NULL)
+		{
+			dir->Add(macs[num], num);
+		}
+		num++;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (cnt = 0; cnt < events; cnt++)
+	{
+		/* a client leaves */
+		memcpy(mac, macs[bench_rand() % num], IPA_MAC_ADDR_SIZE);
+		idx = bench_find(dir, macs, num, mac);
+		bench_leave(macs, &num, idx, dir);
+
+		/* a new one joins at the end of the array and gets an address */
+		do
+		{
+			bench_make_mac(mac);
+		} while (bench_find(dir, macs, num, mac) != IPACM_INVALID_INDEX);
+		memcpy(macs[num], mac, IPA_MAC_ADDR_SIZE);
+		if (dir != NULL)
+		{
+			dir->Add(mac, num);
+			dir->SetV4(mac, 0x0A000000 + cnt);
+		}
+		num++;
+
+		/* ipaddr, route rule and power save events look the client up */
+		for (lookup = 0; lookup < BENCH_LOOKUPS_PER_EVENT; lookup++)
+		{
+			idx = bench_rand() % num;
+			if (bench_find(dir, macs, num, macs[idx]) != idx)
+			{
+				misses++;
+			}
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (misses != 0 || (dir != NULL && dir->GetCount() != num))
+	{
+		fprintf(stderr, "lookup mismatch: %ld misses, %d clients\n", misses, num);
+	}
+	free(macs);
+	delete dir;
+
+	return events / ((end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+}
+
+int main(int argc, char **argv)
+{
+	static const int clients[] = { 15, 32, 100, IPACM_CLIENT_DIR_MAX };
+	int events = (argc > 1) ? atoi(argv[1]) : 1000000;
+	unsigned int cnt;
+
+	/* the ipacm debug logs go to stdout */
+	for (cnt = 0; cnt < sizeof(clients) / sizeof(clients[0]); cnt++)
+	{
+		fprintf(stderr, "%4d clients: linear %10.0f events/sec, directory %10.0f events/sec\n", clients[cnt],
+				bench_run(clients[cnt], events, false),
+				bench_run(clients[cnt], events, true));
+	}
+	return 0;
+}
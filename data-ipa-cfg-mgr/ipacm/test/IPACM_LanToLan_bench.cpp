@@ -0,0 +1,234 @@
+/*
+Copyright (c) 2018, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_LanToLan_bench.cpp
+
+	@brief
+	N bridged interfaces with M clients each: bring the interfaces up, churn
+	the clients (one leaves, a new one joins on the same interface), flap the
+	one interface with another l2 header type and take the interfaces down
+	again. Reports the rules, ioctls and commits the LanToLan bookkeeping and
+	the IPACM_RuleTxn batching send per event
+
+	usage: lantolan_bench [events]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "IPACM_LanToLan.h"
+#include "IPACM_Lan.h"
+#include "IPACM_Config.h"
+#include "IPACM_LanToLan_stubs.h"
+
+#define BENCH_MAX_EVENTS 1000000
+
+class LanToLanBench
+{
+public:
+	static uint32_t seed;
+	static IPACM_Listener *listener;
+
+	static uint32_t Rand()
+	{
+		seed = seed * 1103515245 + 12345;
+		return seed >> 8;
+	}
+
+	/* bridge member with one v4 and one v6 tx prop, eth0 is the only one with
+	   802.3 headers; the constructor of IPACM_Lan talks to the driver, so only
+	   the fields LanToLan reads are set */
+	static IPACM_Lan* MakeIface(int idx)
+	{
+		IPACM_Lan *iface;
+		ipa_hdr_l2_type l2_type;
+		int len;
+
+		iface = (IPACM_Lan *)calloc(1, sizeof(IPACM_Lan));
+		snprintf(iface->dev_name, sizeof(iface->dev_name), "eth%d", idx);
+		iface->ipa_if_cate = LAN_IF;
+
+		len = sizeof(struct ipa_ioc_query_intf_tx_props) + 2 * sizeof(struct ipa_ioc_tx_intf_prop);
+		iface->tx_prop = (struct ipa_ioc_query_intf_tx_props *)calloc(1, len);
+		iface->tx_prop->num_tx_props = 2;
+		iface->tx_prop->tx[0].ip = IPA_IP_v4;
+		iface->tx_prop->tx[1].ip = IPA_IP_v6;
+		l2_type = (idx == 0) ? IPA_HDR_L2_802_3 : IPA_HDR_L2_ETHERNET_II;
+		iface->tx_prop->tx[0].hdr_l2_type = iface->tx_prop->tx[1].hdr_l2_type = l2_type;
+
+		len = sizeof(struct ipa_ioc_query_intf_rx_props) + 2 * sizeof(struct ipa_ioc_rx_intf_prop);
+		iface->rx_prop = (struct ipa_ioc_query_intf_rx_props *)calloc(1, len);
+		iface->rx_prop->num_rx_props = 2;
+		return iface;
+	}
+
+	static void FreeIface(IPACM_Lan *iface)
+	{
+		free(iface->tx_prop);
+		free(iface->rx_prop);
+		free(iface);
+	}
+
+	static void Post(ipa_cm_event_id event, IPACM_Lan *iface, ipa_ip_type iptype, uint32_t client)
+	{
+		ipacm_event_eth_bridge data;
+
+		memset(&data, 0, sizeof(data));
+		data.p_iface = iface;
+		data.iptype = iptype;
+		data.mac_addr[0] = 0x02;
+		data.mac_addr[2] = (uint8_t)(client >> 24);
+		data.mac_addr[3] = (uint8_t)(client >> 16);
+		data.mac_addr[4] = (uint8_t)(client >> 8);
+		data.mac_addr[5] = (uint8_t)client;
+		listener->event_callback(event, &data);
+	}
+
+	static double Now()
+	{
+		struct timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec + ts.tv_nsec / 1e9;
+	}
+
+	static void Report(const char *what, int bridges, int clients, int events, double start)
+	{
+		fprintf(stderr, "%2d bridges x %2d clients %-12s %8.0f events/sec, %7.1f rules %6.1f ioctls %6.1f commits per event\n",
+			bridges, clients, what, events / (Now() - start), (double)l2l_stub_drv.rules / events,
+			(double)l2l_stub_drv.ioctls / events, (double)l2l_stub_drv.commits / events);
+		l2l_stub_drv.rules = l2l_stub_drv.ioctls = l2l_stub_drv.commits = 0;
+	}
+
+	static void Run(int bridges, int clients, int events)
+	{
+		IPACM_Lan *iface[MAX_NUM_IFACE];
+		uint32_t member[MAX_NUM_IFACE][MAX_NUM_CLIENT];
+		uint32_t next_client = 0;
+		double start, elapsed;
+		l2l_stub_count saved;
+		int i, j, cnt;
+
+		seed = 1;
+		memset(&l2l_stub_drv, 0, sizeof(l2l_stub_drv));
+		for (i = 0; i < bridges; i++)
+		{
+			iface[i] = MakeIface(i);
+		}
+
+		/* every member joins the mesh, then its clients show up */
+		start = Now();
+		for (i = 0; i < bridges; i++)
+		{
+			Post(IPA_ETH_BRIDGE_IFACE_UP, iface[i], IPA_IP_v4, 0);
+			Post(IPA_ETH_BRIDGE_IFACE_UP, iface[i], IPA_IP_v6, 0);
+			for (j = 0; j < clients; j++)
+			{
+				member[i][j] = next_client++;
+				Post(IPA_ETH_BRIDGE_CLIENT_ADD, iface[i], IPA_IP_MAX, member[i][j]);
+			}
+		}
+		Report("mesh up", bridges, clients, bridges * (clients + 2), start);
+
+		start = Now();
+		for (cnt = 0; cnt < events; cnt++)
+		{
+			i = Rand() % bridges;
+			j = Rand() % clients;
+			Post(IPA_ETH_BRIDGE_CLIENT_DEL, iface[i], IPA_IP_MAX, member[i][j]);
+			member[i][j] = next_client++;
+			Post(IPA_ETH_BRIDGE_CLIENT_ADD, iface[i], IPA_IP_MAX, member[i][j]);
+		}
+		Report("client churn", bridges, clients, 2 * events, start);
+
+		/* eth0 leaves and rejoins while the others keep their clients, being the
+		   only 802.3 member every peer reinstalls its client routing rules;
+		   only the down/up events are timed and counted */
+		elapsed = 0;
+		i = 0;
+		for (cnt = 0; cnt < events / 100 + 1; cnt++)
+		{
+			start = Now();
+			Post(IPA_ETH_BRIDGE_IFACE_DOWN, iface[i], IPA_IP_MAX, 0);
+			Post(IPA_ETH_BRIDGE_IFACE_UP, iface[i], IPA_IP_v4, 0);
+			Post(IPA_ETH_BRIDGE_IFACE_UP, iface[i], IPA_IP_v6, 0);
+			elapsed += Now() - start;
+
+			memcpy(&saved, &l2l_stub_drv, sizeof(saved));
+			for (j = 0; j < clients; j++)
+			{
+				Post(IPA_ETH_BRIDGE_CLIENT_ADD, iface[i], IPA_IP_MAX, member[i][j]);
+			}
+			saved.hdl = l2l_stub_drv.hdl;
+			memcpy(&l2l_stub_drv, &saved, sizeof(saved));
+		}
+		Report("iface flap", bridges, clients, 3 * (events / 100 + 1), Now() - elapsed);
+
+		start = Now();
+		for (i = 0; i < bridges; i++)
+		{
+			Post(IPA_ETH_BRIDGE_IFACE_DOWN, iface[i], IPA_IP_MAX, 0);
+		}
+		Report("iface down", bridges, clients, bridges, start);
+
+		for (i = 0; i < bridges; i++)
+		{
+			FreeIface(iface[i]);
+		}
+	}
+};
+
+uint32_t LanToLanBench::seed = 1;
+IPACM_Listener *LanToLanBench::listener = NULL;
+
+int main(int argc, char **argv)
+{
+	static const int bridges[] = { 2, 4, MAX_NUM_IFACE };
+	static const int clients[] = { 4, MAX_NUM_CLIENT };
+	int events = (argc > 1) ? atoi(argv[1]) : 20000;
+	unsigned int i, j;
+
+	/* getEventName() is the only IPACM_Config member reached */
+	IPACM_Iface::ipacmcfg = (IPACM_Config *)calloc(1, sizeof(IPACM_Config));
+	LanToLanBench::listener = IPACM_LanToLan::get_instance();
+	if (events < 1 || events > BENCH_MAX_EVENTS)
+	{
+		events = BENCH_MAX_EVENTS;
+	}
+	for (i = 0; i < sizeof(bridges) / sizeof(bridges[0]); i++)
+	{
+		for (j = 0; j < sizeof(clients) / sizeof(clients[0]); j++)
+		{
+			LanToLanBench::Run(bridges[i], clients[j], events);
+		}
+	}
+	return 0;
+}
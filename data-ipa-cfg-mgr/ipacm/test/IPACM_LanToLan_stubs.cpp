@@ -0,0 +1,323 @@
+/*
+Copyright (c) 2018, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_LanToLan_stubs.cpp
+
+	@brief
+	Driver wrappers, dispatcher and the IPACM_Lan bridge helpers for the
+	LanToLan bench. Rules get fake handles and are counted instead of sent
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "IPACM_Iface.h"
+#include "IPACM_Lan.h"
+#include "IPACM_Wlan.h"
+#include "IPACM_EvtDispatcher.h"
+#include "IPACM_Config.h"
+#include "IPACM_RuleTxn.h"
+#include "IPACM_LanToLan_stubs.h"
+
+l2l_stub_count l2l_stub_drv;
+
+IPACM_Routing IPACM_Iface::m_routing;
+IPACM_Filtering IPACM_Iface::m_filtering;
+IPACM_Header IPACM_Iface::m_header;
+IPACM_Config *IPACM_Iface::ipacmcfg = NULL;
+
+int IPACM_EvtDispatcher::registr(ipa_cm_event_id, IPACM_Listener *)
+{
+	return IPACM_SUCCESS;
+}
+
+const char* IPACM_Config::getEventName(ipa_cm_event_id)
+{
+	return "bench";
+}
+
+IPACM_Routing::IPACM_Routing()
+{
+	m_fd = -1;
+}
+
+IPACM_Routing::~IPACM_Routing()
+{
+}
+
+bool IPACM_Routing::AddRoutingRule(struct ipa_ioc_add_rt_rule *ruleTable)
+{
+	int i;
+
+	for (i = 0; i < ruleTable->num_rules; i++)
+	{
+		ruleTable->rules[i].rt_rule_hdl = ++l2l_stub_drv.hdl;
+		ruleTable->rules[i].status = 0;
+	}
+	l2l_stub_drv.rules += ruleTable->num_rules;
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits += (ruleTable->commit != 0);
+	return true;
+}
+
+bool IPACM_Routing::DeleteRoutingRule(struct ipa_ioc_del_rt_rule *ruleTable)
+{
+	int i;
+
+	for (i = 0; i < ruleTable->num_hdls; i++)
+	{
+		ruleTable->hdl[i].status = 0;
+	}
+	l2l_stub_drv.rules += ruleTable->num_hdls;
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits += (ruleTable->commit != 0);
+	return true;
+}
+
+bool IPACM_Routing::DeleteRoutingHdl(uint32_t, ipa_ip_type)
+{
+	l2l_stub_drv.rules++;
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits++;
+	return true;
+}
+
+bool IPACM_Routing::ModifyRoutingRule(struct ipa_ioc_mdfy_rt_rule *mdfyRules)
+{
+	l2l_stub_drv.rules += mdfyRules->num_rules;
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits += (mdfyRules->commit != 0);
+	return true;
+}
+
+bool IPACM_Routing::Commit(enum ipa_ip_type)
+{
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits++;
+	return true;
+}
+
+bool IPACM_Routing::GetRoutingTable(struct ipa_ioc_get_rt_tbl *routingTable)
+{
+	routingTable->hdl = 1;
+	l2l_stub_drv.ioctls++;
+	return true;
+}
+
+IPACM_Filtering::IPACM_Filtering()
+{
+	fd = -1;
+}
+
+IPACM_Filtering::~IPACM_Filtering()
+{
+}
+
+bool IPACM_Filtering::AddFilteringRule(struct ipa_ioc_add_flt_rule const *ruleTable)
+{
+	int i;
+
+	for (i = 0; i < ruleTable->num_rules; i++)
+	{
+		((struct ipa_ioc_add_flt_rule *)ruleTable)->rules[i].flt_rule_hdl = ++l2l_stub_drv.hdl;
+		((struct ipa_ioc_add_flt_rule *)ruleTable)->rules[i].status = 0;
+	}
+	l2l_stub_drv.rules += ruleTable->num_rules;
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits += (ruleTable->commit != 0);
+	return true;
+}
+
+bool IPACM_Filtering::DeleteFilteringRule(struct ipa_ioc_del_flt_rule *ruleTable)
+{
+	int i;
+
+	for (i = 0; i < ruleTable->num_hdls; i++)
+	{
+		ruleTable->hdl[i].status = 0;
+	}
+	l2l_stub_drv.rules += ruleTable->num_hdls;
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits += (ruleTable->commit != 0);
+	return true;
+}
+
+bool IPACM_Filtering::DeleteFilteringHdls(uint32_t *, ipa_ip_type, uint8_t num_rules)
+{
+	l2l_stub_drv.rules += num_rules;
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits++;
+	return true;
+}
+
+bool IPACM_Filtering::Commit(enum ipa_ip_type)
+{
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits++;
+	return true;
+}
+
+IPACM_Header::IPACM_Header()
+{
+	m_fd = -1;
+}
+
+IPACM_Header::~IPACM_Header()
+{
+}
+
+bool IPACM_Header::AddHeader(struct ipa_ioc_add_hdr *pHeaderTable)
+{
+	int i;
+
+	for (i = 0; i < pHeaderTable->num_hdrs; i++)
+	{
+		pHeaderTable->hdr[i].hdr_hdl = ++l2l_stub_drv.hdl;
+		pHeaderTable->hdr[i].status = 0;
+	}
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits += (pHeaderTable->commit != 0);
+	return true;
+}
+
+bool IPACM_Header::DeleteHeader(struct ipa_ioc_del_hdr *pHeaderTable)
+{
+	int i;
+
+	for (i = 0; i < pHeaderTable->num_hdls; i++)
+	{
+		pHeaderTable->hdl[i].status = 0;
+	}
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits += (pHeaderTable->commit != 0);
+	return true;
+}
+
+bool IPACM_Header::DeleteHeaderHdl(uint32_t)
+{
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits++;
+	return true;
+}
+
+bool IPACM_Header::Commit()
+{
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits++;
+	return true;
+}
+
+/* the bench only brings up LAN_IF members */
+bool IPACM_Wlan::is_guest_ap()
+{
+	return false;
+}
+
+/* one rule per tx prop of the family, queued on txn like the real one */
+int IPACM_Lan::eth_bridge_add_rt_rule(uint8_t *, char *rt_tbl_name, uint32_t hdr_proc_ctx_hdl,
+		ipa_hdr_l2_type, ipa_ip_type iptype, uint32_t *rt_rule_hdl, int *rt_rule_count,
+		IPACM_RuleTxn *txn)
+{
+	struct ipa_ioc_add_rt_rule *rt_rule_table;
+	uint32_t i;
+	int num = 0;
+
+	rt_rule_table = (struct ipa_ioc_add_rt_rule *)calloc(1, sizeof(*rt_rule_table) + MAX_NUM_PROP * sizeof(struct ipa_rt_rule_add));
+	rt_rule_table->commit = 1;
+	rt_rule_table->ip = iptype;
+	strlcpy(rt_rule_table->rt_tbl_name, rt_tbl_name, sizeof(rt_rule_table->rt_tbl_name));
+	for (i = 0; i < tx_prop->num_tx_props && num < MAX_NUM_PROP; i++)
+	{
+		if (tx_prop->tx[i].ip == iptype)
+		{
+			rt_rule_table->rules[num].rule.dst = tx_prop->tx[i].dst_pipe;
+			rt_rule_table->rules[num].rule.hdr_proc_ctx_hdl = hdr_proc_ctx_hdl;
+			num++;
+		}
+	}
+	rt_rule_table->num_rules = num;
+
+	if (txn != NULL)
+	{
+		for (i = 0; i < (uint32_t)num; i++)
+		{
+			txn->AddRoutingRule(iptype, rt_rule_table->rt_tbl_name, &rt_rule_table->rules[i], &rt_rule_hdl[i]);
+		}
+	}
+	else
+	{
+		m_routing.AddRoutingRule(rt_rule_table);
+		for (i = 0; i < (uint32_t)num; i++)
+		{
+			rt_rule_hdl[i] = rt_rule_table->rules[i].rt_rule_hdl;
+		}
+	}
+	*rt_rule_count = num;
+	free(rt_rule_table);
+	return IPACM_SUCCESS;
+}
+
+/* IPA_IOC_ADD_FLT_RULE_AFTER with commit, one rule per call */
+int IPACM_Lan::eth_bridge_add_flt_rule(uint8_t *, uint32_t, ipa_ip_type, uint32_t *flt_rule_hdl)
+{
+	*flt_rule_hdl = ++l2l_stub_drv.hdl;
+	l2l_stub_drv.rules++;
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits++;
+	return IPACM_SUCCESS;
+}
+
+int IPACM_Lan::eth_bridge_del_flt_rule(uint32_t flt_rule_hdl, ipa_ip_type iptype)
+{
+	m_filtering.DeleteFilteringHdls(&flt_rule_hdl, iptype, 1);
+	return IPACM_SUCCESS;
+}
+
+int IPACM_Lan::eth_bridge_modify_rt_rule(uint8_t *, uint32_t, ipa_hdr_l2_type, ipa_ip_type, uint32_t *, int rt_rule_count)
+{
+	l2l_stub_drv.rules += rt_rule_count;
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits++;
+	return IPACM_SUCCESS;
+}
+
+int IPACM_Lan::eth_bridge_add_hdr_proc_ctx(ipa_hdr_l2_type, uint32_t *hdl)
+{
+	*hdl = ++l2l_stub_drv.hdl;
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits++;
+	return IPACM_SUCCESS;
+}
+
+int IPACM_Lan::eth_bridge_del_hdr_proc_ctx(uint32_t)
+{
+	l2l_stub_drv.ioctls++;
+	l2l_stub_drv.commits++;
+	return IPACM_SUCCESS;
+}
@@ -0,0 +1,171 @@
+/*
+Copyright (c) 2018, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_NATApp_bench.cpp
+
+	@brief
+	Replays a synthetic conntrack event stream against the NatApp cache:
+	fill the cache with flows of 64 clients, then mix closes and new flows,
+	duplicate adds, power save toggles and client disconnects. Runs on the
+	stubbed nat driver, so only the cache bookkeeping is timed. NatApp is a
+	singleton sized once from the config, so each table size runs in its
+	own process
+
+	usage: natapp_bench [events]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "IPACM_Conntrack_NATApp.h"
+#include "IPACM_NATApp_stubs.h"
+
+#define BENCH_CLIENTS 64
+#define BENCH_PUB_IP 0x64400001
+
+static uint32_t bench_seed = 1;
+static uint32_t bench_serial = 0;
+
+static uint32_t bench_rand(void)
+{
+	bench_seed = bench_seed * 1103515245 + 12345;
+	return bench_seed >> 8;
+}
+
+/* the serial in the target ip keeps every flow unique */
+static void bench_make_flow(nat_table_entry *rule, uint32_t clnt)
+{
+	memset(rule, 0, sizeof(*rule));
+	rule->private_ip = 0xC0A80102 + clnt;                      /* 192.168.1.2+ */
+	rule->target_ip = 0x0A000000 | (++bench_serial & 0xFFFFFF); /* 10.x.x.x */
+	rule->private_port = 1024 + (bench_rand() % 60000);
+	rule->target_port = (bench_rand() & 1) ? 443 : 80 + (bench_rand() % 1000);
+	rule->public_port = 1024 + (bench_rand() % 60000);
+	rule->protocol = (bench_rand() & 3) ? IPPROTO_TCP : IPPROTO_UDP;
+}
+
+static double bench_run(int flows, int events)
+{
+	NatApp *app;
+	nat_table_entry *live, rule;
+	struct timespec start, end;
+	int cnt, idx, added = 0;
+	uint32_t clnt;
+
+	nat_stub_max_entries = flows;
+	app = NatApp::GetInstance();
+	if (app == NULL || app->AddTable(BENCH_PUB_IP))
+	{
+		return -1;
+	}
+
+	live = (nat_table_entry *)malloc(sizeof(nat_table_entry) * flows);
+	if (live == NULL)
+	{
+		return -1;
+	}
+	while (added < flows)
+	{
+		bench_make_flow(&live[added], added % BENCH_CLIENTS);
+		if (app->AddEntry(&live[added]) == 0)
+		{
+			added++;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (cnt = 0; cnt < events; cnt++)
+	{
+		idx = bench_rand() % flows;
+		clnt = live[idx].private_ip - 0xC0A80102;
+		switch (bench_rand() % 20)
+		{
+		case 0:
+			/* client goes to power save and back */
+			app->UpdatePwrSaveIf(live[idx].private_ip);
+			app->ResetPwrSaveIf(live[idx].private_ip);
+			break;
+		case 1:
+			/* client disconnects, its flows close and it reconnects */
+			app->DelEntriesOnClntDiscon(live[idx].private_ip);
+			app->ResetPwrSaveIf(live[idx].private_ip);
+			break;
+		case 2: case 3: case 4: case 5: case 6: case 7: case 8: case 9:
+			/* duplicate NEW/UPDATE event for a known flow */
+			app->AddEntry(&live[idx]);
+			break;
+		default:
+			/* flow closes, another one of the same client opens */
+			app->DeleteEntry(&live[idx]);
+			bench_make_flow(&rule, clnt);
+			if (app->AddEntry(&rule) == 0)
+			{
+				live[idx] = rule;
+			}
+			break;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (nat_stub_live_rules != flows)
+	{
+		fprintf(stderr, "nat driver holds %d rules, expected %d\n", nat_stub_live_rules, flows);
+	}
+	free(live);
+
+	return events / ((end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+}
+
+int main(int argc, char **argv)
+{
+	static const int flows[] = { 1000, 10000, 50000 };
+	int events = (argc > 1) ? atoi(argv[1]) : 100000;
+	unsigned int cnt;
+	pid_t pid;
+
+	for (cnt = 0; cnt < sizeof(flows) / sizeof(flows[0]); cnt++)
+	{
+		pid = fork();
+		if (pid == 0)
+		{
+			/* the ipacm debug logs go to stdout */
+			fprintf(stderr, "%6d flows: %10.0f events/sec\n", flows[cnt], bench_run(flows[cnt], events));
+			exit(0);
+		}
+		if (pid > 0)
+		{
+			waitpid(pid, NULL, 0);
+		}
+	}
+	return 0;
+}
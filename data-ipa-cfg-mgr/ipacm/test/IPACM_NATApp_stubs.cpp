@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2018, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+		* Redistributions of source code must retain the above copyright
+			notice, this list of conditions and the following disclaimer.
+		* Redistributions in binary form must reproduce the above
+			copyright notice, this list of conditions and the following
+			disclaimer in the documentation and/or other materials provided
+			with the distribution.
+		* Neither the name of The Linux Foundation nor the names of its
+			contributors may be used to endorse or promote products derived
+			from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*!
+	@file
+	IPACM_NATApp_stubs.cpp
+
+	@brief
+	Stands in for the nat driver and the XML config under the NatApp bench.
+	The driver only hands out rule handles and keeps count of the rules it
+	holds, the config is built with the nat table size the bench asks for
+*/
+#include <string.h>
+
+#include "IPACM_Conntrack_NATApp.h"
+#include "IPACM_NATApp_stubs.h"
+
+int nat_stub_max_entries = 1000;
+int nat_stub_live_rules = 0;
+
+static uint32_t nat_stub_rule_hdl = 0;
+
+IPACM_Config::IPACM_Config()
+{
+	alg_table = NULL;
+	pNatIfaces = NULL;
+	ipa_num_alg_ports = 0;
+	ipa_nat_max_entries = nat_stub_max_entries;
+}
+
+IPACM_Config* IPACM_Config::GetInstance()
+{
+	static IPACM_Config *config = NULL;
+
+	if (config == NULL)
+	{
+		config = new IPACM_Config();
+	}
+	return config;
+}
+
+int IPACM_Config::GetAlgPorts(int, ipacm_alg *)
+{
+	return 0;
+}
+
+int ipa_nat_add_ipv4_tbl(uint32_t, uint16_t, uint32_t *table_handle)
+{
+	*table_handle = 1;
+	return 0;
+}
+
+int ipa_nat_del_ipv4_tbl(uint32_t)
+{
+	return 0;
+}
+
+int ipa_nat_add_ipv4_rule(uint32_t, const ipa_nat_ipv4_rule *, uint32_t *rule_handle)
+{
+	*rule_handle = ++nat_stub_rule_hdl;
+	nat_stub_live_rules++;
+	return 0;
+}
+
+int ipa_nat_del_ipv4_rule(uint32_t, uint32_t)
+{
+	nat_stub_live_rules--;
+	return 0;
+}
+
+int ipa_nat_query_timestamp(uint32_t, uint32_t, uint32_t *time_stamp)
+{
+	*time_stamp = 0;
+	return 0;
+}
+
+int ipa_nat_query_timestamps(uint32_t, uint32_t num_rules, const uint32_t *, uint32_t *time_stamps)
+{
+	memset(time_stamps, 0, sizeof(uint32_t) * num_rules);
+	return 0;
+}
+
+int ipa_nat_compact_ipv4_tbl(uint32_t, uint16_t, uint16_t *moves)
+{
+	*moves = 0;
+	return 0;
+}
+
+int ipa_nat_get_chain_stats(uint32_t, ipa_nat_chain_stats *rule_stats, ipa_nat_chain_stats *index_stats)
+{
+	memset(rule_stats, 0, sizeof(*rule_stats));
+	memset(index_stats, 0, sizeof(*index_stats));
+	return 0;
+}
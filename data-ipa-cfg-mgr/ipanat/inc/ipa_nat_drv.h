@@ -62,6 +62,31 @@ typedef struct {
 	uint32_t dst_metadata;
 } ipa_nat_pdn_entry;
 
+#define IPA_NAT_CHAIN_HIST_SIZE 8
+
+/**
+ * struct ipa_nat_chain_stats - shape of the hash chains of a table
+ * @buckets: base table entries
+ * @used: buckets holding at least one entry
+ * @entries: entries in all chains, dead ones included
+ * @dead: deleted entries still kept to hold a chain
+ * @longest: longest chain, in entries
+ * @reads: entries the hw reads to reach every live rule
+ * @hist: number of chains of length 1..IPA_NAT_CHAIN_HIST_SIZE,
+ * the last one counts the longer chains too
+ *
+ * reads / (entries - dead) is the average lookup cost
+ */
+typedef struct {
+	uint32_t buckets;
+	uint32_t used;
+	uint32_t entries;
+	uint32_t dead;
+	uint32_t longest;
+	uint32_t reads;
+	uint32_t hist[IPA_NAT_CHAIN_HIST_SIZE];
+} ipa_nat_chain_stats;
+
 /**
  * ipa_nat_add_ipv4_tbl() - create ipv4 nat table
  * @public_ip_addr: [in] public ipv4 address
@@ -128,6 +153,54 @@ int ipa_nat_query_timestamp(uint32_t  table_handle,
 				uint32_t  rule_handle,
 				uint32_t  *time_stamp);
 
+/**
+ * ipa_nat_query_timestamps() - to query timestamps of many rules
+ * @table_handle: [in] handle of ipv4 nat table
+ * @num_rules: [in] number of rule handles
+ * @rule_handles: [in] ipv4 nat rule handles
+ * @time_stamps: [out] time stamp of each rule
+ *
+ * Same as ipa_nat_query_timestamp() for every rule
+ * handle, read in one pass under one lock
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_query_timestamps(uint32_t  table_handle,
+				uint32_t  num_rules,
+				const uint32_t  *rule_handles,
+				uint32_t  *time_stamps);
+
+
+/**
+ * ipa_nat_get_chain_stats() - read the chain statistics
+ * @table_handle: [in] handle of ipv4 nat table
+ * @rule_stats: [out] chains of the nat table
+ * @index_stats: [out] chains of the index table
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_get_chain_stats(uint32_t  table_handle,
+				ipa_nat_chain_stats *rule_stats,
+				ipa_nat_chain_stats *index_stats);
+
+/**
+ * ipa_nat_compact_ipv4_tbl() - shorten the chains of a table
+ * @table_handle: [in] handle of ipv4 nat table
+ * @max_moves: [in] entries to move in this call, 0 for no limit
+ * @moves: [out] entries moved, each frees one expansion entry
+ *
+ * Deleted chain heads stay in the table until their chain
+ * empties, so every lookup on the bucket reads them. This
+ * moves the next live entry up into the head and frees its
+ * expansion entry, with the rule matching at all times and
+ * its rule handle unchanged. Resumes where the last call
+ * stopped, so it can run a few buckets at a time
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_compact_ipv4_tbl(uint32_t  table_handle,
+				uint16_t  max_moves,
+				uint16_t  *moves);
 
 /**
 * ipa_nat_modify_pdn() - modify single PDN entry in the PDN config table
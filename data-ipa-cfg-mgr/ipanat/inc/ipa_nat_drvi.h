@@ -337,12 +337,19 @@ struct ipa_nat_ip4_table_cache {
 	struct ipa_nat_indx_tbl_meta_info *index_expn_table_meta;
 
 	uint16_t *rule_id_array;
+
+	/* rule handle of each base and expansion entry, the reverse of
+	   rule_id_array; stale once the rule is deleted */
+	uint16_t *entry_hdl_array;
 #ifdef IPA_ON_R3PC
 	uint32_t mmap_offset;
 #endif
 
 	uint16_t cur_tbl_cnt;
 	uint16_t cur_expn_tbl_cnt;
+
+	/* bucket the next compaction pass starts at */
+	uint16_t compact_cursor;
 };
 
 struct ipa_nat_cache {
@@ -352,6 +359,27 @@ struct ipa_nat_cache {
 	enum ipa_hw_type ver;
 };
 
+/**
+ * struct ipa_nat_dev_ops - access to the ipa and nat table devices
+ * @dev_open: open a device node
+ * @dev_close: close a device node
+ * @dev_ioctl: post an IPA_IOC_* command
+ * @dev_mmap: map the nat table memory
+ * @dev_munmap: unmap the nat table memory
+ *
+ * Every device access of the driver goes through these,
+ * so a stand-in backend (e.g. the table simulator of the
+ * nat tests) can run the driver without ipa hw
+ */
+struct ipa_nat_dev_ops {
+	int (*dev_open)(const char *path, int flags);
+	int (*dev_close)(int fd);
+	int (*dev_ioctl)(int fd, unsigned long req, void *arg);
+	void *(*dev_mmap)(void *addr, size_t len, int prot,
+				int flags, int fd, off_t offset);
+	int (*dev_munmap)(void *addr, size_t len);
+};
+
 struct ipa_nat_indx_tbl_sw_rule {
 	uint16_t tbl_entry;
 	uint16_t next_index;
@@ -405,6 +433,16 @@ uint32_t ipa_nati_get_entry_offset(
 				nat_table_type tbl_type,
 				uint16_t  tbl_entry);
 
+/**
+ * ipa_nati_set_dev_ops() - replace the device backend
+ * @ops: [in] backend to use, NULL restores the ipa devices
+ *
+ * Must be called before the first table is added
+ *
+ * Returns:	None
+ */
+void ipa_nati_set_dev_ops(const struct ipa_nat_dev_ops *ops);
+
 int ipa_nati_add_ipv4_tbl(uint32_t public_ip_addr,
 				uint16_t number_of_entries,
 				uint32_t *table_hanle);
@@ -426,8 +464,29 @@ int ipa_nati_query_timestamp(uint32_t  tbl_hdl,
 				uint32_t  rule_hdl,
 				uint32_t  *time_stamp);
 
+int ipa_nati_query_timestamps(uint32_t  tbl_hdl,
+				uint32_t  num_rules,
+				const uint32_t  *rule_hdls,
+				uint32_t  *time_stamps);
+
 int ipa_nati_modify_pdn(struct ipa_ioc_nat_pdn_entry *entry);
 
+/**
+ * ipa_nati_post_nat_dma_cmd() - post a nat dma command
+ * @cmd: [in] table words to write, the hw writes them in order
+ *
+ * Returns:	0 on success, negative on failure
+ */
+int ipa_nati_post_nat_dma_cmd(struct ipa_ioc_nat_dma_cmd *cmd);
+
+int ipa_nati_get_chain_stats(uint32_t tbl_hdl,
+				ipa_nat_chain_stats *rule_stats,
+				ipa_nat_chain_stats *index_stats);
+
+int ipa_nati_compact_ipv4_tbl(uint32_t tbl_hdl,
+				uint16_t max_moves,
+				uint16_t *moves);
+
 int ipa_nati_add_ipv4_rule(uint32_t tbl_hdl,
 				const ipa_nat_ipv4_rule *clnt_rule,
 				uint32_t *rule_hdl);
@@ -491,9 +550,16 @@ void ipa_nati_find_rule_pos(struct ipa_nat_ip4_table_cache *cache_ptr,
 				del_type *rule_pos);
 void ipa_nati_del_dead_ipv4_head_nodes(uint8_t tbl_indx);
 
+uint8_t Read8BitFieldValue(uint32_t param,
+				ipa_nat_rule_field_type fld_type);
+
 uint16_t Read16BitFieldValue(uint32_t param,
 				ipa_nat_rule_field_type fld_type);
 
+void UpdateSwSpecParams(struct ipa_nat_rule *rule,
+				uint8_t param_type,
+				uint32_t value);
+
 /* ========================================================
 								Debug functions
    ========================================================*/
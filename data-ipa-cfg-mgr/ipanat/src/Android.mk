@@ -15,7 +15,8 @@ LOCAL_C_INCLUDES += $(LOCAL_PATH)
 LOCAL_HEADER_LIBRARIES := generated_kernel_headers
 
 LOCAL_SRC_FILES := ipa_nat_drv.c \
-                   ipa_nat_drvi.c
+                   ipa_nat_drvi.c \
+                   ipa_nat_compact.c
 
 
 LOCAL_MODULE_PATH_64 := $(TARGET_OUT_VENDOR)/lib64
@@ -0,0 +1,481 @@
+/*
+Copyright (c) 2018, The Linux Foundation. All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+    * Neither the name of The Linux Foundation nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ipa_nat_drv.h"
+#include "ipa_nat_drvi.h"
+
+extern struct ipa_nat_cache ipv4_nat_cache;
+extern pthread_mutex_t nat_mutex;
+
+/* ------------------------------------------
+		CHAIN WALK HELPERS
+	 --------------------------------------------*/
+
+/* a deleted head keeps its chain, the invalid protocol stops it matching */
+static int ipa_nati_is_dead_rule(struct ipa_nat_rule *rule)
+{
+	return (Read8BitFieldValue(rule->ts_proto, PROTOCOL_FIELD) ==
+					IPA_NAT_INVALID_PROTO_FIELD_CMP);
+}
+
+static void ipa_nati_add_chain(ipa_nat_chain_stats *stats, uint32_t len)
+{
+	if (len == 0)
+		return;
+
+	stats->used++;
+	stats->entries += len;
+	if (len > stats->longest)
+		stats->longest = len;
+	if (len > IPA_NAT_CHAIN_HIST_SIZE)
+		len = IPA_NAT_CHAIN_HIST_SIZE;
+	stats->hist[len - 1]++;
+}
+
+static void ipa_nati_rule_chain_stats(struct ipa_nat_ip4_table_cache *cache_ptr,
+				ipa_nat_chain_stats *stats)
+{
+	struct ipa_nat_rule *tbl_ptr =
+		(struct ipa_nat_rule *)cache_ptr->ipv4_rules_addr;
+	struct ipa_nat_rule *expn_tbl_ptr =
+		(struct ipa_nat_rule *)cache_ptr->ipv4_expn_rules_addr;
+	struct ipa_nat_rule *rule;
+	uint16_t cnt, next;
+	uint32_t len;
+
+	memset(stats, 0, sizeof(*stats));
+	stats->buckets = cache_ptr->table_entries;
+
+	for (cnt = 0; cnt < cache_ptr->table_entries; cnt++) {
+		rule = &tbl_ptr[cnt];
+		len = 0;
+
+		while (Read16BitFieldValue(rule->ip_cksm_enbl, ENABLE_FIELD)) {
+			len++;
+			if (ipa_nati_is_dead_rule(rule))
+				stats->dead++;
+			else
+				stats->reads += len;
+
+			next = Read16BitFieldValue(rule->nxt_indx_pub_port, NEXT_INDEX_FIELD);
+			if (next == IPA_NAT_INVALID_NAT_ENTRY)
+				break;
+			next -= cache_ptr->table_entries;
+			/* a loop or a stray index, stop instead of spinning */
+			if (next >= cache_ptr->expn_table_entries ||
+				len > cache_ptr->expn_table_entries) {
+				IPAERR("broken chain at bucket %d\n", cnt);
+				break;
+			}
+			rule = &expn_tbl_ptr[next];
+		}
+		ipa_nati_add_chain(stats, len);
+	}
+}
+
+static void ipa_nati_index_chain_stats(struct ipa_nat_ip4_table_cache *cache_ptr,
+				ipa_nat_chain_stats *stats)
+{
+	struct ipa_nat_indx_tbl_rule *indx_tbl_ptr =
+		(struct ipa_nat_indx_tbl_rule *)cache_ptr->index_table_addr;
+	struct ipa_nat_indx_tbl_rule *indx_expn_tbl_ptr =
+		(struct ipa_nat_indx_tbl_rule *)cache_ptr->index_table_expn_addr;
+	struct ipa_nat_indx_tbl_rule *indx_rule;
+	uint16_t cnt, next;
+	uint32_t len;
+
+	memset(stats, 0, sizeof(*stats));
+	stats->buckets = cache_ptr->table_entries;
+
+	for (cnt = 0; cnt < cache_ptr->table_entries; cnt++) {
+		indx_rule = &indx_tbl_ptr[cnt];
+		len = 0;
+
+		while (1) {
+			next = Read16BitFieldValue(indx_rule->tbl_entry_nxt_indx,
+									INDX_TBL_NEXT_INDEX_FILED);
+			if (Read16BitFieldValue(indx_rule->tbl_entry_nxt_indx,
+									INDX_TBL_TBL_ENTRY_FIELD)) {
+				len++;
+				stats->reads += len;
+			} else if (next != IPA_NAT_INVALID_NAT_ENTRY) {
+				/* emptied head still holding a chain */
+				len++;
+				stats->dead++;
+			}
+
+			if (next == IPA_NAT_INVALID_NAT_ENTRY)
+				break;
+			next -= cache_ptr->table_entries;
+			if (next >= cache_ptr->expn_table_entries ||
+				len > cache_ptr->expn_table_entries) {
+				IPAERR("broken index chain at bucket %d\n", cnt);
+				break;
+			}
+			indx_rule = &indx_expn_tbl_ptr[next];
+		}
+		ipa_nati_add_chain(stats, len);
+	}
+}
+
+/* ------------------------------------------
+		COMPACTION
+	 --------------------------------------------*/
+
+/* the hw writes of one move, flags/protocol, index entry and next index */
+#define IPA_NAT_COMPACT_DMA_ENTRIES 4
+
+static void ipa_nati_add_dma(struct ipa_ioc_nat_dma_cmd *cmd,
+				uint8_t tbl_indx,
+				nat_table_type tbl_type,
+				uint32_t offset,
+				uint16_t data)
+{
+	struct ipa_ioc_nat_dma_one *dma = &cmd->dma[cmd->entries++];
+
+	dma->table_index = tbl_indx;
+	dma->base_addr = tbl_type;
+	dma->offset = offset;
+	dma->data = data;
+}
+
+/* point the rule handle of an entry at the entry's new place */
+static void ipa_nati_move_rule_id(struct ipa_nat_ip4_table_cache *cache_ptr,
+				uint16_t expn_entry, uint16_t tbl_entry)
+{
+	uint16_t old_id, rule_hdl;
+
+	old_id = (expn_entry << IPA_NAT_RULE_HDL_TBL_TYPE_BITS) |
+		IPA_NAT_RULE_HDL_TBL_TYPE_MASK;
+
+	/* a deleted rule leaves its handle behind, so check it still maps here */
+	rule_hdl = cache_ptr->entry_hdl_array[cache_ptr->table_entries + expn_entry];
+	if (rule_hdl == 0 || cache_ptr->rule_id_array[rule_hdl - 1] != old_id) {
+		IPAERR("no rule handle for expansion entry %d\n", expn_entry);
+		return;
+	}
+
+	cache_ptr->rule_id_array[rule_hdl - 1] =
+		(tbl_entry << IPA_NAT_RULE_HDL_TBL_TYPE_BITS);
+	cache_ptr->entry_hdl_array[tbl_entry] = rule_hdl;
+	cache_ptr->entry_hdl_array[cache_ptr->table_entries + expn_entry] = 0;
+	cache_ptr->cur_expn_tbl_cnt--;
+	cache_ptr->cur_tbl_cnt++;
+}
+
+/**
+ * ipa_nati_promote_rule() - replace a dead head by the next rule
+ * @cache_ptr: [in] table
+ * @tbl_indx: [in] index of the table
+ * @cmd: [in] scratch dma command
+ * @head: [in] base table entry of the dead head
+ *
+ * The hw may walk the chain at any time and never matches
+ * the dead head, so the cpu fills in its rule but for the
+ * flags, protocol and next index. Those, and the index
+ * entry of the rule, go in one dma command: the head
+ * matches once its protocol is written, then the index
+ * entry is repointed and the expansion copy unlinked.
+ *
+ * Returns:	1 when an expansion entry was freed, 0 otherwise
+ */
+static int ipa_nati_promote_rule(struct ipa_nat_ip4_table_cache *cache_ptr,
+				uint8_t tbl_indx,
+				struct ipa_ioc_nat_dma_cmd *cmd,
+				uint16_t head)
+{
+	struct ipa_nat_rule *tbl_ptr =
+		(struct ipa_nat_rule *)cache_ptr->ipv4_rules_addr;
+	struct ipa_nat_rule *expn_tbl_ptr =
+		(struct ipa_nat_rule *)cache_ptr->ipv4_expn_rules_addr;
+	struct ipa_nat_rule *head_rule = &tbl_ptr[head];
+	struct ipa_nat_rule *rule;
+	nat_table_type indx_tbl_type;
+	uint32_t head_offset, temp;
+	uint16_t next, expn_entry, after, indx_entry;
+
+	head_offset = ipa_nati_get_entry_offset(cache_ptr, IPA_NAT_BASE_TBL, head);
+	cmd->entries = 0;
+
+	next = Read16BitFieldValue(head_rule->nxt_indx_pub_port, NEXT_INDEX_FIELD);
+	if (next == IPA_NAT_INVALID_NAT_ENTRY) {
+		/* nothing left behind the dead head, disable and free it */
+		ipa_nati_add_dma(cmd, tbl_indx, IPA_NAT_BASE_TBL,
+						 head_offset + IPA_NAT_RULE_FLAG_FIELD_OFFSET,
+						 IPA_NAT_FLAG_DISABLE_BIT_MASK);
+		if (ipa_nati_post_nat_dma_cmd(cmd))
+			return 0;
+		memset(head_rule, 0, sizeof(*head_rule));
+		return 0;
+	}
+
+	expn_entry = next - cache_ptr->table_entries;
+	if (expn_entry >= cache_ptr->expn_table_entries) {
+		IPAERR("invalid next index %d at bucket %d\n", next, head);
+		return 0;
+	}
+	rule = &expn_tbl_ptr[expn_entry];
+	if (ipa_nati_is_dead_rule(rule))
+		return 0;
+
+	after = Read16BitFieldValue(rule->nxt_indx_pub_port, NEXT_INDEX_FIELD);
+	indx_entry = Read16BitFieldValue(rule->sw_spec_params,
+							SW_SPEC_PARAM_INDX_TBL_ENTRY_FIELD);
+
+	head_rule->private_ip = rule->private_ip;
+	head_rule->target_ip = rule->target_ip;
+
+	/* the public port shares its word with the next index the head keeps */
+	temp = rule->nxt_indx_pub_port;
+	((next_index_pub_port *)&temp)->next_index = next;
+	head_rule->nxt_indx_pub_port = temp;
+
+	head_rule->private_port = rule->private_port;
+	head_rule->target_port = rule->target_port;
+
+	/* low halves only, the flags and the protocol are written by dma */
+	head_rule->ip_cksm_enbl = (head_rule->ip_cksm_enbl & 0xFFFF0000) |
+		(rule->ip_cksm_enbl & 0xFFFF);
+	head_rule->ts_proto = (head_rule->ts_proto & 0xFFFF0000) |
+		(rule->ts_proto & 0xFFFF);
+
+	head_rule->rsvd2 = rule->rsvd2;
+	head_rule->rsvd3 = rule->rsvd3;
+	head_rule->pdn_index = rule->pdn_index;
+	head_rule->tcp_udp_chksum = rule->tcp_udp_chksum;
+
+	ipa_nati_add_dma(cmd, tbl_indx, IPA_NAT_BASE_TBL,
+					 head_offset + IPA_NAT_RULE_FLAG_FIELD_OFFSET,
+					 (uint16_t)(rule->ip_cksm_enbl >> 16));
+	/* the head matches from here on */
+	ipa_nati_add_dma(cmd, tbl_indx, IPA_NAT_BASE_TBL,
+					 head_offset + IPA_NAT_RULE_PROTO_FIELD_OFFSET,
+					 (uint16_t)(rule->ts_proto >> 16));
+
+	/* the index entry of the rule now points at the head */
+	if (indx_entry >= cache_ptr->table_entries) {
+		indx_tbl_type = IPA_NAT_INDEX_EXPN_TBL;
+		ipa_nati_add_dma(cmd, tbl_indx, indx_tbl_type,
+			ipa_nati_get_index_entry_offset(cache_ptr, indx_tbl_type,
+				indx_entry - cache_ptr->table_entries) +
+			IPA_NAT_INDEX_RULE_NAT_INDEX_FIELD_OFFSET, head);
+	} else {
+		indx_tbl_type = IPA_NAT_INDX_TBL;
+		ipa_nati_add_dma(cmd, tbl_indx, indx_tbl_type,
+			ipa_nati_get_index_entry_offset(cache_ptr, indx_tbl_type, indx_entry) +
+			IPA_NAT_INDEX_RULE_NAT_INDEX_FIELD_OFFSET, head);
+	}
+
+	/* unlink the expansion copy */
+	ipa_nati_add_dma(cmd, tbl_indx, IPA_NAT_BASE_TBL,
+					 head_offset + IPA_NAT_RULE_NEXT_FIELD_OFFSET, after);
+
+	if (ipa_nati_post_nat_dma_cmd(cmd))
+		return 0;
+
+	head_rule->sw_spec_params = 0;
+	UpdateSwSpecParams(head_rule, IPA_NAT_SW_PARAM_INDX_TBL_ENTRY_BYTE, indx_entry);
+	if (after != IPA_NAT_INVALID_NAT_ENTRY)
+		UpdateSwSpecParams(&expn_tbl_ptr[after - cache_ptr->table_entries],
+						 IPA_NAT_SW_PARAM_PREV_INDX_BYTE, head);
+
+	ipa_nati_move_rule_id(cache_ptr, expn_entry, head);
+	memset(rule, 0, sizeof(*rule));
+	return 1;
+}
+
+/**
+ * ipa_nati_promote_index_rule() - replace an emptied index head
+ * @cache_ptr: [in] table
+ * @tbl_indx: [in] index of the table
+ * @cmd: [in] scratch dma command
+ * @head: [in] index table entry of the emptied head
+ *
+ * The head takes over the nat entry and then the next index
+ * of its successor in one dma command, after which that
+ * successor is freed.
+ *
+ * Returns:	1 when an index expansion entry was freed, 0 otherwise
+ */
+static int ipa_nati_promote_index_rule(struct ipa_nat_ip4_table_cache *cache_ptr,
+				uint8_t tbl_indx,
+				struct ipa_ioc_nat_dma_cmd *cmd,
+				uint16_t head)
+{
+	struct ipa_nat_rule *tbl_ptr =
+		(struct ipa_nat_rule *)cache_ptr->ipv4_rules_addr;
+	struct ipa_nat_rule *expn_tbl_ptr =
+		(struct ipa_nat_rule *)cache_ptr->ipv4_expn_rules_addr;
+	struct ipa_nat_indx_tbl_rule *indx_tbl_ptr =
+		(struct ipa_nat_indx_tbl_rule *)cache_ptr->index_table_addr;
+	struct ipa_nat_indx_tbl_rule *indx_expn_tbl_ptr =
+		(struct ipa_nat_indx_tbl_rule *)cache_ptr->index_table_expn_addr;
+	struct ipa_nat_rule *rule;
+	uint32_t head_offset;
+	uint16_t next, expn_entry, after, tbl_entry;
+
+	next = Read16BitFieldValue(indx_tbl_ptr[head].tbl_entry_nxt_indx,
+							INDX_TBL_NEXT_INDEX_FILED);
+	expn_entry = next - cache_ptr->table_entries;
+	if (expn_entry >= cache_ptr->expn_table_entries) {
+		IPAERR("invalid next index %d at index bucket %d\n", next, head);
+		return 0;
+	}
+
+	tbl_entry = Read16BitFieldValue(indx_expn_tbl_ptr[expn_entry].tbl_entry_nxt_indx,
+								INDX_TBL_TBL_ENTRY_FIELD);
+	after = Read16BitFieldValue(indx_expn_tbl_ptr[expn_entry].tbl_entry_nxt_indx,
+							INDX_TBL_NEXT_INDEX_FILED);
+	if (tbl_entry == IPA_NAT_INVALID_NAT_ENTRY)
+		return 0;
+
+	head_offset = ipa_nati_get_index_entry_offset(cache_ptr, IPA_NAT_INDX_TBL, head);
+	cmd->entries = 0;
+	ipa_nati_add_dma(cmd, tbl_indx, IPA_NAT_INDX_TBL,
+					 head_offset + IPA_NAT_INDEX_RULE_NAT_INDEX_FIELD_OFFSET, tbl_entry);
+	ipa_nati_add_dma(cmd, tbl_indx, IPA_NAT_INDX_TBL,
+					 head_offset + IPA_NAT_INDEX_RULE_NEXT_FIELD_OFFSET, after);
+	if (ipa_nati_post_nat_dma_cmd(cmd))
+		return 0;
+
+	if (tbl_entry >= cache_ptr->table_entries)
+		rule = &expn_tbl_ptr[tbl_entry - cache_ptr->table_entries];
+	else
+		rule = &tbl_ptr[tbl_entry];
+	UpdateSwSpecParams(rule, IPA_NAT_SW_PARAM_INDX_TBL_ENTRY_BYTE, head);
+
+	if (after != IPA_NAT_INVALID_NAT_ENTRY)
+		cache_ptr->index_expn_table_meta[after - cache_ptr->table_entries].prev_index = head;
+
+	memset(&indx_expn_tbl_ptr[expn_entry], 0, sizeof(struct ipa_nat_indx_tbl_rule));
+	cache_ptr->index_expn_table_meta[expn_entry].prev_index = 0;
+	return 1;
+}
+
+/* ------------------------------------------
+		Main Functions
+	 --------------------------------------------*/
+
+int ipa_nati_get_chain_stats(uint32_t tbl_hdl,
+				ipa_nat_chain_stats *rule_stats,
+				ipa_nat_chain_stats *index_stats)
+{
+	struct ipa_nat_ip4_table_cache *cache_ptr =
+		&ipv4_nat_cache.ip4_tbl[tbl_hdl - 1];
+
+	if (!cache_ptr->valid) {
+		IPAERR("invalid table handle\n");
+		return -EINVAL;
+	}
+
+	if (pthread_mutex_lock(&nat_mutex) != 0) {
+		IPAERR("unable to lock the nat mutex\n");
+		return -1;
+	}
+
+	ipa_nati_rule_chain_stats(cache_ptr, rule_stats);
+	ipa_nati_index_chain_stats(cache_ptr, index_stats);
+
+	if (pthread_mutex_unlock(&nat_mutex) != 0) {
+		IPAERR("unable to unlock the nat mutex\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+int ipa_nati_compact_ipv4_tbl(uint32_t tbl_hdl,
+				uint16_t max_moves,
+				uint16_t *moves)
+{
+	struct ipa_nat_ip4_table_cache *cache_ptr =
+		&ipv4_nat_cache.ip4_tbl[tbl_hdl - 1];
+	struct ipa_nat_rule *tbl_ptr;
+	struct ipa_nat_indx_tbl_rule *indx_tbl_ptr;
+	struct ipa_ioc_nat_dma_cmd *cmd;
+	uint8_t tbl_indx = (uint8_t)(tbl_hdl - 1);
+	uint16_t cnt, bucket;
+
+	*moves = 0;
+	if (!cache_ptr->valid) {
+		IPAERR("invalid table handle\n");
+		return -EINVAL;
+	}
+
+	cmd = (struct ipa_ioc_nat_dma_cmd *)
+		malloc(sizeof(struct ipa_ioc_nat_dma_cmd) +
+			   IPA_NAT_COMPACT_DMA_ENTRIES * sizeof(struct ipa_ioc_nat_dma_one));
+	if (NULL == cmd) {
+		IPAERR("unable to allocate dma command\n");
+		return -ENOMEM;
+	}
+
+	if (pthread_mutex_lock(&nat_mutex) != 0) {
+		IPAERR("unable to lock the nat mutex\n");
+		free(cmd);
+		return -1;
+	}
+
+	tbl_ptr = (struct ipa_nat_rule *)cache_ptr->ipv4_rules_addr;
+	indx_tbl_ptr = (struct ipa_nat_indx_tbl_rule *)cache_ptr->index_table_addr;
+
+	bucket = cache_ptr->compact_cursor;
+	for (cnt = 0; cnt < cache_ptr->table_entries; cnt++) {
+		if (max_moves && *moves >= max_moves)
+			break;
+
+		if (bucket >= cache_ptr->table_entries)
+			bucket = 0;
+
+		if (Read16BitFieldValue(tbl_ptr[bucket].ip_cksm_enbl, ENABLE_FIELD) &&
+			ipa_nati_is_dead_rule(&tbl_ptr[bucket])) {
+			*moves += ipa_nati_promote_rule(cache_ptr, tbl_indx, cmd, bucket);
+		}
+
+		if (!Read16BitFieldValue(indx_tbl_ptr[bucket].tbl_entry_nxt_indx,
+								INDX_TBL_TBL_ENTRY_FIELD) &&
+			Read16BitFieldValue(indx_tbl_ptr[bucket].tbl_entry_nxt_indx,
+								INDX_TBL_NEXT_INDEX_FILED)) {
+			*moves += ipa_nati_promote_index_rule(cache_ptr, tbl_indx, cmd, bucket);
+		}
+
+		bucket++;
+	}
+	cache_ptr->compact_cursor = bucket;
+
+	if (pthread_mutex_unlock(&nat_mutex) != 0) {
+		IPAERR("unable to unlock the nat mutex\n");
+		free(cmd);
+		return -1;
+	}
+	free(cmd);
+
+	IPADBG("compacted %d entries, next pass starts at bucket %d\n", *moves, bucket);
+	return 0;
+}
@@ -172,6 +172,77 @@ int ipa_nat_query_timestamp(uint32_t  tbl_hdl,
   return ipa_nati_query_timestamp(tbl_hdl, rule_hdl, time_stamp);
 }
 
+/**
+ * ipa_nat_query_timestamps() - to query timestamps of many rules
+ * @table_handle: [in] handle of ipv4 nat table
+ * @num_rules: [in] number of rule handles
+ * @rule_handles: [in] ipv4 nat rule handles
+ * @time_stamps: [out] time stamp of each rule
+ *
+ * Same as ipa_nat_query_timestamp() for every rule
+ * handle, read in one pass under one lock
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_query_timestamps(uint32_t  tbl_hdl,
+		uint32_t  num_rules,
+		const uint32_t  *rule_hdls,
+		uint32_t  *time_stamps)
+{
+
+  if (0 == tbl_hdl || tbl_hdl > IPA_NAT_MAX_IP4_TBLS ||
+      NULL == rule_hdls || NULL == time_stamps) {
+    IPAERR("invalid parameters passed \n");
+    return -EINVAL;
+  }
+  IPADBG("Passed Table: 0x%x and %d rule handles\n", tbl_hdl, num_rules);
+
+  return ipa_nati_query_timestamps(tbl_hdl, num_rules, rule_hdls, time_stamps);
+}
+
+/**
+ * ipa_nat_get_chain_stats() - read the chain statistics
+ * @table_handle: [in] handle of ipv4 nat table
+ * @rule_stats: [out] chains of the nat table
+ * @index_stats: [out] chains of the index table
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_get_chain_stats(uint32_t  tbl_hdl,
+		ipa_nat_chain_stats *rule_stats,
+		ipa_nat_chain_stats *index_stats)
+{
+  if (0 == tbl_hdl || tbl_hdl > IPA_NAT_MAX_IP4_TBLS ||
+      NULL == rule_stats || NULL == index_stats) {
+    IPAERR("invalid parameters passed \n");
+    return -EINVAL;
+  }
+
+  return ipa_nati_get_chain_stats(tbl_hdl, rule_stats, index_stats);
+}
+
+/**
+ * ipa_nat_compact_ipv4_tbl() - shorten the chains of a table
+ * @table_handle: [in] handle of ipv4 nat table
+ * @max_moves: [in] entries to move in this call, 0 for no limit
+ * @moves: [out] entries moved
+ *
+ * Returns:	0  On Success, negative on failure
+ */
+int ipa_nat_compact_ipv4_tbl(uint32_t  tbl_hdl,
+		uint16_t  max_moves,
+		uint16_t  *moves)
+{
+  if (0 == tbl_hdl || tbl_hdl > IPA_NAT_MAX_IP4_TBLS ||
+      NULL == moves) {
+    IPAERR("invalid parameters passed \n");
+    return -EINVAL;
+  }
+  IPADBG("Passed Table: 0x%x, max moves %d\n", tbl_hdl, max_moves);
+
+  return ipa_nati_compact_ipv4_tbl(tbl_hdl, max_moves, moves);
+}
+
 
 /**
 * ipa_nat_modify_pdn() - modify single PDN entry in the PDN config table
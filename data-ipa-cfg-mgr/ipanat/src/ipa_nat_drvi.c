@@ -51,6 +51,31 @@ pthread_mutex_t nat_mutex    = PTHREAD_MUTEX_INITIALIZER;
 
 static ipa_nat_pdn_entry pdns[IPA_MAX_PDN_NUM];
 
+static int ipa_nati_dev_open(const char *path, int flags)
+{
+	return open(path, flags);
+}
+
+static int ipa_nati_dev_ioctl(int fd, unsigned long req, void *arg)
+{
+	return ioctl(fd, req, arg);
+}
+
+static const struct ipa_nat_dev_ops ipa_nat_hw_ops = {
+	.dev_open = ipa_nati_dev_open,
+	.dev_close = close,
+	.dev_ioctl = ipa_nati_dev_ioctl,
+	.dev_mmap = mmap,
+	.dev_munmap = munmap,
+};
+
+static const struct ipa_nat_dev_ops *dev_ops = &ipa_nat_hw_ops;
+
+void ipa_nati_set_dev_ops(const struct ipa_nat_dev_ops *ops)
+{
+	dev_ops = (ops) ? ops : &ipa_nat_hw_ops;
+}
+
 /* ------------------------------------------
 		UTILITY FUNCTIONS START
 	 --------------------------------------------*/
@@ -176,7 +201,7 @@ int GetIPAVer(void)
 {
 	int ret;
 
-	ret = ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_GET_HW_VERSION, &ipv4_nat_cache.ver);
+	ret = dev_ops->dev_ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_GET_HW_VERSION, &ipv4_nat_cache.ver);
 	if (ret != 0) {
 		perror("GetIPAVer(): ioctl error value");
 		IPAERR("unable to get IPA version. Error ;%d\n", ret);
@@ -201,7 +226,7 @@ int CreateNatDevice(struct ipa_ioc_nat_alloc_mem *mem)
 {
 	int ret;
 
-	ret = ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_ALLOC_NAT_MEM, mem);
+	ret = dev_ops->dev_ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_ALLOC_NAT_MEM, mem);
 	if (ret != 0) {
 		perror("CreateNatDevice(): ioctl error value");
 		IPAERR("unable to post nat mem init. Error ;%d\n", ret);
@@ -543,6 +568,7 @@ uint16_t ipa_nati_make_rule_hdl(uint16_t tbl_hdl,
 	for (; cnt < (tbl_ptr->table_entries + tbl_ptr->expn_table_entries); cnt++) {
 		if (IPA_NAT_INVALID_NAT_ENTRY == tbl_ptr->rule_id_array[cnt]) {
 			tbl_ptr->rule_id_array[cnt] = rule_hdl;
+			tbl_ptr->entry_hdl_array[tbl_entry] = cnt + 1;
 			return cnt + 1;
 		}
 	}
@@ -770,7 +796,7 @@ int ipa_nati_alloc_table(uint16_t number_of_entries,
 	IPADBG("Nat Base and Index Table size: %zu\n", mem->size);
 
 	if (!ipv4_nat_cache.ipa_fd) {
-		fd = open(IPA_DEV_NAME, O_RDONLY);
+		fd = dev_ops->dev_open(IPA_DEV_NAME, O_RDONLY);
 		if (fd < 0) {
 			perror("ipa_nati_alloc_table(): open error value:");
 			IPAERR("unable to open ipa device\n");
@@ -847,10 +873,25 @@ int ipa_nati_update_cache(struct ipa_ioc_nat_alloc_mem *mem,
 					 sizeof(uint16_t) * (tbl_entries + expn_tbl_entries));
 	}
 
+	/* Allocate memory for entry_hdl_array */
+	if (NULL == ipv4_nat_cache.ip4_tbl[index].entry_hdl_array) {
+		ipv4_nat_cache.ip4_tbl[index].entry_hdl_array =
+			 malloc(sizeof(uint16_t) * (tbl_entries + expn_tbl_entries));
+
+		if (NULL == ipv4_nat_cache.ip4_tbl[index].entry_hdl_array) {
+			IPAERR("Fail to allocate entry handle array\n");
+			return 0;
+		}
+
+		memset(ipv4_nat_cache.ip4_tbl[index].entry_hdl_array,
+					 0,
+					 sizeof(uint16_t) * (tbl_entries + expn_tbl_entries));
+	}
+
 
 	/* open the nat table */
 	strlcpy(mem->dev_name, NAT_DEV_FULL_NAME, IPA_RESOURCE_NAME_MAX);
-	fd = open(mem->dev_name, O_RDWR);
+	fd = dev_ops->dev_open(mem->dev_name, O_RDWR);
 	if (fd < 0) {
 		perror("ipa_nati_update_cache(): open error value:");
 		IPAERR("unable to open nat device. Error:%d\n", fd);
@@ -865,12 +906,12 @@ int ipa_nati_update_cache(struct ipa_ioc_nat_alloc_mem *mem,
 
 	/* open the nat device Table */
 #ifndef IPA_ON_R3PC
-	ipv4_rules_addr = (void *)mmap(NULL, mem->size,
+	ipv4_rules_addr = (void *)dev_ops->dev_mmap(NULL, mem->size,
 																 prot, flags,
 																 fd, offset);
 #else
 	IPADBG("user space r3pc\n");
-	ipv4_rules_addr = (void *)mmap((caddr_t)0, NAT_MMAP_MEM_SIZE,
+	ipv4_rules_addr = (void *)dev_ops->dev_mmap((caddr_t)0, NAT_MMAP_MEM_SIZE,
 																 prot, flags,
 																 fd, offset);
 #endif
@@ -880,7 +921,7 @@ int ipa_nati_update_cache(struct ipa_ioc_nat_alloc_mem *mem,
 	}
 
 #ifdef IPA_ON_R3PC
-	ret = ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_GET_NAT_OFFSET, &nat_mem_offset);
+	ret = dev_ops->dev_ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_GET_NAT_OFFSET, &nat_mem_offset);
 	if (ret != 0) {
 		perror("ipa_nati_post_ipv4_init_cmd(): ioctl error value");
 		IPAERR("unable to post ant offset cmd Error: %d\n", ret);
@@ -934,7 +975,7 @@ int ipa_nati_post_ipv4_init_cmd(uint8_t tbl_index)
 
 	cmd.ip_addr = ipv4_nat_cache.ip4_tbl[tbl_index].public_addr;
 
-	ret = ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_V4_INIT_NAT, &cmd);
+	ret = dev_ops->dev_ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_V4_INIT_NAT, &cmd);
 	if (ret != 0) {
 		perror("ipa_nati_post_ipv4_init_cmd(): ioctl error value");
 		IPAERR("unable to post init cmd Error: %d\n", ret);
@@ -966,14 +1007,14 @@ int ipa_nati_del_ipv4_table(uint32_t tbl_hdl)
 
 	/* unmap the device memory from user space */
 #ifndef IPA_ON_R3PC
-	munmap(addr, ipv4_nat_cache.ip4_tbl[index].size);
+	dev_ops->dev_munmap(addr, ipv4_nat_cache.ip4_tbl[index].size);
 #else
 	addr = (char *)addr - ipv4_nat_cache.ip4_tbl[index].mmap_offset;
-	munmap(addr, NAT_MMAP_MEM_SIZE);
+	dev_ops->dev_munmap(addr, NAT_MMAP_MEM_SIZE);
 #endif
 
 	/* close the file descriptor of nat device */
-	if (close(ipv4_nat_cache.ip4_tbl[index].nat_fd)) {
+	if (dev_ops->dev_close(ipv4_nat_cache.ip4_tbl[index].nat_fd)) {
 		IPAERR("unable to close the file descriptor\n");
 		ret = -EINVAL;
 		if (pthread_mutex_unlock(&nat_mutex) != 0)
@@ -983,7 +1024,7 @@ int ipa_nati_del_ipv4_table(uint32_t tbl_hdl)
 
 	del_cmd.table_index = index;
 	del_cmd.public_ip_addr = ipv4_nat_cache.ip4_tbl[index].public_addr;
-	ret = ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_V4_DEL_NAT, &del_cmd);
+	ret = dev_ops->dev_ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_V4_DEL_NAT, &del_cmd);
 	if (ret != 0) {
 		perror("ipa_nati_del_ipv4_table(): ioctl error value");
 		IPAERR("unable to post nat del command init Error: %d\n", ret);
@@ -997,6 +1038,7 @@ int ipa_nati_del_ipv4_table(uint32_t tbl_hdl)
 
 	free(ipv4_nat_cache.ip4_tbl[index].index_expn_table_meta);
 	free(ipv4_nat_cache.ip4_tbl[index].rule_id_array);
+	free(ipv4_nat_cache.ip4_tbl[index].entry_hdl_array);
 
 	memset(&ipv4_nat_cache.ip4_tbl[index],
 				 0,
@@ -1064,12 +1106,59 @@ int ipa_nati_query_timestamp(uint32_t  tbl_hdl,
 	return 0;
 }
 
+int ipa_nati_query_timestamps(uint32_t  tbl_hdl,
+				uint32_t  num_rules,
+				const uint32_t  *rule_hdls,
+				uint32_t  *time_stamps)
+{
+	uint8_t tbl_index = (uint8_t)(tbl_hdl - 1);
+	uint8_t expn_tbl = 0;
+	uint16_t tbl_entry = 0;
+	uint32_t cnt;
+	struct ipa_nat_rule *rules_ptr = NULL;
+	struct ipa_nat_rule *expn_rules_ptr = NULL;
+	struct ipa_nat_rule *tbl_ptr = NULL;
+
+	if (!ipv4_nat_cache.ip4_tbl[tbl_index].valid) {
+		IPAERR("invalid table handle\n");
+		return -EINVAL;
+	}
+
+	if (pthread_mutex_lock(&nat_mutex) != 0) {
+		IPAERR("unable to lock the nat mutex\n");
+		return -1;
+	}
+
+	/* both tables are mmapped, so this is a plain read of each rule */
+	rules_ptr =
+	(struct ipa_nat_rule *)ipv4_nat_cache.ip4_tbl[tbl_index].ipv4_rules_addr;
+	expn_rules_ptr =
+	(struct ipa_nat_rule *)ipv4_nat_cache.ip4_tbl[tbl_index].ipv4_expn_rules_addr;
+
+	for (cnt = 0; cnt < num_rules; cnt++) {
+		ipa_nati_parse_ipv4_rule_hdl(tbl_index, (uint16_t)rule_hdls[cnt],
+																 &expn_tbl, &tbl_entry);
+		tbl_ptr = (expn_tbl) ? expn_rules_ptr : rules_ptr;
+		time_stamps[cnt] = 0;
+		if (tbl_ptr)
+			time_stamps[cnt] = Read32BitFieldValue(tbl_ptr[tbl_entry].ts_proto,
+								TIME_STAMP_FIELD);
+	}
+
+	if (pthread_mutex_unlock(&nat_mutex) != 0) {
+		IPAERR("unable to unlock the nat mutex\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 int ipa_nati_modify_pdn(struct ipa_ioc_nat_pdn_entry *entry)
 {
 	if (entry->public_ip == 0)
 		IPADBG("PDN %d public ip will be set  to 0\n", entry->pdn_index);
 
-	if (ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_NAT_MODIFY_PDN, entry)) {
+	if (dev_ops->dev_ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_NAT_MODIFY_PDN, entry)) {
 		perror("ipa_nati_modify_pdn(): ioctl error value");
 		IPAERR("unable to call modify pdn icotl\n");
 		IPAERR("index %d, ip 0x%X, src_metdata 0x%X, dst_metadata 0x%X\n",
@@ -1088,6 +1177,18 @@ int ipa_nati_modify_pdn(struct ipa_ioc_nat_pdn_entry *entry)
 	return 0;
 }
 
+int ipa_nati_post_nat_dma_cmd(struct ipa_ioc_nat_dma_cmd *cmd)
+{
+	if (dev_ops->dev_ioctl(ipv4_nat_cache.ipa_fd, IPA_IOC_NAT_DMA, cmd)) {
+		perror("ipa_nati_post_nat_dma_cmd(): ioctl error value");
+		IPAERR("unable to post nat dma command with %d entries\n", cmd->entries);
+		IPADBG("ipa fd %d\n", ipv4_nat_cache.ipa_fd);
+		return -EIO;
+	}
+
+	return 0;
+}
+
 int ipa_nati_add_ipv4_rule(uint32_t tbl_hdl,
 				const ipa_nat_ipv4_rule *clnt_rule,
 				uint32_t *rule_hdl)
@@ -37,6 +37,8 @@ LOCAL_SRC_FILES := ipa_nat_test000.c \
 		ipa_nat_test020.c \
 		ipa_nat_test021.c \
 		ipa_nat_test022.c \
+		ipa_nat_sim.c \
+		ipa_nat_bench.c \
 		main.c
 
 
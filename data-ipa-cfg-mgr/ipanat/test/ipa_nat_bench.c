@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2018, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of The Linux Foundation nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*=========================================================================*/
+/*!
+	@file
+	ipa_nat_bench.c
+
+	@brief
+	Measures the nat driver on one table:
+	1. Rule add and delete throughput
+	2. Chain lengths of the base and index tables, i.e. how far the
+	   hw walks into the expansion tables per lookup
+	3. Spread of the rules over the hash buckets
+	4. The dead chain heads half the deletes leave, and what a
+	   compaction pass gets back
+
+	Runs against whatever backend the driver uses, "ipanattest sim bench"
+	runs it on the table simulator
+*/
+/*=========================================================================*/
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "ipa_nat_drv.h"
+#include "ipa_nat_drvi.h"
+#include "ipa_nat_test.h"
+
+extern struct ipa_nat_cache ipv4_nat_cache;
+
+static uint64_t ipa_nat_bench_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void ipa_nat_bench_print_chains(const char *name,
+				const ipa_nat_chain_stats *stats)
+{
+	uint32_t live = stats->entries - stats->dead;
+	int cnt;
+
+	printf("%s: %u/%u buckets used, %u rules, %u dead, longest chain %u, "
+			 "%.2f reads per lookup\n", name, stats->used, stats->buckets,
+			 live, stats->dead, stats->longest,
+			 (live) ? (double)stats->reads / live : 0.0);
+
+	printf("%s: chain length histogram:", name);
+	for (cnt = 0; cnt < IPA_NAT_CHAIN_HIST_SIZE; cnt++)
+		printf(" %d%s:%u", cnt + 1, (cnt == IPA_NAT_CHAIN_HIST_SIZE - 1) ? "+" : "",
+				 stats->hist[cnt]);
+	printf("\n");
+}
+
+static void ipa_nat_bench_chains(u32 tbl_hdl, const char *when)
+{
+	ipa_nat_chain_stats rule_stats, index_stats;
+
+	if (ipa_nat_get_chain_stats(tbl_hdl, &rule_stats, &index_stats)) {
+		IPAERR("unable to get chain stats\n");
+		return;
+	}
+	printf("-- %s\n", when);
+	ipa_nat_bench_print_chains("nat table", &rule_stats);
+	ipa_nat_bench_print_chains("index table", &index_stats);
+}
+
+static void ipa_nat_bench_gen_rule(ipa_nat_ipv4_rule *rule, unsigned int *seed)
+{
+	memset(rule, 0, sizeof(*rule));
+	rule->private_ip = 0xC0A80000 | (rand_r(seed) & 0xFFFF); /* 192.168.x.x */
+	rule->target_ip = ((uint32_t)rand_r(seed) << 16) ^ rand_r(seed);
+	rule->private_port = (uint16_t)(1024 + rand_r(seed) % 64511);
+	rule->target_port = (uint16_t)(1 + rand_r(seed) % 65535);
+	rule->public_port = (uint16_t)(1024 + rand_r(seed) % 64511);
+	rule->protocol = (rand_r(seed) & 1) ? IPPROTO_TCP : IPPROTO_UDP;
+}
+
+/**
+ * ipa_nat_bench() - run the nat driver benchmark
+ * @total_entries: [in] table size passed to ipa_nat_add_ipv4_tbl()
+ * @num_rules: [in] rules added per iteration, 0 fills the table
+ * @nt: [in] number of iterations
+ * @seed: [in] seed of the generated rules
+ *
+ * Returns:	0 on success, negative on failure
+ */
+int ipa_nat_bench(int total_entries, int num_rules, int nt, unsigned int seed)
+{
+	u32 pub_ip_add = 0x011617c0;   /* "192.23.22.1" */
+	u32 tbl_hdl = 0;
+	ipa_nat_ipv4_rule *rules;
+	u32 *rule_hdls;
+	uint64_t start, add_ns = 0, del_ns = 0, compact_ns = 0;
+	uint32_t added = 0, failed = 0, total_moves = 0;
+	uint16_t moves;
+	int cnt, iter, ret;
+
+	if (total_entries <= 0 || total_entries > 0xFFFF || num_rules < 0 || nt <= 0) {
+		IPAERR("invalid bench parameters\n");
+		return -EINVAL;
+	}
+	if (num_rules == 0)
+		num_rules = total_entries;
+
+	rules = malloc(sizeof(*rules) * num_rules);
+	rule_hdls = malloc(sizeof(*rule_hdls) * num_rules);
+	if (rules == NULL || rule_hdls == NULL) {
+		IPAERR("unable to allocate %d rules\n", num_rules);
+		free(rules);
+		free(rule_hdls);
+		return -ENOMEM;
+	}
+
+	ret = ipa_nat_add_ipv4_tbl(pub_ip_add, total_entries, &tbl_hdl);
+	if (ret) {
+		IPAERR("unable to add table of %d entries, %d\n", total_entries, ret);
+		goto fail;
+	}
+
+	printf("table: %d entries requested, %u base, %u expansion\n",
+			 total_entries, ipv4_nat_cache.ip4_tbl[tbl_hdl - 1].table_entries,
+			 ipv4_nat_cache.ip4_tbl[tbl_hdl - 1].expn_table_entries);
+
+	for (iter = 0; iter < nt; iter++) {
+		for (cnt = 0; cnt < num_rules; cnt++)
+			ipa_nat_bench_gen_rule(&rules[cnt], &seed);
+
+		start = ipa_nat_bench_ns();
+		for (cnt = 0; cnt < num_rules; cnt++) {
+			if (ipa_nat_add_ipv4_rule(tbl_hdl, &rules[cnt], &rule_hdls[cnt])) {
+				/* table full */
+				rule_hdls[cnt] = 0;
+				failed++;
+				continue;
+			}
+			added++;
+		}
+		add_ns += ipa_nat_bench_ns() - start;
+
+		/* the chains are the same shape each iteration, print the first */
+		if (iter == 0)
+			ipa_nat_bench_chains(tbl_hdl, "after add");
+
+		/* delete every other rule, then the rest, to leave dead chain
+			 heads behind the way long uptimes do */
+		start = ipa_nat_bench_ns();
+		for (cnt = 0; cnt < num_rules; cnt += 2) {
+			if (rule_hdls[cnt] &&
+				ipa_nat_del_ipv4_rule(tbl_hdl, rule_hdls[cnt])) {
+				IPAERR("unable to delete rule %d\n", cnt);
+			}
+		}
+		del_ns += ipa_nat_bench_ns() - start;
+
+		if (iter == 0)
+			ipa_nat_bench_chains(tbl_hdl, "after deleting half");
+
+		start = ipa_nat_bench_ns();
+		if (ipa_nat_compact_ipv4_tbl(tbl_hdl, 0, &moves)) {
+			IPAERR("unable to compact the table\n");
+		}
+		compact_ns += ipa_nat_bench_ns() - start;
+		total_moves += moves;
+
+		if (iter == 0) {
+			ipa_nat_bench_chains(tbl_hdl, "after compaction");
+			printf("compaction moved %u entries\n", moves);
+		}
+
+		start = ipa_nat_bench_ns();
+		for (cnt = 1; cnt < num_rules; cnt += 2) {
+			if (rule_hdls[cnt] &&
+				ipa_nat_del_ipv4_rule(tbl_hdl, rule_hdls[cnt])) {
+				IPAERR("unable to delete rule %d\n", cnt);
+			}
+		}
+		del_ns += ipa_nat_bench_ns() - start;
+	}
+
+	printf("add: %u rules, %u failed, %.0f ns per rule\n",
+			 added, failed, (added) ? (double)add_ns / added : 0.0);
+	printf("delete: %u rules, %.0f ns per rule\n",
+			 added, (added) ? (double)del_ns / added : 0.0);
+	printf("compaction: %u entries moved, %.0f ns per pass\n",
+			 total_moves, (double)compact_ns / nt);
+
+	ret = ipa_nat_del_ipv4_tbl(tbl_hdl);
+	if (ret)
+		IPAERR("unable to delete table, %d\n", ret);
+
+fail:
+	free(rules);
+	free(rule_hdls);
+	return ret;
+}
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2018, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of The Linux Foundation nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*=========================================================================*/
+/*!
+	@file
+	ipa_nat_sim.c
+
+	@brief
+	Backs the nat driver device accesses with plain memory. The ioctls
+	are checked the way the ipa kernel driver checks them, so layout
+	errors show up here the same as on target
+*/
+/*=========================================================================*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ipa_nat_drv.h"
+#include "ipa_nat_drvi.h"
+#include "ipa_nat_sim.h"
+
+#define IPA_NAT_SIM_IPA_FD  0x1a0
+#define IPA_NAT_SIM_TBL_FD  0x1a1
+
+static struct {
+	enum ipa_hw_type ver;
+	uint8_t tbl_open;
+	uint8_t tbl_inited;
+	size_t tbl_size;
+	void *tbl_mem;
+	size_t map_len;
+	/* start and size of the base, expansion, index and index
+	   expansion tables in tbl_mem, by nat_table_type */
+	uint32_t sub_offset[4];
+	uint32_t sub_size[4];
+	struct ipa_ioc_nat_pdn_entry pdns[IPA_MAX_PDN_NUM];
+	struct ipa_nat_sim_stats stats;
+} sim;
+
+static int ipa_nat_sim_open(const char *path, int flags)
+{
+	(void)flags;
+
+	sim.stats.opens++;
+	if (!strcmp(path, IPA_DEV_NAME))
+		return IPA_NAT_SIM_IPA_FD;
+
+	if (!strcmp(path, NAT_DEV_FULL_NAME)) {
+		/* the table device only exists once its memory is allocated */
+		if (!sim.tbl_size || sim.tbl_open) {
+			errno = ENOENT;
+			return -1;
+		}
+		sim.tbl_open = 1;
+		return IPA_NAT_SIM_TBL_FD;
+	}
+
+	errno = ENOENT;
+	return -1;
+}
+
+static int ipa_nat_sim_close(int fd)
+{
+	if (fd == IPA_NAT_SIM_TBL_FD && sim.tbl_open) {
+		sim.tbl_open = 0;
+		return 0;
+	}
+	if (fd == IPA_NAT_SIM_IPA_FD)
+		return 0;
+
+	errno = EBADF;
+	return -1;
+}
+
+static int ipa_nat_sim_init_tbl(const struct ipa_ioc_v4_nat_init *cmd)
+{
+	uint32_t entries = (uint32_t)cmd->table_entries + 1;
+	uint32_t end;
+
+	if (!sim.tbl_mem || cmd->tbl_index >= IPA_NAT_MAX_IP4_TBLS)
+		return -EINVAL;
+
+	/* base table size must be a power of 2 for the hw hash */
+	if (entries & (entries - 1))
+		return -EINVAL;
+
+	if (cmd->expn_rules_offset != cmd->ipv4_rules_offset +
+			entries * IPA_NAT_TABLE_ENTRY_SIZE ||
+		cmd->index_offset != cmd->expn_rules_offset +
+			cmd->expn_table_entries * IPA_NAT_TABLE_ENTRY_SIZE ||
+		cmd->index_expn_offset != cmd->index_offset +
+			entries * IPA_NAT_INDEX_TABLE_ENTRY_SIZE)
+		return -EINVAL;
+
+	end = cmd->index_expn_offset +
+		cmd->expn_table_entries * IPA_NAT_INDEX_TABLE_ENTRY_SIZE;
+	if (end > sim.tbl_size)
+		return -EINVAL;
+
+	sim.sub_offset[IPA_NAT_BASE_TBL] = cmd->ipv4_rules_offset;
+	sim.sub_size[IPA_NAT_BASE_TBL] = entries * IPA_NAT_TABLE_ENTRY_SIZE;
+	sim.sub_offset[IPA_NAT_EXPN_TBL] = cmd->expn_rules_offset;
+	sim.sub_size[IPA_NAT_EXPN_TBL] =
+		cmd->expn_table_entries * IPA_NAT_TABLE_ENTRY_SIZE;
+	sim.sub_offset[IPA_NAT_INDX_TBL] = cmd->index_offset;
+	sim.sub_size[IPA_NAT_INDX_TBL] = entries * IPA_NAT_INDEX_TABLE_ENTRY_SIZE;
+	sim.sub_offset[IPA_NAT_INDEX_EXPN_TBL] = cmd->index_expn_offset;
+	sim.sub_size[IPA_NAT_INDEX_EXPN_TBL] =
+		cmd->expn_table_entries * IPA_NAT_INDEX_TABLE_ENTRY_SIZE;
+
+	sim.tbl_inited = 1;
+	return 0;
+}
+
+/* each entry writes one 16 bit word at an offset into one of the
+   tables, in order, the way the hw runs the dma command list */
+static int ipa_nat_sim_dma(const struct ipa_ioc_nat_dma_cmd *cmd)
+{
+	const struct ipa_ioc_nat_dma_one *dma;
+	uint16_t *word;
+	int cnt;
+
+	if (!sim.tbl_inited || !sim.tbl_mem || !cmd->entries)
+		return -EINVAL;
+
+	/* the whole list is checked before anything is written */
+	for (cnt = 0; cnt < cmd->entries; cnt++) {
+		dma = &cmd->dma[cnt];
+		if (dma->table_index >= IPA_NAT_MAX_IP4_TBLS ||
+			dma->base_addr > IPA_NAT_INDEX_EXPN_TBL ||
+			(dma->offset & 1) ||
+			dma->offset + sizeof(uint16_t) > sim.sub_size[dma->base_addr])
+			return -EPERM;
+	}
+
+	for (cnt = 0; cnt < cmd->entries; cnt++) {
+		dma = &cmd->dma[cnt];
+		word = (uint16_t *)((char *)sim.tbl_mem +
+				sim.sub_offset[dma->base_addr] + dma->offset);
+		*word = dma->data;
+	}
+	sim.stats.dma_writes += cmd->entries;
+	return 0;
+}
+
+static int ipa_nat_sim_ioctl(int fd, unsigned long req, void *arg)
+{
+	struct ipa_ioc_nat_alloc_mem *mem;
+	struct ipa_ioc_nat_pdn_entry *pdn;
+	int ret = 0;
+
+	if (fd != IPA_NAT_SIM_IPA_FD) {
+		errno = EBADF;
+		return -1;
+	}
+	sim.stats.ioctls++;
+
+	switch (req) {
+	case IPA_IOC_GET_HW_VERSION:
+		*(enum ipa_hw_type *)arg = sim.ver;
+		break;
+
+	case IPA_IOC_ALLOC_NAT_MEM:
+		mem = (struct ipa_ioc_nat_alloc_mem *)arg;
+		if (sim.tbl_size || !mem->size) {
+			ret = -EINVAL;
+			break;
+		}
+		sim.tbl_size = mem->size;
+		mem->offset = 0;
+		break;
+
+	case IPA_IOC_GET_NAT_OFFSET:
+		*(uint32_t *)arg = 0;
+		break;
+
+	case IPA_IOC_V4_INIT_NAT:
+		ret = ipa_nat_sim_init_tbl((struct ipa_ioc_v4_nat_init *)arg);
+		break;
+
+	case IPA_IOC_NAT_DMA:
+		ret = ipa_nat_sim_dma((struct ipa_ioc_nat_dma_cmd *)arg);
+		break;
+
+	case IPA_IOC_V4_DEL_NAT:
+		if (!sim.tbl_inited || sim.tbl_mem) {
+			ret = -EINVAL;
+			break;
+		}
+		sim.tbl_inited = 0;
+		sim.tbl_size = 0;
+		break;
+
+	case IPA_IOC_NAT_MODIFY_PDN:
+		pdn = (struct ipa_ioc_nat_pdn_entry *)arg;
+		if (sim.ver < IPA_HW_v4_0 || pdn->pdn_index >= IPA_MAX_PDN_NUM) {
+			ret = -EINVAL;
+			break;
+		}
+		sim.pdns[pdn->pdn_index] = *pdn;
+		break;
+
+	default:
+		ret = -ENOTTY;
+		break;
+	}
+
+	if (ret) {
+		errno = -ret;
+		return -1;
+	}
+	return 0;
+}
+
+static void *ipa_nat_sim_mmap(void *addr, size_t len, int prot,
+				int flags, int fd, off_t offset)
+{
+	(void)addr;
+	(void)prot;
+	(void)flags;
+
+	if (fd != IPA_NAT_SIM_TBL_FD || !sim.tbl_open || sim.tbl_mem ||
+		offset != 0 || len < sim.tbl_size) {
+		errno = EINVAL;
+		return MAP_FAILED;
+	}
+
+	sim.tbl_mem = calloc(1, len);
+	if (sim.tbl_mem == NULL) {
+		errno = ENOMEM;
+		return MAP_FAILED;
+	}
+	sim.map_len = len;
+	sim.stats.maps++;
+	return sim.tbl_mem;
+}
+
+static int ipa_nat_sim_munmap(void *addr, size_t len)
+{
+	if (addr == NULL || addr != sim.tbl_mem || len != sim.map_len) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	free(sim.tbl_mem);
+	sim.tbl_mem = NULL;
+	sim.map_len = 0;
+	return 0;
+}
+
+static const struct ipa_nat_dev_ops ipa_nat_sim_ops = {
+	.dev_open = ipa_nat_sim_open,
+	.dev_close = ipa_nat_sim_close,
+	.dev_ioctl = ipa_nat_sim_ioctl,
+	.dev_mmap = ipa_nat_sim_mmap,
+	.dev_munmap = ipa_nat_sim_munmap,
+};
+
+void ipa_nat_sim_enable(enum ipa_hw_type ver)
+{
+	free(sim.tbl_mem);
+	memset(&sim, 0, sizeof(sim));
+	sim.ver = ver;
+	ipa_nati_set_dev_ops(&ipa_nat_sim_ops);
+}
+
+void ipa_nat_sim_disable(void)
+{
+	ipa_nati_set_dev_ops(NULL);
+}
+
+void ipa_nat_sim_get_stats(struct ipa_nat_sim_stats *stats)
+{
+	*stats = sim.stats;
+	stats->tbl_size = sim.tbl_size;
+}
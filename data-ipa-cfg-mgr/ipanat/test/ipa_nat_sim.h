@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2018, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of The Linux Foundation nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*=========================================================================*/
+/*!
+	@file
+	ipa_nat_sim.h
+
+	@brief
+	In-memory stand-in for /dev/ipa and the nat table device, so the
+	nat driver and its tests run without ipa hw
+*/
+/*=========================================================================*/
+
+#ifndef IPA_NAT_SIM_H
+#define IPA_NAT_SIM_H
+
+#include <linux/msm_ipa.h>
+
+/**
+ * struct ipa_nat_sim_stats - device accesses seen by the simulator
+ * @opens: devices opened
+ * @ioctls: commands posted
+ * @maps: table mappings made
+ * @dma_writes: table words written by nat dma commands
+ * @tbl_size: size of the allocated nat memory, 0 if none
+ */
+struct ipa_nat_sim_stats {
+	uint32_t opens;
+	uint32_t ioctls;
+	uint32_t maps;
+	uint32_t dma_writes;
+	size_t tbl_size;
+};
+
+/**
+ * ipa_nat_sim_enable() - route the nat driver to the simulator
+ * @ver: [in] ipa hw version to report, it selects the hash
+ *
+ * Must be called before the first table is added
+ *
+ * Returns:	None
+ */
+void ipa_nat_sim_enable(enum ipa_hw_type ver);
+
+/**
+ * ipa_nat_sim_disable() - route the nat driver back to the ipa hw
+ *
+ * Returns:	None
+ */
+void ipa_nat_sim_disable(void);
+
+/**
+ * ipa_nat_sim_get_stats() - read the simulator counters
+ * @stats: [out] device accesses so far
+ *
+ * Returns:	None
+ */
+void ipa_nat_sim_get_stats(struct ipa_nat_sim_stats *stats);
+
+#endif /* IPA_NAT_SIM_H */
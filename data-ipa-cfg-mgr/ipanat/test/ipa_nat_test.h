@@ -102,3 +102,5 @@ int ipa_nat_test019(int, u32, u8);
 int ipa_nat_test020(int, u32, u8);
 int ipa_nat_test021(int, int);
 int ipa_nat_test022(int, u32, u8);
+
+int ipa_nat_bench(int, int, int, unsigned int);
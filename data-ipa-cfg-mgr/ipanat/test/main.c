@@ -38,6 +38,7 @@
 #include "ipa_nat_drv.h"
 #include "ipa_nat_drvi.h"
 #include "ipa_nat_test.h"
+#include "ipa_nat_sim.h"
 
 extern struct ipa_nat_cache ipv4_nat_cache;
 
@@ -310,6 +311,23 @@ int main(int argc, char* argv[])
 
 	IPADBG("ipa_nat_testing user space nat driver\n");
 
+	/* "sim" runs everything below on the table simulator */
+	if (argc >= 2 && !strncmp(argv[1], "sim", 3))
+	{
+		ipa_nat_sim_enable(IPA_HW_v4_0);
+		argc--;
+		argv++;
+	}
+
+	if (argc >= 3 && !strncmp(argv[1], "bench", 5))
+	{
+		ret = ipa_nat_bench(atoi(argv[2]),
+				(argc >= 4) ? atoi(argv[3]) : 0,
+				(argc >= 5) ? atoi(argv[4]) : 1,
+				(argc >= 6) ? (unsigned int)atoi(argv[5]) : 1);
+		return ret;
+	}
+
 	if (argc == 4)
 	{
 		if (!strncmp(argv[1], "reg", 3))
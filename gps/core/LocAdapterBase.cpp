@@ -50,14 +50,19 @@ LocAdapterBase::LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
     mLocApi->addAdapter(this);
 }
 
-uint32_t LocAdapterBase::mSessionIdCounter(1);
+std::atomic<uint32_t> LocAdapterBase::mSessionIdCounter(1);
 
 uint32_t LocAdapterBase::generateSessionId()
 {
-    if (++mSessionIdCounter == 0xFFFFFFFF)
-        mSessionIdCounter = 1;
-
-     return mSessionIdCounter;
+    // LocationAPI calls into the adapters without a global lock, so
+    // session ids may be handed out on several client threads at once.
+    uint32_t id = mSessionIdCounter.load(std::memory_order_relaxed);
+    uint32_t next;
+    do {
+        next = (id + 1 == 0xFFFFFFFF) ? 1 : id + 1;
+    } while (!mSessionIdCounter.compare_exchange_weak(id, next,
+                                                      std::memory_order_relaxed));
+    return next;
 }
 
 void LocAdapterBase::handleEngineUpEvent()
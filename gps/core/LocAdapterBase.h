@@ -34,6 +34,7 @@
 #include <ContextBase.h>
 #include <LocationAPI.h>
 #include <map>
+#include <atomic>
 
 typedef struct LocationSessionKey {
     LocationAPI* client;
@@ -58,7 +59,7 @@ class LocAdapterProxyBase;
 
 class LocAdapterBase {
 private:
-    static uint32_t mSessionIdCounter;
+    static std::atomic<uint32_t> mSessionIdCounter;
 protected:
     LOC_API_ADAPTER_EVENT_MASK_T mEvtMask;
     ContextBase* mContext;
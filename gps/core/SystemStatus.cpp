@@ -34,6 +34,7 @@
 #include <string.h>
 #include <sys/time.h>
 #include <pthread.h>
+#include <atomic>
 #include <loc_pla.h>
 #include <log_util.h>
 #include <loc_nmea.h>
@@ -50,8 +51,58 @@ namespace loc_core
 ******************************************************************************/
 class SystemStatusNmeaBase
 {
+public:
+    static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
+    static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
+    // the longest sentence, $PQWP7, has 3 fields per SV
+    static const uint32_t NMEA_MAXFIELDS = 2 + SV_ALL_NUM * 3;
+
 protected:
-    std::vector<std::string> mField;
+    // A field of the sentence, pointing into it. It is not NUL terminated
+    // but ends at the following ',' or '*', where atoi / atof / strtol stop.
+    class Field
+    {
+        const char* mData;
+        uint32_t mSize;
+    public:
+        inline Field(const char* data, uint32_t size) : mData(data), mSize(size) {}
+        inline const char* data() const { return mData; }
+        inline uint32_t size() const { return mSize; }
+    };
+
+    // Fields of the sentence as offsets into it, split in a single pass
+    // without copying the sentence or allocating anything.
+    class Fields
+    {
+        const char* mBase;
+        uint32_t mCount;
+        struct {
+            uint16_t offset;
+            uint16_t size;
+        } mSpan[NMEA_MAXFIELDS];
+    public:
+        inline Fields() : mBase(nullptr), mCount(0) {}
+        void split(const char* str, uint32_t len)
+        {
+            mBase = str;
+            mCount = 0;
+            uint32_t start = 0;
+            for (uint32_t i = 0; i <= len && mCount < NMEA_MAXFIELDS; i++) {
+                if (i == len || ',' == str[i]) {
+                    mSpan[mCount].offset = start;
+                    mSpan[mCount].size = i - start;
+                    mCount++;
+                    start = i + 1;
+                }
+            }
+        }
+        inline size_t size() const { return mCount; }
+        inline Field operator[](size_t i) const {
+            return Field(mBase + mSpan[i].offset, mSpan[i].size);
+        }
+    };
+
+    Fields mField;
 
     SystemStatusNmeaBase(const char *str_in, uint32_t len_in)
     {
@@ -60,34 +111,16 @@ protected:
             return;
         }
 
-        std::string parser(str_in);
-        std::string::size_type index = 0;
-
-        // verify checksum field
-        index = parser.find("*");
-        if (index == std::string::npos) {
+        // fields are everything up to the checksum
+        const char* checksum = (const char*)memchr(str_in, '*', len_in);
+        if (nullptr == checksum) {
             return;
         }
-        parser[index] = ',';
-
-        // tokenize parser
-        while (1) {
-            std::string str;
-            index = parser.find(",");
-            if (index == std::string::npos) {
-                break;
-            }
-            str = parser.substr(0, index);
-            parser = parser.substr(index + 1);
-            mField.push_back(str);
-        }
+
+        mField.split(str_in, checksum - str_in);
     }
 
     virtual ~SystemStatusNmeaBase() { }
-
-public:
-    static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
-    static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
 };
 
 /******************************************************************************
@@ -211,39 +244,39 @@ public:
             mM1.mTimeValid = 0;
             return;
         }
-        mM1.mGpsWeek = atoi(mField[eGpsWeek].c_str());
-        mM1.mGpsTowMs = atoi(mField[eGpsTowMs].c_str());
-        mM1.mTimeValid = atoi(mField[eTimeValid].c_str());
-        mM1.mTimeSource = atoi(mField[eTimeSource].c_str());
-        mM1.mTimeUnc = atoi(mField[eTimeUnc].c_str());
-        mM1.mClockFreqBias = atoi(mField[eClockFreqBias].c_str());
-        mM1.mClockFreqBiasUnc = atoi(mField[eClockFreqBiasUnc].c_str());
-        mM1.mXoState = atoi(mField[eXoState].c_str());
-        mM1.mPgaGain = atoi(mField[ePgaGain].c_str());
-        mM1.mGpsBpAmpI = atoi(mField[eGpsBpAmpI].c_str());
-        mM1.mGpsBpAmpQ = atoi(mField[eGpsBpAmpQ].c_str());
-        mM1.mAdcI = atoi(mField[eAdcI].c_str());
-        mM1.mAdcQ = atoi(mField[eAdcQ].c_str());
-        mM1.mJammerGps = atoi(mField[eJammerGps].c_str());
-        mM1.mJammerGlo = atoi(mField[eJammerGlo].c_str());
-        mM1.mJammerBds = atoi(mField[eJammerBds].c_str());
-        mM1.mJammerGal = atoi(mField[eJammerGal].c_str());
-        mM1.mRecErrorRecovery = atoi(mField[eRecErrorRecovery].c_str());
-        mM1.mAgcGps = atof(mField[eAgcGps].c_str());
-        mM1.mAgcGlo = atof(mField[eAgcGlo].c_str());
-        mM1.mAgcBds = atof(mField[eAgcBds].c_str());
-        mM1.mAgcGal = atof(mField[eAgcGal].c_str());
+        mM1.mGpsWeek = atoi(mField[eGpsWeek].data());
+        mM1.mGpsTowMs = atoi(mField[eGpsTowMs].data());
+        mM1.mTimeValid = atoi(mField[eTimeValid].data());
+        mM1.mTimeSource = atoi(mField[eTimeSource].data());
+        mM1.mTimeUnc = atoi(mField[eTimeUnc].data());
+        mM1.mClockFreqBias = atoi(mField[eClockFreqBias].data());
+        mM1.mClockFreqBiasUnc = atoi(mField[eClockFreqBiasUnc].data());
+        mM1.mXoState = atoi(mField[eXoState].data());
+        mM1.mPgaGain = atoi(mField[ePgaGain].data());
+        mM1.mGpsBpAmpI = atoi(mField[eGpsBpAmpI].data());
+        mM1.mGpsBpAmpQ = atoi(mField[eGpsBpAmpQ].data());
+        mM1.mAdcI = atoi(mField[eAdcI].data());
+        mM1.mAdcQ = atoi(mField[eAdcQ].data());
+        mM1.mJammerGps = atoi(mField[eJammerGps].data());
+        mM1.mJammerGlo = atoi(mField[eJammerGlo].data());
+        mM1.mJammerBds = atoi(mField[eJammerBds].data());
+        mM1.mJammerGal = atoi(mField[eJammerGal].data());
+        mM1.mRecErrorRecovery = atoi(mField[eRecErrorRecovery].data());
+        mM1.mAgcGps = atof(mField[eAgcGps].data());
+        mM1.mAgcGlo = atof(mField[eAgcGlo].data());
+        mM1.mAgcBds = atof(mField[eAgcBds].data());
+        mM1.mAgcGal = atof(mField[eAgcGal].data());
         if (mField.size() > eLeapSecUnc) {
-            mM1.mLeapSeconds = atoi(mField[eLeapSeconds].c_str());
-            mM1.mLeapSecUnc = atoi(mField[eLeapSecUnc].c_str());
+            mM1.mLeapSeconds = atoi(mField[eLeapSeconds].data());
+            mM1.mLeapSecUnc = atoi(mField[eLeapSecUnc].data());
         }
         if (mField.size() > eGalBpAmpQ) {
-            mM1.mGloBpAmpI = atoi(mField[eGloBpAmpI].c_str());
-            mM1.mGloBpAmpQ = atoi(mField[eGloBpAmpQ].c_str());
-            mM1.mBdsBpAmpI = atoi(mField[eBdsBpAmpI].c_str());
-            mM1.mBdsBpAmpQ = atoi(mField[eBdsBpAmpQ].c_str());
-            mM1.mGalBpAmpI = atoi(mField[eGalBpAmpI].c_str());
-            mM1.mGalBpAmpQ = atoi(mField[eGalBpAmpQ].c_str());
+            mM1.mGloBpAmpI = atoi(mField[eGloBpAmpI].data());
+            mM1.mGloBpAmpQ = atoi(mField[eGloBpAmpQ].data());
+            mM1.mBdsBpAmpI = atoi(mField[eBdsBpAmpI].data());
+            mM1.mBdsBpAmpQ = atoi(mField[eBdsBpAmpQ].data());
+            mM1.mGalBpAmpI = atoi(mField[eGalBpAmpI].data());
+            mM1.mGalBpAmpQ = atoi(mField[eGalBpAmpQ].data());
         }
     }
 
@@ -299,13 +332,13 @@ public:
             return;
         }
         memset(&mP1, 0, sizeof(mP1));
-        mP1.mEpiValidity = strtol(mField[eEpiValidity].c_str(), NULL, 16);
-        mP1.mEpiLat = atof(mField[eEpiLat].c_str());
-        mP1.mEpiLon = atof(mField[eEpiLon].c_str());
-        mP1.mEpiAlt = atof(mField[eEpiAlt].c_str());
-        mP1.mEpiHepe = atoi(mField[eEpiHepe].c_str());
-        mP1.mEpiAltUnc = atof(mField[eEpiAltUnc].c_str());
-        mP1.mEpiSrc = atoi(mField[eEpiSrc].c_str());
+        mP1.mEpiValidity = strtol(mField[eEpiValidity].data(), NULL, 16);
+        mP1.mEpiLat = atof(mField[eEpiLat].data());
+        mP1.mEpiLon = atof(mField[eEpiLon].data());
+        mP1.mEpiAlt = atof(mField[eEpiAlt].data());
+        mP1.mEpiHepe = atoi(mField[eEpiHepe].data());
+        mP1.mEpiAltUnc = atof(mField[eEpiAltUnc].data());
+        mP1.mEpiSrc = atoi(mField[eEpiSrc].data());
     }
 
     inline SystemStatusPQWP1& get() { return mP1;}
@@ -354,11 +387,11 @@ public:
             return;
         }
         memset(&mP2, 0, sizeof(mP2));
-        mP2.mBestLat = atof(mField[eBestLat].c_str());
-        mP2.mBestLon = atof(mField[eBestLon].c_str());
-        mP2.mBestAlt = atof(mField[eBestAlt].c_str());
-        mP2.mBestHepe = atof(mField[eBestHepe].c_str());
-        mP2.mBestAltUnc = atof(mField[eBestAltUnc].c_str());
+        mP2.mBestLat = atof(mField[eBestLat].data());
+        mP2.mBestLon = atof(mField[eBestLon].data());
+        mP2.mBestAlt = atof(mField[eBestAlt].data());
+        mP2.mBestHepe = atof(mField[eBestHepe].data());
+        mP2.mBestAltUnc = atof(mField[eBestAltUnc].data());
     }
 
     inline SystemStatusPQWP2& get() { return mP2;}
@@ -425,17 +458,17 @@ public:
             return;
         }
         memset(&mP3, 0, sizeof(mP3));
-        mP3.mXtraValidMask = strtol(mField[eXtraValidMask].c_str(), NULL, 16);
-        mP3.mGpsXtraAge = atoi(mField[eGpsXtraAge].c_str());
-        mP3.mGloXtraAge = atoi(mField[eGloXtraAge].c_str());
-        mP3.mBdsXtraAge = atoi(mField[eBdsXtraAge].c_str());
-        mP3.mGalXtraAge = atoi(mField[eGalXtraAge].c_str());
-        mP3.mQzssXtraAge = atoi(mField[eQzssXtraAge].c_str());
-        mP3.mGpsXtraValid = strtol(mField[eGpsXtraValid].c_str(), NULL, 16);
-        mP3.mGloXtraValid = strtol(mField[eGloXtraValid].c_str(), NULL, 16);
-        mP3.mBdsXtraValid = strtol(mField[eBdsXtraValid].c_str(), NULL, 16);
-        mP3.mGalXtraValid = strtol(mField[eGalXtraValid].c_str(), NULL, 16);
-        mP3.mQzssXtraValid = strtol(mField[eQzssXtraValid].c_str(), NULL, 16);
+        mP3.mXtraValidMask = strtol(mField[eXtraValidMask].data(), NULL, 16);
+        mP3.mGpsXtraAge = atoi(mField[eGpsXtraAge].data());
+        mP3.mGloXtraAge = atoi(mField[eGloXtraAge].data());
+        mP3.mBdsXtraAge = atoi(mField[eBdsXtraAge].data());
+        mP3.mGalXtraAge = atoi(mField[eGalXtraAge].data());
+        mP3.mQzssXtraAge = atoi(mField[eQzssXtraAge].data());
+        mP3.mGpsXtraValid = strtol(mField[eGpsXtraValid].data(), NULL, 16);
+        mP3.mGloXtraValid = strtol(mField[eGloXtraValid].data(), NULL, 16);
+        mP3.mBdsXtraValid = strtol(mField[eBdsXtraValid].data(), NULL, 16);
+        mP3.mGalXtraValid = strtol(mField[eGalXtraValid].data(), NULL, 16);
+        mP3.mQzssXtraValid = strtol(mField[eQzssXtraValid].data(), NULL, 16);
     }
 
     inline SystemStatusPQWP3& get() { return mP3;}
@@ -484,11 +517,11 @@ public:
             return;
         }
         memset(&mP4, 0, sizeof(mP4));
-        mP4.mGpsEpheValid = strtol(mField[eGpsEpheValid].c_str(), NULL, 16);
-        mP4.mGloEpheValid = strtol(mField[eGloEpheValid].c_str(), NULL, 16);
-        mP4.mBdsEpheValid = strtol(mField[eBdsEpheValid].c_str(), NULL, 16);
-        mP4.mGalEpheValid = strtol(mField[eGalEpheValid].c_str(), NULL, 16);
-        mP4.mQzssEpheValid = strtol(mField[eQzssEpheValid].c_str(), NULL, 16);
+        mP4.mGpsEpheValid = strtol(mField[eGpsEpheValid].data(), NULL, 16);
+        mP4.mGloEpheValid = strtol(mField[eGloEpheValid].data(), NULL, 16);
+        mP4.mBdsEpheValid = strtol(mField[eBdsEpheValid].data(), NULL, 16);
+        mP4.mGalEpheValid = strtol(mField[eGalEpheValid].data(), NULL, 16);
+        mP4.mQzssEpheValid = strtol(mField[eQzssEpheValid].data(), NULL, 16);
     }
 
     inline SystemStatusPQWP4& get() { return mP4;}
@@ -567,21 +600,21 @@ public:
             return;
         }
         memset(&mP5, 0, sizeof(mP5));
-        mP5.mGpsUnknownMask = strtol(mField[eGpsUnknownMask].c_str(), NULL, 16);
-        mP5.mGloUnknownMask = strtol(mField[eGloUnknownMask].c_str(), NULL, 16);
-        mP5.mBdsUnknownMask = strtol(mField[eBdsUnknownMask].c_str(), NULL, 16);
-        mP5.mGalUnknownMask = strtol(mField[eGalUnknownMask].c_str(), NULL, 16);
-        mP5.mQzssUnknownMask = strtol(mField[eQzssUnknownMask].c_str(), NULL, 16);
-        mP5.mGpsGoodMask = strtol(mField[eGpsGoodMask].c_str(), NULL, 16);
-        mP5.mGloGoodMask = strtol(mField[eGloGoodMask].c_str(), NULL, 16);
-        mP5.mBdsGoodMask = strtol(mField[eBdsGoodMask].c_str(), NULL, 16);
-        mP5.mGalGoodMask = strtol(mField[eGalGoodMask].c_str(), NULL, 16);
-        mP5.mQzssGoodMask = strtol(mField[eQzssGoodMask].c_str(), NULL, 16);
-        mP5.mGpsBadMask = strtol(mField[eGpsBadMask].c_str(), NULL, 16);
-        mP5.mGloBadMask = strtol(mField[eGloBadMask].c_str(), NULL, 16);
-        mP5.mBdsBadMask = strtol(mField[eBdsBadMask].c_str(), NULL, 16);
-        mP5.mGalBadMask = strtol(mField[eGalBadMask].c_str(), NULL, 16);
-        mP5.mQzssBadMask = strtol(mField[eQzssBadMask].c_str(), NULL, 16);
+        mP5.mGpsUnknownMask = strtol(mField[eGpsUnknownMask].data(), NULL, 16);
+        mP5.mGloUnknownMask = strtol(mField[eGloUnknownMask].data(), NULL, 16);
+        mP5.mBdsUnknownMask = strtol(mField[eBdsUnknownMask].data(), NULL, 16);
+        mP5.mGalUnknownMask = strtol(mField[eGalUnknownMask].data(), NULL, 16);
+        mP5.mQzssUnknownMask = strtol(mField[eQzssUnknownMask].data(), NULL, 16);
+        mP5.mGpsGoodMask = strtol(mField[eGpsGoodMask].data(), NULL, 16);
+        mP5.mGloGoodMask = strtol(mField[eGloGoodMask].data(), NULL, 16);
+        mP5.mBdsGoodMask = strtol(mField[eBdsGoodMask].data(), NULL, 16);
+        mP5.mGalGoodMask = strtol(mField[eGalGoodMask].data(), NULL, 16);
+        mP5.mQzssGoodMask = strtol(mField[eQzssGoodMask].data(), NULL, 16);
+        mP5.mGpsBadMask = strtol(mField[eGpsBadMask].data(), NULL, 16);
+        mP5.mGloBadMask = strtol(mField[eGloBadMask].data(), NULL, 16);
+        mP5.mBdsBadMask = strtol(mField[eBdsBadMask].data(), NULL, 16);
+        mP5.mGalBadMask = strtol(mField[eGalBadMask].data(), NULL, 16);
+        mP5.mQzssBadMask = strtol(mField[eQzssBadMask].data(), NULL, 16);
     }
 
     inline SystemStatusPQWP5& get() { return mP5;}
@@ -618,7 +651,7 @@ public:
             return;
         }
         memset(&mP6, 0, sizeof(mP6));
-        mP6.mFixInfoMask = strtol(mField[eFixInfoMask].c_str(), NULL, 16);
+        mP6.mFixInfoMask = strtol(mField[eFixInfoMask].data(), NULL, 16);
     }
 
     inline SystemStatusPQWP6& get() { return mP6;}
@@ -653,9 +686,9 @@ public:
             return;
         }
         for (uint32_t i=0; i<SV_ALL_NUM; i++) {
-            mP7.mNav[i].mType   = GnssEphemerisType(atoi(mField[i*3+2].c_str()));
-            mP7.mNav[i].mSource = GnssEphemerisSource(atoi(mField[i*3+3].c_str()));
-            mP7.mNav[i].mAgeSec = atoi(mField[i*3+4].c_str());
+            mP7.mNav[i].mType   = GnssEphemerisType(atoi(mField[i*3+2].data()));
+            mP7.mNav[i].mSource = GnssEphemerisSource(atoi(mField[i*3+3].data()));
+            mP7.mNav[i].mAgeSec = atoi(mField[i*3+4].data());
         }
     }
 
@@ -696,8 +729,8 @@ public:
             return;
         }
         memset(&mS1, 0, sizeof(mS1));
-        mS1.mFixInfoMask = atoi(mField[eFixInfoMask].c_str());
-        mS1.mHepeLimit = atoi(mField[eHepeLimit].c_str());
+        mS1.mFixInfoMask = atoi(mField[eFixInfoMask].data());
+        mS1.mHepeLimit = atoi(mField[eHepeLimit].data());
     }
 
     inline SystemStatusPQWS1& get() { return mS1;}
@@ -1306,41 +1339,58 @@ SystemStatus::SystemStatus(const MsgTask* msgTask) :
  SystemStatus - storing dataitems
 ******************************************************************************/
 template <typename TYPE_REPORT, typename TYPE_ITEM>
-bool SystemStatus::setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s)
+bool SystemStatus::setIteminReport(TYPE_REPORT& report, SystemStatusSnapshot<TYPE_REPORT>& snapshot,
+                                   TYPE_ITEM&& s)
 {
+    snapshot.setUtcReported(s.mUtcReported);
     if (!report.empty() && report.back().equals(static_cast<TYPE_ITEM&>(s.collate(report.back())))) {
         // there is no change - just update reported timestamp
         report.back().mUtcReported = s.mUtcReported;
         return false;
     }
 
-    // first event or updated
+    // first event or updated, overwrites the oldest one once the history is full
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
+    snapshot.publish(report);
     return true;
 }
 
 template <typename TYPE_REPORT, typename TYPE_ITEM>
-void SystemStatus::setDefaultIteminReport(TYPE_REPORT& report, const TYPE_ITEM& s)
+void SystemStatus::setDefaultIteminReport(TYPE_REPORT& report, SystemStatusSnapshot<TYPE_REPORT>& snapshot,
+                                          const TYPE_ITEM& s)
 {
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
+    snapshot.setUtcReported(s.mUtcReported);
+    snapshot.publish(report);
 }
 
-template <typename TYPE_REPORT, typename TYPE_ITEM>
-void SystemStatus::getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) const
+template <typename TYPE_REPORT>
+void SystemStatus::getIteminReport(TYPE_REPORT& reportout, const SystemStatusSnapshot<TYPE_REPORT>& c,
+                                   bool isLatestOnly) const
 {
+    std::shared_ptr<const TYPE_REPORT> history = c.load();
     reportout.clear();
-    if (c.size() >= 1) {
-        reportout.push_back(c.back());
+    if (nullptr == history || history->empty()) {
+        return;
+    }
+
+    if (isLatestOnly) {
+        reportout.push_back(history->back());
+    } else {
+        reportout = *history;
+    }
+    c.getUtcReported(reportout.back().mUtcReported);
+    if (isLatestOnly) {
         reportout.back().dump();
     }
 }
 
+// $PQW debug sentences are told apart by the 2 chars following $PQW
+static inline constexpr uint16_t nmeaSentenceId(char c0, char c1)
+{
+    return ((uint16_t)(uint8_t)c0 << 8) | (uint8_t)c1;
+}
+
 /******************************************************************************
 @brief      API to set report data into internal buffer
 
@@ -1355,53 +1405,53 @@ bool SystemStatus::setNmeaString(const char *data, uint32_t len)
         return false;
     }
 
-    char buf[SystemStatusNmeaBase::NMEA_MAXSIZE + 1] = { 0 };
-    strlcpy(buf, data, sizeof(buf));
-
     pthread_mutex_lock(&mMutexSystemStatus);
 
-    // parse the received nmea strings here
-    if (0 == strncmp(data, "$PQWM1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        SystemStatusPQWM1 s = SystemStatusPQWM1parser(buf, len).get();
-        setIteminReport(mCache.mTimeAndClock, SystemStatusTimeAndClock(s));
-        setIteminReport(mCache.mXoState, SystemStatusXoState(s));
-        setIteminReport(mCache.mRfAndParams, SystemStatusRfAndParams(s));
-        setIteminReport(mCache.mErrRecovery, SystemStatusErrRecovery(s));
-    }
-    else if (0 == strncmp(data, "$PQWP1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mInjectedPosition,
-                SystemStatusInjectedPosition(SystemStatusPQWP1parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP2", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mBestPosition,
-                SystemStatusBestPosition(SystemStatusPQWP2parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP3", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mXtra,
-                SystemStatusXtra(SystemStatusPQWP3parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP4", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mEphemeris,
-                SystemStatusEphemeris(SystemStatusPQWP4parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP5", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mSvHealth,
-                SystemStatusSvHealth(SystemStatusPQWP5parser(buf, len).get()));
+    // parse the received nmea strings here, by the id following $PQW
+    switch (nmeaSentenceId(data[4], data[5])) {
+    case nmeaSentenceId('M', '1'): {
+        SystemStatusPQWM1 s = SystemStatusPQWM1parser(data, len).get();
+        setIteminReport(mCache.mTimeAndClock, mSnapshot.mTimeAndClock, SystemStatusTimeAndClock(s));
+        setIteminReport(mCache.mXoState, mSnapshot.mXoState, SystemStatusXoState(s));
+        setIteminReport(mCache.mRfAndParams, mSnapshot.mRfAndParams, SystemStatusRfAndParams(s));
+        setIteminReport(mCache.mErrRecovery, mSnapshot.mErrRecovery, SystemStatusErrRecovery(s));
+        break;
     }
-    else if (0 == strncmp(data, "$PQWP6", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mPdr,
-                SystemStatusPdr(SystemStatusPQWP6parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP7", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mNavData,
-                SystemStatusNavData(SystemStatusPQWP7parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWS1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mPositionFailure,
-                SystemStatusPositionFailure(SystemStatusPQWS1parser(buf, len).get()));
-    }
-    else {
+    case nmeaSentenceId('P', '1'):
+        setIteminReport(mCache.mInjectedPosition, mSnapshot.mInjectedPosition,
+                SystemStatusInjectedPosition(SystemStatusPQWP1parser(data, len).get()));
+        break;
+    case nmeaSentenceId('P', '2'):
+        setIteminReport(mCache.mBestPosition, mSnapshot.mBestPosition,
+                SystemStatusBestPosition(SystemStatusPQWP2parser(data, len).get()));
+        break;
+    case nmeaSentenceId('P', '3'):
+        setIteminReport(mCache.mXtra, mSnapshot.mXtra,
+                SystemStatusXtra(SystemStatusPQWP3parser(data, len).get()));
+        break;
+    case nmeaSentenceId('P', '4'):
+        setIteminReport(mCache.mEphemeris, mSnapshot.mEphemeris,
+                SystemStatusEphemeris(SystemStatusPQWP4parser(data, len).get()));
+        break;
+    case nmeaSentenceId('P', '5'):
+        setIteminReport(mCache.mSvHealth, mSnapshot.mSvHealth,
+                SystemStatusSvHealth(SystemStatusPQWP5parser(data, len).get()));
+        break;
+    case nmeaSentenceId('P', '6'):
+        setIteminReport(mCache.mPdr, mSnapshot.mPdr,
+                SystemStatusPdr(SystemStatusPQWP6parser(data, len).get()));
+        break;
+    case nmeaSentenceId('P', '7'):
+        setIteminReport(mCache.mNavData, mSnapshot.mNavData,
+                SystemStatusNavData(SystemStatusPQWP7parser(data, len).get()));
+        break;
+    case nmeaSentenceId('S', '1'):
+        setIteminReport(mCache.mPositionFailure, mSnapshot.mPositionFailure,
+                SystemStatusPositionFailure(SystemStatusPQWS1parser(data, len).get()));
+        break;
+    default:
         // do nothing
+        break;
     }
 
     pthread_mutex_unlock(&mMutexSystemStatus);
@@ -1421,7 +1471,7 @@ bool SystemStatus::eventPosition(const UlpLocation& location,
     bool ret = false;
     pthread_mutex_lock(&mMutexSystemStatus);
 
-    ret = setIteminReport(mCache.mLocation, SystemStatusLocation(location, locationEx));
+    ret = setIteminReport(mCache.mLocation, mSnapshot.mLocation, SystemStatusLocation(location, locationEx));
     LOC_LOGV("eventPosition - lat=%f lon=%f alt=%f speed=%f",
              location.gpsLocation.latitude,
              location.gpsLocation.longitude,
@@ -1446,91 +1496,91 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
     switch(dataitem->getId())
     {
         case AIRPLANEMODE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mAirplaneMode,
+            ret = setIteminReport(mCache.mAirplaneMode, mSnapshot.mAirplaneMode,
                     SystemStatusAirplaneMode(*(static_cast<AirplaneModeDataItemBase*>(dataitem))));
             break;
         case ENH_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mENH,
+            ret = setIteminReport(mCache.mENH, mSnapshot.mENH,
                     SystemStatusENH(*(static_cast<ENHDataItemBase*>(dataitem))));
             break;
         case GPSSTATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mGPSState,
+            ret = setIteminReport(mCache.mGPSState, mSnapshot.mGPSState,
                     SystemStatusGpsState(*(static_cast<GPSStateDataItemBase*>(dataitem))));
             break;
         case NLPSTATUS_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mNLPStatus,
+            ret = setIteminReport(mCache.mNLPStatus, mSnapshot.mNLPStatus,
                     SystemStatusNLPStatus(*(static_cast<NLPStatusDataItemBase*>(dataitem))));
             break;
         case WIFIHARDWARESTATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mWifiHardwareState,
+            ret = setIteminReport(mCache.mWifiHardwareState, mSnapshot.mWifiHardwareState,
                     SystemStatusWifiHardwareState(*(static_cast<WifiHardwareStateDataItemBase*>(dataitem))));
             break;
         case NETWORKINFO_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mNetworkInfo,
+            ret = setIteminReport(mCache.mNetworkInfo, mSnapshot.mNetworkInfo,
                     SystemStatusNetworkInfo(*(static_cast<NetworkInfoDataItemBase*>(dataitem))));
             break;
         case RILSERVICEINFO_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mRilServiceInfo,
+            ret = setIteminReport(mCache.mRilServiceInfo, mSnapshot.mRilServiceInfo,
                     SystemStatusServiceInfo(*(static_cast<RilServiceInfoDataItemBase*>(dataitem))));
             break;
         case RILCELLINFO_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mRilCellInfo,
+            ret = setIteminReport(mCache.mRilCellInfo, mSnapshot.mRilCellInfo,
                     SystemStatusRilCellInfo(*(static_cast<RilCellInfoDataItemBase*>(dataitem))));
             break;
         case SERVICESTATUS_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mServiceStatus,
+            ret = setIteminReport(mCache.mServiceStatus, mSnapshot.mServiceStatus,
                     SystemStatusServiceStatus(*(static_cast<ServiceStatusDataItemBase*>(dataitem))));
             break;
         case MODEL_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mModel,
+            ret = setIteminReport(mCache.mModel, mSnapshot.mModel,
                     SystemStatusModel(*(static_cast<ModelDataItemBase*>(dataitem))));
             break;
         case MANUFACTURER_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mManufacturer,
+            ret = setIteminReport(mCache.mManufacturer, mSnapshot.mManufacturer,
                     SystemStatusManufacturer(*(static_cast<ManufacturerDataItemBase*>(dataitem))));
             break;
         case ASSISTED_GPS_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mAssistedGps,
+            ret = setIteminReport(mCache.mAssistedGps, mSnapshot.mAssistedGps,
                     SystemStatusAssistedGps(*(static_cast<AssistedGpsDataItemBase*>(dataitem))));
             break;
         case SCREEN_STATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mScreenState,
+            ret = setIteminReport(mCache.mScreenState, mSnapshot.mScreenState,
                     SystemStatusScreenState(*(static_cast<ScreenStateDataItemBase*>(dataitem))));
             break;
         case POWER_CONNECTED_STATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mPowerConnectState,
+            ret = setIteminReport(mCache.mPowerConnectState, mSnapshot.mPowerConnectState,
                     SystemStatusPowerConnectState(*(static_cast<PowerConnectStateDataItemBase*>(dataitem))));
             break;
         case TIMEZONE_CHANGE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mTimeZoneChange,
+            ret = setIteminReport(mCache.mTimeZoneChange, mSnapshot.mTimeZoneChange,
                     SystemStatusTimeZoneChange(*(static_cast<TimeZoneChangeDataItemBase*>(dataitem))));
             break;
         case TIME_CHANGE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mTimeChange,
+            ret = setIteminReport(mCache.mTimeChange, mSnapshot.mTimeChange,
                     SystemStatusTimeChange(*(static_cast<TimeChangeDataItemBase*>(dataitem))));
             break;
         case WIFI_SUPPLICANT_STATUS_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mWifiSupplicantStatus,
+            ret = setIteminReport(mCache.mWifiSupplicantStatus, mSnapshot.mWifiSupplicantStatus,
                     SystemStatusWifiSupplicantStatus(*(static_cast<WifiSupplicantStatusDataItemBase*>(dataitem))));
             break;
         case SHUTDOWN_STATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mShutdownState,
+            ret = setIteminReport(mCache.mShutdownState, mSnapshot.mShutdownState,
                     SystemStatusShutdownState(*(static_cast<ShutdownStateDataItemBase*>(dataitem))));
             break;
         case TAC_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mTac,
+            ret = setIteminReport(mCache.mTac, mSnapshot.mTac,
                     SystemStatusTac(*(static_cast<TacDataItemBase*>(dataitem))));
             break;
         case MCCMNC_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mMccMnc,
+            ret = setIteminReport(mCache.mMccMnc, mSnapshot.mMccMnc,
                     SystemStatusMccMnc(*(static_cast<MccmncDataItemBase*>(dataitem))));
             break;
         case BTLE_SCAN_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mBtDeviceScanDetail,
+            ret = setIteminReport(mCache.mBtDeviceScanDetail, mSnapshot.mBtDeviceScanDetail,
                     SystemStatusBtDeviceScanDetail(*(static_cast<BtDeviceScanDetailsDataItemBase*>(dataitem))));
             break;
         case BT_SCAN_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mBtLeDeviceScanDetail,
+            ret = setIteminReport(mCache.mBtLeDeviceScanDetail, mSnapshot.mBtLeDeviceScanDetail,
                     SystemStatusBtleDeviceScanDetail(*(static_cast<BtLeDeviceScanDetailsDataItemBase*>(dataitem))));
             break;
         default:
@@ -1550,96 +1600,47 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
 ******************************************************************************/
 bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) const
 {
-    pthread_mutex_lock(&mMutexSystemStatus);
-
-    if (isLatestOnly) {
-        // push back only the latest report and return it
-        getIteminReport(report.mLocation, mCache.mLocation);
-
-        getIteminReport(report.mTimeAndClock, mCache.mTimeAndClock);
-        getIteminReport(report.mXoState, mCache.mXoState);
-        getIteminReport(report.mRfAndParams, mCache.mRfAndParams);
-        getIteminReport(report.mErrRecovery, mCache.mErrRecovery);
-
-        getIteminReport(report.mInjectedPosition, mCache.mInjectedPosition);
-        getIteminReport(report.mBestPosition, mCache.mBestPosition);
-        getIteminReport(report.mXtra, mCache.mXtra);
-        getIteminReport(report.mEphemeris, mCache.mEphemeris);
-        getIteminReport(report.mSvHealth, mCache.mSvHealth);
-        getIteminReport(report.mPdr, mCache.mPdr);
-        getIteminReport(report.mNavData, mCache.mNavData);
-
-        getIteminReport(report.mPositionFailure, mCache.mPositionFailure);
-
-        getIteminReport(report.mAirplaneMode, mCache.mAirplaneMode);
-        getIteminReport(report.mENH, mCache.mENH);
-        getIteminReport(report.mGPSState, mCache.mGPSState);
-        getIteminReport(report.mNLPStatus, mCache.mNLPStatus);
-        getIteminReport(report.mWifiHardwareState, mCache.mWifiHardwareState);
-        getIteminReport(report.mNetworkInfo, mCache.mNetworkInfo);
-        getIteminReport(report.mRilServiceInfo, mCache.mRilServiceInfo);
-        getIteminReport(report.mRilCellInfo, mCache.mRilCellInfo);
-        getIteminReport(report.mServiceStatus, mCache.mServiceStatus);
-        getIteminReport(report.mModel, mCache.mModel);
-        getIteminReport(report.mManufacturer, mCache.mManufacturer);
-        getIteminReport(report.mAssistedGps, mCache.mAssistedGps);
-        getIteminReport(report.mScreenState, mCache.mScreenState);
-        getIteminReport(report.mPowerConnectState, mCache.mPowerConnectState);
-        getIteminReport(report.mTimeZoneChange, mCache.mTimeZoneChange);
-        getIteminReport(report.mTimeChange, mCache.mTimeChange);
-        getIteminReport(report.mWifiSupplicantStatus, mCache.mWifiSupplicantStatus);
-        getIteminReport(report.mShutdownState, mCache.mShutdownState);
-        getIteminReport(report.mTac, mCache.mTac);
-        getIteminReport(report.mMccMnc, mCache.mMccMnc);
-        getIteminReport(report.mBtDeviceScanDetail, mCache.mBtDeviceScanDetail);
-        getIteminReport(report.mBtLeDeviceScanDetail, mCache.mBtLeDeviceScanDetail);
-    }
-    else {
-        // copy entire reports and return them
-        report.mLocation.clear();
-
-        report.mTimeAndClock.clear();
-        report.mXoState.clear();
-        report.mRfAndParams.clear();
-        report.mErrRecovery.clear();
-
-        report.mInjectedPosition.clear();
-        report.mBestPosition.clear();
-        report.mXtra.clear();
-        report.mEphemeris.clear();
-        report.mSvHealth.clear();
-        report.mPdr.clear();
-        report.mNavData.clear();
-
-        report.mPositionFailure.clear();
-
-        report.mAirplaneMode.clear();
-        report.mENH.clear();
-        report.mGPSState.clear();
-        report.mNLPStatus.clear();
-        report.mWifiHardwareState.clear();
-        report.mNetworkInfo.clear();
-        report.mRilServiceInfo.clear();
-        report.mRilCellInfo.clear();
-        report.mServiceStatus.clear();
-        report.mModel.clear();
-        report.mManufacturer.clear();
-        report.mAssistedGps.clear();
-        report.mScreenState.clear();
-        report.mPowerConnectState.clear();
-        report.mTimeZoneChange.clear();
-        report.mTimeChange.clear();
-        report.mWifiSupplicantStatus.clear();
-        report.mShutdownState.clear();
-        report.mTac.clear();
-        report.mMccMnc.clear();
-        report.mBtDeviceScanDetail.clear();
-        report.mBtLeDeviceScanDetail.clear();
-
-        report = mCache;
-    }
-
-    pthread_mutex_unlock(&mMutexSystemStatus);
+    // lock free, the writers only ever swap in new copies. When isLatestOnly
+    // is false, the entire history of each report is copied.
+    getIteminReport(report.mLocation, mSnapshot.mLocation, isLatestOnly);
+
+    getIteminReport(report.mTimeAndClock, mSnapshot.mTimeAndClock, isLatestOnly);
+    getIteminReport(report.mXoState, mSnapshot.mXoState, isLatestOnly);
+    getIteminReport(report.mRfAndParams, mSnapshot.mRfAndParams, isLatestOnly);
+    getIteminReport(report.mErrRecovery, mSnapshot.mErrRecovery, isLatestOnly);
+
+    getIteminReport(report.mInjectedPosition, mSnapshot.mInjectedPosition, isLatestOnly);
+    getIteminReport(report.mBestPosition, mSnapshot.mBestPosition, isLatestOnly);
+    getIteminReport(report.mXtra, mSnapshot.mXtra, isLatestOnly);
+    getIteminReport(report.mEphemeris, mSnapshot.mEphemeris, isLatestOnly);
+    getIteminReport(report.mSvHealth, mSnapshot.mSvHealth, isLatestOnly);
+    getIteminReport(report.mPdr, mSnapshot.mPdr, isLatestOnly);
+    getIteminReport(report.mNavData, mSnapshot.mNavData, isLatestOnly);
+
+    getIteminReport(report.mPositionFailure, mSnapshot.mPositionFailure, isLatestOnly);
+
+    getIteminReport(report.mAirplaneMode, mSnapshot.mAirplaneMode, isLatestOnly);
+    getIteminReport(report.mENH, mSnapshot.mENH, isLatestOnly);
+    getIteminReport(report.mGPSState, mSnapshot.mGPSState, isLatestOnly);
+    getIteminReport(report.mNLPStatus, mSnapshot.mNLPStatus, isLatestOnly);
+    getIteminReport(report.mWifiHardwareState, mSnapshot.mWifiHardwareState, isLatestOnly);
+    getIteminReport(report.mNetworkInfo, mSnapshot.mNetworkInfo, isLatestOnly);
+    getIteminReport(report.mRilServiceInfo, mSnapshot.mRilServiceInfo, isLatestOnly);
+    getIteminReport(report.mRilCellInfo, mSnapshot.mRilCellInfo, isLatestOnly);
+    getIteminReport(report.mServiceStatus, mSnapshot.mServiceStatus, isLatestOnly);
+    getIteminReport(report.mModel, mSnapshot.mModel, isLatestOnly);
+    getIteminReport(report.mManufacturer, mSnapshot.mManufacturer, isLatestOnly);
+    getIteminReport(report.mAssistedGps, mSnapshot.mAssistedGps, isLatestOnly);
+    getIteminReport(report.mScreenState, mSnapshot.mScreenState, isLatestOnly);
+    getIteminReport(report.mPowerConnectState, mSnapshot.mPowerConnectState, isLatestOnly);
+    getIteminReport(report.mTimeZoneChange, mSnapshot.mTimeZoneChange, isLatestOnly);
+    getIteminReport(report.mTimeChange, mSnapshot.mTimeChange, isLatestOnly);
+    getIteminReport(report.mWifiSupplicantStatus, mSnapshot.mWifiSupplicantStatus, isLatestOnly);
+    getIteminReport(report.mShutdownState, mSnapshot.mShutdownState, isLatestOnly);
+    getIteminReport(report.mTac, mSnapshot.mTac, isLatestOnly);
+    getIteminReport(report.mMccMnc, mSnapshot.mMccMnc, isLatestOnly);
+    getIteminReport(report.mBtDeviceScanDetail, mSnapshot.mBtDeviceScanDetail, isLatestOnly);
+    getIteminReport(report.mBtLeDeviceScanDetail, mSnapshot.mBtLeDeviceScanDetail, isLatestOnly);
     return true;
 }
 
@@ -1654,22 +1655,22 @@ bool SystemStatus::setDefaultGnssEngineStates(void)
 {
     pthread_mutex_lock(&mMutexSystemStatus);
 
-    setDefaultIteminReport(mCache.mLocation, SystemStatusLocation());
+    setDefaultIteminReport(mCache.mLocation, mSnapshot.mLocation, SystemStatusLocation());
 
-    setDefaultIteminReport(mCache.mTimeAndClock, SystemStatusTimeAndClock());
-    setDefaultIteminReport(mCache.mXoState, SystemStatusXoState());
-    setDefaultIteminReport(mCache.mRfAndParams, SystemStatusRfAndParams());
-    setDefaultIteminReport(mCache.mErrRecovery, SystemStatusErrRecovery());
+    setDefaultIteminReport(mCache.mTimeAndClock, mSnapshot.mTimeAndClock, SystemStatusTimeAndClock());
+    setDefaultIteminReport(mCache.mXoState, mSnapshot.mXoState, SystemStatusXoState());
+    setDefaultIteminReport(mCache.mRfAndParams, mSnapshot.mRfAndParams, SystemStatusRfAndParams());
+    setDefaultIteminReport(mCache.mErrRecovery, mSnapshot.mErrRecovery, SystemStatusErrRecovery());
 
-    setDefaultIteminReport(mCache.mInjectedPosition, SystemStatusInjectedPosition());
-    setDefaultIteminReport(mCache.mBestPosition, SystemStatusBestPosition());
-    setDefaultIteminReport(mCache.mXtra, SystemStatusXtra());
-    setDefaultIteminReport(mCache.mEphemeris, SystemStatusEphemeris());
-    setDefaultIteminReport(mCache.mSvHealth, SystemStatusSvHealth());
-    setDefaultIteminReport(mCache.mPdr, SystemStatusPdr());
-    setDefaultIteminReport(mCache.mNavData, SystemStatusNavData());
+    setDefaultIteminReport(mCache.mInjectedPosition, mSnapshot.mInjectedPosition, SystemStatusInjectedPosition());
+    setDefaultIteminReport(mCache.mBestPosition, mSnapshot.mBestPosition, SystemStatusBestPosition());
+    setDefaultIteminReport(mCache.mXtra, mSnapshot.mXtra, SystemStatusXtra());
+    setDefaultIteminReport(mCache.mEphemeris, mSnapshot.mEphemeris, SystemStatusEphemeris());
+    setDefaultIteminReport(mCache.mSvHealth, mSnapshot.mSvHealth, SystemStatusSvHealth());
+    setDefaultIteminReport(mCache.mPdr, mSnapshot.mPdr, SystemStatusPdr());
+    setDefaultIteminReport(mCache.mNavData, mSnapshot.mNavData, SystemStatusNavData());
 
-    setDefaultIteminReport(mCache.mPositionFailure, SystemStatusPositionFailure());
+    setDefaultIteminReport(mCache.mPositionFailure, mSnapshot.mPositionFailure, SystemStatusPositionFailure());
 
     pthread_mutex_unlock(&mMutexSystemStatus);
     return true;
@@ -1693,3 +1694,117 @@ bool SystemStatus::eventConnectionStatus(bool connected, int8_t type)
 
 } // namespace loc_core
 
+
+#ifdef __LOC_DEBUG__
+
+#include <stdio.h>
+#include <time.h>
+#include <new>
+
+// Runs the debug NMEA parsers over a corpus of $PQW sentences, one per line
+// in the given file, e.g. pulled from a logcat capture, or over a built-in
+// sample, and reports sentences/sec and heap allocations per sentence.
+//
+// For Linux command line testing:
+// compilation:
+//     g++ -D__LOC_DEBUG__ -O2 -std=c++11 -I. -I../utils -I../location -I../pla/android -Idata-items -Iobserver -I../../../../system/core/include -o systemstatus_bench SystemStatus.cpp SystemStatusOsObserver.cpp data-items/DataItemsFactoryProxy.cpp ../utils/*.cpp ../utils/*.c -lpthread -ldl
+// usage:
+//     ./systemstatus_bench [corpus file] [passes]
+
+static uint64_t gBenchAllocs = 0;
+
+void* operator new(size_t size)
+{
+    gBenchAllocs++;
+    void* ptr = malloc(size);
+    if (nullptr == ptr) {
+        abort();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+using namespace loc_core;
+
+static void benchParse(const char* nmea, uint32_t len)
+{
+    switch (nmeaSentenceId(nmea[4], nmea[5])) {
+    case nmeaSentenceId('M', '1'): SystemStatusPQWM1parser(nmea, len).get(); break;
+    case nmeaSentenceId('P', '1'): SystemStatusPQWP1parser(nmea, len).get(); break;
+    case nmeaSentenceId('P', '2'): SystemStatusPQWP2parser(nmea, len).get(); break;
+    case nmeaSentenceId('P', '3'): SystemStatusPQWP3parser(nmea, len).get(); break;
+    case nmeaSentenceId('P', '4'): SystemStatusPQWP4parser(nmea, len).get(); break;
+    case nmeaSentenceId('P', '5'): SystemStatusPQWP5parser(nmea, len).get(); break;
+    case nmeaSentenceId('P', '6'): SystemStatusPQWP6parser(nmea, len).get(); break;
+    case nmeaSentenceId('P', '7'): SystemStatusPQWP7parser(nmea, len).get(); break;
+    case nmeaSentenceId('S', '1'): SystemStatusPQWS1parser(nmea, len).get(); break;
+    default: break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    static const char* sample[] = {
+        "$PQWM1,1987,345678901,1,3,12,-35,4,2,100,200,300,400,500,10,20,30,40,0,"
+        "-1.5,-2.5,-3.5,-4.5,18,1,210,220,230,240,250,260*1C\r\n",
+        "$PQWP1,095223.00,1F,37.4219999,-122.0840575,12.5,50,3.2,4*2A\r\n",
+        "$PQWP2,095223.00,37.4219999,-122.0840575,12.5,8.1,3.2*44\r\n",
+        "$PQWP3,095223.00,3F,12,14,16,18,20,FFFFFFFF,FFFFFF,3FFFFFFFF,3FFFFFFFF,1F*11\r\n",
+        "$PQWP4,095223.00,8FFF0F,FF0FF,0,0,0*3B\r\n",
+        "$PQWP5,095223.00,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*3E\r\n",
+        "$PQWP6,095223.00,1*6E\r\n",
+        "$PQWS1,095223.00,3,100*47\r\n",
+    };
+    std::vector<std::string> corpus;
+    if (argc > 1) {
+        FILE* file = fopen(argv[1], "r");
+        char line[SystemStatusNmeaBase::NMEA_MAXSIZE + 1];
+        while (nullptr != file && nullptr != fgets(line, sizeof(line), file)) {
+            if (loc_nmea_is_debug(line, strlen(line))) {
+                corpus.push_back(line);
+            }
+        }
+        if (nullptr != file) {
+            fclose(file);
+        }
+    } else {
+        for (size_t i = 0; i < sizeof(sample) / sizeof(sample[0]); i++) {
+            corpus.push_back(sample[i]);
+        }
+        // $PQWP7 with ephemeris type, source and age for every SV
+        std::string p7("$PQWP7,095223.00");
+        for (uint32_t i = 0; i < SV_ALL_NUM; i++) {
+            p7 += ",1,2,120";
+        }
+        p7 += "*00\r\n";
+        corpus.push_back(p7);
+    }
+    int passes = (argc > 2) ? atoi(argv[2]) : 20000;
+    if (corpus.empty() || passes <= 0) {
+        printf("no $PQW sentences to parse\n");
+        return 1;
+    }
+
+    struct timespec start, end;
+    uint64_t allocs = gBenchAllocs;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int pass = 0; pass < passes; pass++) {
+        for (size_t i = 0; i < corpus.size(); i++) {
+            benchParse(corpus[i].c_str(), corpus[i].length());
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    allocs = gBenchAllocs - allocs;
+
+    double sentences = (double)passes * corpus.size();
+    double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%zu sentences x %d passes: %.0f sentences/sec, %.2f allocations/sentence\n",
+           corpus.size(), passes, sentences / secs, allocs / sentences);
+    return 0;
+}
+
+#endif
@@ -32,6 +32,9 @@
 #include <stdint.h>
 #include <sys/time.h>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <new>
 #include <loc_pla.h>
 #include <log_util.h>
 #include <MsgTask.h>
@@ -731,6 +734,92 @@ public:
     }
 };
 
+/******************************************************************************
+ SystemStatusHistory
+******************************************************************************/
+// Fixed capacity history of one report, indexed oldest first. Once full, each
+// push_back overwrites the oldest item in place instead of shifting the rest.
+template <typename TYPE_ITEM, uint32_t N = SystemStatusItemBase::maxItem>
+class SystemStatusHistory
+{
+    TYPE_ITEM mItems[N];
+    uint32_t  mHead;    // slot of the oldest item
+    uint32_t  mCount;
+public:
+    inline SystemStatusHistory() : mHead(0), mCount(0) {}
+    inline bool empty() const { return (0 == mCount); }
+    inline uint32_t size() const { return mCount; }
+    inline uint32_t capacity() const { return N; }
+    inline void clear() { mHead = 0; mCount = 0; }
+    inline TYPE_ITEM& operator[](uint32_t i) { return mItems[(mHead + i) % N]; }
+    inline const TYPE_ITEM& operator[](uint32_t i) const { return mItems[(mHead + i) % N]; }
+    inline TYPE_ITEM& front() { return (*this)[0]; }
+    inline const TYPE_ITEM& front() const { return (*this)[0]; }
+    inline TYPE_ITEM& back() { return (*this)[mCount - 1]; }
+    inline const TYPE_ITEM& back() const { return (*this)[mCount - 1]; }
+    inline void push_back(const TYPE_ITEM& item) {
+        if (mCount < N) {
+            mItems[(mHead + mCount) % N] = item;
+            mCount++;
+        } else {
+            mItems[mHead] = item;
+            mHead = (mHead + 1) % N;
+        }
+    }
+};
+
+/******************************************************************************
+ SystemStatusSnapshot
+******************************************************************************/
+// Read only copy of one report history handed out by getReport() without
+// taking mMutexSystemStatus. The writer republishes it only when an item was
+// added to the history, reusing the previous copy once no reader holds it.
+// When an unchanged item is reported again only its reported time moves,
+// which is kept aside so that it does not need a new copy.
+template <typename TYPE_HISTORY>
+class SystemStatusSnapshot
+{
+    std::shared_ptr<const TYPE_HISTORY> mPublished;
+    std::shared_ptr<TYPE_HISTORY>       mCurrent;   // writer's alias of mPublished
+    std::shared_ptr<TYPE_HISTORY>       mSpare;     // previous copy
+    std::atomic<uint64_t>               mUtcReportedNs;
+public:
+    inline SystemStatusSnapshot() : mUtcReportedNs(0) {}
+
+    // writer side, called with mMutexSystemStatus held
+    inline void setUtcReported(const timespec& ts) {
+        mUtcReportedNs.store((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec,
+                             std::memory_order_relaxed);
+    }
+    inline void publish(const TYPE_HISTORY& history) {
+        if (nullptr != mSpare && 1 == mSpare.use_count()) {
+            // order the last reader's release of this copy before overwriting it
+            std::atomic_thread_fence(std::memory_order_acquire);
+            *mSpare = history;
+        } else {
+            mSpare.reset(new (std::nothrow) TYPE_HISTORY(history));
+            if (nullptr == mSpare) {
+                LOC_LOGE("%s: failed to allocate report snapshot", __func__);
+                return;
+            }
+        }
+        std::atomic_store(&mPublished, std::shared_ptr<const TYPE_HISTORY>(mSpare));
+        mCurrent.swap(mSpare);
+    }
+
+    // reader side
+    inline std::shared_ptr<const TYPE_HISTORY> load() const {
+        return std::atomic_load(&mPublished);
+    }
+    inline void getUtcReported(timespec& ts) const {
+        uint64_t ns = mUtcReportedNs.load(std::memory_order_relaxed);
+        if (0 != ns) {
+            ts.tv_sec = ns / 1000000000ULL;
+            ts.tv_nsec = ns % 1000000000ULL;
+        }
+    }
+};
+
 /******************************************************************************
  SystemStatusReports
 ******************************************************************************/
@@ -738,49 +827,93 @@ class SystemStatusReports
 {
 public:
     // from QMI_LOC indication
-    std::vector<SystemStatusLocation>         mLocation;
+    SystemStatusHistory<SystemStatusLocation>         mLocation;
 
     // from ME debug NMEA
-    std::vector<SystemStatusTimeAndClock>     mTimeAndClock;
-    std::vector<SystemStatusXoState>          mXoState;
-    std::vector<SystemStatusRfAndParams>      mRfAndParams;
-    std::vector<SystemStatusErrRecovery>      mErrRecovery;
+    SystemStatusHistory<SystemStatusTimeAndClock>     mTimeAndClock;
+    SystemStatusHistory<SystemStatusXoState>          mXoState;
+    SystemStatusHistory<SystemStatusRfAndParams>      mRfAndParams;
+    SystemStatusHistory<SystemStatusErrRecovery>      mErrRecovery;
 
     // from PE debug NMEA
-    std::vector<SystemStatusInjectedPosition> mInjectedPosition;
-    std::vector<SystemStatusBestPosition>     mBestPosition;
-    std::vector<SystemStatusXtra>             mXtra;
-    std::vector<SystemStatusEphemeris>        mEphemeris;
-    std::vector<SystemStatusSvHealth>         mSvHealth;
-    std::vector<SystemStatusPdr>              mPdr;
-    std::vector<SystemStatusNavData>          mNavData;
+    SystemStatusHistory<SystemStatusInjectedPosition> mInjectedPosition;
+    SystemStatusHistory<SystemStatusBestPosition>     mBestPosition;
+    SystemStatusHistory<SystemStatusXtra>             mXtra;
+    SystemStatusHistory<SystemStatusEphemeris>        mEphemeris;
+    SystemStatusHistory<SystemStatusSvHealth>         mSvHealth;
+    SystemStatusHistory<SystemStatusPdr>              mPdr;
+    SystemStatusHistory<SystemStatusNavData>          mNavData;
 
     // from SM debug NMEA
-    std::vector<SystemStatusPositionFailure>  mPositionFailure;
+    SystemStatusHistory<SystemStatusPositionFailure>  mPositionFailure;
 
     // from dataitems observer
-    std::vector<SystemStatusAirplaneMode>     mAirplaneMode;
-    std::vector<SystemStatusENH>              mENH;
-    std::vector<SystemStatusGpsState>         mGPSState;
-    std::vector<SystemStatusNLPStatus>        mNLPStatus;
-    std::vector<SystemStatusWifiHardwareState> mWifiHardwareState;
-    std::vector<SystemStatusNetworkInfo>      mNetworkInfo;
-    std::vector<SystemStatusServiceInfo>      mRilServiceInfo;
-    std::vector<SystemStatusRilCellInfo>      mRilCellInfo;
-    std::vector<SystemStatusServiceStatus>    mServiceStatus;
-    std::vector<SystemStatusModel>            mModel;
-    std::vector<SystemStatusManufacturer>     mManufacturer;
-    std::vector<SystemStatusAssistedGps>      mAssistedGps;
-    std::vector<SystemStatusScreenState>      mScreenState;
-    std::vector<SystemStatusPowerConnectState> mPowerConnectState;
-    std::vector<SystemStatusTimeZoneChange>   mTimeZoneChange;
-    std::vector<SystemStatusTimeChange>       mTimeChange;
-    std::vector<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
-    std::vector<SystemStatusShutdownState>    mShutdownState;
-    std::vector<SystemStatusTac>              mTac;
-    std::vector<SystemStatusMccMnc>           mMccMnc;
-    std::vector<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
-    std::vector<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
+    SystemStatusHistory<SystemStatusAirplaneMode>     mAirplaneMode;
+    SystemStatusHistory<SystemStatusENH>              mENH;
+    SystemStatusHistory<SystemStatusGpsState>         mGPSState;
+    SystemStatusHistory<SystemStatusNLPStatus>        mNLPStatus;
+    SystemStatusHistory<SystemStatusWifiHardwareState> mWifiHardwareState;
+    SystemStatusHistory<SystemStatusNetworkInfo>      mNetworkInfo;
+    SystemStatusHistory<SystemStatusServiceInfo>      mRilServiceInfo;
+    SystemStatusHistory<SystemStatusRilCellInfo>      mRilCellInfo;
+    SystemStatusHistory<SystemStatusServiceStatus>    mServiceStatus;
+    SystemStatusHistory<SystemStatusModel>            mModel;
+    SystemStatusHistory<SystemStatusManufacturer>     mManufacturer;
+    SystemStatusHistory<SystemStatusAssistedGps>      mAssistedGps;
+    SystemStatusHistory<SystemStatusScreenState>      mScreenState;
+    SystemStatusHistory<SystemStatusPowerConnectState> mPowerConnectState;
+    SystemStatusHistory<SystemStatusTimeZoneChange>   mTimeZoneChange;
+    SystemStatusHistory<SystemStatusTimeChange>       mTimeChange;
+    SystemStatusHistory<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
+    SystemStatusHistory<SystemStatusShutdownState>    mShutdownState;
+    SystemStatusHistory<SystemStatusTac>              mTac;
+    SystemStatusHistory<SystemStatusMccMnc>           mMccMnc;
+    SystemStatusHistory<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
+    SystemStatusHistory<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
+};
+
+/******************************************************************************
+ SystemStatusSnapshots
+******************************************************************************/
+// the published copies of SystemStatusReports, one per report history
+class SystemStatusSnapshots
+{
+public:
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusLocation>> mLocation;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusTimeAndClock>> mTimeAndClock;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusXoState>> mXoState;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusRfAndParams>> mRfAndParams;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusErrRecovery>> mErrRecovery;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusInjectedPosition>> mInjectedPosition;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusBestPosition>> mBestPosition;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusXtra>> mXtra;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusEphemeris>> mEphemeris;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusSvHealth>> mSvHealth;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusPdr>> mPdr;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusNavData>> mNavData;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusPositionFailure>> mPositionFailure;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusAirplaneMode>> mAirplaneMode;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusENH>> mENH;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusGpsState>> mGPSState;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusNLPStatus>> mNLPStatus;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusWifiHardwareState>> mWifiHardwareState;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusNetworkInfo>> mNetworkInfo;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusServiceInfo>> mRilServiceInfo;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusRilCellInfo>> mRilCellInfo;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusServiceStatus>> mServiceStatus;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusModel>> mModel;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusManufacturer>> mManufacturer;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusAssistedGps>> mAssistedGps;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusScreenState>> mScreenState;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusPowerConnectState>> mPowerConnectState;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusTimeZoneChange>> mTimeZoneChange;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusTimeChange>> mTimeChange;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusWifiSupplicantStatus>> mWifiSupplicantStatus;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusShutdownState>> mShutdownState;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusTac>> mTac;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusMccMnc>> mMccMnc;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusBtDeviceScanDetail>> mBtDeviceScanDetail;
+    SystemStatusSnapshot<SystemStatusHistory<SystemStatusBtleDeviceScanDetail>> mBtLeDeviceScanDetail;
 };
 
 /******************************************************************************
@@ -800,15 +933,21 @@ private:
     static pthread_mutex_t                    mMutexSystemStatus;
     SystemStatusReports mCache;
 
+    // read only copies of the mCache histories for getReport()
+    SystemStatusSnapshots mSnapshot;
+
     template <typename TYPE_REPORT, typename TYPE_ITEM>
-    bool setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s);
+    bool setIteminReport(TYPE_REPORT& report, SystemStatusSnapshot<TYPE_REPORT>& snapshot,
+                         TYPE_ITEM&& s);
 
     // set default dataitem derived item in report cache
     template <typename TYPE_REPORT, typename TYPE_ITEM>
-    void setDefaultIteminReport(TYPE_REPORT& report, const TYPE_ITEM& s);
+    void setDefaultIteminReport(TYPE_REPORT& report, SystemStatusSnapshot<TYPE_REPORT>& snapshot,
+                                const TYPE_ITEM& s);
 
-    template <typename TYPE_REPORT, typename TYPE_ITEM>
-    void getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) const;
+    template <typename TYPE_REPORT>
+    void getIteminReport(TYPE_REPORT& reportout, const SystemStatusSnapshot<TYPE_REPORT>& c,
+                         bool isLatestOnly) const;
 
 public:
     // Static methods
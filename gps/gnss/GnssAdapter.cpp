@@ -67,7 +67,6 @@ GnssAdapter::GnssAdapter() :
     mUlpProxy(new UlpProxyBase()),
     mUlpPositionMode(),
     mGnssSvIdUsedInPosition(),
-    mGnssSvIdUsedInPosAvail(false),
     mControlCallbacks(),
     mPowerVoteId(0),
     mNmeaMask(0),
@@ -1333,6 +1332,7 @@ void
 GnssAdapter::saveClient(LocationAPI* client, const LocationCallbacks& callbacks)
 {
     mClientData[client] = callbacks;
+    updateClientsCallbacks();
     updateClientsEventMask();
 }
 
@@ -1343,9 +1343,37 @@ GnssAdapter::eraseClient(LocationAPI* client)
     if (it != mClientData.end()) {
         mClientData.erase(it);
     }
+    updateClientsCallbacks();
     updateClientsEventMask();
 }
 
+void
+GnssAdapter::updateClientsCallbacks()
+{
+    mTrackingClients.clear();
+    mLocationInfoClients.clear();
+    mSvClients.clear();
+    mNmeaClients.clear();
+    mMeasurementsClients.clear();
+    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
+        if (nullptr != it->second.trackingCb) {
+            mTrackingClients.push_back(&it->second);
+        }
+        if (nullptr != it->second.gnssLocationInfoCb) {
+            mLocationInfoClients.push_back(&it->second);
+        }
+        if (nullptr != it->second.gnssSvCb) {
+            mSvClients.push_back(&it->second);
+        }
+        if (nullptr != it->second.gnssNmeaCb) {
+            mNmeaClients.push_back(&it->second);
+        }
+        if (nullptr != it->second.gnssMeasurementsCb) {
+            mMeasurementsClients.push_back(&it->second);
+        }
+    }
+}
+
 bool
 GnssAdapter::hasTrackingCallback(LocationAPI* client)
 {
@@ -2111,19 +2139,26 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
     bool reported = needReport(ulpLocation, status, techMask);
     if (reported) {
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_GNSS_SV_USED_DATA) {
-            mGnssSvIdUsedInPosAvail = true;
-            mGnssSvIdUsedInPosition = locationExtended.gnss_sv_used_ids;
-        }
-        for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-            if (nullptr != it->second.trackingCb) {
-                Location location = {};
-                convertLocation(location, ulpLocation.gpsLocation, locationExtended, techMask);
-                it->second.trackingCb(location);
+            const GnssSvUsedInPosition& svUsed = locationExtended.gnss_sv_used_ids;
+            mGnssSvIdUsedInPosition[GNSS_SV_TYPE_GPS] = svUsed.gps_sv_used_ids_mask;
+            mGnssSvIdUsedInPosition[GNSS_SV_TYPE_GLONASS] = svUsed.glo_sv_used_ids_mask;
+            mGnssSvIdUsedInPosition[GNSS_SV_TYPE_BEIDOU] = svUsed.bds_sv_used_ids_mask;
+            mGnssSvIdUsedInPosition[GNSS_SV_TYPE_GALILEO] = svUsed.gal_sv_used_ids_mask;
+            mGnssSvIdUsedInPosition[GNSS_SV_TYPE_QZSS] = svUsed.qzss_sv_used_ids_mask;
+        }
+        // convert the fix once, then hand the same notification to every client
+        if (!mTrackingClients.empty()) {
+            Location location = {};
+            convertLocation(location, ulpLocation.gpsLocation, locationExtended, techMask);
+            for (size_t i = 0; i < mTrackingClients.size(); i++) {
+                mTrackingClients[i]->trackingCb(location);
             }
-            if (nullptr != it->second.gnssLocationInfoCb) {
-                GnssLocationInfoNotification locationInfo = {};
-                convertLocationInfo(locationInfo, locationExtended);
-                it->second.gnssLocationInfoCb(locationInfo);
+        }
+        if (!mLocationInfoClients.empty()) {
+            GnssLocationInfoNotification locationInfo = {};
+            convertLocationInfo(locationInfo, locationExtended);
+            for (size_t i = 0; i < mLocationInfoClients.size(); i++) {
+                mLocationInfoClients[i]->gnssLocationInfoCb(locationInfo);
             }
         }
     }
@@ -2135,10 +2170,10 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
                           (0 == ulpLocation.gpsLocation.longitude) &&
                           (LOC_RELIABILITY_NOT_SET == locationExtended.horizontal_reliability));
         uint8_t generate_nmea = (reported && status != LOC_SESS_FAILURE && !blank_fix);
-        std::vector<std::string> nmeaArraystr;
-        loc_nmea_generate_pos(ulpLocation, locationExtended, generate_nmea, nmeaArraystr);
-        for (auto sentence : nmeaArraystr) {
-            reportNmea(sentence.c_str(), sentence.length());
+        LocNmeaSentences nmeaSentences;
+        loc_nmea_generate_pos(ulpLocation, locationExtended, generate_nmea, nmeaSentences);
+        for (size_t i = 0; i < nmeaSentences.size(); i++) {
+            reportNmea(nmeaSentences[i]->data(), nmeaSentences[i]->length());
         }
     }
 
@@ -2185,68 +2220,38 @@ void
 GnssAdapter::reportSv(GnssSvNotification& svNotify)
 {
     int numSv = svNotify.count;
-    int16_t gnssSvId = 0;
-    uint64_t svUsedIdMask = 0;
     for (int i=0; i < numSv; i++) {
-        svUsedIdMask = 0;
-        gnssSvId = svNotify.gnssSvs[i].svId;
-        switch (svNotify.gnssSvs[i].type) {
-            case GNSS_SV_TYPE_GPS:
-                if (mGnssSvIdUsedInPosAvail) {
-                    svUsedIdMask = mGnssSvIdUsedInPosition.gps_sv_used_ids_mask;
-                }
-                break;
-            case GNSS_SV_TYPE_GLONASS:
-                if (mGnssSvIdUsedInPosAvail) {
-                    svUsedIdMask = mGnssSvIdUsedInPosition.glo_sv_used_ids_mask;
-                }
-                break;
-            case GNSS_SV_TYPE_BEIDOU:
-                if (mGnssSvIdUsedInPosAvail) {
-                    svUsedIdMask = mGnssSvIdUsedInPosition.bds_sv_used_ids_mask;
-                }
-                break;
-            case GNSS_SV_TYPE_GALILEO:
-                if (mGnssSvIdUsedInPosAvail) {
-                    svUsedIdMask = mGnssSvIdUsedInPosition.gal_sv_used_ids_mask;
-                }
-                break;
-            case GNSS_SV_TYPE_QZSS:
-                if (mGnssSvIdUsedInPosAvail) {
-                    svUsedIdMask = mGnssSvIdUsedInPosition.qzss_sv_used_ids_mask;
-                }
-                // QZSS SV id's need to reported as it is to framework, since
-                // framework expects it as it is. See GnssStatus.java.
-                // SV id passed to here by LocApi is 1-based.
-                svNotify.gnssSvs[i].svId += (QZSS_SV_PRN_MIN - 1);
-                break;
-            default:
-                svUsedIdMask = 0;
-                break;
-        }
+        GnssSv& gnssSv = svNotify.gnssSvs[i];
+        uint64_t svUsedIdMask = (gnssSv.type <= GNSS_SV_TYPE_GALILEO) ?
+                mGnssSvIdUsedInPosition[gnssSv.type] : 0;
 
         // If SV ID was used in previous position fix, then set USED_IN_FIX
         // flag, else clear the USED_IN_FIX flag.
-        if (svUsedIdMask & (1 << (gnssSvId - 1))) {
-            svNotify.gnssSvs[i].gnssSvOptionsMask |= GNSS_SV_OPTIONS_USED_IN_FIX_BIT;
+        if (gnssSv.svId > 0 && gnssSv.svId <= 64 &&
+            (svUsedIdMask & (1ULL << (gnssSv.svId - 1)))) {
+            gnssSv.gnssSvOptionsMask |= GNSS_SV_OPTIONS_USED_IN_FIX_BIT;
+        }
+        if (GNSS_SV_TYPE_QZSS == gnssSv.type) {
+            // QZSS SV id's need to reported as it is to framework, since
+            // framework expects it as it is. See GnssStatus.java.
+            // SV id passed to here by LocApi is 1-based.
+            gnssSv.svId += (QZSS_SV_PRN_MIN - 1);
         }
     }
 
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssSvCb) {
-            it->second.gnssSvCb(svNotify);
-        }
+    for (size_t i = 0; i < mSvClients.size(); i++) {
+        mSvClients[i]->gnssSvCb(svNotify);
     }
 
     if (NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER && !mTrackingSessions.empty()) {
-        std::vector<std::string> nmeaArraystr;
-        loc_nmea_generate_sv(svNotify, nmeaArraystr);
-        for (auto sentence : nmeaArraystr) {
-            reportNmea(sentence.c_str(), sentence.length());
+        LocNmeaSentences nmeaSentences;
+        loc_nmea_generate_sv(svNotify, nmeaSentences);
+        for (size_t i = 0; i < nmeaSentences.size(); i++) {
+            reportNmea(nmeaSentences[i]->data(), nmeaSentences[i]->length());
         }
     }
 
-    mGnssSvIdUsedInPosAvail = false;
+    memset(mGnssSvIdUsedInPosition, 0, sizeof(mGnssSvIdUsedInPosition));
 }
 
 void
@@ -2261,35 +2266,36 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length, bool fromUlp)
 
     struct MsgReportNmea : public LocMsg {
         GnssAdapter& mAdapter;
-        const char* mNmea;
-        size_t mLength;
+        LocNmeaSentence* mNmea;
         inline MsgReportNmea(GnssAdapter& adapter,
                              const char* nmea,
                              size_t length) :
             LocMsg(),
             mAdapter(adapter),
-            mNmea(new char[length+1]),
-            mLength(length) {
+            mNmea(LocNmeaSentence::obtain(nmea, length)) {
                 if (mNmea == nullptr) {
                     LOC_LOGE("%s] new allocation failed, fatal error.", __func__);
-                    return;
                 }
-                strlcpy((char*)mNmea, nmea, length+1);
             }
         inline virtual ~MsgReportNmea()
         {
-            delete[] mNmea;
+            if (mNmea != nullptr) {
+                mNmea->release();
+            }
         }
         inline virtual void proc() const {
+            if (mNmea == nullptr) {
+                return;
+            }
             // extract bug report info - this returns true if consumed by systemstatus
             bool ret = false;
             SystemStatus* s = mAdapter.getSystemStatus();
             if (nullptr != s) {
-                ret = s->setNmeaString(mNmea, mLength);
+                ret = s->setNmeaString(mNmea->data(), mNmea->length());
             }
             if (false == ret) {
                 // forward NMEA message to upper layer
-                mAdapter.reportNmea(mNmea, mLength);
+                mAdapter.reportNmea(mNmea->data(), mNmea->length());
             }
         }
     };
@@ -2310,10 +2316,8 @@ GnssAdapter::reportNmea(const char* nmea, size_t length)
     nmeaNotification.nmea = nmea;
     nmeaNotification.length = length;
 
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssNmeaCb) {
-            it->second.gnssNmeaCb(nmeaNotification);
-        }
+    for (size_t i = 0; i < mNmeaClients.size(); i++) {
+        mNmeaClients[i]->gnssNmeaCb(nmeaNotification);
     }
 }
 
@@ -2510,10 +2514,8 @@ GnssAdapter::reportGnssMeasurementDataEvent(const GnssMeasurementsNotification&
 void
 GnssAdapter::reportGnssMeasurementData(const GnssMeasurementsNotification& measurements)
 {
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssMeasurementsCb) {
-            it->second.gnssMeasurementsCb(measurements);
-        }
+    for (size_t i = 0; i < mMeasurementsClients.size(); i++) {
+        mMeasurementsClients[i]->gnssMeasurementsCb(measurements);
     }
 }
 
@@ -3231,6 +3233,20 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
     convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_GALILEO, reports);
     LOC_LOGV("getDebugReport - satellite=%zu", r.mSatelliteInfo.size());
 
+    // message pool block
+    LocMsgPoolStats poolStats;
+    LocMsg::getPoolStats(poolStats);
+    r.mMsgPool.size = sizeof(r.mMsgPool);
+    r.mMsgPool.mAllocs = poolStats.allocs;
+    r.mMsgPool.mFrees = poolStats.frees;
+    r.mMsgPool.mHeapAllocs = poolStats.heapAllocs;
+    r.mMsgPool.mInUse = poolStats.inUse;
+    r.mMsgPool.mPooled = poolStats.pooled;
+    LOC_LOGV("getDebugReport - msgpool allocs=%" PRIu64 " heap=%" PRIu64
+             " inuse=%" PRIu64 " pooled=%" PRIu64,
+             r.mMsgPool.mAllocs, r.mMsgPool.mHeapAllocs,
+             r.mMsgPool.mInUse, r.mMsgPool.mPooled);
+
     return true;
 }
 
@@ -3321,3 +3337,96 @@ static void agpsCloseResultCb (bool isSuccess, AGpsExtType agpsType, void* userD
         adapter->dataConnFailedCommand(agpsType);
     }
 }
+
+#ifdef __LOC_DEBUG__
+
+#include <stdio.h>
+#include <time.h>
+
+// Times reportPosition() + reportSv() for one fix of 24 SVs as the number of
+// clients with tracking, location info and SV callbacks grows. The callbacks
+// only touch the notification, so the numbers are the adapter's own
+// conversion and dispatch cost.
+//
+// For Linux command line testing:
+// compilation:
+//     g++ -D__LOC_DEBUG__ -O2 -std=c++11 -I. -I../core -I../core/data-items -I../core/observer -I../utils -I../location -I../pla/android -I../../../../system/core/include -o gnssadapter_bench GnssAdapter.cpp Agps.cpp XtraSystemStatusObserver.cpp ../core/*.cpp ../core/data-items/*.cpp ../utils/*.cpp ../utils/*.c -lpthread -ldl
+// usage:
+//     ./gnssadapter_bench [fixes]
+
+static volatile uint64_t gBenchSink = 0;
+
+int main(int argc, char** argv)
+{
+    int fixes = (argc > 1) ? atoi(argv[1]) : 100000;
+    if (fixes <= 0) {
+        printf("usage: %s [fixes]\n", argv[0]);
+        return 1;
+    }
+
+    GnssAdapter* adapter = new GnssAdapter();
+    LocationCallbacks callbacks = {};
+    callbacks.size = sizeof(LocationCallbacks);
+    callbacks.trackingCb = [](Location location) {
+        gBenchSink += location.timestamp;
+    };
+    callbacks.gnssLocationInfoCb = [](GnssLocationInfoNotification locationInfo) {
+        gBenchSink += locationInfo.flags;
+    };
+    callbacks.gnssSvCb = [](GnssSvNotification svNotify) {
+        gBenchSink += svNotify.count;
+    };
+
+    UlpLocation ulpLocation = {};
+    ulpLocation.size = sizeof(UlpLocation);
+    ulpLocation.gpsLocation.flags = LOC_GPS_LOCATION_HAS_LAT_LONG | LOC_GPS_LOCATION_HAS_ALTITUDE |
+            LOC_GPS_LOCATION_HAS_SPEED | LOC_GPS_LOCATION_HAS_BEARING |
+            LOC_GPS_LOCATION_HAS_ACCURACY;
+    ulpLocation.gpsLocation.latitude = 37.4219999;
+    ulpLocation.gpsLocation.longitude = -122.0840575;
+    GpsLocationExtended locationExtended = {};
+    locationExtended.size = sizeof(GpsLocationExtended);
+    locationExtended.flags = GPS_LOCATION_EXTENDED_HAS_DOP | GPS_LOCATION_EXTENDED_HAS_VERT_UNC |
+            GPS_LOCATION_EXTENDED_HAS_GNSS_SV_USED_DATA;
+    locationExtended.gnss_sv_used_ids.gps_sv_used_ids_mask = 0x00ff00ff;
+    locationExtended.gnss_sv_used_ids.glo_sv_used_ids_mask = 0x0000ffff;
+
+    GnssSvNotification svTemplate = {};
+    svTemplate.size = sizeof(GnssSvNotification);
+    svTemplate.count = 24;
+    static const GnssSvType svTypes[] = {
+        GNSS_SV_TYPE_GPS, GNSS_SV_TYPE_GLONASS, GNSS_SV_TYPE_BEIDOU,
+        GNSS_SV_TYPE_GALILEO, GNSS_SV_TYPE_QZSS, GNSS_SV_TYPE_SBAS
+    };
+    for (size_t i = 0; i < svTemplate.count; i++) {
+        svTemplate.gnssSvs[i].size = sizeof(GnssSv);
+        svTemplate.gnssSvs[i].type = svTypes[i % (sizeof(svTypes) / sizeof(svTypes[0]))];
+        svTemplate.gnssSvs[i].svId = 1 + i;
+    }
+
+    static const size_t clientCounts[] = { 1, 4, 16, 64 };
+    size_t clients = 0;
+    for (size_t c = 0; c < sizeof(clientCounts) / sizeof(clientCounts[0]); c++) {
+        for (; clients < clientCounts[c]; clients++) {
+            adapter->saveClient((LocationAPI*)(uintptr_t)(0x1000 + clients), callbacks);
+        }
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < fixes; i++) {
+            ulpLocation.gpsLocation.timestamp = i;
+            adapter->reportPosition(ulpLocation, locationExtended, LOC_SESS_SUCCESS,
+                                    LOC_POS_TECH_MASK_SATELLITE);
+            GnssSvNotification svNotify = svTemplate;
+            adapter->reportSv(svNotify);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double ns = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / fixes;
+        printf("%3zu clients: %8.0f ns/fix, %6.0f ns/fix/client\n",
+               clients, ns, ns / clients);
+    }
+    return 0;
+}
+
+#endif
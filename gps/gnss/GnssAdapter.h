@@ -36,6 +36,7 @@
 #include <Agps.h>
 #include <SystemStatus.h>
 #include <XtraSystemStatusObserver.h>
+#include <vector>
 
 #define MAX_URL_LEN 256
 #define NMEA_SENTENCE_MAX_LENGTH 200
@@ -118,12 +119,20 @@ class GnssAdapter : public LocAdapterBase {
     /* ==== CLIENT ========================================================================= */
     typedef std::map<LocationAPI*, LocationCallbacks> ClientDataMap;
     ClientDataMap mClientData;
+    // clients of each report callback, rebuilt by saveClient/eraseClient; the
+    // pointers refer to mClientData entries, which stay put until erased
+    typedef std::vector<const LocationCallbacks*> ClientCallbacksList;
+    ClientCallbacksList mTrackingClients;
+    ClientCallbacksList mLocationInfoClients;
+    ClientCallbacksList mSvClients;
+    ClientCallbacksList mNmeaClients;
+    ClientCallbacksList mMeasurementsClients;
 
     /* ==== TRACKING ======================================================================= */
     LocationSessionMap mTrackingSessions;
     LocPosMode mUlpPositionMode;
-    GnssSvUsedInPosition mGnssSvIdUsedInPosition;
-    bool mGnssSvIdUsedInPosAvail;
+    // SVs used in the last fix, indexed by GnssSvType; cleared once reported in reportSv
+    uint64_t mGnssSvIdUsedInPosition[GNSS_SV_TYPE_GALILEO + 1];
 
     /* ==== CONTROL ======================================================================== */
     LocationControlCallbacks mControlCallbacks;
@@ -186,6 +195,7 @@ public:
     void saveClient(LocationAPI* client, const LocationCallbacks& callbacks);
     void eraseClient(LocationAPI* client);
     void updateClientsEventMask();
+    void updateClientsCallbacks();
     void stopClientSessions(LocationAPI* client);
     LocationCallbacks getClientCallbacks(LocationAPI* client);
     LocationCapabilitiesMask getCapabilities();
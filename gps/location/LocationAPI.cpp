@@ -33,24 +33,32 @@
 #include <log_util.h>
 #include <pthread.h>
 #include <map>
+#include <memory>
+#include <atomic>
 
 typedef void* (getLocationInterface)();
 typedef std::map<LocationAPI*, LocationCallbacks> LocationClientMap;
+typedef std::shared_ptr<const LocationClientMap> LocationClientMapPtr;
+/* Every API call looks up its client and interface, while clients and
+   interfaces only change on create/update/destroy. Writers serialize on
+   gDataMutex and publish a new copy of the client map with atomic_store;
+   callers take a snapshot with atomic_load and never wait on the lock.
+   An interface pointer is published once, after its initialize(). */
 typedef struct {
-    LocationClientMap clientData;
+    LocationClientMapPtr clientData;
     LocationControlAPI* controlAPI;
     LocationControlCallbacks controlCallbacks;
-    GnssInterface* gnssInterface;
-    GeofenceInterface* geofenceInterface;
-    FlpInterface* flpInterface;
+    std::atomic<GnssInterface*> gnssInterface;
+    std::atomic<GeofenceInterface*> geofenceInterface;
+    std::atomic<FlpInterface*> flpInterface;
 } LocationAPIData;
-static LocationAPIData gData = {};
+static LocationAPIData gData;
 static pthread_mutex_t gDataMutex = PTHREAD_MUTEX_INITIALIZER;
 static bool gGnssLoadFailed = false;
 static bool gFlpLoadFailed = false;
 static bool gGeofenceLoadFailed = false;
 
-static bool needsGnssTrackingInfo(LocationCallbacks& locationCallbacks)
+static bool needsGnssTrackingInfo(const LocationCallbacks& locationCallbacks)
 {
     return (locationCallbacks.gnssLocationInfoCb != nullptr ||
             locationCallbacks.gnssSvCb != nullptr ||
@@ -58,25 +66,68 @@ static bool needsGnssTrackingInfo(LocationCallbacks& locationCallbacks)
             locationCallbacks.gnssMeasurementsCb != nullptr);
 }
 
-static bool isGnssClient(LocationCallbacks& locationCallbacks)
+static bool isGnssClient(const LocationCallbacks& locationCallbacks)
 {
     return (locationCallbacks.gnssNiCb != nullptr ||
             locationCallbacks.trackingCb != nullptr ||
             locationCallbacks.gnssMeasurementsCb != nullptr);
 }
 
-static bool isFlpClient(LocationCallbacks& locationCallbacks)
+static bool isFlpClient(const LocationCallbacks& locationCallbacks)
 {
     return (locationCallbacks.trackingCb != nullptr ||
             locationCallbacks.batchingCb != nullptr);
 }
 
-static bool isGeofenceClient(LocationCallbacks& locationCallbacks)
+static bool isGeofenceClient(const LocationCallbacks& locationCallbacks)
 {
     return (locationCallbacks.geofenceBreachCb != nullptr ||
             locationCallbacks.geofenceStatusCb != nullptr);
 }
 
+static inline GnssInterface* loadedGnssInterface()
+{
+    return gData.gnssInterface.load(std::memory_order_acquire);
+}
+
+static inline FlpInterface* loadedFlpInterface()
+{
+    return gData.flpInterface.load(std::memory_order_acquire);
+}
+
+static inline GeofenceInterface* loadedGeofenceInterface()
+{
+    return gData.geofenceInterface.load(std::memory_order_acquire);
+}
+
+// returns the callbacks of client in the given snapshot, or NULL if not registered
+static const LocationCallbacks* findClient(const LocationClientMapPtr& clientData,
+                                           LocationAPI* client)
+{
+    if (nullptr != clientData) {
+        auto it = clientData->find(client);
+        if (it != clientData->end()) {
+            return &it->second;
+        }
+    }
+    return NULL;
+}
+
+// gDataMutex must be held; NULL callbacks removes the client
+static void publishClient(LocationAPI* client, const LocationCallbacks* locationCallbacks)
+{
+    LocationClientMapPtr clientData = std::atomic_load(&gData.clientData);
+    std::shared_ptr<LocationClientMap> newClientData = (nullptr == clientData) ?
+            std::make_shared<LocationClientMap>() :
+            std::make_shared<LocationClientMap>(*clientData);
+    if (NULL != locationCallbacks) {
+        (*newClientData)[client] = *locationCallbacks;
+    } else {
+        newClientData->erase(client);
+    }
+    std::atomic_store(&gData.clientData, LocationClientMapPtr(newClientData));
+}
+
 static void* loadLocationInterface(const char* library, const char* name) {
     LOC_LOGD("%s]: loading %s::%s ...", __func__, library, name);
     if (NULL == library || NULL == name) {
@@ -103,6 +154,44 @@ static void* loadLocationInterface(const char* library, const char* name) {
     }
 }
 
+// gDataMutex must be held
+template <typename LocationInterface>
+static LocationInterface* loadInterface(std::atomic<LocationInterface*>& loaded,
+                                        bool& loadFailed, const char* library,
+                                        const char* name, const char* tag)
+{
+    LocationInterface* locationInterface = loaded.load(std::memory_order_relaxed);
+    if (NULL == locationInterface && !loadFailed) {
+        locationInterface = (LocationInterface*)loadLocationInterface(library, name);
+        if (NULL == locationInterface) {
+            loadFailed = true;
+            LOC_LOGW("%s:%d]: No %s interface available", __func__, __LINE__, tag);
+        } else {
+            locationInterface->initialize();
+            loaded.store(locationInterface, std::memory_order_release);
+        }
+    }
+    return locationInterface;
+}
+
+static inline GnssInterface* loadGnssInterface()
+{
+    return loadInterface(gData.gnssInterface, gGnssLoadFailed,
+                         "libgnss.so", "getGnssInterface", "gnss");
+}
+
+static inline FlpInterface* loadFlpInterface()
+{
+    return loadInterface(gData.flpInterface, gFlpLoadFailed,
+                         "libflp.so", "getFlpInterface", "flp");
+}
+
+static inline GeofenceInterface* loadGeofenceInterface()
+{
+    return loadInterface(gData.geofenceInterface, gGeofenceLoadFailed,
+                         "libgeofence.so", "getGeofenceInterface", "geofence");
+}
+
 LocationAPI*
 LocationAPI::createInstance(LocationCallbacks& locationCallbacks)
 {
@@ -118,66 +207,39 @@ LocationAPI::createInstance(LocationCallbacks& locationCallbacks)
     pthread_mutex_lock(&gDataMutex);
 
     if (isGnssClient(locationCallbacks)) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
-        if (NULL != gData.gnssInterface) {
-            gData.gnssInterface->addClient(newLocationAPI, locationCallbacks);
+        GnssInterface* gnssInterface = loadGnssInterface();
+        if (NULL != gnssInterface) {
+            gnssInterface->addClient(newLocationAPI, locationCallbacks);
             if (!requestedCapabilities) {
-                gData.gnssInterface->requestCapabilities(newLocationAPI);
+                gnssInterface->requestCapabilities(newLocationAPI);
                 requestedCapabilities = true;
             }
         }
     }
 
     if (isFlpClient(locationCallbacks)) {
-        if (NULL == gData.flpInterface && !gFlpLoadFailed) {
-            gData.flpInterface =
-                (FlpInterface*)loadLocationInterface("libflp.so", "getFlpInterface");
-            if (NULL == gData.flpInterface) {
-                gFlpLoadFailed = true;
-                LOC_LOGW("%s:%d]: No flp interface available", __func__, __LINE__);
-            } else {
-                gData.flpInterface->initialize();
-            }
-        }
-        if (NULL != gData.flpInterface) {
-            gData.flpInterface->addClient(newLocationAPI, locationCallbacks);
+        FlpInterface* flpInterface = loadFlpInterface();
+        if (NULL != flpInterface) {
+            flpInterface->addClient(newLocationAPI, locationCallbacks);
             if (!requestedCapabilities) {
-                gData.flpInterface->requestCapabilities(newLocationAPI);
+                flpInterface->requestCapabilities(newLocationAPI);
                 requestedCapabilities = true;
             }
         }
     }
 
     if (isGeofenceClient(locationCallbacks)) {
-        if (NULL == gData.geofenceInterface && !gGeofenceLoadFailed) {
-            gData.geofenceInterface =
-                (GeofenceInterface*)loadLocationInterface("libgeofence.so", "getGeofenceInterface");
-            if (NULL == gData.geofenceInterface) {
-                gGeofenceLoadFailed = true;
-                LOC_LOGW("%s:%d]: No geofence interface available", __func__, __LINE__);
-            } else {
-                gData.geofenceInterface->initialize();
-            }
-        }
-        if (NULL != gData.geofenceInterface) {
-            gData.geofenceInterface->addClient(newLocationAPI, locationCallbacks);
+        GeofenceInterface* geofenceInterface = loadGeofenceInterface();
+        if (NULL != geofenceInterface) {
+            geofenceInterface->addClient(newLocationAPI, locationCallbacks);
             if (!requestedCapabilities) {
-                gData.geofenceInterface->requestCapabilities(newLocationAPI);
+                geofenceInterface->requestCapabilities(newLocationAPI);
                 requestedCapabilities = true;
             }
         }
     }
 
-    gData.clientData[newLocationAPI] = locationCallbacks;
+    publishClient(newLocationAPI, &locationCallbacks);
 
     pthread_mutex_unlock(&gDataMutex);
 
@@ -200,18 +262,22 @@ LocationAPI::~LocationAPI()
     LOC_LOGD("LOCATION API DESTRUCTOR");
     pthread_mutex_lock(&gDataMutex);
 
-    auto it = gData.clientData.find(this);
-    if (it != gData.clientData.end()) {
-        if (isGnssClient(it->second) && NULL != gData.gnssInterface) {
-            gData.gnssInterface->removeClient(it->first);
+    GnssInterface* gnssInterface = loadedGnssInterface();
+    FlpInterface* flpInterface = loadedFlpInterface();
+    GeofenceInterface* geofenceInterface = loadedGeofenceInterface();
+    LocationClientMapPtr clientData = std::atomic_load(&gData.clientData);
+    const LocationCallbacks* locationCallbacks = findClient(clientData, this);
+    if (NULL != locationCallbacks) {
+        if (isGnssClient(*locationCallbacks) && NULL != gnssInterface) {
+            gnssInterface->removeClient(this);
         }
-        if (isFlpClient(it->second) && NULL != gData.flpInterface) {
-            gData.flpInterface->removeClient(it->first);
+        if (isFlpClient(*locationCallbacks) && NULL != flpInterface) {
+            flpInterface->removeClient(this);
         }
-        if (isGeofenceClient(it->second) && NULL != gData.geofenceInterface) {
-            gData.geofenceInterface->removeClient(it->first);
+        if (isGeofenceClient(*locationCallbacks) && NULL != geofenceInterface) {
+            geofenceInterface->removeClient(this);
         }
-        gData.clientData.erase(it);
+        publishClient(this, NULL);
     } else {
         LOC_LOGE("%s:%d]: Location API client %p not found in client data",
                  __func__, __LINE__, this);
@@ -232,57 +298,30 @@ LocationAPI::updateCallbacks(LocationCallbacks& locationCallbacks)
     pthread_mutex_lock(&gDataMutex);
 
     if (isGnssClient(locationCallbacks)) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
-        if (NULL != gData.gnssInterface) {
+        GnssInterface* gnssInterface = loadGnssInterface();
+        if (NULL != gnssInterface) {
             // either adds new Client or updates existing Client
-            gData.gnssInterface->addClient(this, locationCallbacks);
+            gnssInterface->addClient(this, locationCallbacks);
         }
     }
 
     if (isFlpClient(locationCallbacks)) {
-        if (NULL == gData.flpInterface && !gFlpLoadFailed) {
-            gData.flpInterface =
-                (FlpInterface*)loadLocationInterface("libflp.so", "getFlpInterface");
-            if (NULL == gData.flpInterface) {
-                gFlpLoadFailed = true;
-                LOC_LOGW("%s:%d]: No flp interface available", __func__, __LINE__);
-            } else {
-                gData.flpInterface->initialize();
-            }
-        }
-        if (NULL != gData.flpInterface) {
+        FlpInterface* flpInterface = loadFlpInterface();
+        if (NULL != flpInterface) {
             // either adds new Client or updates existing Client
-            gData.flpInterface->addClient(this, locationCallbacks);
+            flpInterface->addClient(this, locationCallbacks);
         }
     }
 
     if (isGeofenceClient(locationCallbacks)) {
-        if (NULL == gData.geofenceInterface && !gGeofenceLoadFailed) {
-            gData.geofenceInterface =
-                (GeofenceInterface*)loadLocationInterface("libgeofence.so", "getGeofenceInterface");
-            if (NULL == gData.geofenceInterface) {
-                gGeofenceLoadFailed = true;
-                LOC_LOGW("%s:%d]: No geofence interface available", __func__, __LINE__);
-            } else {
-                gData.geofenceInterface->initialize();
-            }
-        }
-        if (NULL != gData.geofenceInterface) {
+        GeofenceInterface* geofenceInterface = loadGeofenceInterface();
+        if (NULL != geofenceInterface) {
             // either adds new Client or updates existing Client
-            gData.geofenceInterface->addClient(this, locationCallbacks);
+            geofenceInterface->addClient(this, locationCallbacks);
         }
     }
 
-    gData.clientData[this] = locationCallbacks;
+    publishClient(this, &locationCallbacks);
 
     pthread_mutex_unlock(&gDataMutex);
 }
@@ -291,18 +330,20 @@ uint32_t
 LocationAPI::startTracking(LocationOptions& locationOptions)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
-
-    auto it = gData.clientData.find(this);
-    if (it != gData.clientData.end()) {
-        if (gData.flpInterface != NULL && locationOptions.minDistance > 0) {
-            id = gData.flpInterface->startTracking(this, locationOptions);
-        } else if (gData.gnssInterface != NULL && needsGnssTrackingInfo(it->second)) {
-            id = gData.gnssInterface->startTracking(this, locationOptions);
-        } else if (gData.flpInterface != NULL) {
-            id = gData.flpInterface->startTracking(this, locationOptions);
-        } else if (gData.gnssInterface != NULL) {
-            id = gData.gnssInterface->startTracking(this, locationOptions);
+    GnssInterface* gnssInterface = loadedGnssInterface();
+    FlpInterface* flpInterface = loadedFlpInterface();
+
+    LocationClientMapPtr clientData = std::atomic_load(&gData.clientData);
+    const LocationCallbacks* locationCallbacks = findClient(clientData, this);
+    if (NULL != locationCallbacks) {
+        if (flpInterface != NULL && locationOptions.minDistance > 0) {
+            id = flpInterface->startTracking(this, locationOptions);
+        } else if (gnssInterface != NULL && needsGnssTrackingInfo(*locationCallbacks)) {
+            id = gnssInterface->startTracking(this, locationOptions);
+        } else if (flpInterface != NULL) {
+            id = flpInterface->startTracking(this, locationOptions);
+        } else if (gnssInterface != NULL) {
+            id = gnssInterface->startTracking(this, locationOptions);
         } else {
             LOC_LOGE("%s:%d]: No gnss/flp interface available for Location API client %p ",
                      __func__, __LINE__, this);
@@ -312,26 +353,27 @@ LocationAPI::startTracking(LocationOptions& locationOptions)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 void
 LocationAPI::stopTracking(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = loadedGnssInterface();
+    FlpInterface* flpInterface = loadedFlpInterface();
 
-    auto it = gData.clientData.find(this);
-    if (it != gData.clientData.end()) {
+    LocationClientMapPtr clientData = std::atomic_load(&gData.clientData);
+    const LocationCallbacks* locationCallbacks = findClient(clientData, this);
+    if (NULL != locationCallbacks) {
         // we don't know if tracking was started on flp or gnss, so we call stop on both, where
         // stopTracking call to the incorrect interface will fail without response back to client
-        if (gData.gnssInterface != NULL) {
-            gData.gnssInterface->stopTracking(this, id);
+        if (gnssInterface != NULL) {
+            gnssInterface->stopTracking(this, id);
         }
-        if (gData.flpInterface != NULL) {
-            gData.flpInterface->stopTracking(this, id);
+        if (flpInterface != NULL) {
+            flpInterface->stopTracking(this, id);
         }
-        if (gData.flpInterface == NULL && gData.gnssInterface == NULL) {
+        if (flpInterface == NULL && gnssInterface == NULL) {
             LOC_LOGE("%s:%d]: No gnss/flp interface available for Location API client %p ",
                      __func__, __LINE__, this);
         }
@@ -339,26 +381,26 @@ LocationAPI::stopTracking(uint32_t id)
         LOC_LOGE("%s:%d]: Location API client %p not found in client data",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::updateTrackingOptions(uint32_t id, LocationOptions& locationOptions)
 {
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = loadedGnssInterface();
+    FlpInterface* flpInterface = loadedFlpInterface();
 
-    auto it = gData.clientData.find(this);
-    if (it != gData.clientData.end()) {
+    LocationClientMapPtr clientData = std::atomic_load(&gData.clientData);
+    const LocationCallbacks* locationCallbacks = findClient(clientData, this);
+    if (NULL != locationCallbacks) {
         // we don't know if tracking was started on flp or gnss, so we call update on both, where
         // updateTracking call to the incorrect interface will fail without response back to client
-        if (gData.gnssInterface != NULL) {
-            gData.gnssInterface->updateTrackingOptions(this, id, locationOptions);
+        if (gnssInterface != NULL) {
+            gnssInterface->updateTrackingOptions(this, id, locationOptions);
         }
-        if (gData.flpInterface != NULL) {
-            gData.flpInterface->updateTrackingOptions(this, id, locationOptions);
+        if (flpInterface != NULL) {
+            flpInterface->updateTrackingOptions(this, id, locationOptions);
         }
-        if (gData.flpInterface == NULL && gData.gnssInterface == NULL) {
+        if (flpInterface == NULL && gnssInterface == NULL) {
             LOC_LOGE("%s:%d]: No gnss/flp interface available for Location API client %p ",
                      __func__, __LINE__, this);
         }
@@ -366,166 +408,146 @@ LocationAPI::updateTrackingOptions(uint32_t id, LocationOptions& locationOptions
         LOC_LOGE("%s:%d]: Location API client %p not found in client data",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 uint32_t
 LocationAPI::startBatching(LocationOptions& locationOptions, BatchingOptions &batchingOptions)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    FlpInterface* flpInterface = loadedFlpInterface();
 
-    if (gData.flpInterface != NULL) {
-        id = gData.flpInterface->startBatching(this, locationOptions, batchingOptions);
+    if (flpInterface != NULL) {
+        id = flpInterface->startBatching(this, locationOptions, batchingOptions);
     } else {
         LOC_LOGE("%s:%d]: No flp interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 void
 LocationAPI::stopBatching(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
+    FlpInterface* flpInterface = loadedFlpInterface();
 
-    if (gData.flpInterface != NULL) {
-        gData.flpInterface->stopBatching(this, id);
+    if (flpInterface != NULL) {
+        flpInterface->stopBatching(this, id);
     } else {
         LOC_LOGE("%s:%d]: No flp interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::updateBatchingOptions(uint32_t id,
         LocationOptions& locationOptions, BatchingOptions& batchOptions)
 {
-    pthread_mutex_lock(&gDataMutex);
+    FlpInterface* flpInterface = loadedFlpInterface();
 
-    if (gData.flpInterface != NULL) {
-        gData.flpInterface->updateBatchingOptions(this,
-                                                  id,
-                                                  locationOptions,
-                                                  batchOptions);
+    if (flpInterface != NULL) {
+        flpInterface->updateBatchingOptions(this,
+                                            id,
+                                            locationOptions,
+                                            batchOptions);
     } else {
         LOC_LOGE("%s:%d]: No flp interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::getBatchedLocations(uint32_t id, size_t count)
 {
-    pthread_mutex_lock(&gDataMutex);
+    FlpInterface* flpInterface = loadedFlpInterface();
 
-    if (gData.flpInterface != NULL) {
-        gData.flpInterface->getBatchedLocations(this, id, count);
+    if (flpInterface != NULL) {
+        flpInterface->getBatchedLocations(this, id, count);
     } else {
         LOC_LOGE("%s:%d]: No flp interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 uint32_t*
 LocationAPI::addGeofences(size_t count, GeofenceOption* options, GeofenceInfo* info)
 {
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
+    GeofenceInterface* geofenceInterface = loadedGeofenceInterface();
 
-    if (gData.geofenceInterface != NULL) {
-        ids = gData.geofenceInterface->addGeofences(this, count, options, info);
+    if (geofenceInterface != NULL) {
+        ids = geofenceInterface->addGeofences(this, count, options, info);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return ids;
 }
 
 void
 LocationAPI::removeGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
+    GeofenceInterface* geofenceInterface = loadedGeofenceInterface();
 
-    if (gData.geofenceInterface != NULL) {
-        gData.geofenceInterface->removeGeofences(this, count, ids);
+    if (geofenceInterface != NULL) {
+        geofenceInterface->removeGeofences(this, count, ids);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::modifyGeofences(size_t count, uint32_t* ids, GeofenceOption* options)
 {
-    pthread_mutex_lock(&gDataMutex);
+    GeofenceInterface* geofenceInterface = loadedGeofenceInterface();
 
-    if (gData.geofenceInterface != NULL) {
-        gData.geofenceInterface->modifyGeofences(this, count, ids, options);
+    if (geofenceInterface != NULL) {
+        geofenceInterface->modifyGeofences(this, count, ids, options);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::pauseGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
+    GeofenceInterface* geofenceInterface = loadedGeofenceInterface();
 
-    if (gData.geofenceInterface != NULL) {
-        gData.geofenceInterface->pauseGeofences(this, count, ids);
+    if (geofenceInterface != NULL) {
+        geofenceInterface->pauseGeofences(this, count, ids);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::resumeGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
+    GeofenceInterface* geofenceInterface = loadedGeofenceInterface();
 
-    if (gData.geofenceInterface != NULL) {
-        gData.geofenceInterface->resumeGeofences(this, count, ids);
+    if (geofenceInterface != NULL) {
+        geofenceInterface->resumeGeofences(this, count, ids);
     } else {
         LOC_LOGE("%s:%d]: No geofence interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 void
 LocationAPI::gnssNiResponse(uint32_t id, GnssNiResponse response)
 {
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = loadedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        gData.gnssInterface->gnssNiResponse(this, id, response);
+    if (gnssInterface != NULL) {
+        gnssInterface->gnssNiResponse(this, id, response);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 LocationControlAPI*
@@ -535,20 +557,11 @@ LocationControlAPI::createInstance(LocationControlCallbacks& locationControlCall
     pthread_mutex_lock(&gDataMutex);
 
     if (nullptr != locationControlCallbacks.responseCb && NULL == gData.controlAPI) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
-        if (NULL != gData.gnssInterface) {
+        GnssInterface* gnssInterface = loadGnssInterface();
+        if (NULL != gnssInterface) {
             gData.controlAPI = new LocationControlAPI();
             gData.controlCallbacks = locationControlCallbacks;
-            gData.gnssInterface->setControlCallbacks(locationControlCallbacks);
+            gnssInterface->setControlCallbacks(locationControlCallbacks);
             controlAPI = gData.controlAPI;
         }
     }
@@ -582,48 +595,44 @@ uint32_t
 LocationControlAPI::enable(LocationTechnologyType techType)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = loadedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->enable(techType);
+    if (gnssInterface != NULL) {
+        id = gnssInterface->enable(techType);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location Control API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
 
 void
 LocationControlAPI::disable(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = loadedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        gData.gnssInterface->disable(id);
+    if (gnssInterface != NULL) {
+        gnssInterface->disable(id);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location Control API client %p ",
                  __func__, __LINE__, this);
     }
-
-    pthread_mutex_unlock(&gDataMutex);
 }
 
 uint32_t*
 LocationControlAPI::gnssUpdateConfig(GnssConfig config)
 {
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = loadedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        ids = gData.gnssInterface->gnssUpdateConfig(config);
+    if (gnssInterface != NULL) {
+        ids = gnssInterface->gnssUpdateConfig(config);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location Control API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return ids;
 }
 
@@ -631,15 +640,181 @@ uint32_t
 LocationControlAPI::gnssDeleteAidingData(GnssAidingData& data)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    GnssInterface* gnssInterface = loadedGnssInterface();
 
-    if (gData.gnssInterface != NULL) {
-        id = gData.gnssInterface->gnssDeleteAidingData(data);
+    if (gnssInterface != NULL) {
+        id = gnssInterface->gnssDeleteAidingData(data);
     } else {
         LOC_LOGE("%s:%d]: No gnss interface available for Location Control API client %p ",
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
     return id;
 }
+
+#ifdef __LOC_DEBUG__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include <algorithm>
+
+// Stress test of the client registry: worker threads, each owning one client,
+// issue startTracking/updateTrackingOptions/stopTracking against a no-op gnss
+// interface while the rest of the clients sit idle in the registry and one
+// more thread keeps creating and destroying clients. Reports the latency of
+// each call as the number of registered clients grows. With "serial", every
+// call also takes one global mutex, as all calls did before the registry
+// snapshot, for comparison.
+//
+// For Linux command line testing:
+// compilation:
+//     g++ -D__LOC_DEBUG__ -O2 -std=c++11 -I. -I../utils -I../pla/android -I../../../../system/core/include -o locationapi_bench LocationAPI.cpp -lpthread -ldl
+// usage:
+//     ./locationapi_bench [threads] [calls per thread] [serial]
+
+static std::atomic<uint32_t> gBenchSessionId(1);
+static std::atomic<bool> gBenchDone(false);
+static bool gBenchSerial = false;
+static pthread_mutex_t gBenchMutex = PTHREAD_MUTEX_INITIALIZER;
+static int gBenchCalls = 0;
+
+static void benchInitialize() {}
+static void benchClient(LocationAPI*, const LocationCallbacks&) {}
+static void benchRemoveClient(LocationAPI*) {}
+static void benchRequestCapabilities(LocationAPI*) {}
+static uint32_t benchStartTracking(LocationAPI*, LocationOptions&)
+{
+    return gBenchSessionId.fetch_add(1, std::memory_order_relaxed);
+}
+static void benchUpdateTrackingOptions(LocationAPI*, uint32_t, LocationOptions&) {}
+static void benchStopTracking(LocationAPI*, uint32_t) {}
+
+static LocationCallbacks benchCallbacks()
+{
+    LocationCallbacks callbacks = {};
+    callbacks.size = sizeof(LocationCallbacks);
+    callbacks.capabilitiesCb = [](LocationCapabilitiesMask) {};
+    callbacks.responseCb = [](LocationError, uint32_t) {};
+    callbacks.collectiveResponseCb = [](size_t, LocationError*, uint32_t*) {};
+    callbacks.trackingCb = [](Location) {};
+    return callbacks;
+}
+
+static inline uint64_t benchNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void* benchWorker(void* arg)
+{
+    std::vector<uint64_t>& samples = *(std::vector<uint64_t>*)arg;
+    LocationCallbacks callbacks = benchCallbacks();
+    LocationAPI* client = LocationAPI::createInstance(callbacks);
+    LocationOptions options;
+    memset(&options, 0, sizeof(options));
+    options.size = sizeof(options);
+    options.minInterval = 1000;
+
+    for (int i = 0; i < gBenchCalls; i++) {
+        uint64_t start = benchNow();
+        if (gBenchSerial) {
+            pthread_mutex_lock(&gBenchMutex);
+        }
+        uint32_t id = client->startTracking(options);
+        client->updateTrackingOptions(id, options);
+        client->stopTracking(id);
+        if (gBenchSerial) {
+            pthread_mutex_unlock(&gBenchMutex);
+        }
+        samples.push_back(benchNow() - start);
+    }
+    client->destroy();
+    return NULL;
+}
+
+static void* benchChurn(void*)
+{
+    LocationCallbacks callbacks = benchCallbacks();
+    while (!gBenchDone.load()) {
+        LocationAPI* client = LocationAPI::createInstance(callbacks);
+        usleep(100);
+        client->destroy();
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    int threads = (argc > 1) ? atoi(argv[1]) : 8;
+    gBenchCalls = (argc > 2) ? atoi(argv[2]) : 200000;
+    gBenchSerial = (argc > 3) && (0 == strcmp(argv[3], "serial"));
+    if (threads <= 0 || gBenchCalls <= 0) {
+        printf("usage: %s [threads] [calls per thread] [serial]\n", argv[0]);
+        return 1;
+    }
+
+    static GnssInterface gnssInterface;
+    memset(&gnssInterface, 0, sizeof(gnssInterface));
+    gnssInterface.size = sizeof(gnssInterface);
+    gnssInterface.initialize = benchInitialize;
+    gnssInterface.addClient = benchClient;
+    gnssInterface.removeClient = benchRemoveClient;
+    gnssInterface.requestCapabilities = benchRequestCapabilities;
+    gnssInterface.startTracking = benchStartTracking;
+    gnssInterface.updateTrackingOptions = benchUpdateTrackingOptions;
+    gnssInterface.stopTracking = benchStopTracking;
+    gData.gnssInterface.store(&gnssInterface);
+    gFlpLoadFailed = true;
+    gGeofenceLoadFailed = true;
+
+    static const int idleClients[] = { 0, 16, 256, 4096 };
+    for (size_t c = 0; c < sizeof(idleClients) / sizeof(idleClients[0]); c++) {
+        LocationCallbacks callbacks = benchCallbacks();
+        std::vector<LocationAPI*> idle;
+        for (int i = 0; i < idleClients[c]; i++) {
+            idle.push_back(LocationAPI::createInstance(callbacks));
+        }
+
+        std::vector<std::vector<uint64_t>> samples(threads);
+        std::vector<pthread_t> workers(threads);
+        pthread_t churn;
+        gBenchDone.store(false);
+        pthread_create(&churn, NULL, benchChurn, NULL);
+        uint64_t start = benchNow();
+        for (int t = 0; t < threads; t++) {
+            samples[t].reserve(gBenchCalls);
+            pthread_create(&workers[t], NULL, benchWorker, &samples[t]);
+        }
+        for (int t = 0; t < threads; t++) {
+            pthread_join(workers[t], NULL);
+        }
+        double secs = (benchNow() - start) / 1e9;
+        gBenchDone.store(true);
+        pthread_join(churn, NULL);
+
+        std::vector<uint64_t> all;
+        for (int t = 0; t < threads; t++) {
+            all.insert(all.end(), samples[t].begin(), samples[t].end());
+        }
+        std::sort(all.begin(), all.end());
+        printf("%s %d threads, %5d clients: %8.0f calls/sec, "
+               "latency p50 %6" PRIu64 " ns, p99 %7" PRIu64 " ns, max %9" PRIu64 " ns\n",
+               gBenchSerial ? "serial" : "snapshot", threads, threads + idleClients[c],
+               3.0 * all.size() / secs, all[all.size() / 2],
+               all[all.size() * 99 / 100], all.back());
+
+        for (size_t i = 0; i < idle.size(); i++) {
+            idle[i]->destroy();
+        }
+    }
+    return 0;
+}
+
+#endif
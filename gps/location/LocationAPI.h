@@ -647,11 +647,21 @@ typedef struct {
     float                               serverPredictionAgeSeconds;
 } GnssDebugSatelliteInfo;
 
+typedef struct {
+    size_t size;                        // set to sizeof
+    uint64_t                            mAllocs;
+    uint64_t                            mFrees;
+    uint64_t                            mHeapAllocs;
+    uint64_t                            mInUse;
+    uint64_t                            mPooled;
+} GnssDebugMsgPool;
+
 typedef struct {
     size_t size;                        // set to sizeof
     GnssDebugLocation                   mLocation;
     GnssDebugTime                       mTime;
     std::vector<GnssDebugSatelliteInfo> mSatelliteInfo;
+    GnssDebugMsgPool                    mMsgPool;
 } GnssDebugReport;
 
 /* Provides the capabilities of the system
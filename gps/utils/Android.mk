@@ -36,6 +36,11 @@ ifeq ($(TARGET_BUILD_VARIANT),user)
    LOCAL_CFLAGS += -DTARGET_BUILD_VARIANT_USER
 endif
 
+# LocTimer on a hierarchical timing wheel instead of a heap
+ifeq ($(LOC_TIMER_WHEEL),true)
+   LOCAL_CFLAGS += -DLOC_TIMER_WHEEL
+endif
+
 LOCAL_LDFLAGS += -Wl,--export-dynamic
 
 ## Includes
@@ -29,10 +29,28 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
 #include <errno.h>
+#include <vector>
 #include <log_util.h>
 #include "LocIpc.h"
 
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS (1024 + 9)
+#define F_GET_SEALS (1024 + 10)
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+
 namespace loc_util {
 
 #ifdef LOG_TAG
@@ -42,8 +60,71 @@ namespace loc_util {
 
 #define LOC_MSG_BUF_LEN 8192
 #define LOC_MSG_HEAD "$MSGLEN$"
+#define LOC_MSG_SHM "$MSGSHM$"
+#define LOC_MSG_SHM_ACK "$MSGSHA$"
 #define LOC_MSG_ABORT "LocIpcMsg::ABORT"
 
+// datagrams per recvmmsg() / sendmmsg() call
+#define LOC_IPC_BATCH 16
+// shared memory rings a listener keeps mapped at most
+#define LOC_IPC_MAX_SHM_RINGS 8
+// largest shared memory ring a listener maps
+#define LOC_IPC_MAX_SHM_RING_SIZE (16 * 1024 * 1024)
+
+// Datagram that stands for a message in a shared memory ring. The memfd of
+// the ring goes along with each of them as SCM_RIGHTS, so that a listener
+// can map a ring any time, e.g. after it restarted.
+struct LocIpcShmMsg {
+    char head[sizeof(LOC_MSG_SHM) - 1];
+    uint64_t pos;
+    uint32_t length;
+};
+
+// Datagram the listener sends back to the socket of a shared memory ring once
+// it is done with a message: the ring space before tail is free again.
+struct LocIpcShmAck {
+    char head[sizeof(LOC_MSG_SHM_ACK) - 1];
+    uint64_t tail;
+};
+
+// Sender side of a shared memory ring. The ring is written only by the
+// sender, at ever increasing positions, and read in order by the receiver.
+// The receiver maps it read only, so the positions it is done with come back
+// as acks on the ring's own socket.
+class LocIpcShmRing {
+public:
+    const uint32_t mSize;
+    int mFd;
+    int mSocket;
+    uint8_t* mBase;
+    // next position to write at
+    uint64_t mHead;
+    // end of the last message the receiver acked
+    uint64_t mTail;
+    std::mutex mMutex;
+
+    inline LocIpcShmRing(uint32_t size) :
+            mSize(size), mFd(-1), mSocket(-1), mBase(nullptr), mHead(0), mTail(0) {}
+    inline ~LocIpcShmRing() {
+        if (nullptr != mBase) {
+            munmap(mBase, mSize);
+        }
+        if (mFd >= 0) {
+            ::close(mFd);
+        }
+        if (mSocket >= 0) {
+            ::close(mSocket);
+        }
+    }
+};
+
+// receiver side of a shared memory ring
+struct LocIpcShmMap {
+    const uint8_t* mBase;
+    size_t mSize;
+    dev_t mDev;
+};
+
 class LocIpcRunnable : public LocRunnable {
 friend LocIpc;
 public:
@@ -97,46 +178,112 @@ bool LocIpc::startListeningBlocking(const std::string& name) {
     // inform that the socket is ready to receive message
     onListenerReady();
 
-    ssize_t nBytes = 0;
-    std::string msg = "";
-    std::string abort = LOC_MSG_ABORT;
-    while (1) {
-        msg.resize(LOC_MSG_BUF_LEN);
-        nBytes = ::recvfrom(mIpcFd, (void*)(msg.data()), msg.size(), 0, NULL, NULL);
-        if (nBytes < 0) {
-            break;
-        } else if (nBytes == 0) {
-            continue;
+    // Up to LOC_IPC_BATCH datagrams are read per recvmmsg() into buffers that
+    // live as long as the listening does, and are passed to onReceiveData()
+    // in place. Only long messages that come in fragments are copied, to be
+    // put back together.
+    std::vector<uint8_t> buf(LOC_IPC_BATCH * LOC_MSG_BUF_LEN);
+    struct mmsghdr msgs[LOC_IPC_BATCH];
+    struct iovec iovs[LOC_IPC_BATCH];
+    struct sockaddr_un addrs[LOC_IPC_BATCH];
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } ctrls[LOC_IPC_BATCH];
+    std::vector<uint8_t> longMsg;
+    size_t longMsgReceived = 0;
+    std::unordered_map<uint64_t, LocIpcShmMap> shmMaps;
+    bool done = false;
+
+    while (!done) {
+        memset(msgs, 0, sizeof(msgs));
+        for (int i = 0; i < LOC_IPC_BATCH; i++) {
+            iovs[i].iov_base = &buf[i * LOC_MSG_BUF_LEN];
+            iovs[i].iov_len = LOC_MSG_BUF_LEN;
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_name = &addrs[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+            msgs[i].msg_hdr.msg_control = ctrls[i].buf;
+            msgs[i].msg_hdr.msg_controllen = sizeof(ctrls[i].buf);
         }
 
-        if (strncmp(msg.data(), abort.c_str(), abort.length()) == 0) {
-            LOC_LOGi("recvd abort msg.data %s", msg.data());
+        int count = ::recvmmsg(mIpcFd, msgs, LOC_IPC_BATCH,
+                               MSG_WAITFORONE | MSG_CMSG_CLOEXEC, NULL);
+        if (count < 0) {
             break;
         }
 
-        if (strncmp(msg.data(), LOC_MSG_HEAD, sizeof(LOC_MSG_HEAD) - 1)) {
-            // short message
-            msg.resize(nBytes);
-            onReceive(msg);
-        } else {
-            // long message
-            size_t msgLen = 0;
-            sscanf(msg.data(), LOC_MSG_HEAD"%zu", &msgLen);
-            msg.resize(msgLen);
-            size_t msgLenReceived = 0;
-            while ((msgLenReceived < msgLen) && (nBytes > 0)) {
-                nBytes = recvfrom(mIpcFd, (void*)&(msg[msgLenReceived]),
-                        msg.size() - msgLenReceived, 0, NULL, NULL);
-                msgLenReceived += nBytes;
+        for (int i = 0; i < count; i++) {
+            const uint8_t* data = (const uint8_t*)iovs[i].iov_base;
+            size_t nBytes = msgs[i].msg_len;
+
+            // a memfd of a shared memory ring may come along
+            int shmFd = -1;
+            struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+            if (nullptr != cmsg && SOL_SOCKET == cmsg->cmsg_level &&
+                    SCM_RIGHTS == cmsg->cmsg_type && cmsg->cmsg_len == CMSG_LEN(sizeof(int))) {
+                memcpy(&shmFd, CMSG_DATA(cmsg), sizeof(shmFd));
             }
-            if (nBytes > 0) {
-                onReceive(msg);
+
+            // the datagrams read along with an abort are still delivered,
+            // the listening ends after this batch
+            if (nBytes == 0) {
+                // skip empty datagrams
+            } else if (longMsgReceived < longMsg.size()) {
+                // fragment of a long message
+                size_t partLen = longMsg.size() - longMsgReceived;
+                if (partLen > nBytes) {
+                    partLen = nBytes;
+                }
+                memcpy(&longMsg[longMsgReceived], data, partLen);
+                longMsgReceived += partLen;
+                if (longMsgReceived == longMsg.size()) {
+                    onReceiveData(longMsg.data(), longMsg.size());
+                }
+            } else if (nBytes >= sizeof(LOC_MSG_ABORT) - 1 &&
+                    0 == memcmp(data, LOC_MSG_ABORT, sizeof(LOC_MSG_ABORT) - 1)) {
+                LOC_LOGi("recvd abort msg.data %.*s", (int)nBytes, data);
+                done = true;
+            } else if (nBytes == sizeof(LocIpcShmMsg) &&
+                    0 == memcmp(data, LOC_MSG_SHM, sizeof(LOC_MSG_SHM) - 1)) {
+                // message in a shared memory ring, its space is handed back
+                // to the sender even when it could not be read
+                LocIpcShmMsg shmMsg;
+                memcpy(&shmMsg, data, sizeof(shmMsg));
+                receiveShm(shmMaps, shmMsg, shmFd);
+                LocIpcShmAck ack;
+                memcpy(ack.head, LOC_MSG_SHM_ACK, sizeof(ack.head));
+                ack.tail = shmMsg.pos + shmMsg.length;
+                if (msgs[i].msg_hdr.msg_namelen > sizeof(sa_family_t) &&
+                        ::sendto(mIpcFd, &ack, sizeof(ack), MSG_DONTWAIT,
+                                 (struct sockaddr*)&addrs[i], msgs[i].msg_hdr.msg_namelen) < 0) {
+                    // a later ack covers this one
+                    LOC_LOGw("cannot ack shared memory message. reason:%s", strerror(errno));
+                }
+            } else if (nBytes > sizeof(LOC_MSG_HEAD) - 1 &&
+                    0 == memcmp(data, LOC_MSG_HEAD, sizeof(LOC_MSG_HEAD) - 1)) {
+                // head of a long message
+                std::string head((const char*)data, nBytes);
+                size_t msgLen = 0;
+                sscanf(head.c_str(), LOC_MSG_HEAD"%zu", &msgLen);
+                longMsg.resize(msgLen);
+                longMsgReceived = 0;
             } else {
-                break;
+                // short message
+                onReceiveData(data, nBytes);
+            }
+
+            if (shmFd >= 0) {
+                ::close(shmFd);
             }
         }
     }
 
+    for (auto& map : shmMaps) {
+        munmap((void*)map.second.mBase, map.second.mSize);
+    }
+
     if (mStopRequested) {
         mStopRequested = false;
         return true;
@@ -148,6 +295,62 @@ bool LocIpc::startListeningBlocking(const std::string& name) {
     }
 }
 
+// Hand a message in a shared memory ring to onReceiveData(), mapping the ring
+// first if needed. The ring is whatever memfd comes along with the message; it
+// is only taken if its size is sealed, so that the sender can not truncate it
+// under the mapping, and it is mapped read only.
+void LocIpc::receiveShm(std::unordered_map<uint64_t, LocIpcShmMap>& shmMaps,
+        const LocIpcShmMsg& shmMsg, int shmFd) {
+
+    struct stat st;
+    if (shmFd < 0 || fstat(shmFd, &st) < 0) {
+        LOC_LOGe("no memfd along with shared memory message");
+        return;
+    }
+
+    // a mapped ring keeps its inode, no other memfd can have the same one
+    auto it = shmMaps.find((uint64_t)st.st_ino);
+    if (shmMaps.end() != it && it->second.mDev != st.st_dev) {
+        munmap((void*)it->second.mBase, it->second.mSize);
+        shmMaps.erase(it);
+        it = shmMaps.end();
+    }
+
+    if (shmMaps.end() == it) {
+        int seals = fcntl(shmFd, F_GET_SEALS);
+        if (seals < 0 || (F_SEAL_SHRINK | F_SEAL_GROW) != (seals & (F_SEAL_SHRINK | F_SEAL_GROW))) {
+            LOC_LOGe("shared memory ring size not sealed, seals:%d", seals);
+            return;
+        }
+        if (st.st_size <= 0 || st.st_size > LOC_IPC_MAX_SHM_RING_SIZE) {
+            LOC_LOGe("bad shared memory ring size %lld", (long long)st.st_size);
+            return;
+        }
+        void* base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, shmFd, 0);
+        if (MAP_FAILED == base) {
+            LOC_LOGe("cannot map shared memory ring. reason:%s", strerror(errno));
+            return;
+        }
+        if (shmMaps.size() >= LOC_IPC_MAX_SHM_RINGS) {
+            // its sender passes its memfd again with its next message
+            auto evict = shmMaps.begin();
+            munmap((void*)evict->second.mBase, evict->second.mSize);
+            shmMaps.erase(evict);
+        }
+        LocIpcShmMap map = { (const uint8_t*)base, (size_t)st.st_size, st.st_dev };
+        it = shmMaps.emplace((uint64_t)st.st_ino, map).first;
+    }
+
+    uint64_t size = it->second.mSize;
+    uint64_t offset = shmMsg.pos % size;
+    if (shmMsg.length > size || offset > size - shmMsg.length) {
+        LOC_LOGe("bad message in shared memory ring, pos %llu length %u",
+                 (unsigned long long)shmMsg.pos, shmMsg.length);
+        return;
+    }
+    onReceiveData(it->second.mBase + offset, shmMsg.length);
+}
+
 void LocIpc::stopListening() {
 
     const char *socketName = nullptr;
@@ -196,11 +399,14 @@ bool LocIpc::send(const char name[], const uint8_t data[], uint32_t length) {
 }
 
 
-bool LocIpc::sendData(int fd, const sockaddr_un &addr, const uint8_t data[], uint32_t length) {
+bool LocIpc::sendData(int fd, const sockaddr_un &addr, const uint8_t data[], uint32_t length,
+                      LocIpcShmRing* ring) {
 
     bool result = true;
 
-    if (length <= LOC_MSG_BUF_LEN) {
+    if (nullptr != ring && length > LOC_IPC_SHM_THRESHOLD && sendShm(*ring, addr, data, length)) {
+        // went through the shared memory ring
+    } else if (length <= LOC_MSG_BUF_LEN) {
         if (::sendto(fd, data, length, 0,
                 (struct sockaddr*)&addr, sizeof(addr)) < 0) {
             LOC_LOGe("cannot send to socket. reason:%s", strerror(errno));
@@ -234,4 +440,396 @@ bool LocIpc::sendData(int fd, const sockaddr_un &addr, const uint8_t data[], uin
     return result;
 }
 
+// Copy the message into the ring, and send its position along with the memfd.
+// Return false, without sending anything, if the message does not fit.
+bool LocIpc::sendShm(LocIpcShmRing& ring, const sockaddr_un& addr,
+                     const uint8_t data[], uint32_t length) {
+    bool rtv = false;
+    std::lock_guard<std::mutex> lock(ring.mMutex);
+
+    // take in the acks that came in since, from the receiver only
+    LocIpcShmAck ack;
+    struct sockaddr_un from;
+    socklen_t fromLen;
+    ssize_t nBytes;
+    do {
+        memset(&from, 0, sizeof(from));
+        fromLen = sizeof(from);
+        nBytes = ::recvfrom(ring.mSocket, &ack, sizeof(ack), MSG_DONTWAIT,
+                            (struct sockaddr*)&from, &fromLen);
+        if (sizeof(ack) == nBytes && 0 == memcmp(ack.head, LOC_MSG_SHM_ACK, sizeof(ack.head)) &&
+                0 == strncmp(from.sun_path, addr.sun_path, sizeof(from.sun_path)) &&
+                ack.tail > ring.mTail && ack.tail <= ring.mHead) {
+            ring.mTail = ack.tail;
+        }
+    } while (nBytes >= 0);
+
+    // a message never wraps around, it starts over at the ring start instead
+    uint64_t pos = ring.mHead;
+    uint64_t offset = pos % ring.mSize;
+    if (offset + length > ring.mSize) {
+        pos += ring.mSize - offset;
+        offset = 0;
+    }
+    if (length > ring.mSize || pos + length - ring.mTail > ring.mSize) {
+        return false;
+    }
+    memcpy(ring.mBase + offset, data, length);
+
+    LocIpcShmMsg shmMsg;
+    memcpy(shmMsg.head, LOC_MSG_SHM, sizeof(shmMsg.head));
+    shmMsg.pos = pos;
+    shmMsg.length = length;
+
+    struct iovec iov = { &shmMsg, sizeof(shmMsg) };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } ctrl;
+    memset(&ctrl, 0, sizeof(ctrl));
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = (void*)&addr;
+    msg.msg_namelen = sizeof(addr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl.buf;
+    msg.msg_controllen = sizeof(ctrl.buf);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &ring.mFd, sizeof(int));
+
+    if (::sendmsg(ring.mSocket, &msg, 0) < 0) {
+        LOC_LOGe("cannot send to socket. reason:%s", strerror(errno));
+    } else {
+        ring.mHead = pos + length;
+        rtv = true;
+    }
+    return rtv;
+}
+
+bool LocIpcSender::send(const uint8_t data[], uint32_t length) {
+    bool rtv = false;
+    if (nullptr != mSocket && nullptr != data) {
+        LocIpcShmRing* ring = nullptr;
+        if (length > LOC_IPC_SHM_THRESHOLD && enableSharedMemory()) {
+            ring = mRing.get();
+        }
+        rtv = LocIpc::sendData(*mSocket, mDestAddr, data, length, ring);
+    }
+    return rtv;
 }
+
+bool LocIpcSender::send(const struct iovec msgs[], uint32_t count) {
+    bool rtv = (nullptr != mSocket && nullptr != msgs);
+
+    struct mmsghdr batch[LOC_IPC_BATCH];
+    uint32_t i = 0;
+    while (rtv && i < count) {
+        // the run of short messages from i on goes in one sendmmsg()
+        uint32_t n = 0;
+        memset(batch, 0, sizeof(batch));
+        while (n < LOC_IPC_BATCH && i + n < count && msgs[i + n].iov_len <= LOC_MSG_BUF_LEN) {
+            batch[n].msg_hdr.msg_name = &mDestAddr;
+            batch[n].msg_hdr.msg_namelen = sizeof(mDestAddr);
+            batch[n].msg_hdr.msg_iov = (struct iovec*)&msgs[i + n];
+            batch[n].msg_hdr.msg_iovlen = 1;
+            n++;
+        }
+
+        if (0 == n) {
+            rtv = send((const uint8_t*)msgs[i].iov_base, msgs[i].iov_len);
+            i++;
+            continue;
+        }
+
+        uint32_t sent = 0;
+        while (sent < n) {
+            int rv = ::sendmmsg(*mSocket, &batch[sent], n - sent, 0);
+            if (rv < 0) {
+                LOC_LOGe("cannot send to socket. reason:%s", strerror(errno));
+                rtv = false;
+                break;
+            }
+            sent += rv;
+        }
+        i += n;
+    }
+    return rtv;
+}
+
+bool LocIpcSender::enableSharedMemory(uint32_t ringSize) {
+    std::call_once(mRingOnce, [this, ringSize] {
+        if (nullptr == mSocket || 0 == ringSize || ringSize > LOC_IPC_MAX_SHM_RING_SIZE) {
+            return;
+        }
+
+        std::shared_ptr<LocIpcShmRing> ring = std::make_shared<LocIpcShmRing>(ringSize);
+#ifdef __NR_memfd_create
+        ring->mFd = syscall(__NR_memfd_create, "LocIpcShmRing", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+        errno = ENOSYS;
+#endif
+        if (ring->mFd < 0) {
+            LOC_LOGe("cannot create memfd. reason:%s", strerror(errno));
+            return;
+        }
+        // the receivers only take a ring whose size can not change any more
+        if (ftruncate(ring->mFd, ringSize) < 0 ||
+                fcntl(ring->mFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+            LOC_LOGe("cannot size and seal memfd. reason:%s", strerror(errno));
+            return;
+        }
+        void* base = mmap(NULL, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED, ring->mFd, 0);
+        if (MAP_FAILED == base) {
+            LOC_LOGe("cannot map memfd. reason:%s", strerror(errno));
+            return;
+        }
+        ring->mBase = (uint8_t*)base;
+
+        // the ring's own socket, autobound, for the acks to find their way back
+        ring->mSocket = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+        struct sockaddr_un addr = { .sun_family = AF_UNIX };
+        if (ring->mSocket < 0 ||
+                ::bind(ring->mSocket, (struct sockaddr*)&addr, sizeof(sa_family_t)) < 0) {
+            LOC_LOGe("cannot bind shared memory ring socket. reason:%s", strerror(errno));
+            return;
+        }
+
+        mRing = ring;
+    });
+    return nullptr != mRing;
+}
+
+}
+
+#ifdef __LOC_DEBUG__
+
+#include <sys/wait.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+#include <algorithm>
+
+/* Loopback benchmark of LocIpc between two local processes. The child
+   process listens on one socket and counts the messages it gets; at the end
+   of each run it acks the count back to the parent's socket. It also echoes
+   pings, from which the parent takes the round trip latency. Runs compare
+   one sendto() per message with batched sendmmsg(), and for large payloads
+   fragments over the socket with the shared memory ring.
+
+   For Linux command line testing:
+   compilation:
+       g++ -O2 -std=c++11 -I. -I../pla/android -I../../../../system/core/include -c LocThread.cpp
+       g++ -D__LOC_DEBUG__ -O2 -std=c++11 -I. -I../pla/android -I../../../../system/core/include -o LocIpc_bench LocIpc.cpp LocThread.o -lpthread
+   usage:
+       ./LocIpc_bench [small msgs per run] */
+
+using namespace loc_util;
+
+// the first byte of each benchmark message tells what it is
+#define LOC_IPC_BENCH_DATA  'D'
+#define LOC_IPC_BENCH_END   'E'
+#define LOC_IPC_BENCH_ACK   'A'
+#define LOC_IPC_BENCH_PING  'P'
+#define LOC_IPC_BENCH_READY 'R'
+#define LOC_IPC_BENCH_QUIT  'Q'
+
+static uint64_t locIpcBenchNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// child side
+class LocIpcBenchEcho : public LocIpc {
+    LocIpcSender mReply;
+    uint64_t mCount;
+    uint64_t mBytes;
+public:
+    inline LocIpcBenchEcho(const char* replyName) :
+            mReply(replyName), mCount(0), mBytes(0) {}
+protected:
+    void onListenerReady() override {
+        uint8_t ready = LOC_IPC_BENCH_READY;
+        mReply.send(&ready, 1);
+    }
+    void onReceiveData(const uint8_t data[], uint32_t length) override {
+        switch (data[0]) {
+        case LOC_IPC_BENCH_DATA:
+            mCount++;
+            mBytes += length;
+            break;
+        case LOC_IPC_BENCH_END: {
+            uint8_t ack[1 + 2 * sizeof(uint64_t)] = { LOC_IPC_BENCH_ACK };
+            memcpy(&ack[1], &mCount, sizeof(uint64_t));
+            memcpy(&ack[1 + sizeof(uint64_t)], &mBytes, sizeof(uint64_t));
+            mReply.send(ack, sizeof(ack));
+            mCount = 0;
+            mBytes = 0;
+            break;
+        }
+        case LOC_IPC_BENCH_PING:
+            mReply.send(data, length);
+            break;
+        case LOC_IPC_BENCH_QUIT:
+            stopListening();
+            break;
+        }
+    }
+};
+
+// parent side, takes the replies of the child one at a time
+class LocIpcBenchReplies : public LocIpc {
+    pthread_mutex_t mMutex;
+    pthread_cond_t mCond;
+    bool mReady;
+    bool mGotReply;
+    uint8_t mReply[1 + 2 * sizeof(uint64_t)];
+public:
+    inline LocIpcBenchReplies() : mReady(false), mGotReply(false) {
+        pthread_mutex_init(&mMutex, NULL);
+        pthread_cond_init(&mCond, NULL);
+    }
+    void waitReady() {
+        pthread_mutex_lock(&mMutex);
+        while (!mReady) {
+            pthread_cond_wait(&mCond, &mMutex);
+        }
+        pthread_mutex_unlock(&mMutex);
+    }
+    void waitReply(uint8_t reply[], uint32_t length) {
+        pthread_mutex_lock(&mMutex);
+        while (!mGotReply) {
+            pthread_cond_wait(&mCond, &mMutex);
+        }
+        mGotReply = false;
+        memcpy(reply, mReply, std::min(length, (uint32_t)sizeof(mReply)));
+        pthread_mutex_unlock(&mMutex);
+    }
+protected:
+    void onListenerReady() override {
+        pthread_mutex_lock(&mMutex);
+        mReady = true;
+        pthread_cond_signal(&mCond);
+        pthread_mutex_unlock(&mMutex);
+    }
+    void onReceiveData(const uint8_t data[], uint32_t length) override {
+        pthread_mutex_lock(&mMutex);
+        memcpy(mReply, data, std::min(length, (uint32_t)sizeof(mReply)));
+        mGotReply = true;
+        pthread_cond_signal(&mCond);
+        pthread_mutex_unlock(&mMutex);
+    }
+};
+
+static void locIpcBenchThroughput(const char* name, LocIpcSender& sender,
+        LocIpcBenchReplies& replies, uint32_t size, uint32_t count, bool batched) {
+    std::vector<uint8_t> msg(size, 0x5a);
+    msg[0] = LOC_IPC_BENCH_DATA;
+    struct iovec iovs[LOC_IPC_BATCH];
+    for (int i = 0; i < LOC_IPC_BATCH; i++) {
+        iovs[i].iov_base = msg.data();
+        iovs[i].iov_len = size;
+    }
+
+    uint64_t start = locIpcBenchNs();
+    for (uint32_t i = 0; i < count; ) {
+        if (batched) {
+            uint32_t n = std::min(count - i, (uint32_t)LOC_IPC_BATCH);
+            sender.send(iovs, n);
+            i += n;
+        } else {
+            sender.send(msg.data(), size);
+            i++;
+        }
+    }
+    uint8_t end = LOC_IPC_BENCH_END;
+    sender.send(&end, 1);
+    uint8_t ack[1 + 2 * sizeof(uint64_t)];
+    replies.waitReply(ack, sizeof(ack));
+    double secs = (double)(locIpcBenchNs() - start) / 1e9;
+
+    uint64_t received = 0;
+    memcpy(&received, &ack[1], sizeof(uint64_t));
+    printf("%-10s %7u B x %7u: %10.0f msgs/s, %8.1f MB/s, %" PRIu64 " received\n",
+           name, size, count, count / secs, (double)size * count / secs / 1e6, received);
+}
+
+static void locIpcBenchLatency(const char* name, LocIpcSender& sender,
+        LocIpcBenchReplies& replies, uint32_t size, uint32_t count) {
+    std::vector<uint8_t> msg(size, 0x5a);
+    msg[0] = LOC_IPC_BENCH_PING;
+    std::vector<uint64_t> latency(count);
+    uint8_t pong[1];
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t start = locIpcBenchNs();
+        sender.send(msg.data(), size);
+        replies.waitReply(pong, sizeof(pong));
+        latency[i] = locIpcBenchNs() - start;
+    }
+
+    std::sort(latency.begin(), latency.end());
+    printf("%-10s %7u B x %7u: round trip p50 %9.2f us, p99 %9.2f us\n",
+           name, size, count, latency[count / 2] / 1000.0,
+           latency[(uint32_t)(count * 0.99)] / 1000.0);
+}
+
+int main(int argc, char** argv) {
+    uint32_t count = argc > 1 ? atoi(argv[1]) : 200000;
+    char echoName[64];
+    char repliesName[64];
+    snprintf(echoName, sizeof(echoName), "/tmp/LocIpcBench.%d.echo", getpid());
+    snprintf(repliesName, sizeof(repliesName), "/tmp/LocIpcBench.%d.replies", getpid());
+
+    LocIpcBenchReplies replies;
+    replies.startListeningNonBlocking(repliesName);
+    replies.waitReady();
+
+    pid_t child = fork();
+    if (0 == child) {
+        LocIpcBenchEcho echo(repliesName);
+        echo.startListeningBlocking(echoName);
+        unlink(echoName);
+        _exit(0);
+    }
+
+    uint8_t ready[1];
+    replies.waitReply(ready, sizeof(ready));
+
+    LocIpcSender sender(echoName);
+    // a failed setup leaves a sender without ring for good
+    LocIpcSender fragSender(echoName);
+    fragSender.enableSharedMemory(0);
+    LocIpcSender shmSender(echoName);
+    if (!shmSender.enableSharedMemory(4 * LOC_IPC_SHM_RING_SIZE)) {
+        printf("no shared memory ring\n");
+    }
+
+    locIpcBenchThroughput("sendto", sender, replies, 64, count, false);
+    locIpcBenchThroughput("sendmmsg", sender, replies, 64, count, true);
+    for (uint32_t size = 16384; size <= 1024 * 1024; size *= 4) {
+        uint32_t n = std::max(count / (size / 1024), 100U);
+        locIpcBenchThroughput("fragments", fragSender, replies, size, n, false);
+        locIpcBenchThroughput("shm", shmSender, replies, size, n, false);
+    }
+
+    locIpcBenchLatency("sendto", sender, replies, 64, count / 10);
+    for (uint32_t size = 16384; size <= 1024 * 1024; size *= 4) {
+        uint32_t n = std::max(count / (size / 100), 100U);
+        locIpcBenchLatency("fragments", fragSender, replies, size, n);
+        locIpcBenchLatency("shm", shmSender, replies, size, n);
+    }
+
+    uint8_t quit = LOC_IPC_BENCH_QUIT;
+    sender.send(&quit, 1);
+    waitpid(child, NULL, 0);
+    replies.stopListening();
+    unlink(repliesName);
+    return 0;
+}
+
+#endif
@@ -32,14 +32,27 @@
 
 #include <string>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <stdint.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <LocThread.h>
 
+// size of the shared memory ring of a LocIpcSender
+#define LOC_IPC_SHM_RING_SIZE (1024 * 1024)
+// messages longer than this, which the socket would take in fragments, go
+// through the shared memory ring
+#define LOC_IPC_SHM_THRESHOLD 8192
+
 namespace loc_util {
 
 class LocIpcSender;
+class LocIpcShmRing;
+struct LocIpcShmMsg;
+struct LocIpcShmMap;
 
 class LocIpc {
 friend LocIpcSender;
@@ -84,13 +97,25 @@ protected:
     // Argument data contains the received message. You need to parse it.
     inline virtual void onReceive(const std::string& /*data*/) {}
 
+    // Zero copy flavor of onReceive(). data points into the receive buffer, or
+    // into the read only mapping of the sender's shared memory ring, and is only
+    // valid until this callback returns. The default implementation copies the
+    // message into a string and calls onReceive(); override this one to avoid the copy.
+    inline virtual void onReceiveData(const uint8_t data[], uint32_t length) {
+        onReceive(std::string((const char*)data, length));
+    }
+
     // LocIpc client can overwrite this function to get notification
     // when the socket for LocIpc is ready to receive messages.
     inline virtual void onListenerReady() {}
 
 private:
     static bool sendData(int fd, const sockaddr_un& addr,
+            const uint8_t data[], uint32_t length, LocIpcShmRing* ring = nullptr);
+    static bool sendShm(LocIpcShmRing& ring, const sockaddr_un& addr,
             const uint8_t data[], uint32_t length);
+    void receiveShm(std::unordered_map<uint64_t, LocIpcShmMap>& shmMaps,
+            const LocIpcShmMsg& shmMsg, int shmFd);
 
     int mIpcFd;
     bool mStopRequested;
@@ -125,19 +150,31 @@ public:
     // Send out a message.
     // Call this function to send a message
     //
-    // Argument data and length contains the message to be sent out.
+    // Argument data and length contains the message to be sent out. Messages
+    // longer than LOC_IPC_SHM_THRESHOLD go through the shared memory ring,
+    // which the first of them sets up, or in fragments when that fails.
     // Return true when succeeded
-    inline bool send(const uint8_t data[], uint32_t length) {
-        bool rtv = false;
-        if (nullptr != mSocket && nullptr != data) {
-            rtv = LocIpc::sendData(*mSocket, mDestAddr, data, length);
-        }
-        return rtv;
-    }
+    bool send(const uint8_t data[], uint32_t length);
+
+    // Send out a batch of messages.
+    // Short messages are coalesced into as few sendmmsg() calls as possible,
+    // the others are sent one by one as by send(). The receiver gets them in
+    // order, one onReceive per entry of msgs.
+    // Return true when all of them succeeded
+    bool send(const struct iovec msgs[], uint32_t count);
+
+    // Pass long messages through a sealed memfd of ringSize bytes, which the
+    // receiver maps read only, instead of fragmenting them over the socket.
+    // Only the ring position travels over the socket. Falls back to the
+    // socket whenever the ring is full. Only the first call sets up the ring.
+    // Return false if shared memory is not available, e.g. no memfd support.
+    bool enableSharedMemory(uint32_t ringSize = LOC_IPC_SHM_RING_SIZE);
 
 private:
     std::shared_ptr<int> mSocket;
     struct sockaddr_un mDestAddr;
+    std::shared_ptr<LocIpcShmRing> mRing;
+    std::once_flag mRingOnce;
 
     inline LocIpcSender(
             const std::shared_ptr<int>& mySocket, const char* destSocket) : mSocket(mySocket) {
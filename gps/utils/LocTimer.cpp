@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <errno.h>
+#include <stdint.h>
 #include <sys/timerfd.h>
 #include <sys/epoll.h>
 #include <log_util.h>
@@ -49,8 +50,9 @@
 #endif
 
 /*
-There are implementations of 5 classes in this file:
-LocTimer, LocTimerDelegate, LocTimerContainer, LocTimerPollTask, LocTimerWrapper
+There are implementations of 6 classes in this file:
+LocTimer, LocTimerDelegate, LocTimerContainer, LocTimerWheel, LocTimerPollTask,
+LocTimerWrapper
 
 LocTimer - client front end, interface for client to start / stop timers, also
            to provide a callback.
@@ -72,6 +74,11 @@ LocTimerContainer - core of the timer service. It is a container (derived from
                     provided by LocTimerPollTask. All the heap management on the
                     LocTimerDelegate objs are done in the MsgTask context, such
                     that synchronization is ensured.
+LocTimerWheel - optional replacement of the heap of a LocTimerContainer. It is
+                a hierarchical timing wheel of 1 ms ticks, where add / remove
+                are O(1). When used, the container re-arms its timerfd once
+                per batch of queued add / remove msgs instead of on each.
+                Enabled with LOC_TIMER_WHEEL at build time.
 LocTimerPollTask - is a class that wraps timerfd and epoll POXIS APIs. It also
                    both implements LocRunnalbe with epoll_wait() in the run()
                    method. It is also a LocThread client, so as to loop the run
@@ -82,6 +89,7 @@ LocTimerWrapper - a LocTimer client itself, to implement the existing C API with
 */
 
 class LocTimerPollTask;
+class LocTimerWheel;
 
 // This is a multi-functaional class that:
 // * extends the LocHeap class for the detection of head update upon add / remove
@@ -102,8 +110,16 @@ class LocTimerContainer : public LocHeap {
     static MsgTask* mMsgTask;
     // Poll task to provide epoll call and threading to poll.
     static LocTimerPollTask* mPollTask;
+    // backend of the containers created from now on, heap or timing wheel
+    static bool mUseWheel;
     // timer / alarm fd
     int mDevFd;
+    // timing wheel that replaces the heap, if not NULL
+    LocTimerWheel* mWheel;
+    // tick the timerfd is armed to with mWheel, LocTimerWheel::NO_TICK if disarmed
+    uint64_t mArmedTick;
+    // a MsgTimerRearm is queued for mWheel
+    bool mRearmPending;
     // ctor
     LocTimerContainer(bool wakeOnExpire);
     // dtor
@@ -114,10 +130,16 @@ class LocTimerContainer : public LocHeap {
     LocTimerDelegate* popIfOutRanks(LocTimerDelegate& timer);
     // update the timer POSIX calls with updated soonest timer spec
     void updateSoonestTime(LocTimerDelegate* priorTop);
+    // mWheel only, queue one re-arm behind the msgs already in the queue
+    void scheduleRearm();
+    // mWheel only, update the timer POSIX calls with the soonest wheel tick
+    void rearm();
 
 public:
     // factory method to control the creation of mSwTimers / mHwTimers
     static LocTimerContainer* get(bool wakeOnExpire);
+    // choose the timing wheel over the heap for containers not yet created
+    static void useWheel(bool useWheel);
 
     LocTimerDelegate* getSoonestTimer();
     int getTimerFd();
@@ -175,14 +197,24 @@ public:
 // the container (of LocHeap), it gets placed in sorted order.
 class LocTimerDelegate : public LocRankable {
     friend class LocTimerContainer;
+    friend class LocTimerWheel;
     friend class LocTimer;
+    // mLevel of a timer that is not in a LocTimerWheel
+    static const uint8_t NO_LEVEL = 0xff;
     LocTimer* mClient;
     LocSharedLock* mLock;
     struct timespec mFutureTime;
     LocTimerContainer* mContainer;
+    // LocTimerWheel bookkeeping, slot list links and position
+    LocTimerDelegate* mPrev;
+    LocTimerDelegate* mNext;
+    uint64_t mExpireTick;
+    uint8_t mLevel;
+    uint8_t mSlot;
     // not a complete obj, just ctor for LocRankable comparisons
     inline LocTimerDelegate(struct timespec& delay)
-        : mClient(NULL), mLock(NULL), mFutureTime(delay), mContainer(NULL) {}
+        : mClient(NULL), mLock(NULL), mFutureTime(delay), mContainer(NULL),
+          mPrev(NULL), mNext(NULL), mExpireTick(0), mLevel(NO_LEVEL), mSlot(0) {}
     inline ~LocTimerDelegate() { if (mLock) { mLock->drop(); mLock = NULL; } }
 public:
     LocTimerDelegate(LocTimer& client, struct timespec& futureTime, LocTimerContainer* container);
@@ -193,6 +225,52 @@ public:
     inline struct timespec getFutureTime() { return mFutureTime; }
 };
 
+// Hierarchical timing wheel of LocTimerDelegate objs, in ticks of 1 ms on
+// CLOCK_BOOTTIME. Level 0 has a slot per tick for the next 64 ticks, level 1
+// a slot per 64 ticks for the next 64^2 ticks, and so on up to 64^5 ticks, or
+// about 12 days. Timers even further out wait in an overflow list. A timer is
+// moved (cascaded) down a level when the wheel reaches the start of its slot,
+// and expires when the wheel reaches its level 0 slot. Timers are linked into
+// their slot through the delegate itself, so there is no allocation at all.
+// Occupancy bitmaps let getSoonestTick() and advance() skip empty slots, such
+// that neither depends on how long the wheel has been idle.
+class LocTimerWheel {
+public:
+    static const uint64_t NO_TICK = UINT64_MAX;
+private:
+    static const uint32_t SLOT_BITS = 6;
+    static const uint32_t SLOTS = 1 << SLOT_BITS;
+    static const uint32_t LEVELS = 5;
+    // mLevel of the timers in the overflow list
+    static const uint8_t OVERFLOW_LEVEL = LEVELS;
+    LocTimerDelegate* mSlots[LEVELS][SLOTS];
+    uint64_t mOccupied[LEVELS];
+    LocTimerDelegate* mOverflow;
+    // the next tick that has not been processed by advance()
+    uint64_t mTick;
+    uint32_t mCount;
+    inline LocTimerDelegate*& getSlot(uint8_t level, uint8_t slot) {
+        return (OVERFLOW_LEVEL == level) ? mOverflow : mSlots[level][slot];
+    }
+    void link(LocTimerDelegate& timer);
+    void unlink(LocTimerDelegate& timer);
+    // unlink all timers of a slot and link them again relative to mTick
+    void cascade(uint8_t level, uint8_t slot);
+public:
+    LocTimerWheel(uint64_t now);
+    inline bool isEmpty() { return 0 == mCount; }
+    static uint64_t getTick(const struct timespec& time, bool roundUp);
+    void add(LocTimerDelegate& timer);
+    // returns false if timer is not in the wheel, e.g. already expired
+    bool remove(LocTimerDelegate& timer);
+    // the tick at which the wheel next has some work to do, i.e. a timer to
+    // expire or a slot to cascade; NO_TICK if the wheel is empty
+    uint64_t getSoonestTick();
+    // process all ticks up to and including now. Returns the expired timers,
+    // linked through mNext, which are no longer in the wheel.
+    LocTimerDelegate* advance(uint64_t now);
+};
+
 /***************************LocTimerContainer methods***************************/
 
 // Most of these static recources are created on demand. They however are never
@@ -205,12 +283,18 @@ LocTimerContainer* LocTimerContainer::mSwTimers = NULL;
 LocTimerContainer* LocTimerContainer::mHwTimers = NULL;
 MsgTask* LocTimerContainer::mMsgTask = NULL;
 LocTimerPollTask* LocTimerContainer::mPollTask = NULL;
+#ifdef LOC_TIMER_WHEEL
+bool LocTimerContainer::mUseWheel = true;
+#else
+bool LocTimerContainer::mUseWheel = false;
+#endif
 
 // ctor - initialize timer heaps
 // A container for swTimer (timer) is created, when wakeOnExpire is true; or
 // HwTimer (alarm), when wakeOnExpire is false.
 LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
-    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)) {
+    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)),
+    mWheel(NULL), mArmedTick(LocTimerWheel::NO_TICK), mRearmPending(false) {
 
     if ((-1 == mDevFd) && (errno == EINVAL)) {
         LOC_LOGW("%s: timerfd_create failure, fallback to CLOCK_MONOTONIC - %s",
@@ -222,6 +306,11 @@ LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
         // ensure we have the necessary resources created
         LocTimerContainer::getPollTaskLocked();
         LocTimerContainer::getMsgTaskLocked();
+        if (mUseWheel) {
+            struct timespec now;
+            clock_gettime(CLOCK_BOOTTIME, &now);
+            mWheel = new LocTimerWheel(LocTimerWheel::getTick(now, false));
+        }
     } else {
         LOC_LOGE("%s: timerfd_create failure - %s", __FUNCTION__, strerror(errno));
     }
@@ -231,6 +320,7 @@ LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
 // we do not ever destroy the static resources.
 inline
 LocTimerContainer::~LocTimerContainer() {
+    delete mWheel;
     close(mDevFd);
 }
 
@@ -254,6 +344,12 @@ LocTimerContainer* LocTimerContainer::get(bool wakeOnExpire) {
     return container;
 }
 
+void LocTimerContainer::useWheel(bool useWheel) {
+    pthread_mutex_lock(&mMutex);
+    mUseWheel = useWheel;
+    pthread_mutex_unlock(&mMutex);
+}
+
 MsgTask* LocTimerContainer::getMsgTaskLocked() {
     // it is cheap to check pointer first than locking mutext unconditionally
     if (!mMsgTask) {
@@ -308,6 +404,47 @@ void LocTimerContainer::updateSoonestTime(LocTimerDelegate* priorTop) {
     }
 }
 
+// Called in the MsgTask context. With a burst of add / remove msgs queued,
+// only the first one queues a MsgTimerRearm, which runs after all of them,
+// so the timerfd gets re-armed once for the whole burst.
+void LocTimerContainer::scheduleRearm() {
+    struct MsgTimerRearm : public LocMsg {
+        LocTimerContainer* mTimerContainer;
+        inline MsgTimerRearm(LocTimerContainer& container) :
+            LocMsg(), mTimerContainer(&container) {}
+        inline virtual void proc() const {
+            mTimerContainer->rearm();
+        }
+    };
+
+    if (!mRearmPending) {
+        mRearmPending = true;
+        mMsgTask->sendMsg(new MsgTimerRearm(*this));
+    }
+}
+
+void LocTimerContainer::rearm() {
+    mRearmPending = false;
+    uint64_t soonestTick = mWheel->getSoonestTick();
+
+    if (soonestTick != mArmedTick) {
+        struct itimerspec delay;
+        memset(&delay, 0, sizeof(struct itimerspec));
+        if (LocTimerWheel::NO_TICK == soonestTick) {
+            // wheel is empty now, we remove poll and disarm timer
+            mPollTask->removePoll(*this);
+        } else {
+            // do this first to avoid race condition, in case settime is called
+            // with too small an interval
+            mPollTask->addPoll(*this);
+            delay.it_value.tv_sec = soonestTick / 1000;
+            delay.it_value.tv_nsec = (soonestTick % 1000) * 1000000;
+        }
+        timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
+        mArmedTick = soonestTick;
+    }
+}
+
 // all the heap management is done in the MsgTask context.
 inline
 void LocTimerContainer::add(LocTimerDelegate& timer) {
@@ -318,6 +455,11 @@ void LocTimerContainer::add(LocTimerDelegate& timer) {
         inline MsgTimerPush(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
+            if (mTimerContainer->mWheel) {
+                mTimerContainer->mWheel->add(*mTimer);
+                mTimerContainer->scheduleRearm();
+                return;
+            }
             LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
             mTimerContainer->push((LocRankable&)(*mTimer));
             mTimerContainer->updateSoonestTime(priorTop);
@@ -335,6 +477,13 @@ void LocTimerContainer::remove(LocTimerDelegate& timer) {
         inline MsgTimerRemove(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
+            if (mTimerContainer->mWheel) {
+                if (mTimerContainer->mWheel->remove(*mTimer)) {
+                    mTimerContainer->scheduleRearm();
+                }
+                delete mTimer;
+                return;
+            }
             LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
 
             // update soonest timer only if mTimer is actually removed from
@@ -364,6 +513,21 @@ void LocTimerContainer::expire() {
             struct timespec now;
             // get time spec of now
             clock_gettime(CLOCK_BOOTTIME, &now);
+            if (mTimerContainer->mWheel) {
+                LocTimerDelegate* timer = mTimerContainer->mWheel->advance(
+                        LocTimerWheel::getTick(now, false));
+                while (NULL != timer) {
+                    LocTimerDelegate* next = timer->mNext;
+                    timer->mNext = NULL;
+                    // the timer delegate obj will be deleted by a MsgTimerRemove
+                    timer->expire();
+                    timer = next;
+                }
+                // the timerfd was disarmed by the poll thread before this msg
+                mTimerContainer->mArmedTick = LocTimerWheel::NO_TICK;
+                mTimerContainer->rearm();
+                return;
+            }
             LocTimerDelegate timerOfNow(now);
             // pop everything in the heap that outRanks now, i.e. has time older than now
             // and then call expire() on that timer.
@@ -394,6 +558,166 @@ LocTimerDelegate* LocTimerContainer::popIfOutRanks(LocTimerDelegate& timer) {
 }
 
 
+/***************************LocTimerWheel methods***************************/
+
+LocTimerWheel::LocTimerWheel(uint64_t now) :
+    mOverflow(NULL), mTick(now), mCount(0) {
+    memset(mSlots, 0, sizeof(mSlots));
+    memset(mOccupied, 0, sizeof(mOccupied));
+}
+
+// a timer must not expire before its time, so its tick is rounded up, while
+// the tick of now is rounded down.
+uint64_t LocTimerWheel::getTick(const struct timespec& time, bool roundUp) {
+    return (uint64_t)time.tv_sec * 1000 +
+        ((uint64_t)time.tv_nsec + (roundUp ? 999999 : 0)) / 1000000;
+}
+
+void LocTimerWheel::link(LocTimerDelegate& timer) {
+    // an overdue timer goes to the slot processed next
+    uint64_t tick = (timer.mExpireTick > mTick) ? timer.mExpireTick : mTick;
+    uint64_t delta = tick - mTick;
+    uint8_t level = 0;
+    while (level < LEVELS && delta >= (1ULL << (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+
+    uint8_t slot = 0;
+    if (level < LEVELS) {
+        slot = (tick >> (SLOT_BITS * level)) & (SLOTS - 1);
+        mOccupied[level] |= (1ULL << slot);
+    }
+
+    LocTimerDelegate*& head = getSlot(level, slot);
+    timer.mPrev = NULL;
+    timer.mNext = head;
+    if (head) {
+        head->mPrev = &timer;
+    }
+    head = &timer;
+    timer.mLevel = level;
+    timer.mSlot = slot;
+}
+
+void LocTimerWheel::unlink(LocTimerDelegate& timer) {
+    LocTimerDelegate*& head = getSlot(timer.mLevel, timer.mSlot);
+    if (timer.mPrev) {
+        timer.mPrev->mNext = timer.mNext;
+    } else {
+        head = timer.mNext;
+    }
+    if (timer.mNext) {
+        timer.mNext->mPrev = timer.mPrev;
+    }
+    if (NULL == head && timer.mLevel < LEVELS) {
+        mOccupied[timer.mLevel] &= ~(1ULL << timer.mSlot);
+    }
+    timer.mPrev = NULL;
+    timer.mNext = NULL;
+    timer.mLevel = LocTimerDelegate::NO_LEVEL;
+}
+
+void LocTimerWheel::cascade(uint8_t level, uint8_t slot) {
+    LocTimerDelegate*& head = getSlot(level, slot);
+    LocTimerDelegate* timer = head;
+    // detach the whole list first, a timer may well land in the same slot
+    head = NULL;
+    if (level < LEVELS) {
+        mOccupied[level] &= ~(1ULL << slot);
+    }
+    while (NULL != timer) {
+        LocTimerDelegate* next = timer->mNext;
+        link(*timer);
+        timer = next;
+    }
+}
+
+void LocTimerWheel::add(LocTimerDelegate& timer) {
+    timer.mExpireTick = getTick(timer.mFutureTime, true);
+    link(timer);
+    mCount++;
+}
+
+bool LocTimerWheel::remove(LocTimerDelegate& timer) {
+    bool removed = false;
+    if (LocTimerDelegate::NO_LEVEL != timer.mLevel) {
+        unlink(timer);
+        mCount--;
+        removed = true;
+    }
+    return removed;
+}
+
+uint64_t LocTimerWheel::getSoonestTick() {
+    uint64_t soonestTick = NO_TICK;
+
+    for (uint32_t level = 0; level < LEVELS; level++) {
+        if (mOccupied[level]) {
+            uint32_t shift = SLOT_BITS * level;
+            // the first slot boundary of this level that is not processed yet
+            uint64_t unit = (mTick + (1ULL << shift) - 1) >> shift;
+            uint32_t start = unit & (SLOTS - 1);
+            uint64_t ahead = mOccupied[level] & (~0ULL << start);
+            uint64_t base = unit & ~(uint64_t)(SLOTS - 1);
+            if (ahead) {
+                unit = base + __builtin_ctzll(ahead);
+            } else {
+                // wrapped around into the next turn of this level
+                unit = base + SLOTS + __builtin_ctzll(mOccupied[level]);
+            }
+            if ((unit << shift) < soonestTick) {
+                soonestTick = unit << shift;
+            }
+        }
+    }
+
+    if (mOverflow) {
+        // the overflow list is revisited each time the top level wraps around
+        uint32_t shift = SLOT_BITS * LEVELS;
+        uint64_t tick = ((mTick + (1ULL << shift) - 1) >> shift) << shift;
+        if (tick < soonestTick) {
+            soonestTick = tick;
+        }
+    }
+
+    return soonestTick;
+}
+
+LocTimerDelegate* LocTimerWheel::advance(uint64_t now) {
+    LocTimerDelegate* expired = NULL;
+
+    for (uint64_t tick = getSoonestTick(); tick <= now; tick = getSoonestTick()) {
+        // jumping over the ticks that have nothing to do
+        mTick = tick;
+        if (mOverflow && 0 == (tick & ((1ULL << (SLOT_BITS * LEVELS)) - 1))) {
+            cascade(OVERFLOW_LEVEL, 0);
+        }
+        // higher levels first, so a timer due right now cascades into level 0
+        for (uint32_t level = LEVELS - 1; level > 0; level--) {
+            uint32_t shift = SLOT_BITS * level;
+            if (0 == (tick & ((1ULL << shift) - 1))) {
+                cascade(level, (tick >> shift) & (SLOTS - 1));
+            }
+        }
+        LocTimerDelegate*& head = mSlots[0][tick & (SLOTS - 1)];
+        while (NULL != head) {
+            LocTimerDelegate* timer = head;
+            unlink(*timer);
+            mCount--;
+            timer->mNext = expired;
+            expired = timer;
+        }
+        mTick = tick + 1;
+    }
+
+    if (now >= mTick) {
+        mTick = now + 1;
+    }
+
+    return expired;
+}
+
+
 /***************************LocTimerPollTask methods***************************/
 
 inline
@@ -482,7 +806,12 @@ LocTimerDelegate::LocTimerDelegate(LocTimer& client,
     : mClient(&client),
       mLock(mClient->mLock->share()),
       mFutureTime(futureTime),
-      mContainer(container) {
+      mContainer(container),
+      mPrev(NULL),
+      mNext(NULL),
+      mExpireTick(0),
+      mLevel(NO_LEVEL),
+      mSlot(0) {
     // adding the timer into the container
     mContainer->add(*this);
 }
@@ -693,39 +1022,75 @@ public:
     }
 };
 
+// Timer that signals its expiration. A 0 ms one started after a burst of
+// start() / stop() calls expires only after the timer MsgTask has processed
+// all the msgs of the burst, so waiting for it times the whole burst.
+class LocTimerSync : public LocTimer {
+    pthread_mutex_t mMutex;
+    pthread_cond_t mCond;
+    bool mExpired;
+public:
+    inline LocTimerSync() : LocTimer(), mExpired(false) {
+        pthread_mutex_init(&mMutex, NULL);
+        pthread_cond_init(&mCond, NULL);
+    }
+    inline ~LocTimerSync() {
+        pthread_cond_destroy(&mCond);
+        pthread_mutex_destroy(&mMutex);
+    }
+    inline virtual void timeOutCallback() {
+        pthread_mutex_lock(&mMutex);
+        mExpired = true;
+        pthread_cond_signal(&mCond);
+        pthread_mutex_unlock(&mMutex);
+    }
+    void wait() {
+        pthread_mutex_lock(&mMutex);
+        while (!mExpired) {
+            pthread_cond_wait(&mCond, &mMutex);
+        }
+        mExpired = false;
+        pthread_mutex_unlock(&mMutex);
+    }
+};
+
 // For Linux command line testing:
 // compilation:
 //     g++ -D__LOC_HOST_DEBUG__ -D__LOC_DEBUG__ -g -I. -I../../../../system/core/include -o LocHeap.o LocHeap.cpp
 //     g++ -D__LOC_HOST_DEBUG__ -D__LOC_DEBUG__ -g -std=c++0x -I. -I../../../../system/core/include -lpthread -o LocThread.o LocThread.cpp
 //     g++ -D__LOC_HOST_DEBUG__ -D__LOC_DEBUG__ -g -I. -I../../../../system/core/include -o LocTimer.o LocTimer.cpp
+// usage:
+//     LocTimer [tries] [heap | wheel]
+// tries defaults to 100000. The start / stop check is followed by a benchmark
+// that churns tries timers through the chosen backend, heap by default.
 int main(int argc, char** argv) {
     struct timespec timeOfStart=getNow();
     srand(time(NULL));
-    int tries = atoi(argv[1]);
-    int checks = tries >> 3;
+    int tries = (argc > 1) ? atoi(argv[1]) : 100000;
+    bool useWheel = (argc > 2) && (0 == strcmp(argv[2], "wheel"));
+    LocTimerContainer::useWheel(useWheel);
     LocTimerTest** timerArray = new LocTimerTest*[tries];
-    memset(timerArray, NULL, tries);
+    memset(timerArray, 0, tries * sizeof(LocTimerTest*));
 
+    // timeouts are a minute out so that no timer expires during the check
     for (int i = 0; i < tries; i++) {
         int r = rand() % tries;
-        LocTimerTest* timer = new LocTimerTest(r);
         if (timerArray[r]) {
-            if (!timer->stop()) {
+            if (!timerArray[r]->stop()) {
                 printf("%lf:\n", getDeltaSeconds(timeOfStart, getNow()));
                 printf("ERRER: %dth timer, id %d, not running when it should be\n", i, r);
                 exit(0);
             } else {
-                printf("stop() - %d\n", r);
-                delete timer;
+                delete timerArray[r];
                 timerArray[r] = NULL;
             }
         } else {
-            if (!timer->start(r, false)) {
+            LocTimerTest* timer = new LocTimerTest(60000 + r);
+            if (!timer->start(60000 + r, false)) {
                 printf("%lf:\n", getDeltaSeconds(timeOfStart, getNow()));
                 printf("ERRER: %dth timer, id %d, running when it should not be\n", i, r);
                 exit(0);
             } else {
-                printf("stop() - %d\n", r);
                 timerArray[r] = timer;
             }
         }
@@ -738,13 +1103,40 @@ int main(int argc, char** argv) {
                 printf("ERRER: %dth timer, not running when it should be\n", i);
                 exit(0);
             } else {
-                printf("stop() - %d\n", i);
                 delete timerArray[i];
                 timerArray[i] = NULL;
             }
         }
     }
 
+    // churn: start tries timers 1 to 10 minutes out, restart a random one of
+    // them tries times, then stop them all. Nothing expires but the sync timer.
+    LocTimerSync sync;
+    for (int i = 0; i < tries; i++) {
+        timerArray[i] = new LocTimerTest(i);
+    }
+    struct timespec timeOfChurn = getNow();
+    for (int i = 0; i < tries; i++) {
+        timerArray[i]->start(60000 + rand() % 540000, false);
+    }
+    for (int i = 0; i < tries; i++) {
+        LocTimerTest* timer = timerArray[rand() % tries];
+        timer->stop();
+        timer->start(60000 + rand() % 540000, false);
+    }
+    for (int i = 0; i < tries; i++) {
+        timerArray[i]->stop();
+    }
+    sync.start(0, false);
+    sync.wait();
+    double churnSeconds = getDeltaSeconds(timeOfChurn, getNow());
+    printf("%s: %d starts, %d restarts, %d stops in %lf sec, %lf usec per op\n",
+           useWheel ? "wheel" : "heap", tries, tries, tries, churnSeconds,
+           churnSeconds * 1000000 / (4.0 * tries));
+
+    for (int i = 0; i < tries; i++) {
+        delete timerArray[i];
+    }
     delete[] timerArray;
 
     return 0;
@@ -30,6 +30,9 @@
 #define LOG_TAG "LocSvc_MsgTask"
 
 #include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 #include <MsgTask.h>
 #include <msg_q.h>
 #include <log_util.h>
@@ -40,6 +43,145 @@ static void LocMsgDestroy(void* msg) {
     delete (LocMsg*)msg;
 }
 
+// Size class slab pools behind LocMsg::operator new / delete. Slabs are
+// only ever grown, to the high-water mark of LocMsgs in flight; freed LocMsg
+// slots go on the size class' free list for the next sender to reuse.
+class LocMsgPool {
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+    struct SizeClass {
+        pthread_mutex_t lock;
+        FreeSlot* freeList;
+        uint64_t allocs;
+        uint64_t frees;
+        uint64_t heapAllocs;
+        uint64_t pooled;
+    };
+    static const size_t MIN_SLOT_SIZE = 64;
+    static const size_t NUM_SIZE_CLASSES = 9;   // 64 bytes .. 16K
+    static const size_t SLAB_SIZE = 16 * 1024;
+
+    SizeClass mClasses[NUM_SIZE_CLASSES + 1];   // last one: oversized, plain heap
+
+    static inline size_t slotSize(size_t index) { return MIN_SLOT_SIZE << index; }
+    static inline size_t classOf(size_t size) {
+        size_t index = 0;
+        while (index < NUM_SIZE_CLASSES && slotSize(index) < size) {
+            index++;
+        }
+        return index;
+    }
+
+    // called with sc.lock held
+    bool refill(SizeClass& sc, size_t index) {
+        size_t slot = slotSize(index);
+        size_t count = (slot < SLAB_SIZE) ? (SLAB_SIZE / slot) : 1;
+        char* slab = (char*)malloc(slot * count);
+        if (nullptr == slab) {
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            FreeSlot* freeSlot = (FreeSlot*)(slab + i * slot);
+            freeSlot->next = sc.freeList;
+            sc.freeList = freeSlot;
+        }
+        sc.heapAllocs++;
+        sc.pooled += count;
+        return true;
+    }
+
+public:
+    LocMsgPool() {
+        memset(mClasses, 0, sizeof(mClasses));
+        for (size_t i = 0; i <= NUM_SIZE_CLASSES; i++) {
+            pthread_mutex_init(&mClasses[i].lock, nullptr);
+        }
+    }
+
+    void* alloc(size_t size) {
+        size_t index = classOf(size);
+        SizeClass& sc = mClasses[index];
+        void* ptr = nullptr;
+
+        pthread_mutex_lock(&sc.lock);
+        if (NUM_SIZE_CLASSES == index) {
+            ptr = malloc(size);
+            sc.heapAllocs++;
+        } else if (nullptr != sc.freeList || refill(sc, index)) {
+            ptr = sc.freeList;
+            sc.freeList = sc.freeList->next;
+            sc.pooled--;
+        }
+        if (nullptr != ptr) {
+            sc.allocs++;
+        }
+        pthread_mutex_unlock(&sc.lock);
+
+        return ptr;
+    }
+
+    void release(void* ptr, size_t size) {
+        size_t index = classOf(size);
+        SizeClass& sc = mClasses[index];
+
+        pthread_mutex_lock(&sc.lock);
+        if (NUM_SIZE_CLASSES == index) {
+            free(ptr);
+        } else {
+            FreeSlot* freeSlot = (FreeSlot*)ptr;
+            freeSlot->next = sc.freeList;
+            sc.freeList = freeSlot;
+            sc.pooled++;
+        }
+        sc.frees++;
+        pthread_mutex_unlock(&sc.lock);
+    }
+
+    void getStats(LocMsgPoolStats& stats) {
+        memset(&stats, 0, sizeof(stats));
+        for (size_t i = 0; i <= NUM_SIZE_CLASSES; i++) {
+            SizeClass& sc = mClasses[i];
+            pthread_mutex_lock(&sc.lock);
+            stats.allocs += sc.allocs;
+            stats.frees += sc.frees;
+            stats.heapAllocs += sc.heapAllocs;
+            stats.pooled += sc.pooled;
+            pthread_mutex_unlock(&sc.lock);
+        }
+        stats.inUse = stats.allocs - stats.frees;
+    }
+};
+
+// never destructed, as LocMsgs may still be deleted during process teardown
+static LocMsgPool* getLocMsgPool() {
+    static LocMsgPool* pool = new LocMsgPool();
+    return pool;
+}
+
+void* LocMsg::operator new(size_t size) {
+    void* ptr = getLocMsgPool()->alloc(size);
+    if (nullptr == ptr) {
+        LOC_LOGE("%s: out of memory for a LocMsg of %zu bytes", __func__, size);
+        abort();
+    }
+    return ptr;
+}
+
+void* LocMsg::operator new(size_t size, const std::nothrow_t&) throw() {
+    return getLocMsgPool()->alloc(size);
+}
+
+void LocMsg::operator delete(void* ptr, size_t size) {
+    if (nullptr != ptr) {
+        getLocMsgPool()->release(ptr, size);
+    }
+}
+
+void LocMsg::getPoolStats(LocMsgPoolStats& stats) {
+    getLocMsgPool()->getStats(stats);
+}
+
 MsgTask::MsgTask(LocThread::tCreate tCreator,
                  const char* threadName, bool joinable) :
     mQ(msg_q_init2()), mThread(new LocThread()) {
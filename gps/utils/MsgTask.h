@@ -29,13 +29,32 @@
 #ifndef __MSG_TASK__
 #define __MSG_TASK__
 
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
 #include <LocThread.h>
 
+struct LocMsgPoolStats {
+    uint64_t allocs;      // LocMsgs handed out
+    uint64_t frees;       // LocMsgs given back
+    uint64_t heapAllocs;  // slab refills plus oversized LocMsgs, i.e. trips to the heap
+    uint64_t inUse;       // LocMsgs currently alive
+    uint64_t pooled;      // free LocMsg slots held in slabs
+};
+
 struct LocMsg {
     inline LocMsg() {}
     inline virtual ~LocMsg() {}
     virtual void proc() const = 0;
     inline virtual void log() const {}
+
+    // LocMsgs are created on the sender's thread and deleted on the MsgTask
+    // thread. They are carved out of size class slabs that are recycled, so
+    // that steady state messaging does not go to the heap at all.
+    static void* operator new(size_t size);
+    static void* operator new(size_t size, const std::nothrow_t&) throw();
+    static void operator delete(void* ptr, size_t size);
+    static void getPoolStats(LocMsgPoolStats& stats);
 };
 
 class MsgTask : public LocRunnable {
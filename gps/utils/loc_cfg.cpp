@@ -39,6 +39,9 @@
 #include <time.h>
 #include <pwd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <loc_cfg.h>
 #include <loc_pla.h>
 #include <loc_target.h>
@@ -76,6 +79,51 @@ typedef struct loc_param_v_type
     double param_double_value;
 }loc_param_v_type;
 
+/* Largest table that gets a hash index, bigger ones are scanned linearly */
+#define LOC_PARAM_INDEX_MAX_PARAMS  256
+#define LOC_PARAM_INDEX_MAX_SLOTS   (2 * LOC_PARAM_INDEX_MAX_PARAMS)
+#define LOC_PARAM_INDEX_MAX_BUCKETS (LOC_PARAM_INDEX_MAX_PARAMS / 2)
+#define LOC_PARAM_INDEX_MAX_SEEDS   4096
+
+/* Perfect hash index of a loc_param_s_type table, built for each read. Names
+   are spread over buckets, and each bucket has a seed that places all of its
+   names in slots of their own. */
+typedef struct
+{
+    const loc_param_s_type* table;
+    uint32_t table_length;
+    /* 0 if the table is scanned linearly */
+    uint32_t num_slots;
+    uint32_t num_buckets;
+    uint16_t seeds[LOC_PARAM_INDEX_MAX_BUCKETS];
+    /* 0 for an empty slot, otherwise 1 + table index */
+    uint16_t slots[LOC_PARAM_INDEX_MAX_SLOTS];
+}loc_param_index_type;
+
+/* Config item of a conf file, parsed and kept in loc_conf_file_type */
+typedef struct
+{
+    loc_param_v_type value;
+    uint32_t name_hash;
+}loc_conf_item_type;
+
+/* Parsed conf file, cached as long as the file stays the same */
+typedef struct loc_conf_file_type
+{
+    struct loc_conf_file_type* next;
+    char* path;
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+    loc_conf_item_type* items;
+    uint32_t num_items;
+    char* strings;
+}loc_conf_file_type;
+
+static pthread_mutex_t loc_conf_file_lock = PTHREAD_MUTEX_INITIALIZER;
+static loc_conf_file_type* loc_conf_files = NULL;
+
 // Reference below arrays wherever needed to avoid duplicating
 // same conf path string over and again in location code.
 const char LOC_PATH_GPS_CONF[] = LOC_PATH_GPS_CONF_STR;
@@ -185,6 +233,67 @@ int loc_set_config_entry(const loc_param_s_type* config_entry, loc_param_v_type*
     return ret;
 }
 
+/*===========================================================================
+FUNCTION loc_parse_conf_item
+
+DESCRIPTION
+   Splits a line of configuration item into its name and value, and parses
+   the value as a number.
+
+PARAMETERS:
+   input_buf : buffer contanis config item, tokenized in place
+   config_value: name and values of the config item
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   true if input_buf holds a config item
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static bool loc_parse_conf_item(char* input_buf, loc_param_v_type* config_value)
+{
+    bool ret = false;
+
+    if (input_buf) {
+        char *lasts;
+        memset(config_value, 0, sizeof(*config_value));
+
+        /* Separate variable and value */
+        config_value->param_name = strtok_r(input_buf, "=", &lasts);
+        /* skip lines that do not contain "=" */
+        if (config_value->param_name) {
+            config_value->param_str_value = strtok_r(NULL, "=", &lasts);
+
+            /* skip lines that do not contain two operands */
+            if (config_value->param_str_value) {
+                /* Trim leading and trailing spaces */
+                loc_util_trim_space(config_value->param_name);
+                loc_util_trim_space(config_value->param_str_value);
+
+                /* Parse numerical value */
+                if ((strlen(config_value->param_str_value) >=3) &&
+                    (config_value->param_str_value[0] == '0') &&
+                    (tolower(config_value->param_str_value[1]) == 'x'))
+                {
+                    /* hex */
+                    config_value->param_int_value = (int) strtol(&config_value->param_str_value[2],
+                                                                 (char**) NULL, 16);
+                }
+                else {
+                    config_value->param_double_value = (double) atof(config_value->param_str_value); /* float */
+                    config_value->param_int_value = atoi(config_value->param_str_value); /* dec */
+                }
+                ret = true;
+            }
+        }
+    }
+
+    return ret;
+}
+
 /*===========================================================================
 FUNCTION loc_fill_conf_item
 
@@ -213,49 +322,219 @@ int loc_fill_conf_item(char* input_buf,
     int ret = 0;
 
     if (input_buf && config_table) {
-        char *lasts;
         loc_param_v_type config_value;
-        memset(&config_value, 0, sizeof(config_value));
 
-        /* Separate variable and value */
-        config_value.param_name = strtok_r(input_buf, "=", &lasts);
-        /* skip lines that do not contain "=" */
-        if (config_value.param_name) {
-            config_value.param_str_value = strtok_r(NULL, "=", &lasts);
+        if (loc_parse_conf_item(input_buf, &config_value)) {
+            for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
+            {
+                if(!loc_set_config_entry(&config_table[i], &config_value)) {
+                    ret += 1;
+                }
+            }
+        }
+    }
 
-            /* skip lines that do not contain two operands */
-            if (config_value.param_str_value) {
-                /* Trim leading and trailing spaces */
-                loc_util_trim_space(config_value.param_name);
-                loc_util_trim_space(config_value.param_str_value);
+    return ret;
+}
 
-                /* Parse numerical value */
-                if ((strlen(config_value.param_str_value) >=3) &&
-                    (config_value.param_str_value[0] == '0') &&
-                    (tolower(config_value.param_str_value[1]) == 'x'))
-                {
-                    /* hex */
-                    config_value.param_int_value = (int) strtol(&config_value.param_str_value[2],
-                                                                (char**) NULL, 16);
+/*===========================================================================
+FUNCTION loc_param_name_hash
+
+DESCRIPTION
+   FNV-1a hash of a parameter name.
+===========================================================================*/
+static uint32_t loc_param_name_hash(const char* name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash = (hash ^ (uint8_t)*name++) * 16777619u;
+    }
+    return hash;
+}
+
+static inline uint32_t loc_param_index_slot(const loc_param_index_type* index,
+                                            uint32_t name_hash)
+{
+    uint32_t seed = index->seeds[name_hash & (index->num_buckets - 1)];
+    uint32_t x = name_hash ^ (seed * 0x9e3779b9u);
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x & (index->num_slots - 1);
+}
+
+/*===========================================================================
+FUNCTION loc_param_index_init
+
+DESCRIPTION
+   Builds a perfect hash index of the names in a configuration table, so that
+   a lookup is a single probe. Names are hashed into buckets of about 2, and
+   starting with the fullest bucket, each bucket is given the first seed that
+   puts its names into slots still free. Tables too big, with duplicated names,
+   or for which a bucket gets no such seed are left to a linear scan.
+
+PARAMETERS:
+   index: index to build
+   config_table: table definition of strings to places to store information
+   table_length: length of the configuration table
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static void loc_param_index_init(loc_param_index_type* index,
+                                 const loc_param_s_type* config_table, uint32_t table_length)
+{
+    uint32_t hashes[LOC_PARAM_INDEX_MAX_PARAMS];
+    uint8_t bucket_sizes[LOC_PARAM_INDEX_MAX_BUCKETS];
+    uint32_t max_bucket_size = 0;
+
+    index->table = config_table;
+    index->table_length = table_length;
+    index->num_slots = 0;
+
+    if (NULL == config_table || 0 == table_length ||
+        table_length > LOC_PARAM_INDEX_MAX_PARAMS) {
+        return;
+    }
+
+    index->num_buckets = 1;
+    while (2 * index->num_buckets < table_length) {
+        index->num_buckets <<= 1;
+    }
+    uint32_t num_slots = 2;
+    while (num_slots < 2 * table_length) {
+        num_slots <<= 1;
+    }
+    memset(bucket_sizes, 0, sizeof(bucket_sizes));
+    memset(index->seeds, 0, sizeof(index->seeds));
+    memset(index->slots, 0, num_slots * sizeof(index->slots[0]));
+    /* loc_param_index_slot() masks with num_slots while placing */
+    index->num_slots = num_slots;
+
+    for (uint32_t i = 0; i < table_length; i++) {
+        hashes[i] = loc_param_name_hash(config_table[i].param_name);
+        uint32_t size = ++bucket_sizes[hashes[i] & (index->num_buckets - 1)];
+        if (size > max_bucket_size) {
+            max_bucket_size = size;
+        }
+        /* no seed tells apart names of the same hash, e.g. duplicated ones */
+        for (uint32_t j = 0; j < i; j++) {
+            if (hashes[j] == hashes[i]) {
+                index->num_slots = 0;
+                return;
+            }
+        }
+    }
+
+    for (uint32_t size = max_bucket_size; size > 0; size--) {
+        for (uint32_t b = 0; b < index->num_buckets; b++) {
+            if (bucket_sizes[b] != size) {
+                continue;
+            }
+            uint32_t seed = 0;
+            for (; seed < LOC_PARAM_INDEX_MAX_SEEDS; seed++) {
+                uint32_t placed = 0;
+                index->seeds[b] = (uint16_t)seed;
+                for (uint32_t i = 0; i < table_length && placed < size; i++) {
+                    if ((hashes[i] & (index->num_buckets - 1)) != b) {
+                        continue;
+                    }
+                    uint32_t slot = loc_param_index_slot(index, hashes[i]);
+                    if (index->slots[slot]) {
+                        break;
+                    }
+                    index->slots[slot] = (uint16_t)(i + 1);
+                    placed++;
                 }
-                else {
-                    config_value.param_double_value = (double) atof(config_value.param_str_value); /* float */
-                    config_value.param_int_value = atoi(config_value.param_str_value); /* dec */
+                if (placed == size) {
+                    break;
                 }
-
-                for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
-                {
-                    if(!loc_set_config_entry(&config_table[i], &config_value)) {
-                        ret += 1;
+                /* take back what this seed placed so far */
+                for (uint32_t slot = 0; slot < num_slots; slot++) {
+                    uint16_t entry = index->slots[slot];
+                    if (entry && (hashes[entry - 1] & (index->num_buckets - 1)) == b) {
+                        index->slots[slot] = 0;
                     }
                 }
             }
+            if (LOC_PARAM_INDEX_MAX_SEEDS == seed) {
+                LOC_LOGD("%s: no perfect hash for %u params, scanning linearly",
+                         __FUNCTION__, table_length);
+                index->num_slots = 0;
+                return;
+            }
+        }
+    }
+}
+
+/*===========================================================================
+FUNCTION loc_param_index_fill
+
+DESCRIPTION
+   Sets the table entry, or entries, named by a config item.
+
+PARAMETERS:
+   index: index of the configuration table
+   config_value: parsed config item
+   name_hash: loc_param_name_hash() of the config item name
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Number of records in the config table filled with config_value
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static int loc_param_index_fill(const loc_param_index_type* index,
+                                loc_param_v_type* config_value, uint32_t name_hash)
+{
+    int ret = 0;
+
+    if (index->num_slots) {
+        uint16_t entry = index->slots[loc_param_index_slot(index, name_hash)];
+        if (entry && !loc_set_config_entry(&index->table[entry - 1], config_value)) {
+            ret = 1;
+        }
+    } else {
+        for(uint32_t i = 0; NULL != index->table && i < index->table_length; i++)
+        {
+            if(!loc_set_config_entry(&index->table[i], config_value)) {
+                ret += 1;
+            }
         }
     }
 
     return ret;
 }
 
+/*===========================================================================
+FUNCTION loc_param_clear_set_bits
+
+DESCRIPTION
+   Clears all the validity bits of a configuration table.
+===========================================================================*/
+static void loc_param_clear_set_bits(const loc_param_s_type* config_table,
+                                     uint32_t table_length)
+{
+    for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
+    {
+        if(NULL != config_table[i].param_set)
+        {
+            *(config_table[i].param_set) = 0;
+        }
+    }
+}
+
 /*===========================================================================
 FUNCTION loc_read_conf_r (repetitive)
 
@@ -297,25 +576,25 @@ int loc_read_conf_r(FILE *conf_fp, const loc_param_s_type* config_table, uint32_
     }
 
     /* Clear all validity bits */
-    for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
-    {
-        if(NULL != config_table[i].param_set)
-        {
-            *(config_table[i].param_set) = 0;
-        }
-    }
+    loc_param_clear_set_bits(config_table, table_length);
 
     char input_buf[LOC_MAX_PARAM_LINE];  /* declare a char array */
+    loc_param_index_type index;
+    loc_param_index_init(&index, config_table, table_length);
 
     LOC_LOGD("%s:%d]: num_params: %d\n", __func__, __LINE__, num_params);
     while(num_params)
     {
+        loc_param_v_type config_value;
         if(!fgets(input_buf, LOC_MAX_PARAM_LINE, conf_fp)) {
             LOC_LOGD("%s:%d]: fgets returned NULL\n", __func__, __LINE__);
             break;
         }
 
-        num_params -= loc_fill_conf_item(input_buf, config_table, table_length);
+        if (NULL != config_table && loc_parse_conf_item(input_buf, &config_value)) {
+            num_params -= loc_param_index_fill(&index, &config_value,
+                                               loc_param_name_hash(config_value.param_name));
+        }
     }
 
 err:
@@ -367,12 +646,18 @@ int loc_update_conf(const char* conf_data, int32_t length,
             uint32_t num_params = table_length - 1;
             char* saveptr = NULL;
             char* input_buf = strtok_r(conf_copy, "\n", &saveptr);
+            loc_param_index_type index;
+            loc_param_index_init(&index, config_table, table_length);
             ret = 0;
 
             LOC_LOGD("%s:%d]: num_params: %d\n", __func__, __LINE__, num_params);
             while(num_params && input_buf) {
+                loc_param_v_type config_value;
                 ret++;
-                num_params -= loc_fill_conf_item(input_buf, config_table, table_length);
+                if (loc_parse_conf_item(input_buf, &config_value)) {
+                    num_params -= loc_param_index_fill(&index, &config_value,
+                            loc_param_name_hash(config_value.param_name));
+                }
                 input_buf = strtok_r(NULL, "\n", &saveptr);
             }
             free(conf_copy);
@@ -382,6 +667,203 @@ int loc_update_conf(const char* conf_data, int32_t length,
     return ret;
 }
 
+/*===========================================================================
+FUNCTION loc_conf_file_parse
+
+DESCRIPTION
+   Maps a conf file and parses all of its config items in one pass. The file
+   is cut into the same lines that fgets() with a LOC_MAX_PARAM_LINE buffer
+   would return, so that the items are the ones loc_read_conf_r() would see.
+
+PARAMETERS:
+   conf_file: cache entry to fill in
+   fd: open conf file
+   size: size of the conf file
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   0: success
+  -1: failure
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static int loc_conf_file_parse(loc_conf_file_type* conf_file, int fd, size_t size)
+{
+    const char* data = NULL;
+    uint32_t max_items = 0;
+    size_t used = 0;
+
+    conf_file->items = NULL;
+    conf_file->num_items = 0;
+    /* each line is copied out with a NUL, and a line has at least 1 char */
+    conf_file->strings = (char*)malloc(2 * size + 1);
+    if (NULL == conf_file->strings) {
+        return -1;
+    }
+
+    if (size > 0) {
+        data = (const char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED == data) {
+            LOC_LOGE("%s: mmap failed - %s", __FUNCTION__, strerror(errno));
+            return -1;
+        }
+    }
+
+    for (size_t pos = 0; pos < size; ) {
+        size_t len = 0;
+        while (pos + len < size && len < LOC_MAX_PARAM_LINE - 1) {
+            if ('\n' == data[pos + len++]) {
+                break;
+            }
+        }
+
+        char* input_buf = conf_file->strings + used;
+        memcpy(input_buf, data + pos, len);
+        input_buf[len] = '\0';
+        used += len + 1;
+        pos += len;
+
+        loc_param_v_type config_value;
+        if (loc_parse_conf_item(input_buf, &config_value)) {
+            if (conf_file->num_items == max_items) {
+                max_items = max_items ? 2 * max_items : 32;
+                loc_conf_item_type* items = (loc_conf_item_type*)
+                        realloc(conf_file->items, max_items * sizeof(loc_conf_item_type));
+                if (NULL == items) {
+                    munmap((void*)data, size);
+                    return -1;
+                }
+                conf_file->items = items;
+            }
+            conf_file->items[conf_file->num_items].value = config_value;
+            conf_file->items[conf_file->num_items].name_hash =
+                    loc_param_name_hash(config_value.param_name);
+            conf_file->num_items++;
+        }
+    }
+
+    if (size > 0) {
+        munmap((void*)data, size);
+    }
+    return 0;
+}
+
+/*===========================================================================
+FUNCTION loc_conf_file_get
+
+DESCRIPTION
+   Returns the parsed conf file from the cache. The file is parsed again only
+   if it changed since it was parsed last, going by its inode, size and
+   modification time. Must be called with loc_conf_file_lock held.
+
+PARAMETERS:
+   conf_file_name: configuration file to read
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   The parsed conf file, or NULL if it can not be read.
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static loc_conf_file_type* loc_conf_file_get(const char* conf_file_name)
+{
+    loc_conf_file_type** link = &loc_conf_files;
+    loc_conf_file_type* conf_file = NULL;
+    struct stat st;
+
+    while (NULL != *link && strcmp((*link)->path, conf_file_name)) {
+        link = &(*link)->next;
+    }
+    conf_file = *link;
+
+    if (NULL != conf_file && 0 == stat(conf_file_name, &st) &&
+        st.st_dev == conf_file->dev && st.st_ino == conf_file->ino &&
+        st.st_size == conf_file->size &&
+        st.st_mtim.tv_sec == conf_file->mtime.tv_sec &&
+        st.st_mtim.tv_nsec == conf_file->mtime.tv_nsec) {
+        return conf_file;
+    }
+
+    /* not cached yet, or changed */
+    if (NULL != conf_file) {
+        *link = conf_file->next;
+        free(conf_file->items);
+        free(conf_file->strings);
+        free(conf_file->path);
+        free(conf_file);
+        conf_file = NULL;
+    }
+
+    int fd = open(conf_file_name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    conf_file = (loc_conf_file_type*)calloc(1, sizeof(loc_conf_file_type));
+    if (NULL != conf_file && 0 == fstat(fd, &st) &&
+        NULL != (conf_file->path = strdup(conf_file_name)) &&
+        0 == loc_conf_file_parse(conf_file, fd, st.st_size)) {
+        conf_file->dev = st.st_dev;
+        conf_file->ino = st.st_ino;
+        conf_file->size = st.st_size;
+        conf_file->mtime = st.st_mtim;
+        conf_file->next = loc_conf_files;
+        loc_conf_files = conf_file;
+    } else if (NULL != conf_file) {
+        free(conf_file->items);
+        free(conf_file->strings);
+        free(conf_file->path);
+        free(conf_file);
+        conf_file = NULL;
+    }
+
+    close(fd);
+    return conf_file;
+}
+
+/*===========================================================================
+FUNCTION loc_conf_file_fill
+
+DESCRIPTION
+   Sets defined values of a configuration table from a parsed conf file,
+   the same way loc_read_conf_r() does from the file itself.
+
+PARAMETERS:
+   conf_file: parsed configuration file
+   config_table: table definition of strings to places to store information
+   table_length: length of the configuration table
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static void loc_conf_file_fill(loc_conf_file_type* conf_file,
+                               const loc_param_s_type* config_table, uint32_t table_length)
+{
+    unsigned int num_params = table_length;
+    loc_param_index_type index;
+
+    /* Clear all validity bits */
+    loc_param_clear_set_bits(config_table, table_length);
+    loc_param_index_init(&index, config_table, table_length);
+
+    for (uint32_t i = 0; num_params && i < conf_file->num_items; i++) {
+        num_params -= loc_param_index_fill(&index, &conf_file->items[i].value,
+                                           conf_file->items[i].name_hash);
+    }
+}
+
 /*===========================================================================
 FUNCTION loc_read_conf
 
@@ -389,6 +871,8 @@ DESCRIPTION
    Reads the specified configuration file and sets defined values based on
    the passed in configuration table. This table maps strings to values to
    set along with the type of each of these values.
+   The file is parsed once and cached until it changes, so that reading it
+   again for other tables does not go through the file again.
 
 PARAMETERS:
    conf_file_name: configuration file to read
@@ -407,18 +891,18 @@ SIDE EFFECTS
 void loc_read_conf(const char* conf_file_name, const loc_param_s_type* config_table,
                    uint32_t table_length)
 {
-    FILE *conf_fp = NULL;
+    loc_conf_file_type* conf_file = NULL;
 
-    if((conf_fp = fopen(conf_file_name, "r")) != NULL)
+    pthread_mutex_lock(&loc_conf_file_lock);
+    if((conf_file = loc_conf_file_get(conf_file_name)) != NULL)
     {
         LOC_LOGD("%s: using %s", __FUNCTION__, conf_file_name);
         if(table_length && config_table) {
-            loc_read_conf_r(conf_fp, config_table, table_length);
-            rewind(conf_fp);
+            loc_conf_file_fill(conf_file, config_table, table_length);
         }
-        loc_read_conf_r(conf_fp, loc_param_table, loc_param_num);
-        fclose(conf_fp);
+        loc_conf_file_fill(conf_file, loc_param_table, loc_param_num);
     }
+    pthread_mutex_unlock(&loc_conf_file_lock);
     /* Initialize logging mechanism with parsed data */
     loc_logger_init(DEBUG_LEVEL, TIMESTAMP);
 }
@@ -1137,3 +1621,147 @@ err:
 
     return ret;
 }
+
+#ifdef __LOC_DEBUG__
+
+/* Startup benchmark of loc_read_conf(). A conf file with LOC_CFG_BENCH_PARAMS
+   items is read with LOC_CFG_BENCH_TABLES tables of its items, the way gps.conf
+   is read for several tables at startup. Compares the former fgets() / linear
+   table scan reading with a cold read, where the cache is flushed first, and
+   a warm read from the cache, and checks that all of them read the same.
+
+   For Linux command line testing:
+   compilation:
+       g++ -D__LOC_DEBUG__ -O2 -I. -I../pla/android -I../../../../system/core/include -o loc_cfg_bench loc_cfg.cpp loc_misc_utils.cpp loc_log.cpp loc_target.cpp -lpthread
+   usage:
+       ./loc_cfg_bench [startups] */
+
+#define LOC_CFG_BENCH_PARAMS 180
+#define LOC_CFG_BENCH_TABLES 3
+#define LOC_CFG_BENCH_TABLE_LEN (LOC_CFG_BENCH_PARAMS / LOC_CFG_BENCH_TABLES)
+
+static char loc_cfg_bench_names[LOC_CFG_BENCH_PARAMS][LOC_MAX_PARAM_NAME];
+static char loc_cfg_bench_strs[2][LOC_CFG_BENCH_PARAMS][LOC_MAX_PARAM_STRING + 1];
+static double loc_cfg_bench_nums[2][LOC_CFG_BENCH_PARAMS];
+static loc_param_s_type loc_cfg_bench_tables[2][LOC_CFG_BENCH_TABLES][LOC_CFG_BENCH_TABLE_LEN];
+
+static void loc_conf_file_flush()
+{
+    pthread_mutex_lock(&loc_conf_file_lock);
+    while (NULL != loc_conf_files) {
+        loc_conf_file_type* conf_file = loc_conf_files;
+        loc_conf_files = conf_file->next;
+        free(conf_file->items);
+        free(conf_file->strings);
+        free(conf_file->path);
+        free(conf_file);
+    }
+    pthread_mutex_unlock(&loc_conf_file_lock);
+}
+
+/* loc_read_conf() as it was, reading the file line by line for each table */
+static void loc_cfg_bench_legacy_read(const char* conf_file_name,
+                                      const loc_param_s_type* config_table,
+                                      uint32_t table_length)
+{
+    FILE *conf_fp = fopen(conf_file_name, "r");
+    if (NULL != conf_fp) {
+        char input_buf[LOC_MAX_PARAM_LINE];
+        const loc_param_s_type* tables[2] = { config_table, loc_param_table };
+        uint32_t lengths[2] = { table_length, (uint32_t)loc_param_num };
+        for (int t = 0; t < 2; t++) {
+            unsigned int num_params = lengths[t];
+            loc_param_clear_set_bits(tables[t], lengths[t]);
+            while (num_params && fgets(input_buf, LOC_MAX_PARAM_LINE, conf_fp)) {
+                num_params -= loc_fill_conf_item(input_buf, tables[t], lengths[t]);
+            }
+            rewind(conf_fp);
+        }
+        fclose(conf_fp);
+    }
+    loc_logger_init(DEBUG_LEVEL, TIMESTAMP);
+}
+
+static double loc_cfg_bench_secs(const struct timespec* from)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - from->tv_sec) + (double)(now.tv_nsec - from->tv_nsec) / 1e9;
+}
+
+int main(int argc, char** argv)
+{
+    int startups = argc > 1 ? atoi(argv[1]) : 2000;
+    char conf_file_name[64];
+    snprintf(conf_file_name, sizeof(conf_file_name), "/tmp/loc_cfg_bench.%d.conf", getpid());
+
+    FILE* conf_fp = fopen(conf_file_name, "w");
+    if (NULL == conf_fp) {
+        return 1;
+    }
+    for (int i = 0; i < LOC_CFG_BENCH_PARAMS; i++) {
+        snprintf(loc_cfg_bench_names[i], LOC_MAX_PARAM_NAME, "BENCH_PARAM_%03d", i);
+        fprintf(conf_fp, "# %s: what this item is about, and its default\n",
+                loc_cfg_bench_names[i]);
+        switch (i % 3) {
+        case 0: fprintf(conf_fp, "%s = %d\n\n", loc_cfg_bench_names[i], i); break;
+        case 1: fprintf(conf_fp, "%s=0x%x\n\n", loc_cfg_bench_names[i], i); break;
+        default: fprintf(conf_fp, "%s = value.%d\n\n", loc_cfg_bench_names[i], i); break;
+        }
+    }
+    fclose(conf_fp);
+
+    for (int v = 0; v < 2; v++) {
+        for (int i = 0; i < LOC_CFG_BENCH_PARAMS; i++) {
+            loc_param_s_type& entry = loc_cfg_bench_tables[v][i % LOC_CFG_BENCH_TABLES]
+                                                         [i / LOC_CFG_BENCH_TABLES];
+            entry.param_name = loc_cfg_bench_names[i];
+            entry.param_set = NULL;
+            if (2 == i % 3) {
+                entry.param_ptr = loc_cfg_bench_strs[v][i];
+                entry.param_type = 's';
+            } else {
+                entry.param_ptr = &loc_cfg_bench_nums[v][i];
+                entry.param_type = 'f';
+            }
+        }
+    }
+
+    const char* names[3] = { "legacy", "cold", "warm" };
+    for (int run = 0; run < 3; run++) {
+        int v = (0 == run) ? 0 : 1;
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < startups; i++) {
+            if (1 == run) {
+                loc_conf_file_flush();
+            }
+            for (int t = 0; t < LOC_CFG_BENCH_TABLES; t++) {
+                if (0 == run) {
+                    loc_cfg_bench_legacy_read(conf_file_name, loc_cfg_bench_tables[v][t],
+                                              LOC_CFG_BENCH_TABLE_LEN);
+                } else {
+                    loc_read_conf(conf_file_name, loc_cfg_bench_tables[v][t],
+                                  LOC_CFG_BENCH_TABLE_LEN);
+                }
+            }
+        }
+        double secs = loc_cfg_bench_secs(&start);
+        printf("%-6s: %d params in %d tables, %9.2f us per startup\n", names[run],
+               LOC_CFG_BENCH_PARAMS, LOC_CFG_BENCH_TABLES, secs * 1e6 / startups);
+    }
+
+    int mismatches = 0;
+    for (int i = 0; i < LOC_CFG_BENCH_PARAMS; i++) {
+        if (loc_cfg_bench_nums[0][i] != loc_cfg_bench_nums[1][i] ||
+            strcmp(loc_cfg_bench_strs[0][i], loc_cfg_bench_strs[1][i])) {
+            mismatches++;
+        }
+    }
+    printf("%d mismatches\n", mismatches);
+
+    unlink(conf_file_name);
+    return mismatches ? 1 : 0;
+}
+
+#endif
@@ -31,6 +31,8 @@
 #define LOG_TAG "LocSvc_nmea"
 #include <loc_nmea.h>
 #include <math.h>
+#include <pthread.h>
+#include <new>
 #include <log_util.h>
 #include <loc_pla.h>
 
@@ -45,6 +47,13 @@
 #define SYSTEM_ID_BEIDOU       4
 #define SYSTEM_ID_QZSS         5
 
+// Sentence buffers are pooled in two sizes: generated sentences and the
+// (debug) NMEA from the modem, which can be much longer
+#define NMEA_POOL_SMALL_CAPACITY NMEA_SENTENCE_MAX_LENGTH
+#define NMEA_POOL_LARGE_CAPACITY (DEBUG_NMEA_MAXSIZE + 1)
+// free buffers kept per size beyond which they go back to the heap
+#define NMEA_POOL_MAX_FREE 64
+
 typedef struct loc_nmea_sv_meta_s
 {
     char talker[3];
@@ -73,6 +82,148 @@ typedef struct loc_sv_cache_info_s
     float vdop;
 } loc_sv_cache_info;
 
+/*===========================================================================
+  Sentence buffer pool
+===========================================================================*/
+typedef struct loc_nmea_pool_s
+{
+    pthread_mutex_t lock;
+    LocNmeaSentence* freeList[2];   // small, large
+    uint32_t freeCount[2];
+    LocNmeaPoolStats stats;
+} loc_nmea_pool;
+
+static loc_nmea_pool gNmeaPool = { PTHREAD_MUTEX_INITIALIZER, { NULL, NULL }, { 0, 0 }, {} };
+
+static inline int loc_nmea_pool_index(size_t capacity)
+{
+    if (NMEA_POOL_SMALL_CAPACITY == capacity) {
+        return 0;
+    } else if (NMEA_POOL_LARGE_CAPACITY == capacity) {
+        return 1;
+    }
+    return -1;
+}
+
+LocNmeaSentence::LocNmeaSentence(size_t capacity, char* data) :
+    mCapacity(capacity), mLength(0), mNext(NULL), mData(data)
+{
+    mData[0] = '\0';
+}
+
+LocNmeaSentence* LocNmeaSentence::obtain(size_t capacity)
+{
+    if (capacity <= NMEA_POOL_SMALL_CAPACITY) {
+        capacity = NMEA_POOL_SMALL_CAPACITY;
+    } else if (capacity <= NMEA_POOL_LARGE_CAPACITY) {
+        capacity = NMEA_POOL_LARGE_CAPACITY;
+    }
+    int index = loc_nmea_pool_index(capacity);
+    LocNmeaSentence* sentence = NULL;
+
+    pthread_mutex_lock(&gNmeaPool.lock);
+    gNmeaPool.stats.obtained++;
+    if (index >= 0 && NULL != gNmeaPool.freeList[index]) {
+        sentence = gNmeaPool.freeList[index];
+        gNmeaPool.freeList[index] = sentence->mNext;
+        gNmeaPool.freeCount[index]--;
+    } else {
+        gNmeaPool.stats.heapAllocs++;
+    }
+    pthread_mutex_unlock(&gNmeaPool.lock);
+
+    if (NULL == sentence) {
+        void* mem = malloc(sizeof(LocNmeaSentence) + capacity);
+        if (NULL == mem) {
+            LOC_LOGE("%s: no memory for a %zu bytes NMEA sentence", __func__, capacity);
+            return NULL;
+        }
+        sentence = new(mem) LocNmeaSentence(capacity, (char*)mem + sizeof(LocNmeaSentence));
+    } else {
+        sentence->mLength = 0;
+        sentence->mNext = NULL;
+        sentence->mData[0] = '\0';
+    }
+    return sentence;
+}
+
+LocNmeaSentence* LocNmeaSentence::obtain(const char* nmea, size_t length)
+{
+    LocNmeaSentence* sentence = obtain(length + 1);
+    if (NULL != sentence && NULL != nmea) {
+        memcpy(sentence->mData, nmea, length);
+        sentence->setLength(length);
+
+        pthread_mutex_lock(&gNmeaPool.lock);
+        gNmeaPool.stats.bytesCopied += length;
+        pthread_mutex_unlock(&gNmeaPool.lock);
+    }
+    return sentence;
+}
+
+void LocNmeaSentence::release()
+{
+    int index = loc_nmea_pool_index(mCapacity);
+    bool pooled = false;
+    pthread_mutex_lock(&gNmeaPool.lock);
+    if (index >= 0 && gNmeaPool.freeCount[index] < NMEA_POOL_MAX_FREE) {
+        mNext = gNmeaPool.freeList[index];
+        gNmeaPool.freeList[index] = this;
+        gNmeaPool.freeCount[index]++;
+        pooled = true;
+    }
+    pthread_mutex_unlock(&gNmeaPool.lock);
+
+    if (!pooled) {
+        this->~LocNmeaSentence();
+        free(this);
+    }
+}
+
+void LocNmeaSentence::getPoolStats(LocNmeaPoolStats& stats)
+{
+    pthread_mutex_lock(&gNmeaPool.lock);
+    stats = gNmeaPool.stats;
+    pthread_mutex_unlock(&gNmeaPool.lock);
+}
+
+char* LocNmeaSentences::next()
+{
+    if (NULL == mSentences[mCount]) {
+        mSentences[mCount] = LocNmeaSentence::obtain(NMEA_SENTENCE_MAX_LENGTH);
+    }
+    if (NULL == mSentences[mCount]) {
+        mScratch[0] = '\0';
+        return mScratch;
+    }
+    mSentences[mCount]->setLength(0);
+    return mSentences[mCount]->data();
+}
+
+void LocNmeaSentences::commit(size_t length)
+{
+    if (NULL == mSentences[mCount]) {
+        LOC_LOGE("%s: sentence dropped, no buffer", __func__);
+    } else if (NMEA_EPOCH_MAX_SENTENCES == mCount) {
+        LOC_LOGE("%s: sentence dropped, more than %d in epoch",
+                 __func__, NMEA_EPOCH_MAX_SENTENCES);
+    } else {
+        mSentences[mCount]->setLength(length);
+        mSentences[++mCount] = NULL;
+    }
+}
+
+void LocNmeaSentences::clear()
+{
+    for (size_t i = 0; i <= mCount; i++) {
+        if (NULL != mSentences[i]) {
+            mSentences[i]->release();
+        }
+    }
+    mCount = 0;
+    mSentences[0] = NULL;
+}
+
 /*===========================================================================
 FUNCTION    loc_nmea_sv_meta_init
 
@@ -224,12 +375,12 @@ SIDE EFFECTS
 
 ===========================================================================*/
 static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtended,
-                              char* sentence,
-                              int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaSentences &nmeaSentences)
 {
-    if (!sentence || bufSize <= 0 || !sv_meta_p)
+    char* sentence = nmeaSentences.next();
+    int bufSize = NMEA_SENTENCE_MAX_LENGTH;
+    if (!sv_meta_p)
     {
         LOC_LOGE("NMEA Error invalid arguments.");
         return 0;
@@ -324,7 +475,7 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
 
     /* Sentence is ready, add checksum and broadcast */
     length = loc_nmea_put_checksum(sentence, bufSize);
-    nmeaArraystr.push_back(sentence);
+    nmeaSentences.commit(length);
 
     return svUsedCount;
 }
@@ -350,17 +501,11 @@ SIDE EFFECTS
 
 ===========================================================================*/
 static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
-                              char* sentence,
-                              int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaSentences &nmeaSentences)
 {
-    if (!sentence || bufSize <= 0)
-    {
-        LOC_LOGE("NMEA Error invalid argument.");
-        return;
-    }
-
+    char* sentence = nmeaSentences.next();
+    int bufSize = NMEA_SENTENCE_MAX_LENGTH;
     char* pMarker = sentence;
     int lengthRemaining = bufSize;
     int length = 0;
@@ -377,7 +522,7 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
         // no svs in view, so just send a blank $--GSV sentence
         snprintf(sentence, lengthRemaining, "$%sGSV,1,1,0,%d", talker, sv_meta_p->signalId);
         length = loc_nmea_put_checksum(sentence, bufSize);
-        nmeaArraystr.push_back(sentence);
+        nmeaSentences.commit(length);
         return;
     }
 
@@ -387,6 +532,7 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
 
     while (sentenceNumber <= sentenceCount)
     {
+        sentence = nmeaSentences.next();
         pMarker = sentence;
         lengthRemaining = bufSize;
 
@@ -443,7 +589,7 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
         lengthRemaining -= length;
 
         length = loc_nmea_put_checksum(sentence, bufSize);
-        nmeaArraystr.push_back(sentence);
+        nmeaSentences.commit(length);
         sentenceNumber++;
 
     }  //while
@@ -476,7 +622,7 @@ SIDE EFFECTS
 void loc_nmea_generate_pos(const UlpLocation &location,
                                const GpsLocationExtended &locationExtended,
                                unsigned char generate_nmea,
-                               std::vector<std::string> &nmeaArraystr)
+                               LocNmeaSentences &nmeaSentences)
 {
     ENTRY_LOG();
     time_t utcTime(location.gpsLocation.timestamp/1000);
@@ -486,9 +632,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         return;
     }
 
-    char sentence[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char* pMarker = sentence;
-    int lengthRemaining = sizeof(sentence);
+    char* sentence = NULL;
+    char* pMarker = NULL;
+    int lengthRemaining = NMEA_SENTENCE_MAX_LENGTH;
     int length = 0;
     int utcYear = pTm->tm_year % 100; // 2 digit year
     int utcMonth = pTm->tm_mon + 1; // tm_mon starts at zero
@@ -520,9 +666,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GPGSA/$GNGSA---
         // -------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS, true),
-                        nmeaArraystr);
+                        nmeaSentences);
         if (count > 0)
         {
             svUsedCount += count;
@@ -534,9 +680,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GLGSA/$GNGSA---
         // -------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS, true),
-                        nmeaArraystr);
+                        nmeaSentences);
         if (count > 0)
         {
             svUsedCount += count;
@@ -548,9 +694,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GAGSA/$GNGSA---
         // -------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO, true),
-                        nmeaArraystr);
+                        nmeaSentences);
         if (count > 0)
         {
             svUsedCount += count;
@@ -562,9 +708,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$PQGSA/$GNGSA (QZSS)---
         // --------------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS, false),
-                        nmeaArraystr);
+                        nmeaSentences);
         if (count > 0)
         {
             svUsedCount += count;
@@ -574,9 +720,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ----------------------------
         // ---$PQGSA/$GNGSA (BEIDOU)---
         // ----------------------------
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU, false),
-                        nmeaArraystr);
+                        nmeaSentences);
         if (count > 0)
         {
             svUsedCount += count;
@@ -587,8 +733,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ------$--VTG-------
         // -------------------
 
+        sentence = nmeaSentences.next();
         pMarker = sentence;
-        lengthRemaining = sizeof(sentence);
+        lengthRemaining = NMEA_SENTENCE_MAX_LENGTH;
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
         {
@@ -649,15 +796,16 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         else // A means autonomous
             length = snprintf(pMarker, lengthRemaining, "%c", 'A');
 
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        nmeaSentences.commit(length);
 
         // -------------------
         // ------$--RMC-------
         // -------------------
 
+        sentence = nmeaSentences.next();
         pMarker = sentence;
-        lengthRemaining = sizeof(sentence);
+        lengthRemaining = NMEA_SENTENCE_MAX_LENGTH;
 
         length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,A," ,
                           talker, utcHours, utcMinutes, utcSeconds,utcMSeconds/10);
@@ -815,15 +963,16 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         pMarker += length;
         lengthRemaining -= length;
 
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        nmeaSentences.commit(length);
 
         // -------------------
         // ------$--GGA-------
         // -------------------
 
+        sentence = nmeaSentences.next();
         pMarker = sentence;
-        lengthRemaining = sizeof(sentence);
+        lengthRemaining = NMEA_SENTENCE_MAX_LENGTH;
 
         length = snprintf(pMarker, lengthRemaining, "$%sGGA,%02d%02d%02d.%02d," ,
                           talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
@@ -946,34 +1095,40 @@ void loc_nmea_generate_pos(const UlpLocation &location,
             length = snprintf(pMarker, lengthRemaining,",,,");
         }
 
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        nmeaSentences.commit(length);
     }
     //Send blank NMEA reports for non-final fixes
     else {
-        strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GNGSA,A,1,,,,,,,,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$PQGSA,A,1,,,,,,,,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPVTG,,T,,M,,N,,K,N", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPRMC,,V,,,,,,,,,,N,V", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPGGA,,,,,,0,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        sentence = nmeaSentences.next();
+        strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,", NMEA_SENTENCE_MAX_LENGTH);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        nmeaSentences.commit(length);
+
+        sentence = nmeaSentences.next();
+        strlcpy(sentence, "$GNGSA,A,1,,,,,,,,,,,,,,,", NMEA_SENTENCE_MAX_LENGTH);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        nmeaSentences.commit(length);
+
+        sentence = nmeaSentences.next();
+        strlcpy(sentence, "$PQGSA,A,1,,,,,,,,,,,,,,,", NMEA_SENTENCE_MAX_LENGTH);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        nmeaSentences.commit(length);
+
+        sentence = nmeaSentences.next();
+        strlcpy(sentence, "$GPVTG,,T,,M,,N,,K,N", NMEA_SENTENCE_MAX_LENGTH);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        nmeaSentences.commit(length);
+
+        sentence = nmeaSentences.next();
+        strlcpy(sentence, "$GPRMC,,V,,,,,,,,,,N,V", NMEA_SENTENCE_MAX_LENGTH);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        nmeaSentences.commit(length);
+
+        sentence = nmeaSentences.next();
+        strlcpy(sentence, "$GPGGA,,,,,,0,,,,,,,,", NMEA_SENTENCE_MAX_LENGTH);
+        length = loc_nmea_put_checksum(sentence, NMEA_SENTENCE_MAX_LENGTH);
+        nmeaSentences.commit(length);
     }
 
     EXIT_LOG(%d, 0);
@@ -998,11 +1153,10 @@ SIDE EFFECTS
 
 ===========================================================================*/
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaSentences &nmeaSentences)
 {
     ENTRY_LOG();
 
-    char sentence[NMEA_SENTENCE_MAX_LENGTH] = {0};
     int svCount = svNotify.count;
     int svNumber = 1;
     loc_sv_cache_info sv_cache_info = {};
@@ -1076,39 +1230,162 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
     // ------$GPGSV------
     // ------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS, false), nmeaArraystr);
+    loc_nmea_generate_GSV(svNotify,
+            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS, false),
+            nmeaSentences);
 
     // ------------------
     // ------$GLGSV------
     // ------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS, false),
-            nmeaArraystr);
+            nmeaSentences);
 
     // ------------------
     // ------$GAGSV------
     // ------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO, false),
-            nmeaArraystr);
+            nmeaSentences);
 
     // -------------------------
     // ------$PQGSV (QZSS)------
     // -------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
-            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS, false), nmeaArraystr);
+    loc_nmea_generate_GSV(svNotify,
+            loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS, false),
+            nmeaSentences);
 
     // ---------------------------
     // ------$PQGSV (BEIDOU)------
     // ---------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU, false),
-            nmeaArraystr);
+            nmeaSentences);
 
     EXIT_LOG(%d, 0);
 }
+
+#ifdef __LOC_DEBUG__
+
+#include <time.h>
+#include <inttypes.h>
+#include <string>
+#include <vector>
+
+// Counts the bytes copied per NMEA epoch (one position and one sv report
+// with AP generated NMEA, plus the modem's own sentences) on the way to
+// gnssNmeaCb. "vector" replays what the std::vector<std::string> based
+// path did with every sentence: the copy into the vector, the copy by the
+// range based for loop, and for modem sentences, the new[] copy in
+// MsgReportNmea and the stack copy in SystemStatus::setNmeaString.
+//
+// For Linux command line testing:
+// compilation:
+//     g++ -D__LOC_DEBUG__ -O2 -std=c++11 -I. -I../location -I../pla/android -I../../../../system/core/include -o loc_nmea_bench loc_nmea.cpp loc_log.cpp -lpthread
+// usage:
+//     ./loc_nmea_bench [epochs]
+
+static uint64_t bench_now_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static volatile size_t bench_sink;
+static void bench_nmea_cb(const char* nmea, size_t length)
+{
+    bench_sink += nmea[length - 1];
+}
+
+int main(int argc, char** argv)
+{
+    int epochs = (argc > 1) ? atoi(argv[1]) : 100000;
+    const char* modem[] = {
+        "$GPGSV,3,1,12,02,17,300,35,05,48,205,41,06,12,052,30,12,61,094,44*7B\r\n",
+        "$PQWM1,1987,345678901,1,3,12,-35,4,2,100,200,300,400,500,1*1C\r\n",
+    };
+
+    UlpLocation location = {};
+    location.gpsLocation.flags = LOC_GPS_LOCATION_HAS_LAT_LONG | LOC_GPS_LOCATION_HAS_ALTITUDE |
+            LOC_GPS_LOCATION_HAS_SPEED | LOC_GPS_LOCATION_HAS_BEARING |
+            LOC_GPS_LOCATION_HAS_ACCURACY;
+    location.gpsLocation.latitude = 37.4219999;
+    location.gpsLocation.longitude = -122.0840575;
+    location.gpsLocation.timestamp = 1500000000000LL;
+    GpsLocationExtended locationExtended = {};
+    locationExtended.flags = GPS_LOCATION_EXTENDED_HAS_GNSS_SV_USED_DATA |
+            GPS_LOCATION_EXTENDED_HAS_DOP;
+    locationExtended.gnss_sv_used_ids.gps_sv_used_ids_mask = 0xF0F;
+    locationExtended.gnss_sv_used_ids.glo_sv_used_ids_mask = 0x0FF;
+    GnssSvNotification svNotify = {};
+    svNotify.count = 40;
+    for (size_t i = 0; i < svNotify.count; i++) {
+        svNotify.gnssSvs[i].svId = i % 20 + 1;
+        svNotify.gnssSvs[i].type = (i < 20) ? GNSS_SV_TYPE_GPS : GNSS_SV_TYPE_GLONASS;
+        svNotify.gnssSvs[i].cN0Dbhz = 30 + i % 15;
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        bool legacy = (0 == pass);
+        uint64_t copied = 0, sentences = 0;
+        LocNmeaPoolStats before, after;
+        LocNmeaSentence::getPoolStats(before);
+        uint64_t start = bench_now_ns();
+
+        for (int e = 0; e < epochs; e++) {
+            LocNmeaSentences nmeaSentences;
+            loc_nmea_generate_pos(location, locationExtended, 1, nmeaSentences);
+            loc_nmea_generate_sv(svNotify, nmeaSentences);
+            sentences += nmeaSentences.size();
+            if (legacy) {
+                std::vector<std::string> nmeaArraystr;
+                for (size_t i = 0; i < nmeaSentences.size(); i++) {
+                    nmeaArraystr.push_back(nmeaSentences[i]->data());
+                    copied += nmeaSentences[i]->length();
+                }
+                for (auto sentence : nmeaArraystr) {
+                    copied += sentence.length();
+                    bench_nmea_cb(sentence.c_str(), sentence.length());
+                }
+                for (size_t i = 0; i < sizeof(modem) / sizeof(modem[0]); i++) {
+                    size_t length = strlen(modem[i]);
+                    char* nmea = new char[length + 1];
+                    strlcpy(nmea, modem[i], length + 1);
+                    char buf[DEBUG_NMEA_MAXSIZE + 1] = { 0 };
+                    strlcpy(buf, nmea, sizeof(buf));
+                    copied += 2 * length;
+                    bench_nmea_cb(nmea, length);
+                    delete[] nmea;
+                }
+            } else {
+                for (size_t i = 0; i < nmeaSentences.size(); i++) {
+                    bench_nmea_cb(nmeaSentences[i]->data(), nmeaSentences[i]->length());
+                }
+                for (size_t i = 0; i < sizeof(modem) / sizeof(modem[0]); i++) {
+                    LocNmeaSentence* nmea = LocNmeaSentence::obtain(modem[i], strlen(modem[i]));
+                    bench_nmea_cb(nmea->data(), nmea->length());
+                    nmea->release();
+                }
+            }
+        }
+
+        uint64_t elapsed = bench_now_ns() - start;
+        LocNmeaSentence::getPoolStats(after);
+        if (!legacy) {
+            copied = after.bytesCopied - before.bytesCopied;
+        }
+        printf("%-6s: %4.1f sentences/epoch, %7.1f bytes copied/epoch, %6.0f ns/epoch, "
+               "%" PRIu64 " pool heap allocs\n",
+               legacy ? "vector" : "pooled", (double)sentences / epochs,
+               (double)copied / epochs, (double)elapsed / epochs,
+               after.heapAllocs - before.heapAllocs);
+    }
+    return 0;
+}
+
+#endif
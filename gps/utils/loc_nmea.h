@@ -31,20 +31,79 @@
 #define LOC_ENG_NMEA_H
 
 #include <gps_extended.h>
-#include <vector>
-#include <string>
+#include <stdint.h>
 #define NMEA_SENTENCE_MAX_LENGTH 200
 
+#define DEBUG_NMEA_MINSIZE 6
+#define DEBUG_NMEA_MAXSIZE 4096
+
+// Max number of sentences generated for one position or sv report
+#define NMEA_EPOCH_MAX_SENTENCES 32
+
+struct LocNmeaPoolStats {
+    uint64_t obtained;      // sentence buffers handed out
+    uint64_t heapAllocs;    // sentence buffers that had to come from the heap
+    uint64_t bytesCopied;   // bytes copied into sentence buffers from elsewhere
+};
+
+// A NUL terminated NMEA sentence in a buffer recycled through a pool. The sentence is written in place by its producer, and
+// handed on by pointer all the way to the gnssNmeaCb clients.
+class LocNmeaSentence {
+    size_t mCapacity;
+    size_t mLength;
+    LocNmeaSentence* mNext;     // pool free list link
+    char* mData;
+
+    LocNmeaSentence(size_t capacity, char* data);
+    ~LocNmeaSentence() {}
+public:
+    // buffer for a sentence of up to capacity - 1 chars
+    static LocNmeaSentence* obtain(size_t capacity = NMEA_SENTENCE_MAX_LENGTH);
+    // buffer holding a copy of nmea[0..length)
+    static LocNmeaSentence* obtain(const char* nmea, size_t length);
+    static void getPoolStats(LocNmeaPoolStats& stats);
+
+    // puts the buffer back in the pool, called once by its only owner
+    void release();
+
+    inline char* data() const { return mData; }
+    inline size_t capacity() const { return mCapacity; }
+    inline size_t length() const { return mLength; }
+    inline void setLength(size_t length) {
+        mLength = (length < mCapacity) ? length : mCapacity - 1;
+        mData[mLength] = '\0';
+    }
+};
+
+// The sentences generated for one epoch. Lives on the stack of the
+// reporting function; owns and releases each sentence it carries.
+class LocNmeaSentences {
+    // one more than the max, for the sentence being written
+    LocNmeaSentence* mSentences[NMEA_EPOCH_MAX_SENTENCES + 1];
+    size_t mCount;
+    // written into if no buffer could be had; never committed
+    char mScratch[NMEA_SENTENCE_MAX_LENGTH];
+    LocNmeaSentences(const LocNmeaSentences&);
+    LocNmeaSentences& operator=(const LocNmeaSentences&);
+public:
+    inline LocNmeaSentences() : mCount(0) { mSentences[0] = nullptr; }
+    inline ~LocNmeaSentences() { clear(); }
+    // buffer to write the next sentence into, of NMEA_SENTENCE_MAX_LENGTH;
+    // only becomes part of this epoch once commit() is called
+    char* next();
+    void commit(size_t length);
+    void clear();
+    inline size_t size() const { return mCount; }
+    inline const LocNmeaSentence* operator[](size_t i) const { return mSentences[i]; }
+};
+
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
-                              std::vector<std::string> &nmeaArraystr);
+                              LocNmeaSentences &nmeaSentences);
 
 void loc_nmea_generate_pos(const UlpLocation &location,
                                const GpsLocationExtended &locationExtended,
                                unsigned char generate_nmea,
-                               std::vector<std::string> &nmeaArraystr);
-
-#define DEBUG_NMEA_MINSIZE 6
-#define DEBUG_NMEA_MAXSIZE 4096
+                               LocNmeaSentences &nmeaSentences);
 inline bool loc_nmea_is_debug(const char* nmea, int length) {
     return ((nullptr != nmea) &&
             (length >= DEBUG_NMEA_MINSIZE) && (length <= DEBUG_NMEA_MAXSIZE) &&
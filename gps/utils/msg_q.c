@@ -29,17 +29,47 @@
 #define LOG_TAG "LocSvc_utils_q"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
+#include <sched.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#ifdef SYS_futex
+#include <linux/futex.h>
+#endif
 #include <loc_pla.h>
 #include <log_util.h>
 #include "linked_list.h"
 #include "msg_q.h"
 
+#define MSG_Q_CACHE_LINE_SIZE 64
+#define MSG_Q_CACHE_ALIGNED __attribute__((aligned(MSG_Q_CACHE_LINE_SIZE)))
+
+/* One ring slot. seq tells the slot's state relative to a queue position:
+   seq == pos is free for the producer claiming pos, seq == pos + 1 holds
+   the message for pos, ready for the consumer. */
+typedef struct msg_q_slot {
+   uint32_t seq;
+   void* msg_obj;
+   void (*dealloc)(void*);
+} msg_q_slot;
+
 typedef struct msg_q {
    void* msg_list;                  /* Linked list to store information */
    pthread_cond_t  list_cond;       /* Condition variable for waiting on msg queue */
    pthread_mutex_t list_mutex;      /* Mutex for exclusive access to message queue */
    int unblocked;                   /* Has this message queue been unblocked? */
+
+   msg_q_slot* ring;                /* Lock-free ring; NULL for a list only queue */
+   uint32_t ring_mask;              /* Number of ring slots - 1 */
+   int overflowed;                  /* msg_list holds msgs that did not fit in ring */
+
+   /* producer, consumer and wakeup state each on their own cache line */
+   uint32_t enq_pos MSG_Q_CACHE_ALIGNED;  /* Next position to be claimed by a sender */
+   uint32_t deq_pos MSG_Q_CACHE_ALIGNED;  /* Next position to be received */
+   uint32_t wake_seq MSG_Q_CACHE_ALIGNED; /* Bumped on every wakeup of the receiver */
+   int sleeping;                    /* Receiver is (about to be) waiting on wake_seq */
 } msg_q;
 
 /*===========================================================================
@@ -81,6 +111,197 @@ static msq_q_err_type convert_linked_list_err_type(linked_list_err_type linked_l
    }
 }
 
+/*===========================================================================
+FUNCTION    msg_q_ring_push
+
+DESCRIPTION
+   Claims the next free ring slot and publishes msg_obj in it. Safe to be
+   called concurrently by any number of senders.
+
+RETURN VALUE
+   1 if the message is in the ring; 0 if the ring is full
+
+===========================================================================*/
+static int msg_q_ring_push(msg_q* p_msg_q, void* msg_obj, void (*dealloc)(void*))
+{
+   uint32_t pos = __atomic_load_n(&p_msg_q->enq_pos, __ATOMIC_RELAXED);
+
+   for (;;)
+   {
+      msg_q_slot* slot = &p_msg_q->ring[pos & p_msg_q->ring_mask];
+      int32_t diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+
+      if( diff == 0 )
+      {
+         if( __atomic_compare_exchange_n(&p_msg_q->enq_pos, &pos, pos + 1, 1,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+         {
+            slot->msg_obj = msg_obj;
+            slot->dealloc = dealloc;
+            __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+            return 1;
+         }
+         /* lost the race for pos; compare_exchange reloaded it */
+      }
+      else if( diff < 0 )
+      {
+         /* slot still holds the message from one lap ago */
+         return 0;
+      }
+      else
+      {
+         pos = __atomic_load_n(&p_msg_q->enq_pos, __ATOMIC_RELAXED);
+      }
+   }
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_pop
+
+DESCRIPTION
+   Removes the oldest message from the ring. Must only be called by the
+   single receiver. If the oldest position has been claimed by a sender
+   that has not published its message yet, waits for it, so that messages
+   are never handed out of order, also not in favor of overflow messages.
+
+RETURN VALUE
+   1 if a message was removed; 0 if the ring is empty
+
+===========================================================================*/
+static int msg_q_ring_pop(msg_q* p_msg_q, void** msg_obj, void (**dealloc)(void*))
+{
+   uint32_t pos = p_msg_q->deq_pos;
+   msg_q_slot* slot = &p_msg_q->ring[pos & p_msg_q->ring_mask];
+
+   while( __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1 )
+   {
+      if( __atomic_load_n(&p_msg_q->enq_pos, __ATOMIC_ACQUIRE) == pos )
+      {
+         return 0;
+      }
+      sched_yield();
+   }
+
+   *msg_obj = slot->msg_obj;
+   if( dealloc != NULL )
+   {
+      *dealloc = slot->dealloc;
+   }
+   __atomic_store_n(&slot->seq, pos + p_msg_q->ring_mask + 1, __ATOMIC_RELEASE);
+   p_msg_q->deq_pos = pos + 1;
+
+   return 1;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_has_data
+
+DESCRIPTION
+   Tells the receiver if there is anything for it to pick up, in the ring
+   or in the overflow list, or if the queue got unblocked.
+
+===========================================================================*/
+static int msg_q_ring_has_data(msg_q* p_msg_q)
+{
+   return __atomic_load_n(&p_msg_q->enq_pos, __ATOMIC_ACQUIRE) != p_msg_q->deq_pos ||
+          __atomic_load_n(&p_msg_q->overflowed, __ATOMIC_ACQUIRE) ||
+          __atomic_load_n(&p_msg_q->unblocked, __ATOMIC_ACQUIRE);
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_wait
+
+DESCRIPTION
+   Puts the receiver to sleep until a sender calls msg_q_ring_wake().
+   Uses a futex on wake_seq where available, and list_cond otherwise.
+
+===========================================================================*/
+static void msg_q_ring_wait(msg_q* p_msg_q)
+{
+   uint32_t seq = __atomic_load_n(&p_msg_q->wake_seq, __ATOMIC_ACQUIRE);
+
+   /* Pairs with the fence in msg_q_ring_wake(): either the sender sees
+      sleeping set, or we see its message below. */
+   __atomic_store_n(&p_msg_q->sleeping, 1, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+   if( !msg_q_ring_has_data(p_msg_q) )
+   {
+#ifdef SYS_futex
+      syscall(SYS_futex, &p_msg_q->wake_seq, FUTEX_WAIT_PRIVATE, seq, NULL, NULL, 0);
+#else
+      pthread_mutex_lock(&p_msg_q->list_mutex);
+      while( seq == p_msg_q->wake_seq )
+      {
+         pthread_cond_wait(&p_msg_q->list_cond, &p_msg_q->list_mutex);
+      }
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+#endif
+   }
+
+   __atomic_store_n(&p_msg_q->sleeping, 0, __ATOMIC_RELAXED);
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_wake
+
+DESCRIPTION
+   Wakes up the receiver if it is waiting. Costs no syscall otherwise, and
+   only the first sender after the receiver went to sleep pays for it.
+
+===========================================================================*/
+static void msg_q_ring_wake(msg_q* p_msg_q, int force)
+{
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+   if( force ||
+       (__atomic_load_n(&p_msg_q->sleeping, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n(&p_msg_q->sleeping, 0, __ATOMIC_ACQ_REL)) )
+   {
+#ifdef SYS_futex
+      __atomic_add_fetch(&p_msg_q->wake_seq, 1, __ATOMIC_RELEASE);
+      syscall(SYS_futex, &p_msg_q->wake_seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+      pthread_mutex_lock(&p_msg_q->list_mutex);
+      p_msg_q->wake_seq++;
+      pthread_cond_broadcast(&p_msg_q->list_cond);
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+#endif
+   }
+}
+
+/*===========================================================================
+FUNCTION    msg_q_overflow_rcv
+
+DESCRIPTION
+   Removes the oldest message from the overflow list, if any, and clears
+   the overflow state once the list is drained so that senders go back to
+   using the ring.
+
+RETURN VALUE
+   1 if a message was removed; 0 if the overflow list is empty
+
+===========================================================================*/
+static int msg_q_overflow_rcv(msg_q* p_msg_q, void** msg_obj)
+{
+   int received = 0;
+
+   pthread_mutex_lock(&p_msg_q->list_mutex);
+
+   if( !linked_list_empty(p_msg_q->msg_list) )
+   {
+      received = (eLINKED_LIST_SUCCESS == linked_list_remove(p_msg_q->msg_list, msg_obj));
+   }
+   if( linked_list_empty(p_msg_q->msg_list) )
+   {
+      __atomic_store_n(&p_msg_q->overflowed, 0, __ATOMIC_RELEASE);
+   }
+
+   pthread_mutex_unlock(&p_msg_q->list_mutex);
+
+   return received;
+}
+
 /* ----------------------- END INTERNAL FUNCTIONS ---------------------------------------- */
 
 /*===========================================================================
@@ -89,6 +310,30 @@ static msq_q_err_type convert_linked_list_err_type(linked_list_err_type linked_l
 
   ===========================================================================*/
 msq_q_err_type msg_q_init(void** msg_q_data)
+{
+   return msg_q_init3(msg_q_data, MSG_Q_DEFAULT_RING_SIZE);
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_init2
+
+  ===========================================================================*/
+const void* msg_q_init2()
+{
+  void* q = NULL;
+  if (eMSG_Q_SUCCESS != msg_q_init(&q)) {
+    q = NULL;
+  }
+  return q;
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_init3
+
+  ===========================================================================*/
+msq_q_err_type msg_q_init3(void** msg_q_data, uint32_t ring_size)
 {
    if( msg_q_data == NULL )
    {
@@ -96,17 +341,40 @@ msq_q_err_type msg_q_init(void** msg_q_data)
       return eMSG_Q_INVALID_PARAMETER;
    }
 
-   msg_q* tmp_msg_q;
-   tmp_msg_q = (msg_q*)calloc(1, sizeof(msg_q));
-   if( tmp_msg_q == NULL )
+   msg_q* tmp_msg_q = NULL;
+   if( posix_memalign((void**)&tmp_msg_q, MSG_Q_CACHE_LINE_SIZE, sizeof(msg_q)) != 0 )
    {
       LOC_LOGE("%s: Unable to allocate space for message queue!\n", __FUNCTION__);
       return eMSG_Q_FAILURE_GENERAL;
    }
+   memset(tmp_msg_q, 0, sizeof(msg_q));
+
+   if( ring_size > 0 )
+   {
+      uint32_t slots = 1;
+      while( slots < ring_size && slots < 0x80000000 )
+      {
+         slots <<= 1;
+      }
+
+      tmp_msg_q->ring = (msg_q_slot*)calloc(slots, sizeof(msg_q_slot));
+      if( tmp_msg_q->ring == NULL )
+      {
+         LOC_LOGE("%s: Unable to allocate space for message ring!\n", __FUNCTION__);
+         free(tmp_msg_q);
+         return eMSG_Q_FAILURE_GENERAL;
+      }
+      for( uint32_t i = 0; i < slots; i++ )
+      {
+         tmp_msg_q->ring[i].seq = i;
+      }
+      tmp_msg_q->ring_mask = slots - 1;
+   }
 
    if( linked_list_init(&tmp_msg_q->msg_list) != 0 )
    {
       LOC_LOGE("%s: Unable to initialize storage list!\n", __FUNCTION__);
+      free(tmp_msg_q->ring);
       free(tmp_msg_q);
       return eMSG_Q_FAILURE_GENERAL;
    }
@@ -115,6 +383,7 @@ msq_q_err_type msg_q_init(void** msg_q_data)
    {
       LOC_LOGE("%s: Unable to initialize list mutex!\n", __FUNCTION__);
       linked_list_destroy(&tmp_msg_q->msg_list);
+      free(tmp_msg_q->ring);
       free(tmp_msg_q);
       return eMSG_Q_FAILURE_GENERAL;
    }
@@ -124,6 +393,7 @@ msq_q_err_type msg_q_init(void** msg_q_data)
       LOC_LOGE("%s: Unable to initialize msg q cond var!\n", __FUNCTION__);
       linked_list_destroy(&tmp_msg_q->msg_list);
       pthread_mutex_destroy(&tmp_msg_q->list_mutex);
+      free(tmp_msg_q->ring);
       free(tmp_msg_q);
       return eMSG_Q_FAILURE_GENERAL;
    }
@@ -135,20 +405,6 @@ msq_q_err_type msg_q_init(void** msg_q_data)
    return eMSG_Q_SUCCESS;
 }
 
-/*===========================================================================
-
-  FUNCTION:   msg_q_init2
-
-  ===========================================================================*/
-const void* msg_q_init2()
-{
-  void* q = NULL;
-  if (eMSG_Q_SUCCESS != msg_q_init(&q)) {
-    q = NULL;
-  }
-  return q;
-}
-
 /*===========================================================================
 
   FUNCTION:   msg_q_destroy
@@ -170,6 +426,7 @@ msq_q_err_type msg_q_destroy(void** msg_q_data)
 
    p_msg_q->unblocked = 0;
 
+   free(p_msg_q->ring);
    free(*msg_q_data);
    *msg_q_data = NULL;
 
@@ -197,9 +454,27 @@ msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*)
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
-   pthread_mutex_lock(&p_msg_q->list_mutex);
    LOC_LOGV("%s: Sending message with handle = %p\n", __FUNCTION__, msg_obj);
 
+   if( p_msg_q->ring != NULL && !__atomic_load_n(&p_msg_q->overflowed, __ATOMIC_ACQUIRE) )
+   {
+      if( __atomic_load_n(&p_msg_q->unblocked, __ATOMIC_ACQUIRE) )
+      {
+         LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+         return eMSG_Q_UNAVAILABLE_RESOURCE;
+      }
+
+      if( msg_q_ring_push(p_msg_q, msg_obj, dealloc) )
+      {
+         msg_q_ring_wake(p_msg_q, 0);
+         LOC_LOGV("%s: Finished Sending message with handle = %p\n", __FUNCTION__, msg_obj);
+         return eMSG_Q_SUCCESS;
+      }
+   }
+
+   /* List only queue, or the ring is full / not drained from overflow yet */
+   pthread_mutex_lock(&p_msg_q->list_mutex);
+
    if( p_msg_q->unblocked )
    {
       LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
@@ -209,11 +484,22 @@ msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*)
 
    rv = convert_linked_list_err_type(linked_list_add(p_msg_q->msg_list, msg_obj, dealloc));
 
+   if( p_msg_q->ring != NULL )
+   {
+      /* Keep senders on the list until the receiver has caught up */
+      __atomic_store_n(&p_msg_q->overflowed, 1, __ATOMIC_RELEASE);
+   }
+
    /* Show data is in the message queue. */
    pthread_cond_signal(&p_msg_q->list_cond);
 
    pthread_mutex_unlock(&p_msg_q->list_mutex);
 
+   if( p_msg_q->ring != NULL )
+   {
+      msg_q_ring_wake(p_msg_q, 0);
+   }
+
    LOC_LOGV("%s: Finished Sending message with handle = %p\n", __FUNCTION__, msg_obj);
 
    return rv;
@@ -241,6 +527,29 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
+   if( p_msg_q->ring != NULL )
+   {
+      /* Ring first: anything in the overflow list was sent after it */
+      for (;;)
+      {
+         if( __atomic_load_n(&p_msg_q->unblocked, __ATOMIC_ACQUIRE) )
+         {
+            LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+            return eMSG_Q_UNAVAILABLE_RESOURCE;
+         }
+
+         if( msg_q_ring_pop(p_msg_q, msg_obj, NULL) ||
+             (__atomic_load_n(&p_msg_q->overflowed, __ATOMIC_ACQUIRE) &&
+              msg_q_overflow_rcv(p_msg_q, msg_obj)) )
+         {
+            LOC_LOGV("%s: Received message %p rv = %d\n", __FUNCTION__, *msg_obj, eMSG_Q_SUCCESS);
+            return eMSG_Q_SUCCESS;
+         }
+
+         msg_q_ring_wait(p_msg_q);
+      }
+   }
+
    pthread_mutex_lock(&p_msg_q->list_mutex);
 
    if( p_msg_q->unblocked )
@@ -283,10 +592,24 @@ msq_q_err_type msg_q_flush(void* msg_q_data)
 
    LOC_LOGD("%s: Flushing Message Queue\n", __FUNCTION__);
 
+   if( p_msg_q->ring != NULL )
+   {
+      void* msg_obj;
+      void (*dealloc)(void*);
+      while( msg_q_ring_pop(p_msg_q, &msg_obj, &dealloc) )
+      {
+         if( dealloc != NULL )
+         {
+            dealloc(msg_obj);
+         }
+      }
+   }
+
    pthread_mutex_lock(&p_msg_q->list_mutex);
 
    /* Remove all elements from the list */
    rv = convert_linked_list_err_type(linked_list_flush(p_msg_q->msg_list));
+   __atomic_store_n(&p_msg_q->overflowed, 0, __ATOMIC_RELEASE);
 
    pthread_mutex_unlock(&p_msg_q->list_mutex);
 
@@ -320,14 +643,134 @@ msq_q_err_type msg_q_unblock(void* msg_q_data)
 
    LOC_LOGD("%s: Unblocking Message Queue\n", __FUNCTION__);
    /* Unblocking message queue */
-   p_msg_q->unblocked = 1;
+   __atomic_store_n(&p_msg_q->unblocked, 1, __ATOMIC_RELEASE);
 
    /* Allow all the waiters to wake up */
    pthread_cond_broadcast(&p_msg_q->list_cond);
 
    pthread_mutex_unlock(&p_msg_q->list_mutex);
 
+   if( p_msg_q->ring != NULL )
+   {
+      msg_q_ring_wake(p_msg_q, 1);
+   }
+
    LOC_LOGD("%s: Message Queue unblocked\n", __FUNCTION__);
 
    return eMSG_Q_SUCCESS;
 }
+
+#ifdef __LOC_DEBUG__
+
+#include <time.h>
+
+/* Microbenchmark of msg_q_snd() -> msg_q_rcv() handoff, comparing the linked
+   list only queue with the ring. Every message carries its send timestamp;
+   the single receiver records the handoff latency of each one. The burst
+   runs measure throughput with senders going flat out; the paced runs,
+   with a gap between messages, measure the handoff latency of a receiver
+   that mostly waits, which is how MsgTask normally runs.
+
+   For Linux command line testing:
+   compilation:
+       gcc -D__LOC_DEBUG__ -O2 -std=gnu99 -I. -I../pla/android -I../../../../system/core/include -o msg_q_bench msg_q.c linked_list.c -lpthread
+   usage:
+       ./msg_q_bench [msgs per sender] */
+
+typedef struct {
+   void* q;
+   int count;
+   long gap_ns;
+   struct timespec* stamps;
+} msg_q_bench_sender;
+
+static uint64_t msg_q_bench_ns(const struct timespec* ts)
+{
+   return (uint64_t)ts->tv_sec * 1000000000ULL + (uint64_t)ts->tv_nsec;
+}
+
+static void* msg_q_bench_send(void* arg)
+{
+   msg_q_bench_sender* sender = (msg_q_bench_sender*)arg;
+   struct timespec gap = { 0, sender->gap_ns };
+   for( int i = 0; i < sender->count; i++ )
+   {
+      if( gap.tv_nsec > 0 )
+      {
+         nanosleep(&gap, NULL);
+      }
+      clock_gettime(CLOCK_MONOTONIC, &sender->stamps[i]);
+      msg_q_snd(sender->q, &sender->stamps[i], NULL);
+   }
+   return NULL;
+}
+
+static int msg_q_bench_cmp(const void* a, const void* b)
+{
+   uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+   return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void msg_q_bench_run(const char* name, uint32_t ring_size, int senders,
+                            int count, long gap_ns)
+{
+   void* q = NULL;
+   pthread_t threads[8];
+   msg_q_bench_sender sender[8];
+   int total = senders * count;
+   uint64_t* latency = (uint64_t*)malloc(total * sizeof(uint64_t));
+   struct timespec start, end, now;
+
+   msg_q_init3(&q, ring_size);
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for( int i = 0; i < senders; i++ )
+   {
+      sender[i].q = q;
+      sender[i].count = count;
+      sender[i].gap_ns = gap_ns;
+      sender[i].stamps = (struct timespec*)malloc(count * sizeof(struct timespec));
+      pthread_create(&threads[i], NULL, msg_q_bench_send, &sender[i]);
+   }
+
+   for( int i = 0; i < total; i++ )
+   {
+      struct timespec* stamp = NULL;
+      msg_q_rcv(q, (void**)&stamp);
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      latency[i] = msg_q_bench_ns(&now) - msg_q_bench_ns(stamp);
+   }
+   clock_gettime(CLOCK_MONOTONIC, &end);
+
+   for( int i = 0; i < senders; i++ )
+   {
+      pthread_join(threads[i], NULL);
+      free(sender[i].stamps);
+   }
+   msg_q_destroy(&q);
+
+   qsort(latency, total, sizeof(uint64_t), msg_q_bench_cmp);
+   double secs = (double)(msg_q_bench_ns(&end) - msg_q_bench_ns(&start)) / 1e9;
+   printf("%-5s %-5s senders %d: %10.0f msgs/s, p50 %9.2f us, p99 %9.2f us\n",
+          name, gap_ns > 0 ? "paced" : "burst", senders, total / secs,
+          latency[total / 2] / 1000.0, latency[(int)(total * 0.99)] / 1000.0);
+   free(latency);
+}
+
+int main(int argc, char** argv)
+{
+   int count = argc > 1 ? atoi(argv[1]) : 200000;
+
+   for( int senders = 1; senders <= 8; senders <<= 1 )
+   {
+      msg_q_bench_run("list", 0, senders, count, 0);
+      msg_q_bench_run("ring", MSG_Q_DEFAULT_RING_SIZE, senders, count, 0);
+   }
+   for( int senders = 1; senders <= 8; senders <<= 1 )
+   {
+      msg_q_bench_run("list", 0, senders, count / 10, 50000);
+      msg_q_bench_run("ring", MSG_Q_DEFAULT_RING_SIZE, senders, count / 10, 50000);
+   }
+   return 0;
+}
+
+#endif
@@ -34,6 +34,10 @@ extern "C" {
 #endif /* __cplusplus */
 
 #include <stdlib.h>
+#include <stdint.h>
+
+/** Number of ring slots used by msg_q_init() and msg_q_init2() */
+#define MSG_Q_DEFAULT_RING_SIZE 256
 
 /** Linked List Return Codes */
 typedef enum
@@ -56,7 +60,8 @@ typedef enum
 FUNCTION    msg_q_init
 
 DESCRIPTION
-   Initializes internal structures for message queue.
+   Initializes internal structures for message queue, backed by a ring of
+   MSG_Q_DEFAULT_RING_SIZE slots. See msg_q_init3.
 
    msg_q_data: pointer to an opaque Q handle to be returned; NULL if fails
 
@@ -76,7 +81,8 @@ msq_q_err_type msg_q_init(void** msg_q_data);
 FUNCTION    msg_q_init2
 
 DESCRIPTION
-   Initializes internal structures for message queue.
+   Initializes internal structures for message queue, backed by a ring of
+   MSG_Q_DEFAULT_RING_SIZE slots. See msg_q_init3.
 
 DEPENDENCIES
    N/A
@@ -90,6 +96,40 @@ SIDE EFFECTS
 ===========================================================================*/
 const void* msg_q_init2();
 
+/*===========================================================================
+FUNCTION    msg_q_init3
+
+DESCRIPTION
+   Initializes internal structures for message queue, selecting the queue
+   engine to use.
+
+   With a non-zero ring_size, messages are carried in a preallocated,
+   lock-free multi-producer / single-consumer ring of ring_size slots
+   (rounded up to a power of 2). Senders never allocate or take a lock
+   while the ring has room; the receiver is only woken up when it is
+   actually waiting. Once the ring is full, messages spill over into the
+   linked list until the receiver has drained it, so msg_q_snd() never
+   fails because of a full ring. Only one thread may call msg_q_rcv() /
+   msg_q_flush() on such a queue at any time.
+
+   With ring_size of 0, the queue is backed by the linked list only and
+   any number of threads may receive from it.
+
+   msg_q_data: pointer to an opaque Q handle to be returned; NULL if fails
+   ring_size:  number of ring slots; 0 for a linked list only queue
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_init3(void** msg_q_data, uint32_t ring_size);
+
 /*===========================================================================
 FUNCTION    msg_q_destroy
 